@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DescriptorAllocation.h"
+#include "CommandListStatistics.h"
 
 #include <d3d12.h>
 #include <dxgi1_6.h>
@@ -18,6 +19,7 @@ namespace dx12demo::core
 	class Game;
 	class CommandQueue;
 	class DescriptorAllocator;
+	class MeshPool;
 
 	class Application
 	{
@@ -59,6 +61,12 @@ namespace dx12demo::core
 
 		uint64_t GetFrameCount() const;
 
+		// Shared vertex and index buffers the meshes are sub-allocated from.
+		std::shared_ptr<MeshPool> GetMeshPool() const;
+
+		// State calls issued and elided by the command lists of the previous frame (all queues).
+		const CommandListStatistics& GetCommandListStatistics() const;
+
 	protected:
 
 		// Create an application instance.
@@ -99,11 +107,15 @@ namespace dx12demo::core
 
 		std::unique_ptr<DescriptorAllocator> m_DescriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
 
+		std::shared_ptr<MeshPool> m_MeshPool;
+
 		bool m_TearingSupported;
 
 		WindowMap m_Windows;
 		WindowNameMap m_WindowByName;
 
 		uint64_t m_FrameCount = 0;
+
+		CommandListStatistics m_CommandListStatistics;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <BoundingVolumesPrimitive.h>
+
+#include <DirectXMath.h>
+
+#include <vector>
+
+namespace dx12demo::core
+{
+    /* Bounding volumes fitted to the vertex data.
+    *  Ritter, "An Efficient Bounding Sphere", Graphics Gems (1990): fast, usually within 5-20% of the minimal radius.
+    *  Welzl, "Smallest enclosing disks (balls and ellipsoids)" (1991): exact, randomized expected linear time.
+    *  The oriented box axes are the principal components of the vertex positions.
+    */
+    class BoundingVolumeBuilder
+    {
+    public:
+        static BAABB ComputeAABB(const std::vector<DirectX::XMFLOAT3>& positions);
+
+        static BSphere ComputeRitterSphere(const std::vector<DirectX::XMFLOAT3>& positions);
+        static BSphere ComputeMinimalSphere(const std::vector<DirectX::XMFLOAT3>& positions);
+
+        // Falls back to the axis aligned box if the principal axes don't give a smaller volume.
+        static BOBB ComputeOBB(const std::vector<DirectX::XMFLOAT3>& positions);
+
+        static BOBB ToOBB(const BAABB& aabb);
+        static float GetVolume(const BOBB& obb);
+
+        // VerticesContainer must have DirectX::XMFLOAT3 m_position.
+        template<typename VerticesContainer>
+        static std::vector<DirectX::XMFLOAT3> GetPositions(const std::vector<VerticesContainer>& vertices)
+        {
+            std::vector<DirectX::XMFLOAT3> positions(vertices.size());
+            for (size_t i = 0; i < vertices.size(); ++i)
+                positions[i] = vertices[i].m_position;
+
+            return positions;
+        }
+    };
+}
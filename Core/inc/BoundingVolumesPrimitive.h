@@ -16,6 +16,14 @@ namespace dx12demo::core
 		DirectX::XMFLOAT3 box_max;
 	};
 
+	// Oriented box: center + sum(axes[i] * [-extents[i], extents[i]]), the axes are orthonormal.
+	__declspec(align(16)) struct BOBB
+	{
+		DirectX::XMFLOAT3 center;
+		DirectX::XMFLOAT3 extents;
+		DirectX::XMFLOAT3 axes[3];
+	};
+
     class CollectorBVData
     {
         const float INF_PLUS = 3.40282e+37;
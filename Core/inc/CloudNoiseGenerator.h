@@ -0,0 +1,25 @@
+#pragma once
+
+#include <DirectXTex.h>
+
+#include <cstdint>
+
+namespace dx12demo::core
+{
+    /* Procedural cloud noise volumes, an alternative to the slice images of the VolumetricClouds textures.
+    *  The low frequency volume stores Perlin-Worley noise in R and Worley fBm of increasing frequencies in GBA,
+    *  the high frequency one Worley fBm of increasing frequencies in RGB. Every noise wraps at the volume size.
+    *  4 texels of a row are evaluated at a time with DirectXMath (the lattice hashes are per lane),
+    *  the depth slices are generated on the ThreadPool.
+    */
+    class CloudNoiseGenerator
+    {
+    public:
+        static constexpr uint32_t DEFAULT_LOW_FREQUENCY_SIZE = 128;
+        static constexpr uint32_t DEFAULT_HIGH_FREQUENCY_SIZE = 32;
+
+        // R8G8B8A8_UNORM volumes of size^3 with the full mip chain, size a multiple of 4.
+        static void GenerateLowFrequency(uint32_t size, DirectX::ScratchImage& volume);
+        static void GenerateHighFrequency(uint32_t size, DirectX::ScratchImage& volume);
+    };
+}
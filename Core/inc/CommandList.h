@@ -1,6 +1,7 @@
 #pragma once
 
 #include <URootObject.h>
+#include <CommandListStatistics.h>
 #include "TextureUsage.h"
 
 #include <d3d12.h>
@@ -12,6 +13,12 @@
 #include <vector> // for std::vector
 #include <cassert>
 
+namespace DirectX
+{
+    struct TexMetadata;
+    class ScratchImage;
+}
+
 namespace dx12demo::core
 {
     class Buffer;
@@ -27,6 +34,8 @@ namespace dx12demo::core
     class StructuredBuffer;
     class RootSignature;
     class Texture;
+    class TextureCache;
+    class TextureDecodeRequest;
     class UploadBuffer;
     class VertexBuffer;
     class Scene;
@@ -135,13 +144,41 @@ namespace dx12demo::core
             CopyStructuredBuffer(structuredBuffer, 1, sizeof(T), &bufferData);
         }
 
+        /**
+         * Copy the contents to a part of an existing buffer in GPU memory.
+         * The rest of the buffer contents is kept, the buffer views are not changed.
+         */
+        void CopyBufferRegion(Buffer& buffer, size_t dstOffset, size_t numBytes, const void* bufferData);
+
         /**
          * Set the current primitive topology for the rendering pipeline.
          */
         void SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY primitiveTopology);
 
+        // Decodes the file on the TextureDecoder workers and waits for it, unless the texture is cached.
         void LoadTextureFromFile(Texture& texture, const std::wstring& fileName, TextureUsage textureUsage = TextureUsage::Albedo);
 
+        /**
+         * Start decoding the file on the TextureDecoder workers, requests for the same file share one decode.
+         * @returns nullptr if the texture is already cached. Throws if the file doesn't exist.
+         */
+        static std::shared_ptr<TextureDecodeRequest> RequestTexture(const std::wstring& fileName, TextureUsage textureUsage = TextureUsage::Albedo);
+
+        // The textures loaded from files, shared by all the command lists.
+        static TextureCache& GetTextureCache();
+
+        /**
+         * Upload a texture requested with RequestTexture, without blocking on the decode.
+         * @returns false while the request is decoding, the texture is then unchanged. Throws if the decode failed.
+         */
+        bool LoadTextureFromRequest(Texture& texture, const std::wstring& fileName, const std::shared_ptr<TextureDecodeRequest>& request, TextureUsage textureUsage = TextureUsage::Albedo);
+
+        /**
+         * Upload an image decoded with TextureDecoder::LoadFile, fileName is the texture cache key.
+         * Lets the file decode run on a worker thread and only the upload on the thread recording the command list.
+         */
+        void LoadTextureFromImage(Texture& texture, const std::wstring& fileName, const DirectX::ScratchImage& scratchImage, TextureUsage textureUsage = TextureUsage::Albedo);
+
         struct Create3DTextureBuildData
         {
             std::string folderPath = "";
@@ -158,6 +195,10 @@ namespace dx12demo::core
             DXGI_FORMAT  format = DXGI_FORMAT_UNKNOWN;
         };
 
+        /**
+         * Create a volume texture from the slices folderPath + textureBaseName + "(z)" + fileExtensionBaseName, z from 1.
+         * The slices are decoded in parallel by VolumeTextureLoader, which caches the volume and its mips as one DDS file.
+         */
         void Create3DTextureFromMany2DTextures(Texture& texture, const Create3DTextureBuildData& buildData, TextureUsage textureUsage = TextureUsage::Albedo);
 
         void LoadSceneFromFile(Scene& scene, const std::wstring& filname);
@@ -354,6 +395,9 @@ namespace dx12demo::core
 
         void ReleaseTrackedObjects();
 
+        // State calls issued and elided since the last Reset.
+        const CommandListStatistics& GetStatistics() const;
+
         void SetStencilRef(UINT StencilRef);
 
     protected:
@@ -370,6 +414,16 @@ namespace dx12demo::core
 
         void BindDescriptorHeaps();
 
+        // Forget the shadowed pipeline state, the next state calls are always recorded.
+        void ResetStateCache();
+
+        // Count the call, returns false if the same value is already set.
+        bool UpdateStateCache(bool redundant, CommandListStatistics::StateCall stateCall);
+
+        // Returns false if the texture isn't in the cache.
+        bool SetCachedTexture(Texture& texture, const std::wstring& fileName, TextureUsage textureUsage);
+        void UploadTexture(Texture& texture, const std::wstring& fileName, const DirectX::ScratchImage& scratchImage, TextureUsage textureUsage);
+
     private:
 
         // Resource state tracker is used by the command list to track (per command list)
@@ -404,13 +458,49 @@ namespace dx12demo::core
         // signature changes.
         ID3D12RootSignature* m_RootSignature;
 
+        // Shadow of the state set on the D3D12 command list, redundant calls are not recorded.
+        // The root signatures are tracked per pipeline, m_RootSignature is the one parsed by the dynamic descriptor heaps.
+        enum RootSignatureType
+        {
+            GraphicsRoot,
+            ComputeRoot,
+            NumRootTypes
+        };
+
+        // Max root signature size is 64 DWORDs, so there are at most 64 root parameters.
+        static const uint32_t MAX_ROOT_PARAMETERS = 64;
+
+        // Value of a root constants or root descriptor parameter.
+        struct RootArgument
+        {
+            bool IsSet = false;
+            D3D12_GPU_VIRTUAL_ADDRESS Address = 0;
+            // Contents of the dynamic buffers in the upload buffer, valid until the command list is reset.
+            const void* Data = nullptr;
+            size_t SizeInBytes = 0;
+            std::vector<uint32_t> Constants;
+        };
+
+        // Set a dynamic constant or structured buffer unless the same contents are already bound to the parameter.
+        void SetDynamicRootView(RootSignatureType rootType, uint32_t rootParameterIndex, size_t sizeInBytes, const void* bufferData,
+            size_t alignment, bool constantBuffer);
+        void SetRoot32BitConstants(RootSignatureType rootType, uint32_t rootParameterIndex, uint32_t numConstants, const void* constants);
+
+        D3D_PRIMITIVE_TOPOLOGY m_PrimitiveTopology;
+        D3D12_VERTEX_BUFFER_VIEW m_VertexBufferViews[D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+        D3D12_INDEX_BUFFER_VIEW m_IndexBufferView;
+        ID3D12PipelineState* m_PipelineState;
+        ID3D12RootSignature* m_BoundRootSignatures[NumRootTypes];
+        RootArgument m_RootArguments[NumRootTypes][MAX_ROOT_PARAMETERS];
+
+        CommandListStatistics m_Statistics;
+
         using TrackedObjects = std::vector < Microsoft::WRL::ComPtr<ID3D12Object> >;
 
         TrackedObjects m_TrackedObjects;
 
         // Keep track of loaded textures to avoid loading the same texture multiple times.
-        static std::map<std::wstring, ID3D12Resource* > ms_TextureCache;
-        static std::mutex ms_TextureCacheMutex;
+        static TextureCache ms_TextureCache;
 
         // Pipeline state object for Mip map generation.
         std::unique_ptr<GenerateMipsPSO> m_GenerateMipsPSO;
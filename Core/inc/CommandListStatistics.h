@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+namespace dx12demo::core
+{
+    // Pipeline state calls recorded to the D3D12 command lists vs. calls dropped as redundant.
+    struct CommandListStatistics
+    {
+        enum StateCall
+        {
+            PrimitiveTopology,
+            VertexBuffer,
+            IndexBuffer,
+            PipelineState,
+            RootSignature,
+            RootArgument,
+            NumStateCalls
+        };
+
+        uint32_t Issued[NumStateCalls] = {};
+        uint32_t Elided[NumStateCalls] = {};
+
+        uint32_t GetIssued() const
+        {
+            uint32_t count = 0;
+            for (uint32_t i = 0; i < NumStateCalls; ++i)
+                count += Issued[i];
+            return count;
+        }
+
+        uint32_t GetElided() const
+        {
+            uint32_t count = 0;
+            for (uint32_t i = 0; i < NumStateCalls; ++i)
+                count += Elided[i];
+            return count;
+        }
+
+        CommandListStatistics& operator+=(const CommandListStatistics& other)
+        {
+            for (uint32_t i = 0; i < NumStateCalls; ++i)
+            {
+                Issued[i] += other.Issued[i];
+                Elided[i] += other.Elided[i];
+            }
+            return *this;
+        }
+    };
+}
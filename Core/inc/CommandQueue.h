@@ -2,6 +2,7 @@
 
 #include <URootObject.h>
 #include <ThreadSafeQueue.h>
+#include <CommandListStatistics.h>
 
 #include <d3d12.h>  // For ID3D12CommandQueue, ID3D12Device2, and ID3D12Fence
 #include <wrl.h>    // For Microsoft::WRL::ComPtr
@@ -41,6 +42,9 @@ namespace dx12demo::core
 
         Microsoft::WRL::ComPtr<ID3D12CommandQueue> GetD3D12CommandQueue() const;
 
+        // Return the state call counters of the command lists executed since the last call and reset them.
+        CommandListStatistics ResetStatistics();
+
     private:
 
         // Free any command lists that are finished processing on the command queue.
@@ -61,5 +65,8 @@ namespace dx12demo::core
         std::atomic_bool m_bProcessInFlightCommandLists;
         std::mutex m_ProcessInFlightCommandListsThreadMutex;
         std::condition_variable m_ProcessInFlightCommandListsThreadCV;
+
+        CommandListStatistics m_Statistics;
+        std::mutex m_StatisticsMutex;
     };
 }
\ No newline at end of file
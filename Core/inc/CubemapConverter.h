@@ -0,0 +1,59 @@
+#pragma once
+
+#include <DirectXTex.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dx12demo::core
+{
+    /* CPU equirectangular panorama to cubemap conversion, the counterpart of the PanoToCubemap_CS compute shader.
+    *  Same face orientation, texel to direction mapping and bilinear repeat sampling of the panorama mip of the same level,
+    *  so the result matches the GPU one and can be used to check the shader.
+    *  The directions and panorama coordinates of 4 texels are computed at a time with DirectXMath,
+    *  the bands of rows of every face and mip are converted on the ThreadPool.
+    *  Load caches the cubemap as DDS next to the panorama, the later loads skip the decode and the conversion.
+    */
+    class CubemapConverter
+    {
+    public:
+        // Face coordinates (s, t, 1) to direction, the RotateUV matrices of PanoToCubemap_CS (row major, +X -X +Y -Y +Z -Z).
+        static constexpr float FACE_BASIS[6][9] = {
+            {  0,  0,  1,   0, -1,  0,  -1,  0,  0 },
+            {  0,  0, -1,   0, -1,  0,   1,  0,  0 },
+            {  1,  0,  0,   0,  0,  1,   0,  1,  0 },
+            {  1,  0,  0,   0,  0, -1,   0, -1,  0 },
+            {  1,  0,  0,   0, -1,  0,   0,  0,  1 },
+            { -1,  0,  0,   0, -1,  0,   0,  0, -1 },
+        };
+
+        // Rows FirstRow to FirstRow + the band height of a face mip, the job of the passes over a cubemap on the ThreadPool.
+        struct Band
+        {
+            uint32_t Mip;
+            uint32_t Face;
+            uint32_t FirstRow;
+        };
+
+        // The bands of every face of every mip, the last band of a face shorter if its size isn't a multiple of bandHeight.
+        static std::vector<Band> GetBands(uint32_t cubemapSize, uint32_t mipCount, uint32_t bandHeight);
+
+        // Mips of the cubemap, the full chain if mipLevels is 0.
+        static uint32_t GetMipCount(uint32_t cubemapSize, uint32_t mipLevels);
+
+        /**
+         * Convert the panorama (a 2D image, converted to R32G32B32A32_FLOAT and its mips generated if it has none)
+         * to a R32G32B32A32_FLOAT cubemap with mipLevels mips, the full chain if 0.
+         */
+        static void Convert(const DirectX::ScratchImage& panorama, uint32_t cubemapSize, uint32_t mipLevels, DirectX::ScratchImage& cubemap);
+
+        static std::wstring GetCachePath(const std::wstring& panoramaFileName, uint32_t cubemapSize);
+
+        /**
+         * Load the cached cubemap of the panorama, converting it first if the cache is missing, older than the panorama or of other mips.
+         * The cubemap is packed to the HDR storage format (HDRDecoder::SetStorageFormat). Throws if the panorama can't be decoded.
+         */
+        static void Load(const std::wstring& panoramaFileName, uint32_t cubemapSize, uint32_t mipLevels, DirectX::ScratchImage& cubemap);
+    };
+}
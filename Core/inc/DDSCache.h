@@ -0,0 +1,24 @@
+#pragma once
+
+#include <DirectXTex.h>
+
+#include <string>
+#include <vector>
+
+namespace dx12demo::core
+{
+    /* DDS files caching the processed version of a source file next to it: the cooked textures, the cubemaps,
+    *  the environment bakes and the assembled volumes. A cache is stale once a source is newer.
+    */
+    class DDSCache
+    {
+    public:
+        // The cache exists and was written after the last change of the source.
+        static bool IsValid(const std::wstring& sourceFileName, const std::wstring& cachePath);
+        // Of several sources, e.g. the slices of a volume.
+        static bool IsValid(const std::vector<std::string>& sourceFileNames, const std::wstring& cachePath);
+
+        // Written to a temporary file renamed over the cache, the readers never see a partial file. Returns false if it can't be written.
+        static bool Write(const std::wstring& cachePath, const DirectX::ScratchImage& scratchImage);
+    };
+}
@@ -16,6 +16,9 @@ namespace dx12demo::core
 		int bufferH;
 		D3D_ROOT_SIGNATURE_VERSION rootSignatureVersion;
 
+		// Draw the scenes loaded with packVertices, PackedVertex::InputElementsPackedInstanced and DepthBufferPacked_VS.
+		bool packedVertices = false;
+
 		bool bUseCustomDepthBufferDesc = false;
 
 		D3D12_RESOURCE_DESC resDesc;
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <DirectXTex.h>
+
+#include <cstdint>
+#include <string>
+
+namespace dx12demo::core
+{
+    /* The diffuse lighting of an environment: its radiance projected on the 9 SH basis functions of the bands 0 to 2,
+    *  convolved with the clamped cosine and divided by pi. Evaluated for a normal (EvaluateSHIrradiance in
+    *  SphericalHarmonicsInclude.hlsl), it is multiplied by the albedo. RGB in xyz, w is padding for the constant buffer layout.
+    */
+    struct SHIrradiance
+    {
+        DirectX::XMFLOAT4 Coefficients[9];
+    };
+
+    /* CPU baking of the image based lighting of an environment cubemap (R32G32B32A32_FLOAT, CubemapConverter):
+    *  - the SH irradiance, the texels of a face and their basis functions weighted by the solid angle, 4 texels at a time
+    *    with DirectXMath, the faces summed in parallel;
+    *  - the GGX prefiltered cubemap of the split sum approximation, the roughness of a mip is mip / (mips - 1),
+    *    importance sampled with N = V and the source mip chosen by the sample pdf to avoid the noise of the bright texels;
+    *  - the BRDF lookup table of the split sum, the scale and bias of F0 by N.V (u) and roughness (v).
+    *  The texels are computed in bands on the ThreadPool. Load and LoadBRDF cache the results as DDS files.
+    */
+    class EnvironmentBaker
+    {
+    public:
+        static constexpr uint32_t DEFAULT_PREFILTERED_SIZE = 256;
+        static constexpr uint32_t DEFAULT_PREFILTERED_MIPS = 6;
+        static constexpr uint32_t DEFAULT_SAMPLE_COUNT = 128;
+        static constexpr uint32_t DEFAULT_BRDF_SIZE = 128;
+        static constexpr uint32_t DEFAULT_BRDF_SAMPLE_COUNT = 1024;
+
+        // Throws if the cubemap isn't a R32G32B32A32_FLOAT cubemap.
+        static SHIrradiance ProjectSH(const DirectX::ScratchImage& cubemap);
+
+        // The CPU counterpart of EvaluateSHIrradiance, normal must be normalized.
+        static DirectX::XMVECTOR EvaluateSH(const SHIrradiance& irradiance, DirectX::FXMVECTOR normal);
+
+        static float GetRoughness(uint32_t mip, uint32_t mipLevels);
+
+        // R32G32B32A32_FLOAT cubemap of size with mipLevels mips. Throws if the cubemap isn't a R32G32B32A32_FLOAT cubemap.
+        static void Prefilter(const DirectX::ScratchImage& cubemap, uint32_t size, uint32_t mipLevels, uint32_t sampleCount, DirectX::ScratchImage& prefiltered);
+
+        // R32G32_FLOAT size x size table, (scale, bias) of F0.
+        static void BakeBRDF(uint32_t size, uint32_t sampleCount, DirectX::ScratchImage& lut);
+
+        /**
+         * Load the SH irradiance and the prefiltered cubemap of the panorama, cached next to it, baking them first from its cubemap
+         * (CubemapConverter::Load, of any format DirectXTex converts to float) if the caches are missing, older than the panorama or of another size.
+         */
+        static void Load(const std::wstring& panoramaFileName, const DirectX::ScratchImage& cubemap, SHIrradiance& irradiance, DirectX::ScratchImage& prefiltered,
+            uint32_t prefilteredSize = DEFAULT_PREFILTERED_SIZE, uint32_t prefilteredMips = DEFAULT_PREFILTERED_MIPS);
+
+        // Load the BRDF table from fileName, baking it first if the file is missing or of another size.
+        static void LoadBRDF(const std::wstring& fileName, DirectX::ScratchImage& lut, uint32_t size = DEFAULT_BRDF_SIZE);
+    };
+}
@@ -7,6 +7,7 @@
 #include <Texture.h>
 #include <Mesh.h>
 #include <Camera.h>
+#include <EnvironmentBaker.h>
 
 #include <string>
 #include <memory>
@@ -29,6 +30,11 @@ namespace dx12demo::core
 		int16_t cubeMapDepthOrArraySize = 0;
 		int16_t cubeMapMipLevels = 0;
 
+		// Convert the panorama on the CPU and cache the cubemap (CubemapConverter), else PanoToCubemap on the GPU every load.
+		bool cpuConversion = true;
+		// Bake the SH irradiance, the GGX prefiltered cubemap and the BRDF table (EnvironmentBaker), needs cpuConversion.
+		bool bakeLighting = false;
+
 		D3D12_RT_FORMAT_ARRAY rtvFormats;
 		D3D_ROOT_SIGNATURE_VERSION rootSignatureVersion;
 	};
@@ -47,6 +53,13 @@ namespace dx12demo::core
 
 		virtual void OnRender(std::shared_ptr<CommandList>&, RenderEventArgs& e) override;
 
+		// Baked if bakeLighting was set, the SH constants replace a diffuse cubemap (SphericalHarmonicsInclude.hlsl).
+		const SHIrradiance& GetIrradiance() const;
+		const Texture& GetPrefilteredTexture() const;
+		// The TextureCube view of the prefiltered texture.
+		const D3D12_SHADER_RESOURCE_VIEW_DESC& GetPrefilteredSRV() const;
+		const Texture& GetBRDFTexture() const;
+
 	protected:
 
 		std::unique_ptr<Mesh> m_SkyboxMesh;
@@ -57,6 +70,11 @@ namespace dx12demo::core
 		Texture m_SrcTexture;
 		Texture m_CubemapTexture;
 
+		SHIrradiance m_Irradiance = {};
+		Texture m_PrefilteredTexture;
+		D3D12_SHADER_RESOURCE_VIEW_DESC m_PrefilteredSrvDesc = {};
+		Texture m_BRDFTexture;
+
 		Camera* m_Camera = nullptr;
 
 		DirectX::XMMATRIX m_ViewProjMatrix;
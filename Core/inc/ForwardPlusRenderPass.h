@@ -2,11 +2,13 @@
 
 #include <RenderPassBase.h>
 #include <RootSignature.h>
+#include <DirectXMath.h>
 
 namespace dx12demo::core
 {
 	class Texture;
 	class StructuredBuffer;
+	struct SHIrradiance;
 
 	struct ForwardPlusRenderPassInfo : public RenderPassBaseInfo
 	{
@@ -18,6 +20,12 @@ namespace dx12demo::core
 		DXGI_FORMAT depthBufferFormat;
 		D3D_ROOT_SIGNATURE_VERSION rootSignatureVersion;
 
+		// Draw the scenes loaded with packVertices, PackedVertex::InputElementsPackedInstanced and ForwardPlusPacked_VS.
+		bool packedVertices = false;
+
+		// The baked environment lighting (AttachEnvironmentLighting): the roughness of its split sum specular and its scale.
+		float environmentRoughness = 0.5f;
+		float environmentIntensity = 0.1f;
 	};
 
 	class ForwardPlusRenderPass : public RenderPassBase
@@ -45,9 +53,16 @@ namespace dx12demo::core
 		void AttachLightsSB(std::shared_ptr<CommandList>& commandList, const StructuredBuffer& sb);
 		void AttachLightIndexListSB(std::shared_ptr<CommandList>& commandList, const StructuredBuffer& sb);
 
+		// The lighting baked by EnvironmentMapRenderPass, in world space, the inverse view matrix brings the view space normals to it.
+		void AttachEnvironmentLighting(std::shared_ptr<CommandList>& commandList, const DirectX::XMMATRIX& inverseViewMatrix, const SHIrradiance& irradiance,
+			const Texture& prefilteredTex, const D3D12_SHADER_RESOURCE_VIEW_DESC* prefilteredSrv, const Texture& brdfTex);
+
 	private:
 
 		RootSignature m_RootSignature;
 		Microsoft::WRL::ComPtr<ID3D12PipelineState> m_PipelineState;
+
+		float m_EnvironmentRoughness = 0.5f;
+		float m_EnvironmentIntensity = 0.1f;
 	};
 }
\ No newline at end of file
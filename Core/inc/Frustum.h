@@ -21,6 +21,7 @@ namespace dx12demo::core
 
 	struct BSphere;
 	struct BAABB;
+	struct BOBB;
 	class Frustum : public URootObject
 	{
 	public:
@@ -41,6 +42,8 @@ namespace dx12demo::core
 
 		static bool FrustumInAABB(const BAABB& aabb_data, const std::array<DirectX::XMFLOAT4, 6>& planes);
 
+		static bool FrustumInOBB(const BOBB& obb_data, const std::array<DirectX::XMFLOAT4, 6>& planes);
+
 		static void SSECullingSpheres(std::vector<BSphere>& sphere_data, std::vector<int>& culling_res, const std::array<DirectX::XMVECTOR, 6>& planes);
 
 	private:
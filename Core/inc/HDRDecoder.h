@@ -0,0 +1,37 @@
+#pragma once
+
+#include <DirectXTex.h>
+
+#include <string>
+
+namespace dx12demo::core
+{
+    /* Radiance RGBE (.hdr) decoding without the per texel work of LoadFromHDRFile.
+    *  A first pass over the mapped file finds where every RLE scanline starts, the scanlines are then decoded in bands
+    *  on the ThreadPool and converted to float with DirectXMath, 4 bytes to a vector scaled by the exponent.
+    *  The HDR images can be stored in a compact format: R11G11B10_FLOAT, R9G9B9E5_SHAREDEXP (4 bytes per texel)
+    *  or BC6H_UF16 (1 byte), instead of the 16 bytes of R32G32B32A32_FLOAT.
+    */
+    class HDRDecoder
+    {
+    public:
+        /**
+         * Decode a 32-bit_rle_rgbe file of the standard -Y +X orientation, new RLE or flat scanlines, to R32G32B32A32_FLOAT.
+         * @returns false if the file can't be read or is of another layout, LoadFromHDRFile reads the rest.
+         */
+        static bool Decode(const std::wstring& fileName, DirectX::TexMetadata& metadata, DirectX::ScratchImage& scratchImage);
+
+        // R32G32B32A32_FLOAT (the default), R11G11B10_FLOAT, R9G9B9E5_SHAREDEXP or BC6H_UF16.
+        static bool IsStorageFormat(DXGI_FORMAT format);
+
+        // The format TextureDecoder::LoadFile and CubemapConverter::Load return the HDR images in.
+        static void SetStorageFormat(DXGI_FORMAT format);
+        static DXGI_FORMAT GetStorageFormat();
+
+        /**
+         * Pack every image of the R32G32B32A32_FLOAT source to a storage format, in parallel.
+         * BC6H needs a top level multiple of 4, the other sizes are packed to R9G9B9E5_SHAREDEXP.
+         */
+        static void Pack(const DirectX::ScratchImage& source, DXGI_FORMAT format, DirectX::ScratchImage& packed);
+    };
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dx12demo::core
+{
+    /* Read-only memory mapping of a whole file.
+    *  The pages are loaded by the OS on the first access, so opening is cheap for any file size.
+    */
+    class MappedFile
+    {
+    public:
+        MappedFile();
+        virtual ~MappedFile();
+
+        MappedFile(const MappedFile& copy) = delete;
+        MappedFile& operator=(const MappedFile& other) = delete;
+
+        // @returns false if the file can't be opened. An empty file is opened with GetData() == nullptr.
+        bool Open(const std::wstring& fileName);
+        void Close();
+
+        bool IsOpen() const;
+
+        const uint8_t* GetData() const;
+        size_t GetSize() const;
+
+    private:
+        HANDLE m_File = INVALID_HANDLE_VALUE;
+        HANDLE m_Mapping = nullptr;
+        const uint8_t* m_Data = nullptr;
+        size_t m_Size = 0;
+    };
+}
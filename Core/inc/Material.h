@@ -23,6 +23,12 @@ namespace dx12demo::core
 		const Texture& GetSpecularTex() const;
 		const Texture& GetNormalTex() const;
 
+		// Replace a texture, e.g. a placeholder by the streamed one.
+		void SetDiffuseTex(const Texture& texture);
+		void SetAmbientTex(const Texture& texture);
+		void SetSpecularTex(const Texture& texture);
+		void SetNormalTex(const Texture& texture);
+
 	private:
 
 		Texture m_diffuse;
@@ -3,6 +3,7 @@
 #include <CommandList.h>
 #include <VertexBuffer.h>
 #include <IndexBuffer.h>
+#include <MeshPool.h>
 #include <BoundingVolumesPrimitive.h>
 
 #include <DirectXMath.h>
@@ -10,6 +11,7 @@
 
 #include <wrl.h>
 
+#include <array>
 #include <memory> // For std::unique_ptr
 #include <vector>
 #include <unordered_map>
@@ -103,20 +105,86 @@ namespace dx12demo::core
 
         static const int InputElementCountExtended = 5;
         static const D3D12_INPUT_ELEMENT_DESC InputElementsExtended[InputElementCountExtended];
+
+        // InputElementsExtended and the instance world transform rows INSTANCE_TRANSFORM0-3 in the slot 1 (a DirectX::XMFLOAT4X4 per instance).
+        static const int InputElementCountExtendedInstanced = 9;
+        static const D3D12_INPUT_ELEMENT_DESC InputElementsExtendedInstanced[InputElementCountExtendedInstanced];
     };
 
+    /* Compressed PosNormTexExtendedVertex, 20 bytes instead of 56 (see VertexPacker).
+    *  Position is quantized in the mesh AABB, its w holds the bitangent sign.
+    *  Normal and tangent are octahedral encoded, bitangent = cross(normal, tangent) * sign.
+    *  Shaders decode it with shaders/PackedVertexInclude.hlsl, a draw needs the PackedVertexDequantization of its mesh
+    *  (VertexPacker::GetDequantization of GetPackedBounds), Scene::Render binds it.
+    */
+    struct PackedVertex
+    {
+        uint16_t m_position[4];
+        int16_t m_normal[2];
+        int16_t m_tangent[2];
+        uint16_t m_texCoord[2];
+
+        static const int InputElementCountPacked = 4;
+        static const D3D12_INPUT_ELEMENT_DESC InputElementsPacked[InputElementCountPacked];
+
+        // InputElementsPacked and the instance world transform rows, as PosNormTexExtendedVertex::InputElementsExtendedInstanced.
+        static const int InputElementCountPackedInstanced = 8;
+        static const D3D12_INPUT_ELEMENT_DESC InputElementsPackedInstanced[InputElementCountPackedInstanced];
+    };
+
+    static_assert(sizeof(PackedVertex) == 20, "PackedVertex must be tightly packed");
+
     using VertexCollection = std::vector<PosNormTexVertex>;
     using VertexExtendedCollection = std::vector<PosNormTexExtendedVertex>;
+    using PackedVertexCollection = std::vector<PackedVertex>;
     using IndexCollection = std::vector<uint16_t>;
 
-    struct MeshCreatorInfo
+    // Simplified levels of a mesh, their indices reference the vertices of the full detail level.
+    struct MeshLodChain
     {
-        DirectX::XMFLOAT3 bv_pos;
-        DirectX::XMFLOAT3 bv_min_pos;
-        DirectX::XMFLOAT3 bv_max_pos;
+        std::vector<IndexCollection> Indices;
+        // Geometric error of every level in the mesh units.
+        std::vector<float> Errors;
+    };
 
+    struct MeshCreatorInfo
+    {
         unsigned int scale = 1;
         bool rhcoords = false;
+
+        // Optional, see MeshSimplifier::BuildLodChain.
+        MeshLodChain lods;
+
+        // Upload PackedVertex instead of PosNormTexExtendedVertex, the PSO must use PackedVertex::InputElementsPacked.
+        bool packVertices = false;
+
+        // Optional, sub-allocate the geometry from the pool instead of creating own vertex and index buffers.
+        std::shared_ptr<MeshPool> pool;
+
+        // Minimal bounding sphere (Welzl) instead of the Ritter approximation.
+        bool exactBoundingSphere = false;
+
+        // Merge the duplicate vertices with VertexWelder before the optimization. Ignored with lods, their indices would need the remap.
+        bool weldVertices = false;
+    };
+
+    // Post-transform vertex cache statistics of an index buffer.
+    struct VertexCacheStatistics
+    {
+        uint32_t VerticesTransformed = 0;
+        uint32_t TriangleCount = 0;
+        uint32_t VertexCount = 0;
+
+        // Average cache miss ratio: transformed vertices per triangle (0.5 is the ideal, 3.0 is the worst).
+        float ACMR = 0.f;
+        // Average transformed vertex ratio: transformed vertices per referenced vertex (1.0 is the ideal).
+        float ATVR = 0.f;
+    };
+
+    struct MeshOptimizerReport
+    {
+        VertexCacheStatistics Before;
+        VertexCacheStatistics After;
     };
 
     struct SubMesh
@@ -126,6 +194,31 @@ namespace dx12demo::core
         INT BaseVertexLocation = 0;
     };
 
+    // Level of detail range in the mesh index buffer.
+    struct MeshLod
+    {
+        SubMesh Range;
+        // Geometric error in the mesh units, 0 for the full detail level.
+        float Error = 0.f;
+    };
+
+    // Cluster of triangles which occupies a contiguous range of the mesh index buffer.
+    struct Meshlet
+    {
+        UINT StartIndexLocation = 0;
+        UINT IndexCount = 0;
+        uint32_t VertexCount = 0;
+
+        BSphere bsphere;
+
+        // Backface normal cone: the whole cluster is backfacing
+        // if dot(normalize(coneApex - cameraPos), coneAxis) >= coneCutoff.
+        DirectX::XMFLOAT3 coneApex = { 0.f, 0.f, 0.f };
+        DirectX::XMFLOAT3 coneAxis = { 0.f, 0.f, 0.f };
+        // 1 means the cone is too wide to be used for culling.
+        float coneCutoff = 1.f;
+    };
+
     class Mesh
     {
     public:
@@ -133,23 +226,66 @@ namespace dx12demo::core
         void Render(std::shared_ptr<CommandList>& commandList, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
         void RenderSubMesh(std::shared_ptr<CommandList>& commandList, uint16_t indexSubMesh, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
 
+        /* Draw only the meshlets which pass the frustum test and (if cameraPosition is set) the backface cone test.
+        *  Adjacent visible meshlets are merged in one draw.
+        *  Cone culling assumes clockwise front faces, don't use it for the meshes rendered without backface culling.
+        *  @returns the number of submitted triangles.
+        */
+        uint32_t RenderClusters(std::shared_ptr<CommandList>& commandList, const std::array<DirectX::XMFLOAT4, 6>& frustumPlanes, const DirectX::XMFLOAT3* cameraPosition = nullptr, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+
+        void RenderLod(std::shared_ptr<CommandList>& commandList, uint32_t lod, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+
+        /* Pick the coarsest level which error projected on the screen is below maxPixelError.
+        *  projectionScale - viewport height / (2 * tan(fovY / 2)).
+        *  distance - from the camera to the mesh bounding sphere.
+        */
+        uint32_t SelectLod(float distance, float projectionScale, float maxPixelError = 1.f) const;
+
         static std::unique_ptr<Mesh> CreateCustomMesh(CommandList& commandList, VertexExtendedCollection& vertices, IndexCollection& indices, MeshCreatorInfo& info);
         static std::unique_ptr<Mesh> CreateCustomMesh(CommandList& commandList, VertexCollection& vertices, IndexCollection& indices, MeshCreatorInfo& info);
-        static std::unique_ptr<Mesh> CreateCustomMesh(CommandList& commandList, VertexCollection& vertices, IndexCollection& indices, bool rhcoords = false);
-        static std::unique_ptr<Mesh> CreateCustomMesh(CommandList& commandList, VertexExtendedCollection& vertices, IndexCollection& indices, bool rhcoords = false);
+        // Pass optimize = false to keep the triangle order, e.g. when index ranges are pushed as submeshes later.
+        static std::unique_ptr<Mesh> CreateCustomMesh(CommandList& commandList, VertexCollection& vertices, IndexCollection& indices, bool rhcoords = false, bool optimize = true);
+        static std::unique_ptr<Mesh> CreateCustomMesh(CommandList& commandList, VertexExtendedCollection& vertices, IndexCollection& indices, bool rhcoords = false, bool optimize = true);
         static std::unique_ptr<Mesh> CreateCube(CommandList& commandList, float size = 1, bool rhcoords = false);
-        static std::unique_ptr<Mesh> CreateSphere(CommandList& commandList, float diameter = 1, size_t tessellation = 16, bool rhcoords = false);
+        // tangents = true builds PosNormTexExtendedVertex geometry with the generated tangent frame, for the normal mapped materials.
+        static std::unique_ptr<Mesh> CreateSphere(CommandList& commandList, float diameter = 1, size_t tessellation = 16, bool rhcoords = false, bool tangents = false);
         static std::unique_ptr<Mesh> CreateCone(CommandList& commandList, float diameter = 1, float height = 1, size_t tessellation = 32, bool rhcoords = false);
-        static std::unique_ptr<Mesh> CreateTorus(CommandList& commandList, float diameter = 1, float thickness = 0.333f, size_t tessellation = 32, bool rhcoords = false);
+        static std::unique_ptr<Mesh> CreateTorus(CommandList& commandList, float diameter = 1, float thickness = 0.333f, size_t tessellation = 32, bool rhcoords = false, bool tangents = false);
         static std::unique_ptr<Mesh> CreatePlane(CommandList& commandList, float width = 1, float height = 1, bool rhcoords = false);
         static std::unique_ptr<Mesh> CreateQuad(CommandList& commandList, float x, float y, float w, float h, float depth, bool rhcoords = false);
         static std::unique_ptr<Mesh> CreateSkyPlane(CommandList& commandList, int skyPlaneResolution = 10, float skyPlaneWidth = 10.f, float skyPlaneTop = 0.5f, float skyPlaneBottom = 0.f, int textureRepeat = 4, bool rhcoords = false);
 
+        // The bounding volumes are fitted to the vertices when the mesh is created.
         const BSphere& GetBSphere() const;
         const BAABB& GetBAABB() const;
+        const BOBB& GetBOBB() const;
+
+        const MeshOptimizerReport& GetOptimizerReport() const;
+
+        const std::vector<Meshlet>& GetMeshlets() const;
+
+        UINT GetIndexCount() const;
+
+        // The vertex buffer holds PackedVertex, positions are quantized in GetPackedBounds().
+        bool IsPacked() const;
+        const BAABB& GetPackedBounds() const;
+
+        // Level 0 is the full detail mesh.
+        uint32_t GetLodCount() const;
+        const MeshLod& GetLod(uint32_t lod) const;
 
         void PushSubMesh(uint16_t index, SubMesh& submesh);
 
+        // The geometry lives in a MeshPool page, meshes of the same page share the vertex and index buffers.
+        bool IsPooled() const;
+        const MeshPoolAllocation& GetPoolAllocation() const;
+
+        const VertexBuffer& GetVertexBuffer() const;
+        const IndexBuffer& GetIndexBuffer() const;
+
+        // Arguments of the level draw for ExecuteIndirect, the offsets are relative to GetVertexBuffer()/GetIndexBuffer().
+        D3D12_DRAW_INDEXED_ARGUMENTS GetDrawArguments(uint32_t lod = 0, uint32_t instanceCount = 1, uint32_t firstInstance = 0) const;
+
     protected:
 
         void SetBSphere(BSphere& sphere);
@@ -162,18 +298,49 @@ namespace dx12demo::core
         Mesh(const Mesh& copy) = delete;
         virtual ~Mesh();
 
-        void Initialize(CommandList& commandList, VertexCollection& vertices, IndexCollection& indices, bool rhcoords);
-        void Initialize(CommandList& commandList, VertexExtendedCollection& vertices, IndexCollection& indices, bool rhcoords);
+        void Initialize(CommandList& commandList, VertexCollection& vertices, IndexCollection& indices, bool rhcoords, bool optimize = true, MeshLodChain* lods = nullptr,
+            std::shared_ptr<MeshPool> pool = nullptr, bool weld = false);
+        void Initialize(CommandList& commandList, VertexExtendedCollection& vertices, IndexCollection& indices, bool rhcoords, bool optimize = true, MeshLodChain* lods = nullptr,
+            bool packVertices = false, std::shared_ptr<MeshPool> pool = nullptr, bool weld = false);
+        // The tangents are generated for the final winding and texture coordinates.
+        void InitializeWithTangents(CommandList& commandList, VertexCollection& vertices, IndexCollection& indices, bool rhcoords);
+
+        // Append the simplified levels to the index buffer and record all level ranges.
+        void InitializeLods(IndexCollection& indices, MeshLodChain* lods);
+
+        void InitializeBounds(const std::vector<DirectX::XMFLOAT3>& positions);
+
+        // Copy the geometry to the pool if it is set or to the own buffers.
+        void UploadGeometry(CommandList& commandList, size_t vertexCount, size_t vertexStride, const void* vertexData,
+            const IndexCollection& indices, std::shared_ptr<MeshPool> pool);
 
         VertexBuffer m_VertexBuffer;
         IndexBuffer m_IndexBuffer;
 
+        std::shared_ptr<MeshPool> m_MeshPool;
+        MeshPoolAllocation m_PoolAllocation;
+
+        // Offsets of the geometry in the bound buffers, zero for the own buffers.
+        UINT m_StartIndexLocation = 0;
+        INT m_BaseVertexLocation = 0;
+        UINT m_VertexCount = 0;
+
         std::unordered_map<uint16_t, SubMesh> m_SubMeshes;
 
         BSphere m_bsphere;
         BAABB m_baabb;
+        BOBB m_bobb;
 
         UINT m_IndexCount;
 
+        MeshOptimizerReport m_OptimizerReport;
+
+        std::vector<MeshLod> m_Lods;
+
+        bool m_Packed = false;
+        BAABB m_PackedBounds;
+
+        std::vector<Meshlet> m_Meshlets;
+        std::vector<SubMesh> m_VisibleMeshletRanges;
     };
 }
\ No newline at end of file
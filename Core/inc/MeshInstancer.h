@@ -0,0 +1,43 @@
+#pragma once
+
+#include <SceneCache.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace dx12demo::core
+{
+    struct MeshInstancingReport
+    {
+        size_t MeshesBefore = 0;
+        size_t MeshesAfter = 0;
+        // Occurrences of the meshes in the scene, one draw each without instancing.
+        size_t InstanceCount = 0;
+
+        // Vertex and index data.
+        size_t BytesBefore = 0;
+        size_t BytesAfter = 0;
+    };
+
+    /* Finds the scene meshes with the same content and keeps one copy, drawn instanced.
+    *  Meshes are hashed on the worker threads (vertices, indices and material textures),
+    *  the meshes with equal hashes are compared byte for byte before the merge.
+    */
+    class MeshInstancer
+    {
+    public:
+        /**
+         * The duplicates are removed, their occurrences are appended to the Instances of the first mesh with the same content.
+         * Run before the CPU processing, equal input meshes give equal processed ones.
+         */
+        static MeshInstancingReport MergeDuplicates(std::vector<SceneMeshData>& meshes);
+
+        // Stable hash of the vertices, the indices and the textures (FNV-1a).
+        static uint64_t HashMesh(const SceneMeshData& mesh);
+
+    private:
+        static bool IsSameContent(const SceneMeshData& a, const SceneMeshData& b);
+
+        static size_t GetDataSize(const SceneMeshData& mesh);
+    };
+}
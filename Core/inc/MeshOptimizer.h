@@ -0,0 +1,225 @@
+#pragma once
+
+#include <Mesh.h>
+#include <Helpers.h>
+
+#include <DirectXMath.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace dx12demo::core
+{
+    /* CPU mesh optimization stage, run before the geometry is uploaded to the GPU.
+    *  VerticesContainer must have DirectX::XMFLOAT3 m_position;
+    *  see examples in mesh.h struct PosNormTexExtendedVertex and
+    *  struct PosNormTexVertex
+    */
+    class MeshOptimizer
+    {
+    public:
+        // Size of the FIFO cache used to measure ACMR/ATVR (typical for desktop GPUs).
+        static const uint32_t ANALYZE_CACHE_SIZE = 16;
+        // Size of the LRU cache simulated by the Forsyth reordering.
+        static const uint32_t FORSYTH_CACHE_SIZE = 32;
+
+        static VertexCacheStatistics AnalyzeVertexCache(const IndexCollection& indices, size_t vertexCount, uint32_t cacheSize = ANALYZE_CACHE_SIZE);
+
+        // Reorder triangles for the post-transform vertex cache (Tom Forsyth, "Linear-Speed Vertex Cache Optimisation").
+        static void OptimizeVertexCache(IndexCollection& indices, size_t vertexCount);
+
+        /* Reorder clusters of the cache optimized triangles, so the outer facing ones are drawn first
+        *  (Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+        *  threshold - how much the ACMR may grow compared to the cache optimized order (1.05 is 5%).
+        */
+        template<typename VerticesContainer>
+        static void OptimizeOverdraw(IndexCollection& indices, const std::vector<VerticesContainer>& vertices, float threshold = 1.05f);
+
+        // Reorder vertices in the order of the first use in the index buffer. Unreferenced vertices are removed.
+        template<typename VerticesContainer>
+        static void OptimizeVertexFetch(std::vector<VerticesContainer>& vertices, IndexCollection& indices);
+
+        // Run all stages above and return ACMR/ATVR before and after optimization.
+        template<typename VerticesContainer>
+        static MeshOptimizerReport Optimize(std::vector<VerticesContainer>& vertices, IndexCollection& indices);
+
+        // The same for a mesh with the simplified levels which share its vertices. The report is for the full detail level.
+        template<typename VerticesContainer>
+        static MeshOptimizerReport Optimize(std::vector<VerticesContainer>& vertices, IndexCollection& indices, std::vector<IndexCollection>& lodIndices);
+
+    private:
+        // Split the triangle list in clusters which could be reordered without a big ACMR loss.
+        static void BuildClusters(const IndexCollection& indices, size_t vertexCount, float threshold, std::vector<uint32_t>& clusterStarts);
+    };
+
+    template<typename VerticesContainer>
+    void MeshOptimizer::OptimizeOverdraw(IndexCollection& indices, const std::vector<VerticesContainer>& vertices, float threshold/* = 1.05f*/)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount < 2)
+            return;
+
+        std::vector<uint32_t> clusterStarts;
+        BuildClusters(indices, vertices.size(), threshold, clusterStarts);
+
+        const size_t clusterCount = clusterStarts.size();
+        if (clusterCount < 2)
+            return;
+
+        // Area weighted centroid of the whole mesh.
+        DirectX::XMFLOAT3 meshCentroid = { 0.f, 0.f, 0.f };
+        float meshArea = 0.f;
+
+        std::vector<DirectX::XMFLOAT3> clusterCentroid(clusterCount, { 0.f, 0.f, 0.f });
+        std::vector<DirectX::XMFLOAT3> clusterNormal(clusterCount, { 0.f, 0.f, 0.f });
+        std::vector<float> clusterArea(clusterCount, 0.f);
+
+        for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+        {
+            size_t begin = clusterStarts[cluster];
+            size_t end = (cluster + 1 < clusterCount) ? clusterStarts[cluster + 1] : triangleCount;
+
+            for (size_t triangle = begin; triangle < end; ++triangle)
+            {
+                const auto& p0 = vertices[indices[triangle * 3 + 0]].m_position;
+                const auto& p1 = vertices[indices[triangle * 3 + 1]].m_position;
+                const auto& p2 = vertices[indices[triangle * 3 + 2]].m_position;
+
+                DirectX::XMFLOAT3 normal = Math::float3Cross(Math::float3Substruct(p1, p0), Math::float3Substruct(p2, p0));
+                float area = Math::float3Len(normal);
+
+                DirectX::XMFLOAT3 center = p0;
+                Math::float3Add(center, p1);
+                Math::float3Add(center, p2);
+                Math::float3Mult(center, area / 3.f);
+
+                Math::float3Add(clusterCentroid[cluster], center);
+                Math::float3Add(clusterNormal[cluster], normal);
+                clusterArea[cluster] += area;
+            }
+
+            Math::float3Add(meshCentroid, clusterCentroid[cluster]);
+            meshArea += clusterArea[cluster];
+
+            if (clusterArea[cluster] > 0.f)
+                Math::float3Div(clusterCentroid[cluster], clusterArea[cluster]);
+        }
+
+        if (meshArea > 0.f)
+            Math::float3Div(meshCentroid, meshArea);
+
+        // Clusters that face away from the mesh center are likely to occlude the others, so they go first.
+        std::vector<float> sortKey(clusterCount, 0.f);
+        for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+        {
+            float normalLength = Math::float3Len(clusterNormal[cluster]);
+            if (normalLength <= 0.f)
+                continue;
+
+            DirectX::XMFLOAT3 toCluster = Math::float3Substruct(clusterCentroid[cluster], meshCentroid);
+            sortKey[cluster] = Math::float3Dot(toCluster, clusterNormal[cluster]) / normalLength;
+        }
+
+        std::vector<uint32_t> clusterOrder(clusterCount);
+        for (uint32_t cluster = 0; cluster < clusterCount; ++cluster)
+            clusterOrder[cluster] = cluster;
+
+        std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+            [&sortKey](uint32_t a, uint32_t b) { return sortKey[a] > sortKey[b]; });
+
+        IndexCollection result;
+        result.reserve(indices.size());
+
+        for (uint32_t cluster : clusterOrder)
+        {
+            size_t begin = clusterStarts[cluster];
+            size_t end = (cluster + 1 < clusterCount) ? clusterStarts[cluster + 1] : triangleCount;
+
+            result.insert(result.end(), indices.begin() + begin * 3, indices.begin() + end * 3);
+        }
+
+        indices.swap(result);
+    }
+
+    template<typename VerticesContainer>
+    void MeshOptimizer::OptimizeVertexFetch(std::vector<VerticesContainer>& vertices, IndexCollection& indices)
+    {
+        const uint32_t UNUSED = ~0u;
+        std::vector<uint32_t> remap(vertices.size(), UNUSED);
+
+        std::vector<VerticesContainer> result;
+        result.reserve(vertices.size());
+
+        for (auto& index : indices)
+        {
+            uint32_t& newIndex = remap[index];
+            if (newIndex == UNUSED)
+            {
+                newIndex = static_cast<uint32_t>(result.size());
+                result.push_back(vertices[index]);
+            }
+
+            index = static_cast<IndexCollection::value_type>(newIndex);
+        }
+
+        vertices.swap(result);
+    }
+
+    template<typename VerticesContainer>
+    MeshOptimizerReport MeshOptimizer::Optimize(std::vector<VerticesContainer>& vertices, IndexCollection& indices)
+    {
+        MeshOptimizerReport report;
+        report.Before = AnalyzeVertexCache(indices, vertices.size());
+
+        if (indices.size() >= 3 && !vertices.empty())
+        {
+            OptimizeVertexCache(indices, vertices.size());
+            OptimizeOverdraw(indices, vertices);
+            OptimizeVertexFetch(vertices, indices);
+        }
+
+        report.After = AnalyzeVertexCache(indices, vertices.size());
+
+        return report;
+    }
+
+    template<typename VerticesContainer>
+    MeshOptimizerReport MeshOptimizer::Optimize(std::vector<VerticesContainer>& vertices, IndexCollection& indices, std::vector<IndexCollection>& lodIndices)
+    {
+        if (lodIndices.empty())
+            return Optimize(vertices, indices);
+
+        MeshOptimizerReport report;
+        report.Before = AnalyzeVertexCache(indices, vertices.size());
+
+        if (indices.size() >= 3 && !vertices.empty())
+        {
+            OptimizeVertexCache(indices, vertices.size());
+            OptimizeOverdraw(indices, vertices);
+
+            for (auto& lod : lodIndices)
+                OptimizeVertexCache(lod, vertices.size());
+
+            // The vertex order is defined by the full detail level, the simplified ones use a subset of its vertices.
+            IndexCollection allIndices(indices);
+            for (const auto& lod : lodIndices)
+                allIndices.insert(allIndices.end(), lod.begin(), lod.end());
+
+            OptimizeVertexFetch(vertices, allIndices);
+
+            size_t offset = 0;
+            std::copy(allIndices.begin(), allIndices.begin() + indices.size(), indices.begin());
+            offset += indices.size();
+            for (auto& lod : lodIndices)
+            {
+                std::copy(allIndices.begin() + offset, allIndices.begin() + offset + lod.size(), lod.begin());
+                offset += lod.size();
+            }
+        }
+
+        report.After = AnalyzeVertexCache(indices, vertices.size());
+
+        return report;
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <VertexBuffer.h>
+#include <IndexBuffer.h>
+#include <RangeAllocator.h>
+#include <URootObject.h>
+
+#include <d3d12.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+namespace dx12demo::core
+{
+    class CommandList;
+
+    // Geometry range of a mesh inside a MeshPool page.
+    struct MeshPoolAllocation
+    {
+        uint32_t PageIndex = UINT32_MAX;
+
+        UINT BaseVertexLocation = 0;
+        UINT VertexCount = 0;
+        UINT StartIndexLocation = 0;
+        UINT IndexCount = 0;
+
+        bool IsValid() const
+        {
+            return PageIndex != UINT32_MAX;
+        }
+    };
+
+    /* Sub-allocates the mesh geometry from a few large vertex and index buffers instead of
+    *  a committed resource per mesh. All meshes of a page share the buffer views, so they can be
+    *  drawn with one vertex/index buffer bind and with ExecuteIndirect.
+    *  Every page holds vertices of one stride and 16-bit indices.
+    */
+    class MeshPool : public URootObject
+    {
+    public:
+        static const size_t DEFAULT_VERTEX_PAGE_SIZE = 64 * 1024 * 1024;
+        static const size_t DEFAULT_INDEX_PAGE_SIZE = 16 * 1024 * 1024;
+
+        MeshPool(size_t vertexPageSize = DEFAULT_VERTEX_PAGE_SIZE, size_t indexPageSize = DEFAULT_INDEX_PAGE_SIZE);
+        virtual ~MeshPool();
+
+        /**
+        * Allocate ranges for the mesh and record the copy of the data to the commandList.
+        * A new page is created if the existing ones have no space.
+        */
+        MeshPoolAllocation Allocate(CommandList& commandList, size_t vertexCount, size_t vertexStride, const void* vertexData,
+            size_t indexCount, const uint16_t* indexData);
+
+        template<typename VerticesContainer>
+        MeshPoolAllocation Allocate(CommandList& commandList, const std::vector<VerticesContainer>& vertices, const std::vector<uint16_t>& indices)
+        {
+            return Allocate(commandList, vertices.size(), sizeof(VerticesContainer), vertices.data(), indices.size(), indices.data());
+        }
+
+        /**
+        * Return the ranges back to the pool.
+        * @param frameNumber Stale ranges are not freed directly, the GPU may still read them.
+        * They are returned to the pool by ReleaseStaleAllocations when the frame has completed.
+        */
+        void Free(const MeshPoolAllocation& allocation, uint64_t frameNumber);
+        // Free at the current application frame.
+        void Free(const MeshPoolAllocation& allocation);
+
+        void ReleaseStaleAllocations(uint64_t frameNumber);
+
+        const VertexBuffer& GetVertexBuffer(uint32_t pageIndex) const;
+        const IndexBuffer& GetIndexBuffer(uint32_t pageIndex) const;
+
+        uint32_t GetPageCount() const;
+
+    private:
+        struct Page
+        {
+            VertexBuffer Vertices;
+            IndexBuffer Indices;
+            size_t VertexStride = 0;
+
+            // In vertices and indices.
+            RangeAllocator VertexRanges;
+            RangeAllocator IndexRanges;
+        };
+
+        uint32_t CreatePage(CommandList& commandList, size_t vertexStride, size_t vertexCount, size_t indexCount);
+
+        struct StaleAllocation
+        {
+            MeshPoolAllocation Allocation;
+            // The frame number that the allocation was freed.
+            uint64_t FrameNumber;
+        };
+
+        std::vector<std::unique_ptr<Page>> m_Pages;
+        std::queue<StaleAllocation> m_StaleAllocations;
+
+        size_t m_VertexPageSize;
+        size_t m_IndexPageSize;
+
+        mutable std::mutex m_AllocationMutex;
+    };
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <Mesh.h>
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace dx12demo::core
+{
+    /* Quadric error metric simplification (Garland, Heckbert, "Surface Simplification Using Quadric Error Metrics").
+    *  Edges are collapsed into one of their vertices, so the simplified indices reference
+    *  the source vertices and all levels could share one vertex buffer.
+    *  Vertices on UV and normal seams (the same position with different attributes) are never removed,
+    *  vertices of the open borders are moved only along the border.
+    *  VerticesContainer must have DirectX::XMFLOAT3 m_position and DirectX::XMFLOAT3 m_normal;
+    *  see examples in mesh.h struct PosNormTexExtendedVertex and
+    *  struct PosNormTexVertex
+    */
+    class MeshSimplifier
+    {
+    public:
+        // Number of levels including the full detail one.
+        static const uint32_t MAX_LOD_COUNT = 5;
+        // Every level keeps this part of the previous level triangles.
+        static constexpr float LOD_TRIANGLE_RATIO = 0.5f;
+        static const uint32_t MIN_LOD_TRIANGLES = 32;
+        // Levels are not built beyond this error, relative to the mesh bounding box diagonal.
+        static constexpr float MAX_LOD_RELATIVE_ERROR = 0.05f;
+
+        /**
+         * Simplify until indices has targetIndexCount indices or the next collapse exceeds targetError.
+         * @returns the geometric error of the result in the mesh units.
+         */
+        template<typename VerticesContainer>
+        static float Simplify(const std::vector<VerticesContainer>& vertices, const IndexCollection& indices,
+            size_t targetIndexCount, float targetError, IndexCollection& result);
+
+        // Build the simplified levels, every one is simplified from the previous. The full detail level isn't included.
+        template<typename VerticesContainer>
+        static void BuildLodChain(const std::vector<VerticesContainer>& vertices, const IndexCollection& indices, MeshLodChain& lods);
+
+    private:
+        static float Simplify(const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<DirectX::XMFLOAT3>& normals,
+            const IndexCollection& indices, size_t targetIndexCount, float targetError, IndexCollection& result);
+
+        static float GetMaxLodError(const std::vector<DirectX::XMFLOAT3>& positions);
+    };
+
+    template<typename VerticesContainer>
+    float MeshSimplifier::Simplify(const std::vector<VerticesContainer>& vertices, const IndexCollection& indices,
+        size_t targetIndexCount, float targetError, IndexCollection& result)
+    {
+        std::vector<DirectX::XMFLOAT3> positions(vertices.size());
+        std::vector<DirectX::XMFLOAT3> normals(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            positions[i] = vertices[i].m_position;
+            normals[i] = vertices[i].m_normal;
+        }
+
+        return Simplify(positions, normals, indices, targetIndexCount, targetError, result);
+    }
+
+    template<typename VerticesContainer>
+    void MeshSimplifier::BuildLodChain(const std::vector<VerticesContainer>& vertices, const IndexCollection& indices, MeshLodChain& lods)
+    {
+        lods.Indices.clear();
+        lods.Errors.clear();
+
+        std::vector<DirectX::XMFLOAT3> positions(vertices.size());
+        std::vector<DirectX::XMFLOAT3> normals(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            positions[i] = vertices[i].m_position;
+            normals[i] = vertices[i].m_normal;
+        }
+
+        const float maxError = GetMaxLodError(positions);
+
+        // Levels are referenced by pointer while the chain grows.
+        lods.Indices.reserve(MAX_LOD_COUNT - 1);
+
+        const IndexCollection* source = &indices;
+        float accumulatedError = 0.f;
+
+        for (uint32_t level = 1; level < MAX_LOD_COUNT; ++level)
+        {
+            size_t targetTriangles = static_cast<size_t>(source->size() / 3 * LOD_TRIANGLE_RATIO);
+            if (targetTriangles < MIN_LOD_TRIANGLES)
+                break;
+
+            IndexCollection lod;
+            float error = Simplify(positions, normals, *source, targetTriangles * 3, maxError - accumulatedError, lod);
+
+            // Stop when the level is not worth the memory.
+            if (lod.size() * 10 > source->size() * 9)
+                break;
+
+            // Every level is simplified from the previous one, so the errors are summed up.
+            accumulatedError += error;
+
+            lods.Indices.push_back(std::move(lod));
+            lods.Errors.push_back(accumulatedError);
+            source = &lods.Indices.back();
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <Mesh.h>
+#include <BoundingVolumesPrimitive.h>
+#include <Helpers.h>
+
+#include <DirectXMath.h>
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace dx12demo::core
+{
+    /* Splits the mesh index buffer in meshlets with per cluster bounding spheres and normal cones.
+    *  Triangles are taken in the index buffer order, so the index buffer should be already
+    *  optimized for the vertex cache (see MeshOptimizer), then meshlets are spatially coherent.
+    *  VerticesContainer must have DirectX::XMFLOAT3 m_position;
+    *  see examples in mesh.h struct PosNormTexExtendedVertex and
+    *  struct PosNormTexVertex
+    */
+    class MeshletBuilder
+    {
+    public:
+        static const uint32_t MAX_VERTICES = 64;
+        static const uint32_t MAX_TRIANGLES = 124;
+
+        template<typename VerticesContainer>
+        static void Build(const std::vector<VerticesContainer>& vertices, const IndexCollection& indices, std::vector<Meshlet>& meshlets,
+            uint32_t maxVertices = MAX_VERTICES, uint32_t maxTriangles = MAX_TRIANGLES);
+
+        static bool IsVisible(const Meshlet& meshlet, const std::array<DirectX::XMFLOAT4, 6>& frustumPlanes, const DirectX::XMFLOAT3* cameraPosition = nullptr);
+
+        // Collect index ranges of the visible meshlets, adjacent ranges are merged.
+        static void Cull(const std::vector<Meshlet>& meshlets, const std::array<DirectX::XMFLOAT4, 6>& frustumPlanes, const DirectX::XMFLOAT3* cameraPosition, std::vector<SubMesh>& visibleRanges);
+
+    private:
+        // trianglePositions holds 3 positions per triangle of the meshlet.
+        static void ComputeBounds(const std::vector<DirectX::XMFLOAT3>& trianglePositions, Meshlet& meshlet);
+    };
+
+    template<typename VerticesContainer>
+    void MeshletBuilder::Build(const std::vector<VerticesContainer>& vertices, const IndexCollection& indices, std::vector<Meshlet>& meshlets,
+        uint32_t maxVertices/* = MAX_VERTICES*/, uint32_t maxTriangles/* = MAX_TRIANGLES*/)
+    {
+        assert(maxVertices >= 3 && maxTriangles >= 1);
+
+        meshlets.clear();
+
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0)
+            return;
+
+        // Stamp of the meshlet which has last referenced the vertex, to count unique vertices per meshlet.
+        const uint32_t NO_MESHLET = ~0u;
+        std::vector<uint32_t> vertexStamp(vertices.size(), NO_MESHLET);
+
+        std::vector<DirectX::XMFLOAT3> trianglePositions;
+        trianglePositions.reserve(maxTriangles * 3);
+
+        Meshlet current;
+
+        auto flush = [&]()
+        {
+            if (current.IndexCount == 0)
+                return;
+
+            ComputeBounds(trianglePositions, current);
+            meshlets.push_back(current);
+
+            UINT nextStart = current.StartIndexLocation + current.IndexCount;
+            current = Meshlet();
+            current.StartIndexLocation = nextStart;
+            trianglePositions.clear();
+        };
+
+        for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            const uint32_t meshletId = static_cast<uint32_t>(meshlets.size());
+
+            uint32_t newVertices = 0;
+            for (size_t k = 0; k < 3; ++k)
+            {
+                uint32_t index = indices[triangle * 3 + k];
+                if (vertexStamp[index] != meshletId)
+                    newVertices++;
+            }
+
+            // Degenerate triangles may reference the same new vertex twice, that only overestimates.
+            if (current.VertexCount + newVertices > maxVertices || current.IndexCount / 3 + 1 > maxTriangles)
+                flush();
+
+            const uint32_t currentId = static_cast<uint32_t>(meshlets.size());
+            for (size_t k = 0; k < 3; ++k)
+            {
+                uint32_t index = indices[triangle * 3 + k];
+                if (vertexStamp[index] != currentId)
+                {
+                    vertexStamp[index] = currentId;
+                    current.VertexCount++;
+                }
+
+                trianglePositions.push_back(vertices[index].m_position);
+            }
+
+            current.IndexCount += 3;
+        }
+
+        flush();
+    }
+}
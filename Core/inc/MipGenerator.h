@@ -0,0 +1,36 @@
+#pragma once
+
+#include <DirectXTex.h>
+
+namespace dx12demo::core
+{
+    enum class MipFilter
+    {
+        // 2x2 average, 3 taps with the exact weights across an odd dimension.
+        Box,
+        // Windowed sinc filters over 3 destination texels each side, sharper mips for the offline cook.
+        Kaiser,
+        Lanczos,
+    };
+
+    /* CPU mip chain generation, the counterpart of the GenerateMips_CS compute shader which needs no GPU queue.
+    *  The filters are separable, the taps are computed once per level and applied to whole rows with DirectXMath.
+    *  The sRGB formats are filtered in linear space, every level is computed from the previous one like on the GPU.
+    *  The destination rows are split in bands processed on the ThreadPool.
+    */
+    class MipGenerator
+    {
+    public:
+        // The 8 bit RGBA/BGRA formats (sRGB too) and the 16/32 bit float RGBA formats.
+        static bool IsSupportedFormat(DXGI_FORMAT format);
+
+        // A single 2D image of a supported format without mips.
+        static bool CanGenerate(const DirectX::TexMetadata& metadata);
+
+        // The full mip chain of a 2D image, the formats CanGenerate rejects go to the DirectXTex generation.
+        static void Generate(const DirectX::ScratchImage& source, MipFilter filter, DirectX::ScratchImage& mipChain);
+
+        // One level, destination must be max(1, source / 2) in both dimensions and in the same supported format.
+        static void Downsample(const DirectX::Image& source, const DirectX::Image& destination, MipFilter filter);
+    };
+}
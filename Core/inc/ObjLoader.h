@@ -0,0 +1,30 @@
+#pragma once
+
+#include <SceneCache.h>
+
+#include <string>
+#include <vector>
+
+namespace dx12demo::core
+{
+    /* Wavefront OBJ/MTL loader producing the same SceneMeshData as the assimp import in Scene.
+    *  The file is memory mapped and split at line ends into chunks parsed on the ThreadPool
+    *  with a hand written number parser, the meshes are then built in parallel.
+    *  Polygons are triangulated as fans, texture coordinates are flipped like aiProcess_FlipUVs,
+    *  the corners without a normal get the smoothed face normals like aiProcess_GenSmoothNormals.
+    *  Not supported: free-form geometry, lines and points, which assimp would load.
+    */
+    class ObjLoader
+    {
+    public:
+        /**
+         * A mesh per group and material, in the file order; a mesh with more vertices than the 16 bit indices address is split.
+         * Texture paths are relative to the OBJ file directory.
+         * @returns false if the file can't be read.
+         */
+        static bool Load(const std::wstring& fileName, std::vector<SceneMeshData>& meshes);
+
+        // The mtllib names of the file in the file order, relative to its directory. Only scans the lines, empty if the file can't be read.
+        static std::vector<std::string> GetMaterialLibraries(const std::wstring& fileName);
+    };
+}
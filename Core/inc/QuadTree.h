@@ -308,8 +308,6 @@ namespace dx12demo::core
 
 		int vertexStoreIndex = 0;
 
-		CollectorBVData collectorBVData;
-
 		// Go through all the triangles in the vertex list.
 		for (int i = 0; i < m_triangleCount; i++)
 		{
@@ -321,19 +319,16 @@ namespace dx12demo::core
 				// Get the three vertices of this triangle from the vertex list.
 				vertices[vertexStoreIndex] = vertexList[vertexIndex];
 				indices[vertexStoreIndex] = vertexStoreIndex;
-				collectorBVData.Collect(vertices[vertexStoreIndex].m_position);
 				vertexStoreIndex++;
 
 				vertexIndex++;
 				vertices[vertexStoreIndex] = vertexList[vertexIndex];
 				indices[vertexStoreIndex] = vertexStoreIndex;
-				collectorBVData.Collect(vertices[vertexStoreIndex].m_position);
 				vertexStoreIndex++;
 
 				vertexIndex++;
 				vertices[vertexStoreIndex] = vertexList[vertexIndex];
 				indices[vertexStoreIndex] = vertexStoreIndex;
-				collectorBVData.Collect(vertices[vertexStoreIndex].m_position);
 				vertexStoreIndex++;
 			}
 		}
@@ -341,9 +336,6 @@ namespace dx12demo::core
 		vertices.resize(vertexStoreIndex);
 
 		MeshCreatorInfo info;
-		info.bv_min_pos = collectorBVData.GetMin();
-		info.bv_max_pos = collectorBVData.GetMax();
-		info.bv_pos = collectorBVData.GetCenter();
 		info.rhcoords = true;
 		info.scale = 1;
 
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+namespace dx12demo::core
+{
+    /* Free list allocator over a range of abstract units (bytes, vertices, indices, pages),
+    *  the same scheme as DescriptorAllocatorPage: the free blocks are searched by size (best fit)
+    *  and merged with the neighbours by offset on free.
+    *  Not thread safe, the owner synchronizes.
+    */
+    class RangeAllocator
+    {
+    public:
+        static const size_t INVALID_OFFSET = SIZE_MAX;
+
+        explicit RangeAllocator(size_t size = 0);
+
+        // Drop all allocations and set the new range size.
+        void Reset(size_t size);
+
+        /**
+        * Allocate a contiguous block.
+        * @returns INVALID_OFFSET if there is no free block large enough.
+        */
+        size_t Allocate(size_t size);
+
+        void Free(size_t offset, size_t size);
+
+        bool HasSpace(size_t size) const;
+
+        size_t GetSize() const;
+        size_t GetFreeSize() const;
+
+    private:
+        struct FreeBlockInfo;
+        // A map that lists the free blocks by the offset within the range.
+        using FreeListByOffset = std::map<size_t, FreeBlockInfo>;
+
+        // A map that lists the free blocks by size.
+        // Needs to be a multimap since multiple blocks can have the same size.
+        using FreeListBySize = std::multimap<size_t, FreeListByOffset::iterator>;
+
+        struct FreeBlockInfo
+        {
+            FreeBlockInfo(size_t size)
+                : Size(size)
+            {}
+
+            size_t Size;
+            FreeListBySize::iterator FreeListBySizeIt;
+        };
+
+        void AddNewBlock(size_t offset, size_t size);
+
+        FreeListByOffset m_FreeListByOffset;
+        FreeListBySize m_FreeListBySize;
+
+        size_t m_Size = 0;
+        size_t m_FreeSize = 0;
+    };
+}
@@ -1,7 +1,13 @@
 #pragma once
 
 #include <URootObject.h>
+#include <SceneCache.h>
+#include <TextureStreamer.h>
+#include <VertexWelder.h>
 
+#include <DirectXMath.h>
+
+#include <array>
 #include <memory>
 #include <string>
 #include <vector>
@@ -30,25 +36,166 @@ namespace dx12demo::core
 		Scene();
 		virtual ~Scene();
 
-		bool LoadFromFile(std::shared_ptr<CommandList>& commandList, const std::wstring& fileName, bool rhcoords = false, float scale = 1);
+		// packVertices - upload PackedVertex, render the scene with PackedVertex::InputElementsPackedInstanced then, see DEQUANTIZATION_ROOT_PARAMETER.
+		bool LoadFromFile(std::shared_ptr<CommandList>& commandList, const std::wstring& fileName, bool rhcoords = false, float scale = 1, bool packVertices = false);
+
+		/* Non blocking load: the import, the mesh processing and the texture decode run on a background thread,
+		*  UpdateStreaming uploads what is ready. The weld options, the cache and the importer must not change until IsLoading is false.
+		*  Returns false if the file doesn't exist or a load is already running.
+		*/
+		bool LoadFromFileAsync(const std::wstring& fileName, bool rhcoords = false, float scale = 1, bool packVertices = false);
+
+		/**
+		 * Call every frame while IsLoading, with a direct command list executed before the frame renders.
+		 * Not a copy one: the meshes are copied into the shared MeshPool pages, which the direct queue draws from
+		 * (their barriers can't be recorded on a copy list) and whose freed ranges it may still be reading.
+		 * Creates the ready meshes, then uploads the decoded textures, until byteBudget bytes are recorded (at least one item per call).
+		 * A mesh is rendered from the call which creates it, with placeholder textures until its own are uploaded.
+		 */
+		void UpdateStreaming(std::shared_ptr<CommandList>& commandList, size_t byteBudget);
+
+		bool IsLoading() const;
+
+		/* The DDS textures and the cooked ones (see TextureCooker) of the next LoadFromFileAsync are added to streamer
+		*  instead of being loaded whole, they start with their mip tail. nullptr (the default) loads them whole.
+		*  The streamer must outlive the scene, the textures are removed from it by the destructor.
+		*/
+		void SetTextureStreamer(TextureStreamer* streamer);
+
+		/**
+		 * Call every frame with a copy command list executed before the frame renders, also while IsLoading.
+		 * Requests the texture mips for the projected size of the meshes (of their nearest instance), then updates the streamer.
+		 * projectionScale - pixels per world unit at the distance 1, viewportHeight / (2 * tan(fovY / 2)).
+		 */
+		void UpdateTextureStreaming(std::shared_ptr<CommandList>& commandList, const DirectX::XMFLOAT3& cameraPosition, float projectionScale, size_t uploadBudget);
+
+		// The instance world transforms are bound to the vertex buffer slot 1 (the identity for the meshes drawn once),
+		// the PSO applies them with PosNormTexExtendedVertex::InputElementsExtendedInstanced.
 		void Render(std::shared_ptr<CommandList>& commandList, std::function<void(std::shared_ptr<CommandList>&, std::shared_ptr<Material>&)>& drawMatFun);
 		void Render(std::shared_ptr<CommandList>& commandList, Frustum& frustum, std::function<void(std::shared_ptr<CommandList>&, std::shared_ptr<Material>&)>& drawMatFun);
+		/**
+		 * Also culls backfacing meshlets, use only with the clockwise front faces and backface culling enabled.
+		 * Draws every mesh at the coarsest LOD whose error projects below a pixel (Mesh::SelectLod, by the nearest visible instance),
+		 * the coarser levels whole since the meshlets cover the full detail level only.
+		 * projectionScale - as for UpdateTextureStreaming.
+		 */
+		void Render(std::shared_ptr<CommandList>& commandList, Frustum& frustum, const DirectX::XMFLOAT3& cameraPosition, float projectionScale,
+			std::function<void(std::shared_ptr<CommandList>&, std::shared_ptr<Material>&)>& drawMatFun);
+
+		// Render binds the PackedVertexDequantization of every packed mesh (PackedVertexInclude.hlsl) to this root parameter, a constant buffer view.
+		static const uint32_t DEQUANTIZATION_ROOT_PARAMETER = 1;
+
+		// Triangles submitted by the last Render call.
+		uint32_t GetSubmittedTriangleCount() const;
+
+		// Mesh culling of the last Render call with the frustum.
+		struct CullingStatistics
+		{
+			uint32_t MeshCount = 0;
+			// Meshes the bounding sphere of the AABB (the previous test) would cull, for comparison only.
+			uint32_t CulledByAABBSphere = 0;
+			uint32_t CulledBySphere = 0;
+			// Meshes which passed the sphere test but not the OBB one.
+			uint32_t CulledByOBB = 0;
+			// Instances of the instanced meshes, culled by their transformed bounding sphere.
+			uint32_t InstanceCount = 0;
+			uint32_t CulledInstances = 0;
+		};
+
+		const CullingStatistics& GetCullingStatistics() const;
+
+		// Tolerances of the duplicate vertex merge, used by the next LoadFromFile.
+		void SetVertexWeldOptions(const VertexWeldOptions& options);
+
+		// Read and write the SceneCache file next to the scene file, on by default.
+		void SetSceneCacheEnabled(bool enabled);
+
+		// Importer of the next LoadFromFile, by default ObjLoader for the .obj files and assimp for the rest.
+		void SetImporter(SceneImporter importer);
+
+		// Log the import, vertex data, bounding volume, texture cache and vertex cache reports of every load, off by default:
+		// a load then logs only its summary line.
+		void SetStatisticsLogEnabled(bool enabled);
 
 	private:
+		// State of LoadFromFileAsync, defined in Scene.cpp.
+		struct StreamingState;
+
+		// SceneCache read, or the import and the cache write. Safe to call from a background thread.
+		bool ReadMeshes(const std::wstring& fileName, std::vector<SceneMeshData>& meshes, bool& fromCache);
 
-		void ProcessNode(std::shared_ptr<CommandList>& commandList, aiNode* node, const aiScene* scene);
+		// Body of the LoadFromFileAsync thread, hands the meshes and the decoded textures over to UpdateStreaming.
+		void StreamFile(const std::wstring& fileName);
 
-		void ProcessMesh(std::shared_ptr<CommandList>& commandList, aiMesh* mesh, const aiScene* scene);
+		void CreatePlaceholderTextures(std::shared_ptr<CommandList>& commandList);
 
-		void ProcessMeshLoadMaterialTextures(std::shared_ptr<CommandList>& commandList, std::shared_ptr<Material>& inStoreMat, aiMaterial* mat, aiTextureType type);
+		// Adds the texture of the materials to m_TextureStreamer. Returns the uploaded bytes, 0 if the file can't be streamed.
+		size_t AddStreamedTexture(std::shared_ptr<CommandList>& commandList, const std::wstring& fileName, TextureUsage textureUsage,
+			const std::vector<std::shared_ptr<Material>>& materials, TextureStreamer::ResidencyCallback callback);
+
+		// Vertex data, bounding volume and vertex cache reports of the loaded meshes, if m_LogStatistics.
+		void LogSceneStatistics(const std::string& path, size_t vertexCount);
+
+		std::wstring GetTexturePath(const SceneMeshTexture& texture) const;
+
+		// Import and the CPU processing of the meshes, the result is what SceneCache stores.
+		bool ImportFile(const std::wstring& fileName, std::vector<SceneMeshData>& meshes);
+
+		bool ImportAssimp(const std::string& path, std::vector<SceneMeshData>& meshes);
+
+		// Collects the meshes of the node hierarchy and their world transforms, the meshes are processed in parallel then.
+		void ProcessNode(aiNode* node, const aiScene* scene, const aiMatrix4x4& parentTransform,
+			std::vector<std::vector<aiMatrix4x4>>& meshTransforms, std::vector<unsigned int>& meshes);
+
+		// Runs on a worker thread, must touch only importData.
+		void ProcessMesh(aiMesh* mesh, const aiScene* scene, SceneMeshData& importData);
+
+		void CreateMesh(std::shared_ptr<CommandList>& commandList, SceneMeshData& importData);
+
+		/**
+		 * Binds the instance transforms of the mesh to INSTANCE_SLOT, the identity for a mesh without instances.
+		 * With frustumPlanes only the visible instances are bound.
+		 * @returns the instance count to draw, 0 if all are culled.
+		 */
+		uint32_t BindInstances(std::shared_ptr<CommandList>& commandList, size_t meshIndex, const std::array<DirectX::XMFLOAT4, 6>* frustumPlanes, bool& identityBound);
+
+		// Nothing for a mesh of PosNormTexExtendedVertex.
+		void BindDequantization(std::shared_ptr<CommandList>& commandList, const Mesh& mesh);
+
+		// Sphere test first, the OBB test only for the meshes it doesn't cull.
+		bool IsMeshVisible(const Mesh& mesh, const std::array<DirectX::XMFLOAT4, 6>& frustumPlanes);
+
+		void ProcessMeshLoadMaterialTextures(std::shared_ptr<CommandList>& commandList, std::shared_ptr<Material>& inStoreMat, const SceneMeshTexture& texture);
 
 		using MeshMaterialList = std::vector<std::pair<std::shared_ptr<Mesh>, std::shared_ptr<Material>>>;
 
 		MeshMaterialList m_Data;
+		// Per m_Data entry, SceneMeshData::Instances.
+		std::vector<std::vector<DirectX::XMFLOAT4X4>> m_MeshInstances;
+		std::vector<DirectX::XMFLOAT4X4> m_VisibleInstances;
+
+		// Vertex buffer slot of the instance transforms, see PosNormTexExtendedVertex::InputElementsExtendedInstanced.
+		static const uint32_t INSTANCE_SLOT = 1;
+
+		uint32_t m_SubmittedTriangleCount = 0;
+		CullingStatistics m_CullingStatistics;
 
 		std::string m_lastDirectory;
 		bool m_last_rhcoords = false;
 		float m_last_scale = 1;
+		bool m_last_packVertices = false;
+
+		VertexWeldOptions m_WeldOptions;
+		bool m_UseSceneCache = true;
+		SceneImporter m_Importer = SceneImporter::Auto;
+		bool m_LogStatistics = false;
+
+		std::unique_ptr<StreamingState> m_Streaming;
+
+		TextureStreamer* m_TextureStreamer = nullptr;
+		std::vector<TextureStreamer::TextureId> m_StreamedTextures;
+		// Per m_Data entry, the streamed textures of its material.
+		std::vector<std::vector<TextureStreamer::TextureId>> m_MeshStreamedTextures;
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Mesh.h>
+#include <VertexWelder.h>
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dx12demo::core
+{
+    // A material texture of a scene mesh, the path is relative to the scene file directory.
+    struct SceneMeshTexture
+    {
+        // aiTextureType.
+        uint32_t Type = 0;
+        std::string Path;
+    };
+
+    // CPU side data of an imported mesh: welded, with the tangent frame and the LOD chain, ready for Mesh::CreateCustomMesh.
+    struct SceneMeshData
+    {
+        std::string Name;
+
+        VertexExtendedCollection Vertices;
+        IndexCollection Indices;
+        MeshLodChain Lods;
+
+        std::vector<SceneMeshTexture> Textures;
+
+        // World transforms of the occurrences in the scene, drawn instanced. Empty for a single occurrence without a transform.
+        std::vector<DirectX::XMFLOAT4X4> Instances;
+
+        // The file has no tangent frame, TangentGenerator builds it. Not stored, the cached meshes have it already.
+        bool GenerateTangents = false;
+    };
+
+    enum class SceneImporter : uint32_t
+    {
+        // ObjLoader for the .obj files, assimp for the rest.
+        Auto,
+        Assimp,
+        Obj,
+    };
+
+    // Everything besides the source file which changes the imported meshes.
+    struct SceneImportSettings
+    {
+        VertexWeldOptions WeldOptions;
+        SceneImporter Importer = SceneImporter::Auto;
+    };
+
+    /* Binary cache of the imported scene meshes, "scene.obj" is cached in "scene.obj.dxsc" next to it.
+    *  The cache is memory mapped and copied to the meshes, assimp and the CPU processing are skipped.
+    *  It is rebuilt when the version, the vertex layout or the import settings differ,
+    *  or when the source file or a material library it references (the mtllib of an .obj) changed:
+    *  a different size, or a different modification time and content hash.
+    */
+    class SceneCache
+    {
+    public:
+        // Increment on any change of the format or of the import processing (welding, tangents, LODs).
+        static const uint32_t VERSION = 5;
+
+        static std::wstring GetCachePath(const std::wstring& sourceFileName);
+
+        // @returns false if there is no valid cache for the source file, meshes are cleared then.
+        static bool Read(const std::wstring& sourceFileName, const SceneImportSettings& settings, std::vector<SceneMeshData>& meshes);
+
+        // The file is written under a temporary name and renamed, a crash never leaves a partial cache.
+        static bool Write(const std::wstring& sourceFileName, const SceneImportSettings& settings, const std::vector<SceneMeshData>& meshes);
+
+    private:
+        // Stable hash of the file content (FNV-1a).
+        static uint64_t HashFile(const std::wstring& fileName);
+    };
+}
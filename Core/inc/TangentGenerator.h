@@ -0,0 +1,28 @@
+#pragma once
+
+#include <Mesh.h>
+
+namespace dx12demo::core
+{
+    /* Per vertex tangent frame from the positions, normals and texture coordinates,
+    *  following MikkTSpace (Mikkelsen, "Simulation of Wrinkled Surfaces Revisited"):
+    *  the triangle tangents are projected onto the vertex normal plane and weighted by the corner angle,
+    *  the triangles of the opposite UV orientation (mirrored mapping) are not mixed, such a vertex is split.
+    *  The bitangent is cross(normal, tangent) * sign, as the PackedVertex restores it.
+    *  The work runs on the ThreadPool, every vertex sums its triangles in the index order,
+    *  so the result doesn't depend on the thread count.
+    */
+    class TangentGenerator
+    {
+    public:
+        // Fills m_tangent and m_bitangent, split vertices are appended and indices are updated for them.
+        static void Generate(VertexExtendedCollection& vertices, IndexCollection& indices);
+
+        // For the meshes built without the tangent frame (the procedural primitives).
+        static void Generate(const VertexCollection& vertices, IndexCollection& indices, VertexExtendedCollection& result);
+
+    private:
+        // Any unit vector orthogonal to the normal, for the vertices without usable texture coordinates.
+        static DirectX::XMFLOAT3 GetOrthogonal(const DirectX::XMFLOAT3& normal);
+    };
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace dx12demo::core
+{
+    struct TextureCacheStatistics
+    {
+        uint64_t Hits = 0;
+        uint64_t Misses = 0;
+        uint64_t Evictions = 0;
+        uint64_t EvictedBytes = 0;
+
+        size_t EntryCount = 0;
+        // Entries used outside the cache, which can't be evicted.
+        size_t ReferencedCount = 0;
+        size_t ResidentBytes = 0;
+        size_t Budget = 0;
+    };
+
+    /* The textures loaded from files, keyed by path, kept under a GPU memory budget.
+    *  An entry is referenced while anything besides the cache holds its resource: the Textures using it and
+    *  the command lists still in flight, which track the resources they record. This is the COM reference count.
+    *  When the resident size exceeds the budget, the unreferenced entries are evicted, least recently used first.
+    *  The referenced ones stay even over the budget. All the methods are thread safe.
+    */
+    class TextureCache
+    {
+    public:
+        static const size_t DEFAULT_BUDGET = 1024ull * 1024ull * 1024ull;
+
+        explicit TextureCache(size_t budget = DEFAULT_BUDGET);
+        virtual ~TextureCache();
+
+        // nullptr on a miss. A hit makes the entry the most recently used one.
+        Microsoft::WRL::ComPtr<ID3D12Resource> Find(const std::wstring& key);
+
+        // Unlike Find, not counted as a hit or miss and the LRU order is unchanged.
+        bool Contains(const std::wstring& key) const;
+
+        /**
+         * Add a resource and evict down to the budget.
+         * @returns the cached resource, the existing one if another thread added the key first.
+         */
+        Microsoft::WRL::ComPtr<ID3D12Resource> Add(const std::wstring& key, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource);
+
+        void SetBudget(size_t budget);
+        size_t GetBudget() const;
+
+        // Evict down to the budget, e.g. after the Textures of an unloaded scene are released. Returns the evicted bytes.
+        size_t Trim();
+
+        // Evict every unreferenced entry regardless of the budget. Returns the evicted bytes.
+        size_t EvictUnreferenced();
+
+        TextureCacheStatistics GetStatistics() const;
+
+    private:
+        struct Entry
+        {
+            Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+            size_t Size = 0;
+            std::list<std::wstring>::iterator LruPosition;
+        };
+
+        // Both expect m_Mutex to be locked.
+        size_t EvictTo(size_t targetBytes);
+        bool IsReferenced(const Entry& entry) const;
+
+        static size_t GetResourceSize(ID3D12Resource* resource);
+
+        std::unordered_map<std::wstring, Entry> m_Entries;
+        // Most recently used first.
+        std::list<std::wstring> m_LruOrder;
+
+        size_t m_Budget;
+        size_t m_ResidentBytes = 0;
+
+        uint64_t m_Hits = 0;
+        uint64_t m_Misses = 0;
+        uint64_t m_Evictions = 0;
+        uint64_t m_EvictedBytes = 0;
+
+        mutable std::mutex m_Mutex;
+    };
+}
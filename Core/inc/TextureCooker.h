@@ -0,0 +1,48 @@
+#pragma once
+
+#include "TextureUsage.h"
+
+#include <DirectXTex.h>
+
+#include <string>
+
+namespace dx12demo::core
+{
+    /* Offline block compression of the material textures, cached as DDS next to the source file.
+    *  The format is chosen per usage: Albedo BC1 (BC7 with alpha), Ambient and Specular BC1 (BC3 with alpha),
+    *  Normalmap BC5 (x and y only, the shaders rebuild z). The other usages and the DDS/HDR sources aren't cooked.
+    *  The mip chain is generated before the compression (Kaiser filter), the GPU mip generation doesn't handle BC formats.
+    *  The encoding runs on the ThreadPool in strips of block rows.
+    */
+    class TextureCooker
+    {
+    public:
+        // Enabled by default. Disabled, the files are always decoded as they are.
+        static void SetEnabled(bool enabled);
+        static bool IsEnabled();
+
+        // The usage and the source file type are cooked.
+        static bool IsCooked(const std::wstring& sourceFileName, TextureUsage textureUsage);
+
+        static std::wstring GetCachePath(const std::wstring& sourceFileName, TextureUsage textureUsage);
+
+        /**
+         * Load the cooked texture, cooking it first if the cache is missing or older than the source.
+         * A source the format can't be used for (e.g. a size not multiple of 4) is returned decoded as is.
+         * @returns false if the texture isn't cooked (see IsCooked). Throws if the source can't be decoded.
+         */
+        static bool Load(const std::wstring& sourceFileName, TextureUsage textureUsage, DirectX::TexMetadata& metadata, DirectX::ScratchImage& scratchImage);
+
+        /**
+         * Make sure the cache is up to date without loading it, for the readers of the DDS file (TextureStreamer).
+         * @returns the cache path, empty if the texture isn't cooked, can't be compressed or the cache can't be written.
+         */
+        static std::wstring Cook(const std::wstring& sourceFileName, TextureUsage textureUsage);
+
+        // DXGI_FORMAT_UNKNOWN if the image is left uncompressed.
+        static DXGI_FORMAT GetCompressedFormat(TextureUsage textureUsage, const DirectX::ScratchImage& scratchImage);
+
+        // Compress every image of source, in parallel.
+        static void Compress(const DirectX::ScratchImage& source, DXGI_FORMAT format, DirectX::ScratchImage& compressed);
+    };
+}
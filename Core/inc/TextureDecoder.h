@@ -0,0 +1,88 @@
+#pragma once
+
+#include "TextureUsage.h"
+
+#include <DirectXTex.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace dx12demo::core
+{
+    // A texture file decode queued on the TextureDecoder, shared by all the callers which requested the file.
+    class TextureDecodeRequest
+    {
+    public:
+        TextureDecodeRequest(const std::wstring& fileName, TextureUsage textureUsage);
+
+        const std::wstring& GetFileName() const;
+        TextureUsage GetTextureUsage() const;
+
+        bool IsReady() const;
+
+        // Blocks until the image is decoded, a request no worker has started yet is decoded on the calling thread.
+        void Wait();
+
+        // Only valid once ready. Throws if the file couldn't be decoded.
+        const DirectX::ScratchImage& GetImage() const;
+
+    private:
+        friend class TextureDecoder;
+
+        // Returns false if another thread already started the decode.
+        bool Run();
+
+        std::wstring m_FileName;
+        TextureUsage m_TextureUsage;
+        // GetCacheKey when it was requested, the pending request is found by it.
+        std::wstring m_Key;
+        DirectX::ScratchImage m_Image;
+        std::string m_Error;
+
+        std::atomic<bool> m_Started = false;
+        std::atomic<bool> m_Ready = false;
+        std::mutex m_Mutex;
+        std::condition_variable m_ReadyCondition;
+    };
+
+    /* Decodes the texture files (DDS, HDR, TGA and WIC formats) on the ThreadPool, the cooked version for the usages TextureCooker handles.
+    *  Concurrent requests for the same file and cooked usage share one decode, the requests are only tracked while in flight:
+    *  the decoded images are owned by the requests and the uploaded textures are cached by CommandList.
+    */
+    class TextureDecoder
+    {
+    public:
+        static TextureDecoder& Get();
+
+        // The usage of the first request for a file is used while the file is in flight.
+        std::shared_ptr<TextureDecodeRequest> Request(const std::wstring& fileName, TextureUsage textureUsage = TextureUsage::None);
+
+        // Requests currently queued or decoding.
+        size_t GetPendingCount();
+
+        /**
+         * The key of the file in the texture cache and in the pending requests: the file name, or the cooked file
+         * for the usages TextureCooker compresses, whose format depends on the usage (one image can be an albedo and a normal map).
+         */
+        static std::wstring GetCacheKey(const std::wstring& fileName, TextureUsage textureUsage);
+
+        // CPU only, safe to call from any thread. Throws if the file can't be decoded.
+        static void DecodeFile(const std::wstring& fileName, DirectX::TexMetadata& metadata, DirectX::ScratchImage& scratchImage);
+
+        // TextureCooker::Load if the texture is cooked, else DecodeFile and the MipGenerator mip chain. Same threading as DecodeFile.
+        static void LoadFile(const std::wstring& fileName, TextureUsage textureUsage, DirectX::TexMetadata& metadata, DirectX::ScratchImage& scratchImage);
+
+    private:
+        friend class TextureDecodeRequest;
+
+        // Called by the request when its decode finished, the request is no longer shared with new callers.
+        void OnDecoded(const TextureDecodeRequest& request);
+
+        std::map<std::wstring, std::shared_ptr<TextureDecodeRequest>> m_PendingRequests;
+        std::mutex m_Mutex;
+    };
+}
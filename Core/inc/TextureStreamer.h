@@ -0,0 +1,133 @@
+#pragma once
+
+#include <MappedFile.h>
+#include <Texture.h>
+#include <TextureUsage.h>
+
+#include <DirectXTex.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dx12demo::core
+{
+    class CommandList;
+
+    struct TextureStreamerStatistics
+    {
+        size_t TextureCount = 0;
+        // Textures whose desired mip isn't resident after the last Update.
+        size_t PendingCount = 0;
+        size_t ResidentBytes = 0;
+        size_t Budget = 0;
+
+        uint64_t LoadedMips = 0;
+        uint64_t EvictedMips = 0;
+    };
+
+    /* Mip streaming of 2D DDS textures, the mips are read straight from the memory mapped file without a decode.
+    *  Add uploads the mip tail (the levels of at most MIP_TAIL_SIZE texels), which stays resident.
+    *  Every frame the users report the screen size of what the texture covers, Update turns it into a desired mip
+    *  and streams the missing levels, the largest screen sizes with the most missing levels first.
+    *  Over the budget, the levels beyond the desired mip are dropped from the smallest screen sizes first.
+    *  A residency change creates a new resource with the new mip range: the Texture is handed to the callback,
+    *  which replaces the one it uses (e.g. in a Material). The old resource lives as long as its users and the command lists recording it.
+    *  Not thread safe, used from the thread recording the streaming command list.
+    */
+    class TextureStreamer
+    {
+    public:
+        using TextureId = uint32_t;
+        using ResidencyCallback = std::function<void(const Texture&)>;
+
+        static const TextureId INVALID_TEXTURE = UINT32_MAX;
+        static const size_t DEFAULT_BUDGET = 256ull * 1024ull * 1024ull;
+        static const uint32_t MIP_TAIL_SIZE = 128;
+
+        explicit TextureStreamer(size_t budget = DEFAULT_BUDGET);
+        virtual ~TextureStreamer();
+
+        TextureStreamer(const TextureStreamer& copy) = delete;
+        TextureStreamer& operator=(const TextureStreamer& other) = delete;
+
+        // A 2D DDS file with a mip chain, no array or cubemap, stored in its GPU format. Reads only the header.
+        static bool IsStreamable(const std::wstring& fileName);
+
+        /**
+         * Map the file and upload its mip tail, callback receives the tail Texture before Add returns.
+         * @returns INVALID_TEXTURE if the file isn't streamable, load it whole then.
+         */
+        TextureId Add(CommandList& commandList, const std::wstring& fileName, TextureUsage textureUsage, ResidencyCallback callback);
+
+        // Unmaps the file, the last Texture stays valid with the users which hold it.
+        void Remove(TextureId id);
+
+        // Projected size in pixels of a surface using the texture, the largest request of the frame is used.
+        void RequestScreenSize(TextureId id, float screenPixels);
+
+        /**
+         * Stream in and evict toward the desired mips of the requests since the last call, then clear the requests.
+         * A texture without request is taken down to its tail only when the memory is needed.
+         * @returns the bytes recorded, stops before uploadBudget (after at least one upload).
+         */
+        size_t Update(CommandList& commandList, size_t uploadBudget);
+
+        // The mip whose size matches screenPixels, log2(max(width, height) / screenPixels) clamped to 0.
+        static uint32_t EstimateDesiredMip(uint32_t width, uint32_t height, float screenPixels);
+
+        void SetBudget(size_t budget);
+        size_t GetBudget() const;
+
+        const Texture& GetTexture(TextureId id) const;
+        uint32_t GetResidentMip(TextureId id) const;
+
+        TextureStreamerStatistics GetStatistics() const;
+
+    private:
+        // Where every mip is in the file.
+        struct FileLayout
+        {
+            DirectX::TexMetadata Metadata;
+            std::vector<size_t> Offsets;
+            std::vector<size_t> RowPitches;
+            std::vector<size_t> SlicePitches;
+        };
+
+        struct StreamedTexture
+        {
+            std::wstring FileName;
+            TextureUsage Usage = TextureUsage::None;
+            MappedFile File;
+            FileLayout Layout;
+            ResidencyCallback Callback;
+            Texture Resident;
+
+            uint32_t TailMip = 0;
+            uint32_t ResidentMip = 0;
+            uint32_t DesiredMip = 0;
+            float ScreenPixels = 0.0f;
+        };
+
+        static bool ReadLayout(const MappedFile& file, FileLayout& layout);
+
+        // The top level of a block compressed resource must be a multiple of the block size.
+        static bool IsValidTopMip(const DirectX::TexMetadata& metadata, uint32_t mip);
+
+        static size_t GetSize(const StreamedTexture& texture, uint32_t topMip);
+
+        // Replaces the resource with one holding the levels from mip, uploaded from the mapped file. Returns the uploaded bytes.
+        size_t SetResidentMip(CommandList& commandList, StreamedTexture& texture, uint32_t mip);
+
+        std::vector<std::unique_ptr<StreamedTexture>> m_Textures;
+        std::vector<TextureId> m_FreeIds;
+
+        size_t m_Budget;
+        size_t m_ResidentBytes = 0;
+
+        uint64_t m_LoadedMips = 0;
+        uint64_t m_EvictedMips = 0;
+    };
+}
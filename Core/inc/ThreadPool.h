@@ -0,0 +1,115 @@
+#pragma once
+
+#include <ThreadSafeQueue.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dx12demo::core
+{
+    /* Fixed set of worker threads for the CPU side jobs (asset import, mesh processing, etc.).
+    *  Tasks must not touch the D3D12 command lists, those are recorded on the calling thread.
+    */
+    class ThreadPool
+    {
+    public:
+        using Task = std::function<void()>;
+
+        // threadCount = 0 means one worker per hardware thread except the calling one.
+        explicit ThreadPool(uint32_t threadCount = 0);
+        virtual ~ThreadPool();
+
+        ThreadPool(const ThreadPool& copy) = delete;
+        ThreadPool& operator=(const ThreadPool& other) = delete;
+
+        // Pool shared by the whole application.
+        static ThreadPool& Get();
+
+        void Submit(Task task);
+
+        /**
+         * Run func(index) for every index in [0, count) on the workers and the calling thread.
+         * Returns when all indices are processed, the first exception thrown by func is rethrown.
+         */
+        template<typename Func>
+        void ParallelFor(size_t count, Func&& func);
+
+        uint32_t GetThreadCount() const;
+
+    private:
+        void WorkerThread();
+
+        // Run one queued task on the calling thread, used while waiting to avoid deadlocks in nested ParallelFor.
+        bool RunPendingTask();
+
+        std::vector<std::thread> m_Threads;
+        // Empty task stops a worker.
+        ThreadSafeQueue<Task> m_Tasks;
+    };
+
+    template<typename Func>
+    void ThreadPool::ParallelFor(size_t count, Func&& func)
+    {
+        if (count == 0)
+            return;
+
+        if (count == 1 || m_Threads.empty())
+        {
+            for (size_t i = 0; i < count; ++i)
+                func(i);
+            return;
+        }
+
+        struct Context
+        {
+            std::atomic<size_t> nextIndex = 0;
+            std::atomic<size_t> activeJobs = 0;
+            std::exception_ptr exception;
+            std::mutex exceptionMutex;
+        };
+
+        auto context = std::make_shared<Context>();
+
+        auto job = [context, count, &func]()
+        {
+            for (size_t i = context->nextIndex++; i < count; i = context->nextIndex++)
+            {
+                try
+                {
+                    func(i);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(context->exceptionMutex);
+                    if (!context->exception)
+                        context->exception = std::current_exception();
+                }
+            }
+
+            context->activeJobs--;
+        };
+
+        const size_t helperCount = std::min(count - 1, m_Threads.size());
+        context->activeJobs = helperCount + 1;
+        for (size_t i = 0; i < helperCount; ++i)
+            Submit(job);
+
+        job();
+
+        while (context->activeJobs > 0)
+        {
+            if (!RunPendingTask())
+                std::this_thread::yield();
+        }
+
+        if (context->exception)
+            std::rethrow_exception(context->exception);
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <MappedFile.h>
+#include <VirtualTexturePageTable.h>
+
+#include <DirectXTex.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dx12demo::core
+{
+    /* The on-disk format of a virtual texture: every page of every mip stored as a ready to upload tile.
+    *  A tile is the page with a border of texels from its neighbours (clamped at the texture edges) for the filtering,
+    *  (pageSize + 2 * border)^2 texels in the format of the source. The tiles are ordered by mip, then row major.
+    *  Read through a memory mapping, a tile is paged in from the disk on its first access.
+    */
+    class TiledTextureFile
+    {
+    public:
+        static constexpr uint32_t VERSION = 1;
+        static constexpr uint32_t DEFAULT_PAGE_SIZE = 128;
+        static constexpr uint32_t DEFAULT_BORDER = 4;
+
+        TiledTextureFile();
+        virtual ~TiledTextureFile();
+
+        /**
+         * Write the tiles of source, a square 2D image whose size is the page size times a power of two, in an uncompressed format.
+         * The mips down to a single page are taken from source, generated (MipGenerator) if it has fewer.
+         * @returns false if source doesn't fit the format or the file can't be written.
+         */
+        static bool Write(const std::wstring& fileName, const DirectX::ScratchImage& source, uint32_t pageSize = DEFAULT_PAGE_SIZE, uint32_t border = DEFAULT_BORDER);
+
+        // @returns false if the file can't be opened or isn't a valid tiled texture.
+        bool Open(const std::wstring& fileName);
+        void Close();
+        bool IsOpen() const;
+
+        DXGI_FORMAT GetFormat() const;
+        uint32_t GetPageSize() const;
+        uint32_t GetBorder() const;
+        // Texels per tile side, the page and the borders.
+        uint32_t GetTileSize() const;
+        size_t GetTileRowPitch() const;
+        size_t GetTileBytes() const;
+
+        // The page grid of mip 0, the page table of the virtual texture is created from it.
+        uint32_t GetPagesX() const;
+        uint32_t GetPagesY() const;
+        uint32_t GetMipCount() const;
+
+        // nullptr if the page isn't in the file.
+        const uint8_t* GetTile(const VirtualPageId& page) const;
+
+    private:
+        struct Header
+        {
+            uint32_t Magic = 0;
+            uint32_t Version = 0;
+            uint32_t Format = 0;
+            uint32_t PageSize = 0;
+            uint32_t Border = 0;
+            uint32_t PagesX = 0;
+            uint32_t PagesY = 0;
+            uint32_t MipCount = 0;
+            uint64_t TileBytes = 0;
+        };
+
+        static constexpr uint32_t MAGIC = 0x58455456;
+
+        MappedFile m_File;
+        Header m_Header;
+        // Index of the first tile of every mip.
+        std::vector<size_t> m_MipTiles;
+    };
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dx12demo::core
+{
+    /* Flat transform hierarchy, the data oriented alternative to the SceneNode tree.
+    *  Nodes are addressed by a stable NodeId. The transforms live in arrays (local, world, dirty flags, parent slots)
+    *  kept in depth first order: a parent always precedes its children and every subtree is a contiguous range.
+    *  Update recomputes the world transforms of the dirty nodes and their descendants in one linear pass,
+    *  large hierarchies are split into subtrees updated in parallel on the ThreadPool.
+    *  Not thread safe, the nodes must not change during Update.
+    */
+    class TransformHierarchy
+    {
+    public:
+        using NodeId = uint32_t;
+        static const NodeId INVALID_NODE = UINT32_MAX;
+
+        TransformHierarchy();
+        virtual ~TransformHierarchy();
+
+        void Reserve(size_t nodeCount);
+
+        // parent = INVALID_NODE adds a root. The world transform is valid after the next Update.
+        NodeId AddNode(NodeId parent, const DirectX::XMMATRIX& localTransform = DirectX::XMMatrixIdentity(), const std::string& name = "");
+
+        // Moves the node with its subtree, the parent must not be in that subtree.
+        void SetParent(NodeId node, NodeId parent);
+        NodeId GetParent(NodeId node) const;
+
+        void SetLocalTransform(NodeId node, const DirectX::XMMATRIX& localTransform);
+        DirectX::XMMATRIX GetLocalTransform(NodeId node) const;
+
+        // As of the last Update.
+        DirectX::XMMATRIX GetWorldTransform(NodeId node) const;
+
+        // The first node added with the name, INVALID_NODE if there is none.
+        NodeId FindNode(const std::string& name) const;
+        const std::string& GetName(NodeId node) const;
+
+        size_t GetNodeCount() const;
+
+        // Recompute the world transforms changed since the last call.
+        void Update();
+
+        // World transforms recomputed by the last Update.
+        size_t GetUpdatedNodeCount() const;
+
+    private:
+        // Restore the depth first order after AddNode/SetParent and rebuild the parallel jobs.
+        void RebuildOrder();
+
+        // Update of the slots [begin, end), the parents of the range must be up to date. Returns the recomputed node count.
+        size_t UpdateRange(uint32_t begin, uint32_t end);
+
+        static const uint32_t INVALID_SLOT = UINT32_MAX;
+
+        // Per slot (depth first order), the hot data of Update.
+        std::vector<DirectX::XMFLOAT4X4> m_Local;
+        std::vector<DirectX::XMFLOAT4X4> m_World;
+        std::vector<uint32_t> m_ParentSlot;
+        // The local transform changed since the last Update.
+        std::vector<uint8_t> m_LocalDirty;
+        // Index of the last Update which changed the world transform, the children of the changed nodes are recomputed.
+        std::vector<uint32_t> m_WorldChanged;
+        std::vector<uint32_t> m_SubtreeEnd;
+        std::vector<NodeId> m_NodeOfSlot;
+
+        // Per NodeId, the structure.
+        std::vector<uint32_t> m_SlotOfNode;
+        std::vector<NodeId> m_Parent;
+        std::vector<NodeId> m_FirstChild;
+        std::vector<NodeId> m_LastChild;
+        std::vector<NodeId> m_NextSibling;
+        std::vector<std::string> m_Names;
+
+        std::unordered_map<std::string, NodeId> m_NodesByName;
+
+        // Slots updated serially before the jobs: the nodes above the job subtrees.
+        std::vector<uint32_t> m_SerialSlots;
+        // Slot ranges updated in parallel, each a subtree or adjacent subtrees.
+        std::vector<std::pair<uint32_t, uint32_t>> m_JobRanges;
+
+        uint32_t m_UpdateIndex = 0;
+        bool m_OrderValid = true;
+        bool m_AnyDirty = false;
+        size_t m_UpdatedNodeCount = 0;
+    };
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <Mesh.h>
+#include <BoundingVolumesPrimitive.h>
+
+#include <DirectXMath.h>
+
+namespace dx12demo::core
+{
+    /* CPU side encoding of PackedVertex.
+    *  Octahedral normal encoding: Cigolle et al., "A Survey of Efficient Representations for Independent Unit Vectors".
+    */
+    class VertexPacker
+    {
+    public:
+        // Unit vector -> [-1, 1]^2.
+        static DirectX::XMFLOAT2 OctahedralEncode(const DirectX::XMFLOAT3& n);
+        static DirectX::XMFLOAT3 OctahedralDecode(const DirectX::XMFLOAT2& e);
+
+        static PackedVertex Pack(const PosNormTexExtendedVertex& vertex, const BAABB& bounds);
+        static PosNormTexExtendedVertex Unpack(const PackedVertex& vertex, const BAABB& bounds);
+
+        // @returns the bounds the positions are quantized in.
+        static BAABB Pack(const VertexExtendedCollection& vertices, PackedVertexCollection& packedVertices);
+
+        // Position = quantized (UNORM) * scale + bias, the values for the vertex shader.
+        static void GetDequantization(const BAABB& bounds, DirectX::XMFLOAT3& scale, DirectX::XMFLOAT3& bias);
+    };
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <Mesh.h>
+
+#include <DirectXMath.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace dx12demo::core
+{
+    // Per component tolerances, the vertices closer than all of them are merged.
+    struct VertexWeldOptions
+    {
+        float PositionEpsilon = 1e-5f;
+        float NormalEpsilon = 1e-3f;
+        float TexCoordEpsilon = 1e-5f;
+    };
+
+    struct VertexWeldReport
+    {
+        size_t VerticesBefore = 0;
+        size_t VerticesAfter = 0;
+        // Triangles collapsed by the merge, removed from the index buffer.
+        size_t RemovedTriangles = 0;
+    };
+
+    /* Merge the duplicated vertices and rebuild the index buffer (a triangle list).
+    *  Positions are hashed in a grid with the PositionEpsilon cell, every vertex is compared
+    *  with the kept vertices of the 27 neighbour cells, so no pair within the tolerance is missed.
+    *  The first vertex of a group is kept, the result depends only on the input order.
+    *  VerticesContainer must have DirectX::XMFLOAT3 m_position, DirectX::XMFLOAT3 m_normal and DirectX::XMFLOAT2 m_texCoord;
+    *  see examples in mesh.h struct PosNormTexExtendedVertex and
+    *  struct PosNormTexVertex
+    */
+    class VertexWelder
+    {
+    public:
+        template<typename VerticesContainer>
+        static VertexWeldReport Weld(std::vector<VerticesContainer>& vertices, IndexCollection& indices, const VertexWeldOptions& options = VertexWeldOptions());
+
+    private:
+        static bool IsEqual(const PosNormTexVertex& a, const PosNormTexVertex& b, const VertexWeldOptions& options);
+        // The tangent frame is compared too, it is set when the file has one.
+        static bool IsEqual(const PosNormTexExtendedVertex& a, const PosNormTexExtendedVertex& b, const VertexWeldOptions& options);
+
+        static bool IsEqual(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b, float epsilon);
+        static bool IsEqual(const DirectX::XMFLOAT2& a, const DirectX::XMFLOAT2& b, float epsilon);
+
+        static void GetCell(const DirectX::XMFLOAT3& position, float cellSize, int64_t cell[3]);
+        static uint64_t HashCell(int64_t x, int64_t y, int64_t z);
+    };
+
+    template<typename VerticesContainer>
+    VertexWeldReport VertexWelder::Weld(std::vector<VerticesContainer>& vertices, IndexCollection& indices, const VertexWeldOptions& options/* = VertexWeldOptions()*/)
+    {
+        VertexWeldReport report;
+        report.VerticesBefore = vertices.size();
+        report.VerticesAfter = vertices.size();
+
+        if (vertices.empty())
+            return report;
+
+        const float cellSize = std::max(options.PositionEpsilon, 1e-12f);
+
+        // Kept vertices per cell hash, a list through next. Different cells with the same hash only cost extra comparisons.
+        std::unordered_map<uint64_t, uint32_t> cellHeads;
+        cellHeads.reserve(vertices.size());
+        std::vector<uint32_t> next;
+        next.reserve(vertices.size());
+
+        std::vector<VerticesContainer> welded;
+        welded.reserve(vertices.size());
+        std::vector<uint32_t> remap(vertices.size());
+
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            const auto& vertex = vertices[i];
+
+            int64_t cell[3];
+            GetCell(vertex.m_position, cellSize, cell);
+
+            uint32_t match = UINT32_MAX;
+            for (int64_t z = cell[2] - 1; z <= cell[2] + 1 && match == UINT32_MAX; ++z)
+            {
+                for (int64_t y = cell[1] - 1; y <= cell[1] + 1 && match == UINT32_MAX; ++y)
+                {
+                    for (int64_t x = cell[0] - 1; x <= cell[0] + 1 && match == UINT32_MAX; ++x)
+                    {
+                        auto head = cellHeads.find(HashCell(x, y, z));
+                        if (head == cellHeads.end())
+                            continue;
+
+                        for (uint32_t candidate = head->second; candidate != UINT32_MAX; candidate = next[candidate])
+                        {
+                            if (IsEqual(welded[candidate], vertex, options))
+                            {
+                                match = candidate;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (match == UINT32_MAX)
+            {
+                match = static_cast<uint32_t>(welded.size());
+                welded.push_back(vertex);
+
+                auto head = cellHeads.try_emplace(HashCell(cell[0], cell[1], cell[2]), UINT32_MAX).first;
+                next.push_back(head->second);
+                head->second = match;
+            }
+
+            remap[i] = match;
+        }
+
+        if (welded.size() == vertices.size())
+            return report;
+
+        size_t indexCount = 0;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            uint32_t a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+            if (a == b || b == c || a == c)
+            {
+                report.RemovedTriangles++;
+                continue;
+            }
+
+            indices[indexCount++] = static_cast<uint16_t>(a);
+            indices[indexCount++] = static_cast<uint16_t>(b);
+            indices[indexCount++] = static_cast<uint16_t>(c);
+        }
+        indices.resize(indexCount);
+
+        vertices.swap(welded);
+        report.VerticesAfter = vertices.size();
+
+        return report;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <VirtualTexturePageTable.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace dx12demo::core
+{
+    struct VirtualPageRequest
+    {
+        VirtualPageId Page;
+        // Feedback texels which requested the page.
+        uint32_t Count = 0;
+    };
+
+    /* Analysis of the feedback buffer read back from the GPU: the VirtualPageId::Pack() of the page every texel sampled,
+    *  VirtualPageId::INVALID where nothing was sampled.
+    *  The buffer is split in chunks counted on the ThreadPool, runs of the same page (the common case) are counted at once.
+    */
+    class VirtualTextureFeedback
+    {
+    public:
+        /**
+         * The histogram of the requested pages, each page once, the pages outside pageTable dropped.
+         * Sorted by priority: the coarser mips first (they are the fallback of the finer ones), then the most requested.
+         */
+        static std::vector<VirtualPageRequest> Analyze(const uint32_t* feedback, size_t count, const VirtualTexturePageTable& pageTable);
+    };
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <ThreadSafeQueue.h>
+#include <TiledTextureFile.h>
+#include <VirtualTextureFeedback.h>
+#include <VirtualTexturePageTable.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace dx12demo::core
+{
+    struct VirtualTextureStatistics
+    {
+        // Distinct pages of the last feedback.
+        size_t RequestedPages = 0;
+        size_t ResidentPages = 0;
+        size_t PendingLoads = 0;
+
+        uint64_t LoadedPages = 0;
+        uint64_t EvictedPages = 0;
+        // Loads finished while every slot was used by the frame, requested again by the next feedback.
+        uint64_t DroppedPages = 0;
+    };
+
+    /* The CPU side of a virtual texture: a TiledTextureFile, its page table and the page loads driven by the feedback.
+    *  Every frame Update analyzes the feedback, maps the pages loaded since the last frame and starts the loads of the missing ones,
+    *  the coarse mips first. The tiles are read from the file on the ThreadPool, the upload callback receives them
+    *  with their slot on the thread calling Update. The last mip (one page) is loaded by Open and pinned, every page has a fallback.
+    *  No GPU involved: the upload and the indirection textures are left to the renderer, synthetic feedback drives it as well.
+    */
+    class VirtualTextureLoader
+    {
+    public:
+        // A loaded tile to copy into the physical atlas at the slot (see VirtualTexturePageTable::GetSlotPosition).
+        using UploadCallback = std::function<void(uint32_t slot, const VirtualPageId& page, const uint8_t* tile)>;
+
+        static constexpr size_t DEFAULT_MAX_LOADS = 16;
+
+        VirtualTextureLoader(uint32_t physicalPagesX, uint32_t physicalPagesY);
+        virtual ~VirtualTextureLoader();
+
+        VirtualTextureLoader(const VirtualTextureLoader& copy) = delete;
+        VirtualTextureLoader& operator=(const VirtualTextureLoader& other) = delete;
+
+        // @returns false if the file isn't a valid TiledTextureFile.
+        bool Open(const std::wstring& fileName, UploadCallback upload);
+
+        /**
+         * One frame of feedback (see VirtualTextureFeedback), at most maxNewLoads loads are started.
+         * The pages loaded since the last call are mapped first, the requested resident pages are kept over the others.
+         */
+        void Update(const uint32_t* feedback, size_t count, size_t maxNewLoads = DEFAULT_MAX_LOADS);
+
+        // Wait for the loads in flight and map them.
+        void Flush();
+
+        VirtualTexturePageTable& GetPageTable();
+        const TiledTextureFile& GetFile() const;
+
+        VirtualTextureStatistics GetStatistics() const;
+
+    private:
+        struct LoadedPage
+        {
+            VirtualPageId Page;
+            std::vector<uint8_t> Tile;
+        };
+
+        void StartLoad(const VirtualPageId& page);
+        void MapLoadedPages();
+        void WaitForLoads();
+
+        TiledTextureFile m_File;
+        std::unique_ptr<VirtualTexturePageTable> m_PageTable;
+        UploadCallback m_Upload;
+
+        uint32_t m_PhysicalPagesX;
+        uint32_t m_PhysicalPagesY;
+
+        // Packed ids of the pages loading.
+        std::unordered_set<uint32_t> m_PendingPages;
+        ThreadSafeQueue<std::shared_ptr<LoadedPage>> m_LoadedPages;
+        std::atomic<size_t> m_LoadsInFlight = 0;
+
+        size_t m_RequestedPages = 0;
+        uint64_t m_LoadedCount = 0;
+        uint64_t m_EvictedCount = 0;
+        uint64_t m_DroppedCount = 0;
+    };
+}
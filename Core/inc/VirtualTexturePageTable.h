@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <vector>
+
+namespace dx12demo::core
+{
+    /* A page of a virtual texture, in pages of its mip.
+    *  Packed as the feedback pass writes it: x in bits 0-11, y in bits 12-23, the mip in bits 24-27.
+    */
+    struct VirtualPageId
+    {
+        static constexpr uint32_t INVALID = UINT32_MAX;
+        static constexpr uint32_t MAX_PAGES = 1 << 12;
+        static constexpr uint32_t MAX_MIPS = 1 << 4;
+
+        uint32_t X = 0;
+        uint32_t Y = 0;
+        uint32_t Mip = 0;
+
+        uint32_t Pack() const
+        {
+            return X | (Y << 12) | (Mip << 24);
+        }
+
+        static VirtualPageId Unpack(uint32_t packed)
+        {
+            return { packed & 0xfff, (packed >> 12) & 0xfff, (packed >> 24) & 0xf };
+        }
+
+        // The page covering this one in the next mip.
+        VirtualPageId GetParent() const
+        {
+            return { X / 2, Y / 2, Mip + 1 };
+        }
+
+        bool operator==(const VirtualPageId& other) const
+        {
+            return X == other.X && Y == other.Y && Mip == other.Mip;
+        }
+    };
+
+    /* Maps the pages of a virtual texture to the slots of a physical page atlas, with an LRU cache of the slots.
+    *  The virtual texture has a page grid per mip down to a single page, the slots are a grid of physicalPagesX * physicalPagesY.
+    *  A page used by the current frame (see BeginFrame and Touch) or pinned isn't evicted.
+    *  The indirection is what the shaders sample: per virtual page the slot and the mip of the finest resident page covering it.
+    *  Only CPU data, the upload of the indirection and of the pages is left to the renderer. Not thread safe.
+    */
+    class VirtualTexturePageTable
+    {
+    public:
+        static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+        // The page counts of mip 0, every mip halves them (rounded up) down to 1x1.
+        VirtualTexturePageTable(uint32_t virtualPagesX, uint32_t virtualPagesY, uint32_t physicalPagesX, uint32_t physicalPagesY);
+        virtual ~VirtualTexturePageTable();
+
+        uint32_t GetMipCount() const;
+        uint32_t GetPagesX(uint32_t mip) const;
+        uint32_t GetPagesY(uint32_t mip) const;
+        bool IsValid(const VirtualPageId& page) const;
+
+        uint32_t GetSlotCount() const;
+        uint32_t GetMappedCount() const;
+        // The free slots and the ones MapPage can evict in the current frame.
+        uint32_t GetAvailableCount() const;
+
+        void BeginFrame();
+
+        bool IsResident(const VirtualPageId& page) const;
+        // INVALID_SLOT if the page isn't resident.
+        uint32_t GetSlot(const VirtualPageId& page) const;
+
+        // Mark a resident page as used by the current frame, the most recently used.
+        void Touch(const VirtualPageId& page);
+
+        /**
+         * Give the page a slot: a free one, or the least recently used one not used by this frame nor pinned.
+         * evicted receives the page which had the slot. A resident page keeps its slot.
+         * @returns INVALID_SLOT if every slot is in use.
+         */
+        uint32_t MapPage(const VirtualPageId& page, bool pinned = false, VirtualPageId* evicted = nullptr);
+
+        void UnmapPage(const VirtualPageId& page);
+
+        // Slot position in the physical atlas, in pages.
+        void GetSlotPosition(uint32_t slot, uint32_t& x, uint32_t& y) const;
+
+        /**
+         * Per page of the mip, row major: physical x in bits 0-7, y in bits 8-15, the mip of the resident page in bits 16-23.
+         * A page without a resident ancestor (not even the last mip) is 0xffffffff.
+         * Rebuilt on the first call after a mapping change.
+         */
+        const std::vector<uint32_t>& GetIndirection(uint32_t mip);
+
+    private:
+        struct Slot
+        {
+            VirtualPageId Page;
+            bool Pinned = false;
+            uint64_t LastUsedFrame = 0;
+            // Position in m_LruOrder, only for the unpinned mapped slots.
+            std::list<uint32_t>::iterator LruPosition;
+        };
+
+        size_t GetEntryIndex(const VirtualPageId& page) const;
+        void RebuildIndirection();
+
+        std::vector<uint32_t> m_PagesX;
+        std::vector<uint32_t> m_PagesY;
+        // Offset of every mip in m_PageSlots.
+        std::vector<size_t> m_MipOffsets;
+        std::vector<uint32_t> m_PageSlots;
+
+        uint32_t m_PhysicalPagesX;
+        std::vector<Slot> m_Slots;
+        std::vector<uint32_t> m_FreeSlots;
+        // Most recently used first.
+        std::list<uint32_t> m_LruOrder;
+
+        std::vector<std::vector<uint32_t>> m_Indirection;
+        bool m_IndirectionDirty = true;
+
+        uint64_t m_Frame = 1;
+    };
+}
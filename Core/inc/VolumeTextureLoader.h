@@ -0,0 +1,34 @@
+#pragma once
+
+#include <DirectXTex.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dx12demo::core
+{
+    /* Volume textures assembled from 2D slice images, the VolumetricClouds noise.
+    *  The slices are decoded with stb_image on the ThreadPool straight into their depth slice of the volume,
+    *  the mip chain is generated by DirectXTex and Load caches the whole volume as a single 3D DDS file,
+    *  the later loads read one file instead of decoding every slice.
+    */
+    class VolumeTextureLoader
+    {
+    public:
+        /**
+         * Decode the slices (in z order) to a volume of width x height x slice count, of a 4 channel 8 bit format.
+         * Throws if a slice can't be decoded or is of another size.
+         */
+        static void LoadSlices(const std::vector<std::string>& slicePaths, uint32_t width, uint32_t height, DXGI_FORMAT format, DirectX::ScratchImage& volume);
+
+        // The full mip chain of a volume without mips, every level 2x2x2 smaller.
+        static void GenerateMips(const DirectX::ScratchImage& volume, DirectX::ScratchImage& mipChain);
+
+        /**
+         * Load the cached volume with its mips, assembling it from the slices and writing the cache first
+         * if the cache is missing, older than a slice or of another size or format.
+         */
+        static void Load(const std::vector<std::string>& slicePaths, const std::wstring& cachePath, uint32_t width, uint32_t height, DXGI_FORMAT format, DirectX::ScratchImage& volume);
+    };
+}
@@ -29,6 +29,9 @@ namespace dx12demo::core
 
 		std::wstring weathermap_path = L"Assets/Textures/bitmap_clouds/weather_map.png";
 
+		// Generate the Perlin-Worley noise volumes with CloudNoiseGenerator instead of loading the bitmap_clouds slices.
+		bool proceduralNoise = false;
+
 		int skyPlaneResolution = 10;
 		float skyPlaneWidth = 10.0f;
 		float skyPlaneTop = 0.5f;
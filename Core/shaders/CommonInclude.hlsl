@@ -269,9 +269,11 @@ bool PointInsidePlane(in float3 p, in Plane plane)
     return dot(plane.N, p) - plane.d < 0;
 };
 
+// The normal maps may have only x and y (BC5), z is rebuilt from them.
 float3 ExpandNormal(in float3 n)
 {
-    return n * 2.0f - 1.0f;
+    float2 xy = n.xy * 2.0f - 1.0f;
+    return float3(xy, sqrt(saturate(1.0f - dot(xy, xy))));
 }
 
 float3 DoNormalMapping(in float3 normalFromTex, in float3x3 TBN)
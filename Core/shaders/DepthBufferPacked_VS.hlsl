@@ -0,0 +1,37 @@
+#include "PackedVertexInclude.hlsl"
+
+struct Mat
+{
+    matrix ModelMatrix;
+    matrix ModelViewMatrix;
+    matrix InverseTransposeModelViewMatrix;
+    matrix ModelViewProjectionMatrix;
+};
+
+ConstantBuffer<Mat> MatCB : register(b0);
+ConstantBuffer<PackedVertexDequantization> DequantizationCB : register(b1);
+
+// Rows of the instance world transform, the identity for the meshes drawn once (see Scene::Render).
+struct InstanceInput
+{
+    float4 InstanceRow0 : INSTANCE_TRANSFORM0;
+    float4 InstanceRow1 : INSTANCE_TRANSFORM1;
+    float4 InstanceRow2 : INSTANCE_TRANSFORM2;
+    float4 InstanceRow3 : INSTANCE_TRANSFORM3;
+};
+
+struct VertexShaderOutput
+{
+    float4 Position : SV_POSITION;
+};
+
+VertexShaderOutput main(PackedVertexShaderInput IN, InstanceInput instance)
+{
+    VertexShaderOutput OUT;
+
+    float4x4 instanceMatrix = float4x4(instance.InstanceRow0, instance.InstanceRow1, instance.InstanceRow2, instance.InstanceRow3);
+    float3 position = DequantizePosition(IN.Position, DequantizationCB);
+    OUT.Position = mul(MatCB.ModelViewProjectionMatrix, mul(float4(position, 1.0f), instanceMatrix));
+
+    return OUT;
+}
@@ -13,6 +13,11 @@ struct VertexShaderInput
     float3 Position : POSITION;
     float3 Normal    : NORMAL;
     float2 TexCoord  : TEXCOORD;
+    // Rows of the instance world transform, the identity for the meshes drawn once (see Scene::Render).
+    float4 InstanceRow0 : INSTANCE_TRANSFORM0;
+    float4 InstanceRow1 : INSTANCE_TRANSFORM1;
+    float4 InstanceRow2 : INSTANCE_TRANSFORM2;
+    float4 InstanceRow3 : INSTANCE_TRANSFORM3;
 };
 
 struct VertexShaderOutput
@@ -24,7 +29,8 @@ VertexShaderOutput main(VertexShaderInput IN)
 {
     VertexShaderOutput OUT;
 
-    OUT.Position = mul(MatCB.ModelViewProjectionMatrix, float4(IN.Position, 1.0f));
+    float4x4 instanceMatrix = float4x4(IN.InstanceRow0, IN.InstanceRow1, IN.InstanceRow2, IN.InstanceRow3);
+    OUT.Position = mul(MatCB.ModelViewProjectionMatrix, mul(float4(IN.Position, 1.0f), instanceMatrix));
 
     return OUT;
 }
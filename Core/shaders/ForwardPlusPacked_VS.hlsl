@@ -0,0 +1,55 @@
+#include "PackedVertexInclude.hlsl"
+
+struct Mat
+{
+    matrix ModelMatrix;
+    matrix ModelViewMatrix;
+    matrix InverseTransposeModelViewMatrix;
+    matrix ModelViewProjectionMatrix;
+};
+
+ConstantBuffer<Mat> MatCB : register(b0);
+// b1 is the environment of ForwardPlus_PS.
+ConstantBuffer<PackedVertexDequantization> DequantizationCB : register(b2);
+
+// Rows of the instance world transform, the identity for the meshes drawn once (see Scene::Render).
+struct InstanceInput
+{
+    float4 InstanceRow0 : INSTANCE_TRANSFORM0;
+    float4 InstanceRow1 : INSTANCE_TRANSFORM1;
+    float4 InstanceRow2 : INSTANCE_TRANSFORM2;
+    float4 InstanceRow3 : INSTANCE_TRANSFORM3;
+};
+
+struct VertexShaderOutput
+{
+    float4 PositionVS  : POSITION;
+    float2 TexCoord    : TEXCOORD;
+    float4 Position    : SV_POSITION;
+    float3 NormalVS    : NORMAL;
+    float3 TangentVS   : TANGENT;      // View space tangent.
+    float3 BinormalVS  : BINORMAL;     // View space binormal.
+};
+
+// ForwardPlus_VS of PackedVertex.
+VertexShaderOutput main(PackedVertexShaderInput IN, InstanceInput instance)
+{
+    VertexShaderOutput OUT;
+
+    float3 normal = OctahedralDecode(IN.Normal);
+    float3 tangent = OctahedralDecode(IN.Tangent);
+    float3 bitangent = DecodeBitangent(normal, tangent, IN.Position);
+
+    // Row vector convention, as DirectXMath stores the matrix. Uniform scale only, the normals aren't inverse transposed.
+    float4x4 instanceMatrix = float4x4(instance.InstanceRow0, instance.InstanceRow1, instance.InstanceRow2, instance.InstanceRow3);
+    float4 position = mul(float4(DequantizePosition(IN.Position, DequantizationCB), 1.0f), instanceMatrix);
+
+    OUT.PositionVS = mul(MatCB.ModelViewMatrix, position);
+    OUT.Position = mul(MatCB.ModelViewProjectionMatrix, position);
+    OUT.TexCoord = IN.TexCoord;
+    OUT.NormalVS = mul((float3x3)MatCB.ModelViewMatrix, mul(normal, (float3x3)instanceMatrix));
+    OUT.TangentVS = mul((float3x3)MatCB.ModelViewMatrix, mul(tangent, (float3x3)instanceMatrix));
+    OUT.BinormalVS = mul((float3x3)MatCB.ModelViewMatrix, mul(bitangent, (float3x3)instanceMatrix));
+
+    return OUT;
+}
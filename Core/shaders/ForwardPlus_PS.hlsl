@@ -1,4 +1,5 @@
 #include "CommonInclude.hlsl"
+#include "SphericalHarmonicsInclude.hlsl"
 
 #define BLOCK_SIZE 16
 
@@ -21,7 +22,27 @@ Texture2D<uint2> LightGrid : register(t4);
 StructuredBuffer<Light> Lights : register(t5);
 StructuredBuffer<uint>  LightIndexList : register(t6);
 
+// The environment lighting baked by EnvironmentMapRenderPass, in world space.
+struct Environment
+{
+    matrix InverseViewMatrix;
+    SHIrradiance Irradiance;
+    float PrefilteredMips;
+    float Roughness;
+    float Intensity;
+    float Padding;
+};
+
+ConstantBuffer<Environment> EnvironmentCB : register(b1);
+
+TextureCube PrefilteredTexture : register(t7);
+Texture2D<float2> BRDFTexture : register(t8);
+
 SamplerState LinearRepeatSampler : register(s0);
+SamplerState LinearClampSampler : register(s1);
+
+// Of the dielectrics, the specular texture scales it.
+static const float3 ENVIRONMENT_F0 = float3(0.04f, 0.04f, 0.04f);
 
 [earlydepthstencil]
 float4 main(VertexShaderOutput IN) : SV_Target0
@@ -88,9 +109,16 @@ float4 main(VertexShaderOutput IN) : SV_Target0
         lightsRes.Specular += result.Specular;
     }
     
+    // The ambient is the SH irradiance of the environment, the specular gets its split sum reflection.
+    float3 normalWS = normalize(mul((float3x3)EnvironmentCB.InverseViewMatrix, N));
+    float3 reflectionWS = normalize(mul((float3x3)EnvironmentCB.InverseViewMatrix, reflect(-V, N)));
+    float3 environmentDiffuse = EvaluateSHIrradiance(EnvironmentCB.Irradiance, normalWS);
+    float3 environmentSpecular = EvaluateSplitSum(PrefilteredTexture, BRDFTexture, LinearClampSampler, reflectionWS,
+        saturate(dot(N, V)), EnvironmentCB.Roughness, ENVIRONMENT_F0, EnvironmentCB.PrefilteredMips);
+
     diffuse *= lightsRes.Diffuse;
-    specular *= lightsRes.Specular;
-    ambient *= 0.1;
+    specular.rgb *= lightsRes.Specular.rgb + environmentSpecular * EnvironmentCB.Intensity;
+    ambient.rgb *= environmentDiffuse * EnvironmentCB.Intensity;
     
     return float4((ambient + diffuse + specular).rgb, ambient.a);
 }
@@ -15,6 +15,11 @@ struct VertexPositionNormalTexture
     float2 TexCoord  : TEXCOORD;
     float3 Tangent   : TANGENT;
     float3 Bitangent : BITANGENT;
+    // Rows of the instance world transform, the identity for the meshes drawn once (see Scene::Render).
+    float4 InstanceRow0 : INSTANCE_TRANSFORM0;
+    float4 InstanceRow1 : INSTANCE_TRANSFORM1;
+    float4 InstanceRow2 : INSTANCE_TRANSFORM2;
+    float4 InstanceRow3 : INSTANCE_TRANSFORM3;
 };
 
 struct VertexShaderOutput
@@ -31,12 +36,16 @@ VertexShaderOutput main(VertexPositionNormalTexture IN)
 {
     VertexShaderOutput OUT;
 
-    OUT.PositionVS = mul(MatCB.ModelViewMatrix, float4(IN.Position, 1.0f));
-    OUT.Position = mul(MatCB.ModelViewProjectionMatrix, float4(IN.Position, 1.0f));
+    // Row vector convention, as DirectXMath stores the matrix. Uniform scale only, the normals aren't inverse transposed.
+    float4x4 instanceMatrix = float4x4(IN.InstanceRow0, IN.InstanceRow1, IN.InstanceRow2, IN.InstanceRow3);
+    float4 position = mul(float4(IN.Position, 1.0f), instanceMatrix);
+
+    OUT.PositionVS = mul(MatCB.ModelViewMatrix, position);
+    OUT.Position = mul(MatCB.ModelViewProjectionMatrix, position);
     OUT.TexCoord = IN.TexCoord;
-    OUT.NormalVS = mul((float3x3)MatCB.ModelViewMatrix, IN.Normal);
-    OUT.TangentVS = mul((float3x3)MatCB.ModelViewMatrix, IN.Tangent);
-    OUT.BinormalVS = mul((float3x3)MatCB.ModelViewMatrix, IN.Bitangent);
+    OUT.NormalVS = mul((float3x3)MatCB.ModelViewMatrix, mul(IN.Normal, (float3x3)instanceMatrix));
+    OUT.TangentVS = mul((float3x3)MatCB.ModelViewMatrix, mul(IN.Tangent, (float3x3)instanceMatrix));
+    OUT.BinormalVS = mul((float3x3)MatCB.ModelViewMatrix, mul(IN.Bitangent, (float3x3)instanceMatrix));
 
     return OUT;
 }
\ No newline at end of file
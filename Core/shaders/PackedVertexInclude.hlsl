@@ -0,0 +1,42 @@
+// Decoding of PackedVertex (see Core/inc/Mesh.h and VertexPacker), Scene::Render binds the PackedVertexDequantization of the mesh.
+
+struct PackedVertexShaderInput
+{
+    float4 Position : POSITION; // Quantized in the mesh AABB, w - bitangent sign (0 or 1).
+    float2 Normal   : NORMAL;   // Octahedral encoded.
+    float2 Tangent  : TANGENT;  // Octahedral encoded.
+    float2 TexCoord : TEXCOORD;
+};
+
+struct PackedVertexDequantization
+{
+    float3 PositionScale;
+    float  Padding0;
+    float3 PositionBias;
+    float  Padding1;
+};
+
+float3 OctahedralDecode(float2 e)
+{
+    float3 n = float3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += n.xy >= 0.0f ? -t : t;
+    return normalize(n);
+}
+
+float3 DequantizePosition(float4 position, PackedVertexDequantization dequantization)
+{
+    return position.xyz * dequantization.PositionScale + dequantization.PositionBias;
+}
+
+float3 DecodeBitangent(float3 normal, float3 tangent, float4 position)
+{
+    return cross(normal, tangent) * (position.w > 0.5f ? 1.0f : -1.0f);
+}
+
+// it`s fake. not work
+[numthreads(1, 1, 1)]
+void main_fake()
+{
+
+}
@@ -0,0 +1,40 @@
+// Diffuse environment lighting from the SH irradiance of EnvironmentBaker (see Core/inc/EnvironmentBaker.h).
+
+struct SHIrradiance
+{
+    float4 Coefficients[9]; // RGB in xyz.
+};
+
+// The irradiance divided by pi for the normalized normal n, multiplied by the albedo it is the diffuse lighting.
+float3 EvaluateSHIrradiance(SHIrradiance sh, float3 n)
+{
+    float3 result = sh.Coefficients[0].rgb * 0.282095f;
+
+    result += sh.Coefficients[1].rgb * (0.488603f * n.y);
+    result += sh.Coefficients[2].rgb * (0.488603f * n.z);
+    result += sh.Coefficients[3].rgb * (0.488603f * n.x);
+
+    result += sh.Coefficients[4].rgb * (1.092548f * n.x * n.y);
+    result += sh.Coefficients[5].rgb * (1.092548f * n.y * n.z);
+    result += sh.Coefficients[6].rgb * (0.315392f * (3.0f * n.z * n.z - 1.0f));
+    result += sh.Coefficients[7].rgb * (1.092548f * n.x * n.z);
+    result += sh.Coefficients[8].rgb * (0.546274f * (n.x * n.x - n.y * n.y));
+
+    return max(result, 0.0f);
+}
+
+// The split sum specular: the prefiltered environment of the roughness times F0 scaled and biased by the BRDF table.
+float3 EvaluateSplitSum(TextureCube prefiltered, Texture2D<float2> brdf, SamplerState linearClamp,
+    float3 r, float NdotV, float roughness, float3 f0, float prefilteredMips)
+{
+    float3 radiance = prefiltered.SampleLevel(linearClamp, r, roughness * (prefilteredMips - 1.0f)).rgb;
+    float2 scaleBias = brdf.SampleLevel(linearClamp, float2(NdotV, roughness), 0.0f);
+    return radiance * (f0 * scaleBias.x + scaleBias.y);
+}
+
+// it`s fake. not work
+[numthreads(1, 1, 1)]
+void main_fake()
+{
+
+}
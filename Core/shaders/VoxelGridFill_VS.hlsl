@@ -5,6 +5,11 @@ struct VertexPositionNormalTexture
     float2 TexCoord  : TEXCOORD;
     float3 Tangent   : TANGENT;
     float3 Bitangent : BITANGENT;
+    // Rows of the instance world transform, the identity for the meshes drawn once (see Scene::Render).
+    float4 InstanceRow0 : INSTANCE_TRANSFORM0;
+    float4 InstanceRow1 : INSTANCE_TRANSFORM1;
+    float4 InstanceRow2 : INSTANCE_TRANSFORM2;
+    float4 InstanceRow3 : INSTANCE_TRANSFORM3;
 };
 
 struct VertexShaderOutput
@@ -25,9 +30,12 @@ VertexShaderOutput main(VertexPositionNormalTexture IN)
 {
     VertexShaderOutput OUT;
 
-    OUT.Position = mul(bMatCB.ModelMatrix, float4(IN.Position, 1.0f));
+    // Row vector convention, as DirectXMath stores the matrix. Uniform scale only, the normals aren't inverse transposed.
+    float4x4 instanceMatrix = float4x4(IN.InstanceRow0, IN.InstanceRow1, IN.InstanceRow2, IN.InstanceRow3);
+
+    OUT.Position = mul(bMatCB.ModelMatrix, mul(float4(IN.Position, 1.0f), instanceMatrix));
     OUT.TexCoord = IN.TexCoord;
-    OUT.Normal  = IN.Normal;
+    OUT.Normal  = mul(IN.Normal, (float3x3)instanceMatrix);
 
     return OUT;
 }
\ No newline at end of file
@@ -3,9 +3,11 @@
 #include <DX12LibPCH.h>
 
 #include <Game.h>
+#include <CommandList.h>
 #include <CommandQueue.h>
 #include <Window.h>
 #include <DescriptorAllocator.h>
+#include <MeshPool.h>
 #include <URootObject.h>
 
 using namespace dx12demo::core;
@@ -78,6 +80,9 @@ Application::Application(HINSTANCE hInst)
 Application::~Application()
 {
     Flush();
+
+    // The cached textures are released with the device, not at the static destruction.
+    CommandList::GetTextureCache().EvictUnreferenced();
 }
 
 void Application::Initialize()
@@ -122,6 +127,8 @@ void Application::Initialize()
         m_DescriptorAllocators[i] = std::make_unique<DescriptorAllocator>(static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(i));
     }
 
+    m_MeshPool = std::make_shared<MeshPool>();
+
     // Initialize frame counter 
     m_FrameCount = 0;
 }
@@ -436,9 +443,23 @@ uint64_t Application::GetFrameCount() const
     return m_FrameCount;
 }
 
+std::shared_ptr<MeshPool> Application::GetMeshPool() const
+{
+    return m_MeshPool;
+}
+
 void Application::IncFrameCount()
 {
     ++m_FrameCount;
+
+    m_CommandListStatistics = m_DirectCommandQueue->ResetStatistics();
+    m_CommandListStatistics += m_ComputeCommandQueue->ResetStatistics();
+    m_CommandListStatistics += m_CopyCommandQueue->ResetStatistics();
+}
+
+const CommandListStatistics& Application::GetCommandListStatistics() const
+{
+    return m_CommandListStatistics;
 }
 
 DescriptorAllocation Application::AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors/* = 1*/)
@@ -452,6 +473,8 @@ void Application::ReleaseStaleDescriptors(uint64_t finishedFrame)
     {
         m_DescriptorAllocators[i]->ReleaseStaleDescriptors(finishedFrame);
     }
+
+    m_MeshPool->ReleaseStaleAllocations(finishedFrame);
 }
 
 MouseButtonEventArgs::MouseButton DecodeMouseButton(UINT messageID)
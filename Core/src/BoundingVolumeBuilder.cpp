@@ -0,0 +1,409 @@
+#include <BoundingVolumeBuilder.h>
+
+#include <DX12LibPCH.h>
+
+#include <cfloat>
+#include <random>
+
+using namespace dx12demo::core;
+
+namespace
+{
+    // The sphere fitting is done in doubles, the circumsphere solutions are badly conditioned for nearly degenerate point sets.
+    struct Vector3d
+    {
+        double x = 0.0, y = 0.0, z = 0.0;
+
+        Vector3d() = default;
+        Vector3d(double x, double y, double z) : x(x), y(y), z(z) {}
+        explicit Vector3d(const DirectX::XMFLOAT3& v) : x(v.x), y(v.y), z(v.z) {}
+
+        Vector3d operator+(const Vector3d& v) const { return { x + v.x, y + v.y, z + v.z }; }
+        Vector3d operator-(const Vector3d& v) const { return { x - v.x, y - v.y, z - v.z }; }
+        Vector3d operator*(double s) const { return { x * s, y * s, z * s }; }
+    };
+
+    double Dot(const Vector3d& a, const Vector3d& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    Vector3d Cross(const Vector3d& a, const Vector3d& b)
+    {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    struct Sphere
+    {
+        Vector3d center;
+        // Squared radius, negative for the empty sphere.
+        double radiusSq = -1.0;
+
+        bool Contains(const Vector3d& p) const
+        {
+            if (radiusSq < 0.0)
+                return false;
+
+            Vector3d d = p - center;
+            // Relative tolerance against the rounding errors of the circumsphere solutions.
+            return Dot(d, d) <= radiusSq * (1.0 + 1e-9) + 1e-12;
+        }
+    };
+
+    Sphere SphereFrom2(const Vector3d& a, const Vector3d& b)
+    {
+        Sphere sphere;
+        sphere.center = (a + b) * 0.5;
+        Vector3d d = a - sphere.center;
+        sphere.radiusSq = Dot(d, d);
+        return sphere;
+    }
+
+    Sphere SphereFrom3(const Vector3d& a, const Vector3d& b, const Vector3d& c)
+    {
+        Vector3d ab = b - a;
+        Vector3d ac = c - a;
+        Vector3d normal = Cross(ab, ac);
+        double normalSq = Dot(normal, normal);
+
+        // Collinear points, the sphere of the farthest pair.
+        if (normalSq <= 1e-18 * Dot(ab, ab) * Dot(ac, ac))
+        {
+            Sphere sphere = SphereFrom2(a, b);
+            Sphere other = SphereFrom2(a, c);
+            if (other.radiusSq > sphere.radiusSq)
+                sphere = other;
+            other = SphereFrom2(b, c);
+            if (other.radiusSq > sphere.radiusSq)
+                sphere = other;
+            return sphere;
+        }
+
+        // Circumcenter in the triangle plane.
+        Vector3d offset = (Cross(normal, ab) * Dot(ac, ac) + Cross(ac, normal) * Dot(ab, ab)) * (0.5 / normalSq);
+
+        Sphere sphere;
+        sphere.center = a + offset;
+        sphere.radiusSq = Dot(offset, offset);
+        return sphere;
+    }
+
+    Sphere SphereFrom4(const Vector3d& a, const Vector3d& b, const Vector3d& c, const Vector3d& d)
+    {
+        Vector3d ab = b - a;
+        Vector3d ac = c - a;
+        Vector3d ad = d - a;
+
+        double det = Dot(ab, Cross(ac, ad));
+        double scale = sqrt(Dot(ab, ab) * Dot(ac, ac) * Dot(ad, ad));
+
+        // Coplanar points, the smallest circumcircle sphere which holds all four.
+        if (fabs(det) <= 1e-12 * scale)
+        {
+            const Vector3d* points[4] = { &a, &b, &c, &d };
+            Sphere best;
+            for (int skip = 0; skip < 4; ++skip)
+            {
+                const Vector3d* triangle[3];
+                int count = 0;
+                for (int i = 0; i < 4; ++i)
+                {
+                    if (i != skip)
+                        triangle[count++] = points[i];
+                }
+
+                Sphere sphere = SphereFrom3(*triangle[0], *triangle[1], *triangle[2]);
+                if (sphere.Contains(*points[skip]) && (best.radiusSq < 0.0 || sphere.radiusSq < best.radiusSq))
+                    best = sphere;
+            }
+            return best;
+        }
+
+        // Solve 2 * [ab; ac; ad] * offset = [|ab|^2; |ac|^2; |ad|^2] by the Cramer's rule.
+        Vector3d offset = (Cross(ac, ad) * Dot(ab, ab) + Cross(ad, ab) * Dot(ac, ac) + Cross(ab, ac) * Dot(ad, ad)) * (0.5 / det);
+
+        Sphere sphere;
+        sphere.center = a + offset;
+        sphere.radiusSq = Dot(offset, offset);
+        return sphere;
+    }
+
+    Sphere SphereFromSupport(const Vector3d* support, size_t supportCount)
+    {
+        Sphere sphere;
+        switch (supportCount)
+        {
+        case 1:
+            sphere.center = support[0];
+            sphere.radiusSq = 0.0;
+            break;
+        case 2:
+            sphere = SphereFrom2(support[0], support[1]);
+            break;
+        case 3:
+            sphere = SphereFrom3(support[0], support[1], support[2]);
+            break;
+        case 4:
+            sphere = SphereFrom4(support[0], support[1], support[2], support[3]);
+            break;
+        }
+        return sphere;
+    }
+
+    // Smallest sphere of the first count points with the support points on the boundary.
+    // The recursion depth is bounded by the support size (at most 4 points).
+    Sphere WelzlSphere(const std::vector<Vector3d>& points, size_t count, Vector3d* support, size_t supportCount)
+    {
+        Sphere sphere = SphereFromSupport(support, supportCount);
+        if (supportCount == 4)
+            return sphere;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (sphere.Contains(points[i]))
+                continue;
+
+            support[supportCount] = points[i];
+            sphere = WelzlSphere(points, i, support, supportCount + 1);
+        }
+
+        return sphere;
+    }
+
+    // Radius which holds all points around the center, guards the result against the rounding errors.
+    BSphere EncloseAll(const std::vector<DirectX::XMFLOAT3>& positions, const DirectX::XMFLOAT3& center)
+    {
+        BSphere sphere;
+        sphere.pos = center;
+        sphere.r = 0.f;
+        for (const auto& position : positions)
+            sphere.r = std::max(sphere.r, Math::float3Radius(position, center));
+
+        return sphere;
+    }
+
+    // Eigen decomposition of a symmetric 3x3 matrix by the cyclic Jacobi rotations, the eigenvectors are the columns of v.
+    void JacobiEigenvectors(double a[3][3], double v[3][3])
+    {
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                v[i][j] = i == j ? 1.0 : 0.0;
+
+        const int MAX_SWEEPS = 32;
+        for (int sweep = 0; sweep < MAX_SWEEPS; ++sweep)
+        {
+            double offDiagonal = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+            double diagonal = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+            if (offDiagonal <= 1e-24 * diagonal || offDiagonal == 0.0)
+                break;
+
+            for (int p = 0; p < 2; ++p)
+            {
+                for (int q = p + 1; q < 3; ++q)
+                {
+                    if (a[p][q] == 0.0)
+                        continue;
+
+                    double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                    double t = (theta >= 0.0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                    double c = 1.0 / sqrt(t * t + 1.0);
+                    double s = t * c;
+
+                    // A' = J^T * A * J
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        double akp = a[k][p];
+                        double akq = a[k][q];
+                        a[k][p] = c * akp - s * akq;
+                        a[k][q] = s * akp + c * akq;
+                    }
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        double apk = a[p][k];
+                        double aqk = a[q][k];
+                        a[p][k] = c * apk - s * aqk;
+                        a[q][k] = s * apk + c * aqk;
+                    }
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        double vkp = v[k][p];
+                        double vkq = v[k][q];
+                        v[k][p] = c * vkp - s * vkq;
+                        v[k][q] = s * vkp + c * vkq;
+                    }
+                }
+            }
+        }
+    }
+}
+
+BAABB BoundingVolumeBuilder::ComputeAABB(const std::vector<DirectX::XMFLOAT3>& positions)
+{
+    CollectorBVData collectorBVData;
+    for (const auto& position : positions)
+        collectorBVData.Collect(position);
+
+    BAABB aabb;
+    aabb.box_min = positions.empty() ? DirectX::XMFLOAT3(0.f, 0.f, 0.f) : collectorBVData.GetMin();
+    aabb.box_max = positions.empty() ? DirectX::XMFLOAT3(0.f, 0.f, 0.f) : collectorBVData.GetMax();
+    return aabb;
+}
+
+BSphere BoundingVolumeBuilder::ComputeRitterSphere(const std::vector<DirectX::XMFLOAT3>& positions)
+{
+    BSphere sphere;
+    sphere.pos = { 0.f, 0.f, 0.f };
+    sphere.r = 0.f;
+
+    if (positions.empty())
+        return sphere;
+
+    // The initial sphere is spanned by the most distant pair of the extreme points along the axes.
+    size_t minIndex[3] = { 0, 0, 0 };
+    size_t maxIndex[3] = { 0, 0, 0 };
+    for (size_t i = 1; i < positions.size(); ++i)
+    {
+        const float* position = &positions[i].x;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (position[axis] < (&positions[minIndex[axis]].x)[axis])
+                minIndex[axis] = i;
+            if (position[axis] > (&positions[maxIndex[axis]].x)[axis])
+                maxIndex[axis] = i;
+        }
+    }
+
+    int widestAxis = 0;
+    float widestDistance = -1.f;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float distance = Math::float3Radius(positions[minIndex[axis]], positions[maxIndex[axis]]);
+        if (distance > widestDistance)
+        {
+            widestDistance = distance;
+            widestAxis = axis;
+        }
+    }
+
+    Vector3d center = (Vector3d(positions[minIndex[widestAxis]]) + Vector3d(positions[maxIndex[widestAxis]])) * 0.5;
+    double radius = widestDistance * 0.5;
+
+    // Grow the sphere to the points outside, the new sphere touches the point and the opposite side of the old one.
+    for (const auto& position : positions)
+    {
+        Vector3d p(position);
+        Vector3d d = p - center;
+        double distanceSq = Dot(d, d);
+        if (distanceSq <= radius * radius)
+            continue;
+
+        double distance = sqrt(distanceSq);
+        double newRadius = (radius + distance) * 0.5;
+        center = center + d * ((newRadius - radius) / distance);
+        radius = newRadius;
+    }
+
+    return EncloseAll(positions, DirectX::XMFLOAT3(static_cast<float>(center.x), static_cast<float>(center.y), static_cast<float>(center.z)));
+}
+
+BSphere BoundingVolumeBuilder::ComputeMinimalSphere(const std::vector<DirectX::XMFLOAT3>& positions)
+{
+    if (positions.empty())
+        return ComputeRitterSphere(positions);
+
+    std::vector<Vector3d> points(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i)
+        points[i] = Vector3d(positions[i]);
+
+    // The expected linear time depends on the random order, the fixed seed keeps the result deterministic.
+    std::mt19937 random(0x5eed);
+    std::shuffle(points.begin(), points.end(), random);
+
+    Vector3d support[4];
+    Sphere sphere = WelzlSphere(points, points.size(), support, 0);
+
+    return EncloseAll(positions, DirectX::XMFLOAT3(static_cast<float>(sphere.center.x), static_cast<float>(sphere.center.y), static_cast<float>(sphere.center.z)));
+}
+
+BOBB BoundingVolumeBuilder::ComputeOBB(const std::vector<DirectX::XMFLOAT3>& positions)
+{
+    BOBB aabbBox = ToOBB(ComputeAABB(positions));
+    if (positions.size() < 3)
+        return aabbBox;
+
+    Vector3d mean;
+    for (const auto& position : positions)
+        mean = mean + Vector3d(position);
+    mean = mean * (1.0 / positions.size());
+
+    double covariance[3][3] = {};
+    for (const auto& position : positions)
+    {
+        Vector3d d = Vector3d(position) - mean;
+        const double values[3] = { d.x, d.y, d.z };
+        for (int i = 0; i < 3; ++i)
+            for (int j = i; j < 3; ++j)
+                covariance[i][j] += values[i] * values[j];
+    }
+    covariance[1][0] = covariance[0][1];
+    covariance[2][0] = covariance[0][2];
+    covariance[2][1] = covariance[1][2];
+
+    double eigenvectors[3][3];
+    JacobiEigenvectors(covariance, eigenvectors);
+
+    Vector3d axes[3];
+    for (int axis = 0; axis < 3; ++axis)
+        axes[axis] = Vector3d(eigenvectors[0][axis], eigenvectors[1][axis], eigenvectors[2][axis]);
+
+    // Re-orthonormalize, the box must stay a box after the float conversion.
+    axes[0] = axes[0] * (1.0 / sqrt(Dot(axes[0], axes[0])));
+    axes[1] = axes[1] - axes[0] * Dot(axes[0], axes[1]);
+    axes[1] = axes[1] * (1.0 / sqrt(Dot(axes[1], axes[1])));
+    axes[2] = Cross(axes[0], axes[1]);
+
+    double minProjection[3] = { DBL_MAX, DBL_MAX, DBL_MAX };
+    double maxProjection[3] = { -DBL_MAX, -DBL_MAX, -DBL_MAX };
+    for (const auto& position : positions)
+    {
+        Vector3d p(position);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            double projection = Dot(p, axes[axis]);
+            minProjection[axis] = std::min(minProjection[axis], projection);
+            maxProjection[axis] = std::max(maxProjection[axis], projection);
+        }
+    }
+
+    BOBB obb;
+    Vector3d center;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        center = center + axes[axis] * ((minProjection[axis] + maxProjection[axis]) * 0.5);
+        (&obb.extents.x)[axis] = static_cast<float>((maxProjection[axis] - minProjection[axis]) * 0.5);
+        obb.axes[axis] = DirectX::XMFLOAT3(static_cast<float>(axes[axis].x), static_cast<float>(axes[axis].y), static_cast<float>(axes[axis].z));
+    }
+    obb.center = DirectX::XMFLOAT3(static_cast<float>(center.x), static_cast<float>(center.y), static_cast<float>(center.z));
+
+    // The principal axes are not optimal for every shape, e.g. for boxy meshes with uneven vertex density.
+    return GetVolume(obb) < GetVolume(aabbBox) ? obb : aabbBox;
+}
+
+BOBB BoundingVolumeBuilder::ToOBB(const BAABB& aabb)
+{
+    BOBB obb;
+    obb.center = aabb.box_min;
+    Math::float3Add(obb.center, aabb.box_max);
+    Math::float3Mult(obb.center, 0.5f);
+    obb.extents = Math::float3Substruct(aabb.box_max, aabb.box_min);
+    Math::float3Mult(obb.extents, 0.5f);
+    obb.axes[0] = { 1.f, 0.f, 0.f };
+    obb.axes[1] = { 0.f, 1.f, 0.f };
+    obb.axes[2] = { 0.f, 0.f, 1.f };
+    return obb;
+}
+
+float BoundingVolumeBuilder::GetVolume(const BOBB& obb)
+{
+    return 8.f * obb.extents.x * obb.extents.y * obb.extents.z;
+}
@@ -0,0 +1,275 @@
+#include <CloudNoiseGenerator.h>
+
+#include <DX12LibPCH.h>
+
+#include <ThreadPool.h>
+#include <VolumeTextureLoader.h>
+
+#include <DirectXPackedVector.h>
+
+using namespace dx12demo::core;
+using namespace DirectX;
+
+namespace
+{
+    // Lattice cells across the volume of the first octave of the first channel, every channel and octave doubles them.
+    const int32_t LOW_FREQUENCY_PERIOD = 4;
+    const int32_t HIGH_FREQUENCY_PERIOD = 2;
+
+    // Perlin fBm octaves of the Perlin-Worley channel.
+    const uint32_t PERLIN_OCTAVES = 5;
+
+    // The seeds of the channels are this far apart, every octave of a channel adds 1.
+    const uint32_t CHANNEL_SEED_STRIDE = 16;
+
+    // The feature point coordinates in a cell are 10 bits of the cell hash.
+    const float FEATURE_POINT_SCALE = 1.f / 1024.f;
+
+    // The 12 gradients of the improved Perlin noise, the edges of a cube.
+    const float GRADIENTS[12][3] = {
+        {  1,  1,  0 }, { -1,  1,  0 }, {  1, -1,  0 }, { -1, -1,  0 },
+        {  1,  0,  1 }, { -1,  0,  1 }, {  1,  0, -1 }, { -1,  0, -1 },
+        {  0,  1,  1 }, {  0, -1,  1 }, {  0,  1, -1 }, {  0, -1, -1 },
+    };
+
+    uint32_t Hash(int32_t x, int32_t y, int32_t z, uint32_t seed)
+    {
+        uint32_t hash = seed * 0x9e3779b9u;
+        hash ^= static_cast<uint32_t>(x) * 0x8da6b343u;
+        hash ^= static_cast<uint32_t>(y) * 0xd8163841u;
+        hash ^= static_cast<uint32_t>(z) * 0xcb1ab31fu;
+        hash ^= hash >> 16;
+        hash *= 0x7feb352du;
+        hash ^= hash >> 15;
+        hash *= 0x846ca68bu;
+        hash ^= hash >> 16;
+        return hash;
+    }
+
+    // The lattice repeats every period cells, so the volume tiles.
+    int32_t Wrap(int32_t cell, int32_t period)
+    {
+        cell %= period;
+        return cell < 0 ? cell + period : cell;
+    }
+
+    // 6t^5 - 15t^4 + 10t^3.
+    XMVECTOR Fade(FXMVECTOR t)
+    {
+        XMVECTOR result = XMVectorMultiplyAdd(t, XMVectorReplicate(6.f), XMVectorReplicate(-15.f));
+        result = XMVectorMultiplyAdd(result, t, XMVectorReplicate(10.f));
+        return XMVectorMultiply(result, XMVectorMultiply(t, XMVectorMultiply(t, t)));
+    }
+
+    float Fade(float t)
+    {
+        return t * t * t * (t * (t * 6.f - 15.f) + 10.f);
+    }
+
+    // Tileable gradient noise in about [-1, 1] of 4 texels of a row, the coordinates in lattice cells.
+    XMVECTOR PerlinNoise(FXMVECTOR x, float y, float z, int32_t period, uint32_t seed)
+    {
+        const XMVECTOR floorX = XMVectorFloor(x);
+        const XMVECTOR fractionX = XMVectorSubtract(x, floorX);
+        const float floorY = floorf(y);
+        const float floorZ = floorf(z);
+        const float fractionY = y - floorY;
+        const float fractionZ = z - floorZ;
+
+        float cellsX[4];
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(cellsX), floorX);
+
+        XMVECTOR corners[8];
+        for (uint32_t corner = 0; corner < 8; ++corner)
+        {
+            const int32_t offsetX = corner & 1;
+            const int32_t offsetY = (corner >> 1) & 1;
+            const int32_t offsetZ = corner >> 2;
+            const int32_t cellY = Wrap(static_cast<int32_t>(floorY) + offsetY, period);
+            const int32_t cellZ = Wrap(static_cast<int32_t>(floorZ) + offsetZ, period);
+
+            // The neighbouring lanes are usually in the same cell, its hash is reused.
+            float gradientX[4], gradientY[4], gradientZ[4];
+            const float* gradient = nullptr;
+            for (uint32_t lane = 0; lane < 4; ++lane)
+            {
+                if (lane == 0 || cellsX[lane] != cellsX[lane - 1])
+                    gradient = GRADIENTS[Hash(Wrap(static_cast<int32_t>(cellsX[lane]) + offsetX, period), cellY, cellZ, seed) % 12];
+
+                gradientX[lane] = gradient[0];
+                gradientY[lane] = gradient[1];
+                gradientZ[lane] = gradient[2];
+            }
+
+            XMVECTOR dot = XMVectorMultiply(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(gradientX)), XMVectorSubtract(fractionX, XMVectorReplicate(static_cast<float>(offsetX))));
+            dot = XMVectorMultiplyAdd(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(gradientY)), XMVectorReplicate(fractionY - offsetY), dot);
+            dot = XMVectorMultiplyAdd(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(gradientZ)), XMVectorReplicate(fractionZ - offsetZ), dot);
+            corners[corner] = dot;
+        }
+
+        const XMVECTOR fadeX = Fade(fractionX);
+        const float fadeY = Fade(fractionY);
+        const float fadeZ = Fade(fractionZ);
+
+        const XMVECTOR bottomFront = XMVectorLerpV(corners[0], corners[1], fadeX);
+        const XMVECTOR topFront = XMVectorLerpV(corners[2], corners[3], fadeX);
+        const XMVECTOR bottomBack = XMVectorLerpV(corners[4], corners[5], fadeX);
+        const XMVECTOR topBack = XMVectorLerpV(corners[6], corners[7], fadeX);
+        return XMVectorLerp(XMVectorLerp(bottomFront, topFront, fadeY), XMVectorLerp(bottomBack, topBack, fadeY), fadeZ);
+    }
+
+    // Tileable cellular noise in [0, 1]: 1 - the distance to the closest feature point, one point per lattice cell.
+    XMVECTOR WorleyNoise(FXMVECTOR x, float y, float z, int32_t period, uint32_t seed)
+    {
+        const XMVECTOR floorX = XMVectorFloor(x);
+        const XMVECTOR fractionX = XMVectorSubtract(x, floorX);
+        const float floorY = floorf(y);
+        const float floorZ = floorf(z);
+        const XMVECTOR fractionY = XMVectorReplicate(y - floorY);
+        const XMVECTOR fractionZ = XMVectorReplicate(z - floorZ);
+
+        float cellsX[4];
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(cellsX), floorX);
+
+        // The closest point is at most sqrt(3) away, in the cell of the texel.
+        XMVECTOR minDistanceSq = XMVectorReplicate(3.f);
+        for (int32_t offsetZ = -1; offsetZ <= 1; ++offsetZ)
+        {
+            const int32_t cellZ = Wrap(static_cast<int32_t>(floorZ) + offsetZ, period);
+            for (int32_t offsetY = -1; offsetY <= 1; ++offsetY)
+            {
+                const int32_t cellY = Wrap(static_cast<int32_t>(floorY) + offsetY, period);
+                for (int32_t offsetX = -1; offsetX <= 1; ++offsetX)
+                {
+                    float pointX[4], pointY[4], pointZ[4];
+                    uint32_t hash = 0;
+                    for (uint32_t lane = 0; lane < 4; ++lane)
+                    {
+                        if (lane == 0 || cellsX[lane] != cellsX[lane - 1])
+                            hash = Hash(Wrap(static_cast<int32_t>(cellsX[lane]) + offsetX, period), cellY, cellZ, seed);
+
+                        pointX[lane] = offsetX + (hash & 0x3ff) * FEATURE_POINT_SCALE;
+                        pointY[lane] = offsetY + ((hash >> 10) & 0x3ff) * FEATURE_POINT_SCALE;
+                        pointZ[lane] = offsetZ + ((hash >> 20) & 0x3ff) * FEATURE_POINT_SCALE;
+                    }
+
+                    const XMVECTOR deltaX = XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(pointX)), fractionX);
+                    const XMVECTOR deltaY = XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(pointY)), fractionY);
+                    const XMVECTOR deltaZ = XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(pointZ)), fractionZ);
+
+                    XMVECTOR distanceSq = XMVectorMultiply(deltaX, deltaX);
+                    distanceSq = XMVectorMultiplyAdd(deltaY, deltaY, distanceSq);
+                    distanceSq = XMVectorMultiplyAdd(deltaZ, deltaZ, distanceSq);
+                    minDistanceSq = XMVectorMin(minDistanceSq, distanceSq);
+                }
+            }
+        }
+
+        return XMVectorSaturate(XMVectorSubtract(g_XMOne, XMVectorSqrt(minDistanceSq)));
+    }
+
+    // Perlin fBm in [0, 1], the coordinates in [0, 1) of the volume, period the cells of the first octave.
+    XMVECTOR PerlinFbm(FXMVECTOR x, float y, float z, int32_t period, uint32_t octaves, uint32_t seed)
+    {
+        XMVECTOR result = XMVectorZero();
+        float amplitude = 1.f;
+        float amplitudeSum = 0.f;
+        for (uint32_t octave = 0; octave < octaves; ++octave)
+        {
+            const float scale = static_cast<float>(period);
+            result = XMVectorMultiplyAdd(PerlinNoise(XMVectorScale(x, scale), y * scale, z * scale, period, seed + octave), XMVectorReplicate(amplitude), result);
+            amplitudeSum += amplitude;
+            amplitude *= 0.5f;
+            period *= 2;
+        }
+
+        return XMVectorSaturate(XMVectorMultiplyAdd(XMVectorScale(result, 1.f / amplitudeSum), g_XMOneHalf, g_XMOneHalf));
+    }
+
+    // Worley fBm of 3 octaves in [0, 1], the same coordinates as PerlinFbm.
+    XMVECTOR WorleyFbm(FXMVECTOR x, float y, float z, int32_t period, uint32_t seed)
+    {
+        const float WEIGHTS[3] = { 0.625f, 0.25f, 0.125f };
+
+        XMVECTOR result = XMVectorZero();
+        for (uint32_t octave = 0; octave < 3; ++octave)
+        {
+            const float scale = static_cast<float>(period);
+            result = XMVectorMultiplyAdd(WorleyNoise(XMVectorScale(x, scale), y * scale, z * scale, period, seed + octave), XMVectorReplicate(WEIGHTS[octave]), result);
+            period *= 2;
+        }
+
+        return result;
+    }
+
+    // Evaluate the 4 channels of every texel, 4 texels of a row at a time and the depth slices in parallel, then the mips.
+    template<typename Func>
+    void GenerateVolume(uint32_t size, Func&& evaluate, ScratchImage& volume)
+    {
+        assert(size > 0 && size % 4 == 0);
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        ScratchImage base;
+        ThrowIfFailed(base.Initialize3D(DXGI_FORMAT_R8G8B8A8_UNORM, size, size, size, 1));
+        const Image& image = *base.GetImage(0, 0, 0);
+
+        const float invSize = 1.f / size;
+        const XMVECTOR laneOffsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+
+        ThreadPool::Get().ParallelFor(size, [&](size_t z)
+        {
+            const float w = (z + 0.5f) * invSize;
+            for (uint32_t y = 0; y < size; ++y)
+            {
+                const float v = (y + 0.5f) * invSize;
+                auto* row = reinterpret_cast<PackedVector::XMUBYTEN4*>(image.pixels + z * image.slicePitch + y * image.rowPitch);
+
+                for (uint32_t x = 0; x < size; x += 4)
+                {
+                    const XMVECTOR u = XMVectorScale(XMVectorAdd(XMVectorReplicate(static_cast<float>(x)), laneOffsets), invSize);
+
+                    XMVECTOR channels[4];
+                    evaluate(u, v, w, channels);
+
+                    // A vector per channel to a vector per texel.
+                    const XMMATRIX texels = XMMatrixTranspose(XMMATRIX(channels[0], channels[1], channels[2], channels[3]));
+                    for (uint32_t lane = 0; lane < 4; ++lane)
+                        PackedVector::XMStoreUByteN4(row + x + lane, texels.r[lane]);
+                }
+            }
+        });
+
+        VolumeTextureLoader::GenerateMips(base, volume);
+
+        auto generateTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime);
+        char buffer[512];
+        sprintf_s(buffer, "Cloud noise: generated a %u^3 volume in %.2f ms\n", size, generateTime.count());
+        OutputDebugStringA(buffer);
+    }
+}
+
+void CloudNoiseGenerator::GenerateLowFrequency(uint32_t size, DirectX::ScratchImage& volume)
+{
+    GenerateVolume(size, [](FXMVECTOR x, float y, float z, XMVECTOR channels[4])
+    {
+        // The Perlin noise remapped to [worley, 1], the Worley cells make billows of the Perlin noise.
+        const XMVECTOR perlin = PerlinFbm(x, y, z, LOW_FREQUENCY_PERIOD, PERLIN_OCTAVES, 0);
+        const XMVECTOR worley = WorleyFbm(x, y, z, LOW_FREQUENCY_PERIOD, CHANNEL_SEED_STRIDE);
+        channels[0] = XMVectorMultiplyAdd(perlin, XMVectorSubtract(g_XMOne, worley), worley);
+
+        for (uint32_t channel = 1; channel < 4; ++channel)
+            channels[channel] = WorleyFbm(x, y, z, LOW_FREQUENCY_PERIOD << channel, CHANNEL_SEED_STRIDE * (channel + 1));
+    }, volume);
+}
+
+void CloudNoiseGenerator::GenerateHighFrequency(uint32_t size, DirectX::ScratchImage& volume)
+{
+    GenerateVolume(size, [](FXMVECTOR x, float y, float z, XMVECTOR channels[4])
+    {
+        for (uint32_t channel = 0; channel < 3; ++channel)
+            channels[channel] = WorleyFbm(x, y, z, HIGH_FREQUENCY_PERIOD << channel, CHANNEL_SEED_STRIDE * (channel + 5));
+
+        channels[3] = g_XMOne;
+    }, volume);
+}
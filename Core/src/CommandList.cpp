@@ -15,8 +15,11 @@
 #include <RootSignature.h>
 #include <StructuredBuffer.h>
 #include <Texture.h>
+#include <TextureCache.h>
+#include <TextureDecoder.h>
 #include <UploadBuffer.h>
 #include <VertexBuffer.h>
+#include <VolumeTextureLoader.h>
 #include <Scene.h>
 #include <SceneNode.h>
 
@@ -25,8 +28,7 @@
 
 using namespace dx12demo::core;
 
-std::map<std::wstring, ID3D12Resource* > CommandList::ms_TextureCache;
-std::mutex CommandList::ms_TextureCacheMutex;
+TextureCache CommandList::ms_TextureCache;
 
 CommandList::CommandList(D3D12_COMMAND_LIST_TYPE type)
     : m_d3d12CommandListType(type)
@@ -47,6 +49,9 @@ CommandList::CommandList(D3D12_COMMAND_LIST_TYPE type)
         m_DynamicDescriptorHeap[i] = std::make_unique<DynamicDescriptorHeap>(static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(i));
         m_DescriptorHeaps[i] = nullptr;
     }
+
+    m_RootSignature = nullptr;
+    ResetStateCache();
 }
 
 CommandList::~CommandList()
@@ -173,6 +178,44 @@ void CommandList::CopyStructuredBuffer(StructuredBuffer& structuredBuffer, size_
     CopyBuffer(structuredBuffer, numElements, elementSize, bufferData, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
 }
 
+void CommandList::CopyBufferRegion(Buffer& buffer, size_t dstOffset, size_t numBytes, const void* bufferData)
+{
+    auto d3d12Resource = buffer.GetD3D12Resource();
+    if (!d3d12Resource || numBytes == 0 || bufferData == nullptr)
+        return;
+
+    assert(dstOffset + numBytes <= d3d12Resource->GetDesc().Width);
+
+    auto& device = GetApp().GetDevice();
+
+    auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+    auto resDesc = CD3DX12_RESOURCE_DESC::Buffer(numBytes);
+
+    ComPtr<ID3D12Resource> uploadResource;
+    ThrowIfFailed(device->CreateCommittedResource(
+        &heapProp,
+        D3D12_HEAP_FLAG_NONE,
+        &resDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&uploadResource)));
+
+    void* mappedData = nullptr;
+    CD3DX12_RANGE readRange(0, 0);
+    ThrowIfFailed(uploadResource->Map(0, &readRange, &mappedData));
+    memcpy(mappedData, bufferData, numBytes);
+    uploadResource->Unmap(0, nullptr);
+
+    TransitionBarrier(buffer, D3D12_RESOURCE_STATE_COPY_DEST);
+    FlushResourceBarriers();
+
+    m_d3d12CommandList->CopyBufferRegion(d3d12Resource.Get(), dstOffset, uploadResource.Get(), 0, numBytes);
+
+    // Add references to resources so they stay in scope until the command list is reset.
+    TrackObject(uploadResource);
+    TrackResource(buffer);
+}
+
 // Copy the contents of a CPU buffer to a GPU buffer (possibly replacing the previous buffer contents).
 void CommandList::CopyBuffer(Buffer& buffer, size_t numElements, size_t elementSize, const void* bufferData, D3D12_RESOURCE_FLAGS flags/* = D3D12_RESOURCE_FLAG_NONE*/)
 {
@@ -239,6 +282,10 @@ void CommandList::CopyBuffer(Buffer& buffer, size_t numElements, size_t elementS
 
 void CommandList::SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY primitiveTopology)
 {
+    if (!UpdateStateCache(m_PrimitiveTopology == primitiveTopology, CommandListStatistics::PrimitiveTopology))
+        return;
+
+    m_PrimitiveTopology = primitiveTopology;
     m_d3d12CommandList->IASetPrimitiveTopology(primitiveTopology);
 }
 
@@ -276,19 +323,71 @@ void CommandList::ReleaseTrackedObjects()
 void CommandList::SetGraphicsDynamicConstantBuffer(uint32_t rootParameterIndex, size_t sizeInBytes, const void* bufferData)
 {
     // Constant buffers must be 256-byte aligned.
-    auto heapAllococation = m_UploadBuffer->Allocate(sizeInBytes, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
-    memcpy(heapAllococation.CPU, bufferData, sizeInBytes);
-
-    m_d3d12CommandList->SetGraphicsRootConstantBufferView(rootParameterIndex, heapAllococation.GPU);
+    SetDynamicRootView(GraphicsRoot, rootParameterIndex, sizeInBytes, bufferData, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, true);
 }
 
 void CommandList::SetComputeDynamicConstantBuffer(uint32_t rootParameterIndex, size_t sizeInBytes, const void* bufferData)
 {
     // Constant buffers must be 256-byte aligned.
-    auto heapAllococation = m_UploadBuffer->Allocate(sizeInBytes, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
-    memcpy(heapAllococation.CPU, bufferData, sizeInBytes);
+    SetDynamicRootView(ComputeRoot, rootParameterIndex, sizeInBytes, bufferData, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, true);
+}
+
+void CommandList::SetDynamicRootView(RootSignatureType rootType, uint32_t rootParameterIndex, size_t sizeInBytes, const void* bufferData,
+    size_t alignment, bool constantBuffer)
+{
+    assert(rootParameterIndex < MAX_ROOT_PARAMETERS);
 
-    m_d3d12CommandList->SetComputeRootConstantBufferView(rootParameterIndex, heapAllococation.GPU);
+    auto& argument = m_RootArguments[rootType][rootParameterIndex];
+
+    // The previous contents are still in the upload buffer, the same data is not uploaded again.
+    bool redundant = argument.IsSet && argument.Data && argument.SizeInBytes == sizeInBytes &&
+        memcmp(argument.Data, bufferData, sizeInBytes) == 0;
+    if (!UpdateStateCache(redundant, CommandListStatistics::RootArgument))
+        return;
+
+    auto heapAllocation = m_UploadBuffer->Allocate(sizeInBytes, alignment);
+    memcpy(heapAllocation.CPU, bufferData, sizeInBytes);
+
+    argument.IsSet = true;
+    argument.Address = heapAllocation.GPU;
+    argument.Data = heapAllocation.CPU;
+    argument.SizeInBytes = sizeInBytes;
+
+    if (rootType == GraphicsRoot)
+    {
+        if (constantBuffer)
+            m_d3d12CommandList->SetGraphicsRootConstantBufferView(rootParameterIndex, heapAllocation.GPU);
+        else
+            m_d3d12CommandList->SetGraphicsRootShaderResourceView(rootParameterIndex, heapAllocation.GPU);
+    }
+    else
+    {
+        if (constantBuffer)
+            m_d3d12CommandList->SetComputeRootConstantBufferView(rootParameterIndex, heapAllocation.GPU);
+        else
+            m_d3d12CommandList->SetComputeRootShaderResourceView(rootParameterIndex, heapAllocation.GPU);
+    }
+}
+
+void CommandList::SetRoot32BitConstants(RootSignatureType rootType, uint32_t rootParameterIndex, uint32_t numConstants, const void* constants)
+{
+    assert(rootParameterIndex < MAX_ROOT_PARAMETERS);
+
+    auto& argument = m_RootArguments[rootType][rootParameterIndex];
+
+    bool redundant = argument.IsSet && argument.Constants.size() == numConstants &&
+        memcmp(argument.Constants.data(), constants, numConstants * sizeof(uint32_t)) == 0;
+    if (!UpdateStateCache(redundant, CommandListStatistics::RootArgument))
+        return;
+
+    const uint32_t* values = static_cast<const uint32_t*>(constants);
+    argument.IsSet = true;
+    argument.Constants.assign(values, values + numConstants);
+
+    if (rootType == GraphicsRoot)
+        m_d3d12CommandList->SetGraphicsRoot32BitConstants(rootParameterIndex, numConstants, constants, 0);
+    else
+        m_d3d12CommandList->SetComputeRoot32BitConstants(rootParameterIndex, numConstants, constants, 0);
 }
 
 void CommandList::SetShaderResourceView(
@@ -371,6 +470,15 @@ void CommandList::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint3
 }
 
 void CommandList::LoadTextureFromFile(Texture& texture, const std::wstring& fileName, TextureUsage textureUsage/* = TextureUsage::Albedo*/)
+{
+    auto request = RequestTexture(fileName, textureUsage);
+    if (request)
+        request->Wait();
+
+    LoadTextureFromRequest(texture, fileName, request, textureUsage);
+}
+
+std::shared_ptr<TextureDecodeRequest> CommandList::RequestTexture(const std::wstring& fileName, TextureUsage textureUsage/* = TextureUsage::Albedo*/)
 {
     fs::path filePath(fileName);
     if (!fs::exists(filePath))
@@ -378,128 +486,139 @@ void CommandList::LoadTextureFromFile(Texture& texture, const std::wstring& file
         throw std::exception("File not found.");
     }
 
-    std::lock_guard<std::mutex> lock(CommandList::ms_TextureCacheMutex);
-    auto iter = CommandList::ms_TextureCache.find(fileName);
-    if (iter != CommandList::ms_TextureCache.end())
+    if (CommandList::ms_TextureCache.Contains(TextureDecoder::GetCacheKey(fileName, textureUsage)))
+        return nullptr;
+
+    return TextureDecoder::Get().Request(fileName, textureUsage);
+}
+
+TextureCache& CommandList::GetTextureCache()
+{
+    return CommandList::ms_TextureCache;
+}
+
+bool CommandList::LoadTextureFromRequest(Texture& texture, const std::wstring& fileName, const std::shared_ptr<TextureDecodeRequest>& request, TextureUsage textureUsage/* = TextureUsage::Albedo*/)
+{
+    if (SetCachedTexture(texture, fileName, textureUsage))
+        return true;
+
+    // Not requested because it was cached when RequestTexture was called.
+    if (!request)
     {
-        texture.SetTextureUsage(textureUsage);
-        texture.SetD3D12Resource(iter->second);
-        texture.CreateViews();
-        texture.SetName(fileName);
+        auto decodeRequest = TextureDecoder::Get().Request(fileName, textureUsage);
+        decodeRequest->Wait();
+        UploadTexture(texture, fileName, decodeRequest->GetImage(), textureUsage);
+        return true;
     }
-    else
+
+    if (!request->IsReady())
+        return false;
+
+    UploadTexture(texture, fileName, request->GetImage(), textureUsage);
+    return true;
+}
+
+void CommandList::LoadTextureFromImage(Texture& texture, const std::wstring& fileName, const DirectX::ScratchImage& scratchImage, TextureUsage textureUsage/* = TextureUsage::Albedo*/)
+{
+    if (!SetCachedTexture(texture, fileName, textureUsage))
     {
-        TexMetadata metadata;
-        ScratchImage scratchImage;
+        UploadTexture(texture, fileName, scratchImage, textureUsage);
+    }
+}
 
-        if (filePath.extension() == ".dds")
-        {
-            ThrowIfFailed(LoadFromDDSFile(
-                fileName.c_str(),
-                DDS_FLAGS_FORCE_RGB,
-                &metadata,
-                scratchImage));
-        }
-        else if (filePath.extension() == ".hdr")
-        {
-            ThrowIfFailed(LoadFromHDRFile(
-                fileName.c_str(),
-                &metadata,
-                scratchImage));
-        }
-        else if (filePath.extension() == ".tga")
-        {
-            ThrowIfFailed(LoadFromTGAFile(
-                fileName.c_str(),
-                &metadata,
-                scratchImage));
-        }
-        else
-        {
-            ThrowIfFailed(CoInitializeEx(nullptr, COINIT_MULTITHREADED));
-            ThrowIfFailed(LoadFromWICFile(
-                fileName.c_str(),
-                WIC_FLAGS_FORCE_RGB,
-                &metadata,
-                scratchImage));
-            CoUninitialize();
-        }
+bool CommandList::SetCachedTexture(Texture& texture, const std::wstring& fileName, TextureUsage textureUsage)
+{
+    auto resource = CommandList::ms_TextureCache.Find(TextureDecoder::GetCacheKey(fileName, textureUsage));
+    if (!resource)
+        return false;
+
+    texture.SetTextureUsage(textureUsage);
+    texture.SetD3D12Resource(resource);
+    texture.CreateViews();
+    texture.SetName(fileName);
+    return true;
+}
 
-        D3D12_RESOURCE_DESC textureDesc = {};
-        switch (metadata.dimension)
-        {
-        case TEX_DIMENSION_TEXTURE1D:
-            textureDesc = CD3DX12_RESOURCE_DESC::Tex1D(
-                metadata.format,
-                static_cast<UINT64>(metadata.width),
-                static_cast<UINT16>(metadata.arraySize));
-            break;
-        case TEX_DIMENSION_TEXTURE2D:
-            textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(
-                metadata.format,
-                static_cast<UINT64>(metadata.width),
-                static_cast<UINT>(metadata.height),
-                static_cast<UINT16>(metadata.arraySize));
-            break;
-        case TEX_DIMENSION_TEXTURE3D:
-            textureDesc = CD3DX12_RESOURCE_DESC::Tex3D(
-                metadata.format,
-                static_cast<UINT64>(metadata.width),
-                static_cast<UINT>(metadata.height),
-                static_cast<UINT16>(metadata.depth));
-            break;
-        default:
-            throw std::exception("Invalid texture dimension.");
-            break;
-        }
+void CommandList::UploadTexture(Texture& texture, const std::wstring& fileName, const DirectX::ScratchImage& scratchImage, TextureUsage textureUsage)
+{
+    const TexMetadata& metadata = scratchImage.GetMetadata();
 
-        auto device = GetApp().GetDevice();
-        Microsoft::WRL::ComPtr<ID3D12Resource> textureResource;
-        auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+    D3D12_RESOURCE_DESC textureDesc = {};
+    switch (metadata.dimension)
+    {
+    case TEX_DIMENSION_TEXTURE1D:
+        textureDesc = CD3DX12_RESOURCE_DESC::Tex1D(
+            metadata.format,
+            static_cast<UINT64>(metadata.width),
+            static_cast<UINT16>(metadata.arraySize));
+        break;
+    case TEX_DIMENSION_TEXTURE2D:
+        textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(
+            metadata.format,
+            static_cast<UINT64>(metadata.width),
+            static_cast<UINT>(metadata.height),
+            static_cast<UINT16>(metadata.arraySize));
+        break;
+    case TEX_DIMENSION_TEXTURE3D:
+        textureDesc = CD3DX12_RESOURCE_DESC::Tex3D(
+            metadata.format,
+            static_cast<UINT64>(metadata.width),
+            static_cast<UINT>(metadata.height),
+            static_cast<UINT16>(metadata.depth),
+            static_cast<UINT16>(metadata.mipLevels));
+        break;
+    default:
+        throw std::exception("Invalid texture dimension.");
+        break;
+    }
 
-        ThrowIfFailed(device->CreateCommittedResource(
-            &heapProp,
-            D3D12_HEAP_FLAG_NONE,
-            &textureDesc,
-            D3D12_RESOURCE_STATE_COMMON,
-            nullptr,
-            IID_PPV_ARGS(&textureResource)));
+    auto device = GetApp().GetDevice();
+    Microsoft::WRL::ComPtr<ID3D12Resource> textureResource;
+    auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
 
-        texture.SetTextureUsage(textureUsage);
-        texture.SetD3D12Resource(textureResource);
-        texture.CreateViews();
-        texture.SetName(fileName);
+    ThrowIfFailed(device->CreateCommittedResource(
+        &heapProp,
+        D3D12_HEAP_FLAG_NONE,
+        &textureDesc,
+        D3D12_RESOURCE_STATE_COMMON,
+        nullptr,
+        IID_PPV_ARGS(&textureResource)));
 
-        // Update the global state tracker.
-        ResourceStateTracker::AddGlobalResourceState(
-            textureResource.Get(), D3D12_RESOURCE_STATE_COMMON);
+    texture.SetTextureUsage(textureUsage);
+    texture.SetD3D12Resource(textureResource);
+    texture.CreateViews();
+    texture.SetName(fileName);
 
-        std::vector<D3D12_SUBRESOURCE_DATA> subresources(scratchImage.GetImageCount());
-        const Image* pImages = scratchImage.GetImages();
+    // Update the global state tracker.
+    ResourceStateTracker::AddGlobalResourceState(
+        textureResource.Get(), D3D12_RESOURCE_STATE_COMMON);
 
-        for (int i = 0; i < scratchImage.GetImageCount(); ++i)
-        {
-            auto& subresource = subresources[i];
-            subresource.RowPitch = pImages[i].rowPitch;
-            subresource.SlicePitch = pImages[i].slicePitch;
-            subresource.pData = pImages[i].pixels;
-        }
+    std::vector<D3D12_SUBRESOURCE_DATA> subresources(scratchImage.GetImageCount());
+    const Image* pImages = scratchImage.GetImages();
 
-        CopyTextureSubresource(
-            texture,
-            0,
-            static_cast<uint32_t>(subresources.size()),
-            subresources.data());
+    for (int i = 0; i < scratchImage.GetImageCount(); ++i)
+    {
+        auto& subresource = subresources[i];
+        subresource.RowPitch = pImages[i].rowPitch;
+        subresource.SlicePitch = pImages[i].slicePitch;
+        subresource.pData = pImages[i].pixels;
+    }
 
-        if (subresources.size() < textureResource->GetDesc().MipLevels
-            && texture.IsUAVCompatibleFormat())
-        {
-            GenerateMips(texture);
-        }
+    CopyTextureSubresource(
+        texture,
+        0,
+        static_cast<uint32_t>(subresources.size()),
+        subresources.data());
 
-        // Add the texture resource to the texture cache.
-        CommandList::ms_TextureCache[fileName] = textureResource.Get();
+    if (subresources.size() < textureResource->GetDesc().MipLevels
+        && texture.IsUAVCompatibleFormat())
+    {
+        GenerateMips(texture);
     }
+
+    // Add the texture resource to the texture cache.
+    // Two threads may have uploaded the same file concurrently, the first one is cached and the other keeps its copy.
+    CommandList::ms_TextureCache.Add(TextureDecoder::GetCacheKey(fileName, textureUsage), textureResource);
 }
 
 void CommandList::Create3DTextureFromMany2DTextures(Texture& texture, const Create3DTextureBuildData& buildData, TextureUsage textureUsage /* = TextureUsage::Albedo*/)
@@ -510,96 +629,26 @@ void CommandList::Create3DTextureFromMany2DTextures(Texture& texture, const Crea
     assert(buildData.width > 0);
     assert(buildData.height > 0);
     assert(buildData.depth > 0);
-    assert(buildData.num2DImages > 0);
-    assert(buildData.numChannels > 0);
+    assert(buildData.num2DImages == buildData.depth);
+    assert(buildData.numChannels == 4);
     assert(buildData.format != DXGI_FORMAT_UNKNOWN);
 
-    int texWidth, texHeight, texChannels;
-    std::size_t Image3DSize = buildData.width * buildData.height * buildData.depth * buildData.numChannels;
-
-    std::vector<uint8_t> texture3DPixels(Image3DSize, 0);
     auto fileBeginNameFullPath = buildData.folderPath + buildData.textureBaseName;
+    std::wstring fileName(fileBeginNameFullPath.begin(), fileBeginNameFullPath.end());
+    if (SetCachedTexture(texture, fileName, textureUsage))
+        return;
 
+    std::vector<std::string> slicePaths(buildData.num2DImages);
     for (int z = 0; z < buildData.num2DImages; z++)
     {
-        std::string imageIdentifier = fileBeginNameFullPath + "(" + std::to_string(z + 1) + ")" + buildData.fileExtensionBaseName;
-        const char* imagePath = imageIdentifier.c_str();
-        stbi_uc* pixels = stbi_load(imagePath, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-        if (!pixels) {
-            throw std::runtime_error("failed to load texture image!");
-        }
-
-        memcpy(&texture3DPixels[z * texWidth * texHeight * 4], pixels, static_cast<size_t>(texWidth * texHeight * 4));
-        stbi_image_free(pixels);
-    }
-
-    std::lock_guard<std::mutex> lock(CommandList::ms_TextureCacheMutex);
-    std::wstring fileName(fileBeginNameFullPath.begin(), fileBeginNameFullPath.end());
-    auto iter = CommandList::ms_TextureCache.find(fileName);
-    if (iter != CommandList::ms_TextureCache.end())
-    {
-        texture.SetTextureUsage(textureUsage);
-        texture.SetD3D12Resource(iter->second);
-        texture.CreateViews();
-        texture.SetName(fileName);
+        slicePaths[z] = fileBeginNameFullPath + "(" + std::to_string(z + 1) + ")" + buildData.fileExtensionBaseName;
     }
-    else
-    {
-        TexMetadata metadata;
-
-        metadata.width = buildData.width;
-        metadata.height = buildData.height;
-        metadata.depth = buildData.depth;
-        metadata.format = buildData.format;
-        metadata.dimension = TEX_DIMENSION_TEXTURE3D;
-
-        D3D12_RESOURCE_DESC textureDesc = CD3DX12_RESOURCE_DESC::Tex3D(
-                metadata.format,
-                static_cast<UINT64>(metadata.width),
-                static_cast<UINT>(metadata.height),
-                static_cast<UINT16>(metadata.depth));
-
-        auto device = GetApp().GetDevice();
-        Microsoft::WRL::ComPtr<ID3D12Resource> textureResource;
-        auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-
-        ThrowIfFailed(device->CreateCommittedResource(
-            &heapProp,
-            D3D12_HEAP_FLAG_NONE,
-            &textureDesc,
-            D3D12_RESOURCE_STATE_COMMON,
-            nullptr,
-            IID_PPV_ARGS(&textureResource)));
 
-        texture.SetTextureUsage(textureUsage);
-        texture.SetD3D12Resource(textureResource);
-        texture.CreateViews();
-        texture.SetName(fileName);
+    // The slices are decoded in parallel once, then the volume and its mips are read from a single DDS file.
+    ScratchImage volume;
+    VolumeTextureLoader::Load(slicePaths, fileName + L".volume.dds", buildData.width, buildData.height, buildData.format, volume);
 
-        // Update the global state tracker.
-        ResourceStateTracker::AddGlobalResourceState(
-            textureResource.Get(), D3D12_RESOURCE_STATE_COMMON);
-
-        const std::size_t imageCount = 1;
-        std::vector<D3D12_SUBRESOURCE_DATA> subresources(imageCount);
-
-        for (int i = 0; i < imageCount; ++i)
-        {
-            auto& subresource = subresources[i];
-            subresource.RowPitch = 1;
-            subresource.SlicePitch = 1;
-            subresource.pData = texture3DPixels.data();
-        }
-
-        CopyTextureSubresource(
-            texture,
-            0,
-            static_cast<uint32_t>(subresources.size()),
-            subresources.data());
-
-        // Add the texture resource to the texture cache.
-        CommandList::ms_TextureCache[fileName] = textureResource.Get();
-    }
+    UploadTexture(texture, fileName, volume, textureUsage);
 }
 
 void CommandList::LoadSceneFromFile(Scene& scene, const std::wstring& filname)
@@ -687,6 +736,45 @@ void CommandList::Reset()
 
     m_RootSignature = nullptr;
     m_ComputeCommandList = nullptr;
+
+    ResetStateCache();
+    m_Statistics = CommandListStatistics();
+}
+
+void CommandList::ResetStateCache()
+{
+    m_PrimitiveTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+    for (auto& vertexBufferView : m_VertexBufferViews)
+        vertexBufferView = {};
+
+    m_IndexBufferView = {};
+    m_PipelineState = nullptr;
+
+    for (uint32_t rootType = 0; rootType < NumRootTypes; ++rootType)
+    {
+        m_BoundRootSignatures[rootType] = nullptr;
+
+        for (auto& argument : m_RootArguments[rootType])
+            argument.IsSet = false;
+    }
+}
+
+bool CommandList::UpdateStateCache(bool redundant, CommandListStatistics::StateCall stateCall)
+{
+    if (redundant)
+    {
+        m_Statistics.Elided[stateCall]++;
+        return false;
+    }
+
+    m_Statistics.Issued[stateCall]++;
+    return true;
+}
+
+const CommandListStatistics& CommandList::GetStatistics() const
+{
+    return m_Statistics;
 }
 
 void CommandList::Dispatch(uint32_t numGroupsX, uint32_t numGroupsY, uint32_t numGroupsZ)
@@ -841,7 +929,7 @@ void CommandList::GenerateMips_UAV(Texture& texture, bool isSRGB)
         m_GenerateMipsPSO = std::make_unique<GenerateMipsPSO>();
     }
 
-    m_d3d12CommandList->SetPipelineState(m_GenerateMipsPSO->GetPipelineState().Get());
+    SetPipelineState(m_GenerateMipsPSO->GetPipelineState());
     SetComputeRootSignature(m_GenerateMipsPSO->GetRootSignature());
 
     GenerateMipsCB generateMipsCB;
@@ -936,11 +1024,21 @@ void CommandList::SetGraphicsRootSignature(const RootSignature& rootSignature)
         {
             m_DynamicDescriptorHeap[i]->ParseRootSignature(rootSignature);
         }
+    }
+
+    // The graphics and compute root signatures are separate states of the command list.
+    if (!UpdateStateCache(m_BoundRootSignatures[GraphicsRoot] == d3d12RootSignature, CommandListStatistics::RootSignature))
+        return;
 
-        m_d3d12CommandList->SetGraphicsRootSignature(m_RootSignature);
+    m_BoundRootSignatures[GraphicsRoot] = d3d12RootSignature;
 
-        TrackObject(m_RootSignature);
-    }
+    // Changing the root signature invalidates all root arguments.
+    for (auto& argument : m_RootArguments[GraphicsRoot])
+        argument.IsSet = false;
+
+    m_d3d12CommandList->SetGraphicsRootSignature(d3d12RootSignature);
+
+    TrackObject(d3d12RootSignature);
 }
 
 void CommandList::SetComputeRootSignature(const RootSignature& rootSignature)
@@ -954,34 +1052,69 @@ void CommandList::SetComputeRootSignature(const RootSignature& rootSignature)
         {
             m_DynamicDescriptorHeap[i]->ParseRootSignature(rootSignature);
         }
+    }
 
-        m_d3d12CommandList->SetComputeRootSignature(m_RootSignature);
+    if (!UpdateStateCache(m_BoundRootSignatures[ComputeRoot] == d3d12RootSignature, CommandListStatistics::RootSignature))
+        return;
 
-        TrackObject(m_RootSignature);
-    }
+    m_BoundRootSignatures[ComputeRoot] = d3d12RootSignature;
+
+    for (auto& argument : m_RootArguments[ComputeRoot])
+        argument.IsSet = false;
+
+    m_d3d12CommandList->SetComputeRootSignature(d3d12RootSignature);
+
+    TrackObject(d3d12RootSignature);
 }
 
 void CommandList::SetGraphics32BitConstants(uint32_t rootParameterIndex, uint32_t numConstants, const void* constants)
 {
-    m_d3d12CommandList->SetGraphicsRoot32BitConstants(rootParameterIndex, numConstants, constants, 0);
+    SetRoot32BitConstants(GraphicsRoot, rootParameterIndex, numConstants, constants);
 }
 
 void CommandList::SetCompute32BitConstants(uint32_t rootParameterIndex, uint32_t numConstants, const void* constants)
 {
-    m_d3d12CommandList->SetComputeRoot32BitConstants(rootParameterIndex, numConstants, constants, 0);
+    SetRoot32BitConstants(ComputeRoot, rootParameterIndex, numConstants, constants);
 }
 
 void CommandList::SetComputeRootUnorderedAccessView(uint32_t rootParameterIndex, Resource& resource)
 {
-    m_d3d12CommandList->SetComputeRootUnorderedAccessView(rootParameterIndex, resource.GetD3D12Resource()->GetGPUVirtualAddress());
+    assert(rootParameterIndex < MAX_ROOT_PARAMETERS);
+
+    auto address = resource.GetD3D12Resource()->GetGPUVirtualAddress();
+    auto& argument = m_RootArguments[ComputeRoot][rootParameterIndex];
+
+    bool redundant = argument.IsSet && !argument.Data && argument.Address == address;
+    if (!UpdateStateCache(redundant, CommandListStatistics::RootArgument))
+        return;
+
+    argument.IsSet = true;
+    argument.Address = address;
+    argument.Data = nullptr;
+    argument.SizeInBytes = 0;
+
+    m_d3d12CommandList->SetComputeRootUnorderedAccessView(rootParameterIndex, address);
 }
 
 void CommandList::SetVertexBuffer(uint32_t slot, const VertexBuffer& vertexBuffer)
 {
+    assert(slot < D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT);
+
+    // The state is checked on every bind, the buffer may have been written since the last one.
     TransitionBarrier(vertexBuffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
 
     auto vertexBufferView = vertexBuffer.GetVertexBufferView();
 
+    // The view was set by this command list, so the resource is already tracked.
+    const auto& boundView = m_VertexBufferViews[slot];
+    bool redundant = boundView.BufferLocation == vertexBufferView.BufferLocation &&
+        boundView.SizeInBytes == vertexBufferView.SizeInBytes &&
+        boundView.StrideInBytes == vertexBufferView.StrideInBytes &&
+        vertexBufferView.BufferLocation != 0;
+    if (!UpdateStateCache(redundant, CommandListStatistics::VertexBuffer))
+        return;
+
+    m_VertexBufferViews[slot] = vertexBufferView;
     m_d3d12CommandList->IASetVertexBuffers(slot, 1, &vertexBufferView);
 
     TrackResource(vertexBuffer);
@@ -999,6 +1132,10 @@ void CommandList::SetDynamicVertexBuffer(uint32_t slot, size_t numVertices, size
     vertexBufferView.SizeInBytes = static_cast<UINT>(bufferSize);
     vertexBufferView.StrideInBytes = static_cast<UINT>(vertexSize);
 
+    assert(slot < D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT);
+    UpdateStateCache(false, CommandListStatistics::VertexBuffer);
+    m_VertexBufferViews[slot] = vertexBufferView;
+
     m_d3d12CommandList->IASetVertexBuffers(slot, 1, &vertexBufferView);
 }
 
@@ -1008,6 +1145,14 @@ void CommandList::SetIndexBuffer(const IndexBuffer& indexBuffer)
 
     auto indexBufferView = indexBuffer.GetIndexBufferView();
 
+    bool redundant = m_IndexBufferView.BufferLocation == indexBufferView.BufferLocation &&
+        m_IndexBufferView.SizeInBytes == indexBufferView.SizeInBytes &&
+        m_IndexBufferView.Format == indexBufferView.Format &&
+        indexBufferView.BufferLocation != 0;
+    if (!UpdateStateCache(redundant, CommandListStatistics::IndexBuffer))
+        return;
+
+    m_IndexBufferView = indexBufferView;
     m_d3d12CommandList->IASetIndexBuffer(&indexBufferView);
 
     TrackResource(indexBuffer);
@@ -1026,27 +1171,20 @@ void CommandList::SetDynamicIndexBuffer(size_t numIndicies, DXGI_FORMAT indexFor
     indexBufferView.SizeInBytes = static_cast<UINT>(bufferSize);
     indexBufferView.Format = indexFormat;
 
+    UpdateStateCache(false, CommandListStatistics::IndexBuffer);
+    m_IndexBufferView = indexBufferView;
+
     m_d3d12CommandList->IASetIndexBuffer(&indexBufferView);
 }
 
 void CommandList::SetGraphicsDynamicStructuredBuffer(uint32_t slot, size_t numElements, size_t elementSize, const void* bufferData)
 {
-    size_t bufferSize = numElements * elementSize;
-
-    auto heapAllocation = m_UploadBuffer->Allocate(bufferSize, elementSize);
-    memcpy(heapAllocation.CPU, bufferData, bufferSize);
-
-    m_d3d12CommandList->SetGraphicsRootShaderResourceView(slot, heapAllocation.GPU);
+    SetDynamicRootView(GraphicsRoot, slot, numElements * elementSize, bufferData, elementSize, false);
 }
 
 void CommandList::SetComputeDynamicStructuredBuffer(uint32_t slot, size_t numElements, size_t elementSize, const void* bufferData)
 {
-    size_t bufferSize = numElements * elementSize;
-
-    auto heapAllocation = m_UploadBuffer->Allocate(bufferSize, elementSize);
-    memcpy(heapAllocation.CPU, bufferData, bufferSize);
-
-    m_d3d12CommandList->SetComputeRootShaderResourceView(slot, heapAllocation.GPU);
+    SetDynamicRootView(ComputeRoot, slot, numElements * elementSize, bufferData, elementSize, false);
 }
 
 void CommandList::SetViewport(const D3D12_VIEWPORT& viewport)
@@ -1075,6 +1213,10 @@ void CommandList::SetScissorRects(const std::vector<D3D12_RECT>& scissorRects)
 
 void CommandList::SetPipelineState(Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState)
 {
+    if (!UpdateStateCache(m_PipelineState == pipelineState.Get(), CommandListStatistics::PipelineState))
+        return;
+
+    m_PipelineState = pipelineState.Get();
     m_d3d12CommandList->SetPipelineState(pipelineState.Get());
 
     TrackObject(pipelineState);
@@ -1221,7 +1363,7 @@ void CommandList::PanoToCubemap(Texture& cubemapTexture, const Texture& panoText
 
     TransitionBarrier(stagingTexture, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
-    m_d3d12CommandList->SetPipelineState(m_PanoToCubemapPSO->GetPipelineState().Get());
+    SetPipelineState(m_PanoToCubemapPSO->GetPipelineState());
     SetComputeRootSignature(m_PanoToCubemapPSO->GetRootSignature());
 
     PanoToCubemapCB panoToCubemapCB;
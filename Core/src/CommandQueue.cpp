@@ -99,6 +99,11 @@ uint64_t CommandQueue::ExecuteCommandLists(const std::vector<std::shared_ptr<Com
 
         d3d12CommandLists.push_back(commandList->GetGraphicsCommandList().Get());
 
+        {
+            std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+            m_Statistics += commandList->GetStatistics();
+        }
+
         toBeQueued.push_back(pendingCommandList);
         toBeQueued.push_back(commandList);
 
@@ -176,6 +181,16 @@ Microsoft::WRL::ComPtr<ID3D12CommandQueue> CommandQueue::GetD3D12CommandQueue()
     return m_d3d12CommandQueue;
 }
 
+CommandListStatistics CommandQueue::ResetStatistics()
+{
+    std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+
+    CommandListStatistics statistics = m_Statistics;
+    m_Statistics = CommandListStatistics();
+
+    return statistics;
+}
+
 void CommandQueue::Wait(const CommandQueue& other)
 {
     m_d3d12CommandQueue->Wait(other.m_d3d12Fence.Get(), other.m_FenceValue);
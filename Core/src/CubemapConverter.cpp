@@ -0,0 +1,212 @@
+#include <CubemapConverter.h>
+
+#include <DX12LibPCH.h>
+
+#include <DDSCache.h>
+#include <HDRDecoder.h>
+#include <MipGenerator.h>
+#include <TextureDecoder.h>
+#include <ThreadPool.h>
+
+using namespace dx12demo::core;
+using namespace DirectX;
+
+namespace
+{
+    // Rows of a face converted per job.
+    const uint32_t BAND_HEIGHT = 16;
+
+    size_t Wrap(int64_t coordinate, size_t size)
+    {
+        const int64_t wrapped = coordinate % static_cast<int64_t>(size);
+        return static_cast<size_t>(wrapped < 0 ? wrapped + static_cast<int64_t>(size) : wrapped);
+    }
+
+    // Bilinear filtering with the repeat addressing of the shader sampler, (x0, y0) the top left texel of the footprint.
+    XMVECTOR SampleBilinear(const Image& image, int64_t x0, int64_t y0, float fractionX, float fractionY)
+    {
+        const size_t left = Wrap(x0, image.width);
+        const size_t right = Wrap(x0 + 1, image.width);
+        const auto* top = reinterpret_cast<const XMFLOAT4*>(image.pixels + Wrap(y0, image.height) * image.rowPitch);
+        const auto* bottom = reinterpret_cast<const XMFLOAT4*>(image.pixels + Wrap(y0 + 1, image.height) * image.rowPitch);
+
+        XMVECTOR topColor = XMVectorLerp(XMLoadFloat4(top + left), XMLoadFloat4(top + right), fractionX);
+        XMVECTOR bottomColor = XMVectorLerp(XMLoadFloat4(bottom + left), XMLoadFloat4(bottom + right), fractionX);
+        return XMVectorLerp(topColor, bottomColor, fractionY);
+    }
+
+    void ConvertRows(const Image& panorama, const Image& face, uint32_t faceIndex, uint32_t firstRow, uint32_t endRow)
+    {
+        // The texel (u, v, 0.5) is rotated as the (s, t, 1) of the face basis.
+        const float* rotation = CubemapConverter::FACE_BASIS[faceIndex];
+        const uint32_t size = static_cast<uint32_t>(face.width);
+        const XMVECTOR invSize = XMVectorReplicate(1.f / size);
+        const XMVECTOR half = g_XMOneHalf;
+        const XMVECTOR laneOffsets = XMVectorSet(0.f, 1.f, 2.f, 3.f);
+        const XMVECTOR panoramaScale = XMVectorSet(static_cast<float>(panorama.width), static_cast<float>(panorama.height), 0.f, 0.f);
+
+        XMFLOAT4A firstX, firstY, fractionX, fractionY;
+
+        for (uint32_t y = firstRow; y < endRow; ++y)
+        {
+            // Like the shader, texel (x, y) maps to (x / size - 0.5, y / size - 0.5, 0.5) before the face rotation.
+            const XMVECTOR v = XMVectorSubtract(XMVectorMultiply(XMVectorReplicate(static_cast<float>(y)), invSize), half);
+            auto* row = reinterpret_cast<XMFLOAT4*>(face.pixels + y * face.rowPitch);
+
+            for (uint32_t x = 0; x < size; x += 4)
+            {
+                const XMVECTOR u = XMVectorSubtract(XMVectorMultiply(XMVectorAdd(XMVectorReplicate(static_cast<float>(x)), laneOffsets), invSize), half);
+
+                // The directions of 4 texels, one component per vector.
+                XMVECTOR dirX = XMVectorMultiplyAdd(XMVectorReplicate(rotation[0]), u, XMVectorMultiplyAdd(XMVectorReplicate(rotation[1]), v, XMVectorScale(half, rotation[2])));
+                XMVECTOR dirY = XMVectorMultiplyAdd(XMVectorReplicate(rotation[3]), u, XMVectorMultiplyAdd(XMVectorReplicate(rotation[4]), v, XMVectorScale(half, rotation[5])));
+                XMVECTOR dirZ = XMVectorMultiplyAdd(XMVectorReplicate(rotation[6]), u, XMVectorMultiplyAdd(XMVectorReplicate(rotation[7]), v, XMVectorScale(half, rotation[8])));
+
+                const XMVECTOR lengthSq = XMVectorMultiplyAdd(dirX, dirX, XMVectorMultiplyAdd(dirY, dirY, XMVectorMultiply(dirZ, dirZ)));
+                dirY = XMVectorClamp(XMVectorMultiply(dirY, XMVectorReciprocalSqrt(lengthSq)), g_XMNegativeOne, g_XMOne);
+
+                // float2(atan2(-dir.x, -dir.z), acos(dir.y)) * InvAtan, atan2 doesn't need the normalized direction.
+                // Negated by a multiply, -0 at the poles like the shader where 0 - x would give +0 and the other side of the seam.
+                const XMVECTOR panoU = XMVectorScale(XMVectorATan2(XMVectorMultiply(dirX, g_XMNegativeOne), XMVectorMultiply(dirZ, g_XMNegativeOne)), XM_1DIV2PI);
+                const XMVECTOR panoV = XMVectorScale(XMVectorACos(dirY), XM_1DIVPI);
+
+                // Texel space of the panorama, the footprint starts half a texel before the sample.
+                const XMVECTOR texelX = XMVectorSubtract(XMVectorMultiply(panoU, XMVectorSplatX(panoramaScale)), half);
+                const XMVECTOR texelY = XMVectorSubtract(XMVectorMultiply(panoV, XMVectorSplatY(panoramaScale)), half);
+                const XMVECTOR floorX = XMVectorFloor(texelX);
+                const XMVECTOR floorY = XMVectorFloor(texelY);
+
+                XMStoreFloat4A(&firstX, floorX);
+                XMStoreFloat4A(&firstY, floorY);
+                XMStoreFloat4A(&fractionX, XMVectorSubtract(texelX, floorX));
+                XMStoreFloat4A(&fractionY, XMVectorSubtract(texelY, floorY));
+
+                const float* x0 = &firstX.x;
+                const float* y0 = &firstY.x;
+                const float* fx = &fractionX.x;
+                const float* fy = &fractionY.x;
+
+                const uint32_t lanes = std::min(4u, size - x);
+                for (uint32_t lane = 0; lane < lanes; ++lane)
+                {
+                    XMStoreFloat4(row + x + lane, SampleBilinear(panorama,
+                        static_cast<int64_t>(x0[lane]), static_cast<int64_t>(y0[lane]), fx[lane], fy[lane]));
+                }
+            }
+        }
+    }
+}
+
+uint32_t CubemapConverter::GetMipCount(uint32_t cubemapSize, uint32_t mipLevels)
+{
+    uint32_t fullChain = 1;
+    while ((cubemapSize >> fullChain) > 0)
+        ++fullChain;
+
+    return mipLevels == 0 ? fullChain : std::min(mipLevels, fullChain);
+}
+
+void CubemapConverter::Convert(const DirectX::ScratchImage& panorama, uint32_t cubemapSize, uint32_t mipLevels, DirectX::ScratchImage& cubemap)
+{
+    assert(cubemapSize > 0);
+
+    const TexMetadata& metadata = panorama.GetMetadata();
+    if (metadata.dimension != TEX_DIMENSION_TEXTURE2D)
+        throw std::exception("The panorama must be a 2D texture.");
+
+    const uint32_t mipCount = GetMipCount(cubemapSize, mipLevels);
+
+    // The shader samples the panorama mip of the level it writes, from a float texture.
+    const ScratchImage* source = &panorama;
+    ScratchImage converted;
+    if (metadata.format != DXGI_FORMAT_R32G32B32A32_FLOAT)
+    {
+        HRESULT result = IsCompressed(metadata.format) ?
+            Decompress(panorama.GetImages(), panorama.GetImageCount(), metadata, DXGI_FORMAT_R32G32B32A32_FLOAT, converted) :
+            DirectX::Convert(panorama.GetImages(), panorama.GetImageCount(), metadata, DXGI_FORMAT_R32G32B32A32_FLOAT, TEX_FILTER_DEFAULT, TEX_THRESHOLD_DEFAULT, converted);
+        ThrowIfFailed(result);
+        source = &converted;
+    }
+
+    ScratchImage mipChain;
+    if (source->GetMetadata().mipLevels == 1 && mipCount > 1)
+    {
+        MipGenerator::Generate(*source, MipFilter::Box, mipChain);
+        source = &mipChain;
+    }
+
+    ThrowIfFailed(cubemap.InitializeCube(DXGI_FORMAT_R32G32B32A32_FLOAT, cubemapSize, cubemapSize, 1, mipCount));
+
+    const std::vector<Band> bands = GetBands(cubemapSize, mipCount, BAND_HEIGHT);
+
+    const size_t sourceMips = source->GetMetadata().mipLevels;
+    ThreadPool::Get().ParallelFor(bands.size(), [&](size_t index)
+    {
+        const Band& band = bands[index];
+        const Image& face = *cubemap.GetImage(band.Mip, band.Face, 0);
+        const Image& panoramaMip = *source->GetImage(std::min<size_t>(band.Mip, sourceMips - 1), 0, 0);
+
+        ConvertRows(panoramaMip, face, band.Face, band.FirstRow, std::min(band.FirstRow + BAND_HEIGHT, static_cast<uint32_t>(face.height)));
+    });
+}
+
+std::vector<CubemapConverter::Band> CubemapConverter::GetBands(uint32_t cubemapSize, uint32_t mipCount, uint32_t bandHeight)
+{
+    std::vector<Band> bands;
+    for (uint32_t mip = 0; mip < mipCount; ++mip)
+    {
+        const uint32_t mipSize = std::max(1u, cubemapSize >> mip);
+        for (uint32_t face = 0; face < 6; ++face)
+        {
+            for (uint32_t row = 0; row < mipSize; row += bandHeight)
+                bands.push_back({ mip, face, row });
+        }
+    }
+
+    return bands;
+}
+
+std::wstring CubemapConverter::GetCachePath(const std::wstring& panoramaFileName, uint32_t cubemapSize)
+{
+    return panoramaFileName + L".cube" + std::to_wstring(cubemapSize) + L".dds";
+}
+
+void CubemapConverter::Load(const std::wstring& panoramaFileName, uint32_t cubemapSize, uint32_t mipLevels, DirectX::ScratchImage& cubemap)
+{
+    const uint32_t mipCount = GetMipCount(cubemapSize, mipLevels);
+    const std::wstring cachePath = GetCachePath(panoramaFileName, cubemapSize);
+
+    const DXGI_FORMAT storageFormat = HDRDecoder::GetStorageFormat();
+
+    TexMetadata metadata;
+    if (DDSCache::IsValid(panoramaFileName, cachePath) &&
+        SUCCEEDED(LoadFromDDSFile(cachePath.c_str(), DDS_FLAGS_NONE, &metadata, cubemap)) &&
+        metadata.IsCubemap() && metadata.arraySize == 6 && metadata.width == cubemapSize && metadata.mipLevels == mipCount &&
+        metadata.format == storageFormat)
+    {
+        return;
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    // Decoded in float, the mips are generated by Convert.
+    ScratchImage panorama;
+    TextureDecoder::DecodeFile(panoramaFileName, metadata, panorama);
+    Convert(panorama, cubemapSize, mipCount, cubemap);
+
+    if (storageFormat != DXGI_FORMAT_R32G32B32A32_FLOAT)
+    {
+        ScratchImage packed;
+        HDRDecoder::Pack(cubemap, storageFormat, packed);
+        cubemap = std::move(packed);
+    }
+
+    const bool written = DDSCache::Write(cachePath, cubemap);
+
+    std::string path(panoramaFileName.cbegin(), panoramaFileName.cend());
+    auto convertTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime);
+    char buffer[512];
+    sprintf_s(buffer, "Panorama %s: converted to a %u cubemap (%u mips, DXGI format %d) in %.2f ms%s\n", path.c_str(),
+        cubemapSize, mipCount, static_cast<int>(cubemap.GetMetadata().format), convertTime.count(), written ? "" : ", the cache can't be written");
+    OutputDebugStringA(buffer);
+}
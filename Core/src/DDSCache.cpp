@@ -0,0 +1,51 @@
+#include <DDSCache.h>
+
+#include <DX12LibPCH.h>
+
+using namespace dx12demo::core;
+using namespace DirectX;
+
+bool DDSCache::IsValid(const std::wstring& sourceFileName, const std::wstring& cachePath)
+{
+    std::error_code error;
+    auto cacheTime = fs::last_write_time(cachePath, error);
+    if (error)
+        return false;
+
+    auto sourceTime = fs::last_write_time(sourceFileName, error);
+    return !error && cacheTime >= sourceTime;
+}
+
+bool DDSCache::IsValid(const std::vector<std::string>& sourceFileNames, const std::wstring& cachePath)
+{
+    std::error_code error;
+    auto cacheTime = fs::last_write_time(cachePath, error);
+    if (error)
+        return false;
+
+    for (const auto& sourceFileName : sourceFileNames)
+    {
+        auto sourceTime = fs::last_write_time(sourceFileName, error);
+        if (error || sourceTime > cacheTime)
+            return false;
+    }
+
+    return true;
+}
+
+bool DDSCache::Write(const std::wstring& cachePath, const DirectX::ScratchImage& scratchImage)
+{
+    const std::wstring tempPath = cachePath + L".tmp";
+    if (FAILED(SaveToDDSFile(scratchImage.GetImages(), scratchImage.GetImageCount(), scratchImage.GetMetadata(), DDS_FLAGS_NONE, tempPath.c_str())))
+        return false;
+
+    std::error_code error;
+    fs::rename(tempPath, cachePath, error);
+    if (error)
+    {
+        fs::remove(tempPath, error);
+        return false;
+    }
+
+    return true;
+}
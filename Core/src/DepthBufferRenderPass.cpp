@@ -5,6 +5,7 @@
 #include <CommandList.h>
 #include <Mesh.h>
 #include <DepthBuffer_VS.h>
+#include <DepthBufferPacked_VS.h>
 #include <DepthBuffer_PS.h>
 
 using namespace dx12demo::core;
@@ -14,6 +15,7 @@ namespace ComputeParams
 	enum
 	{
 		b0MatCB,
+		b1DequantizationCB,	// Scene::DEQUANTIZATION_ROOT_PARAMETER
 		NumRootParameters
 	};
 }
@@ -108,6 +110,7 @@ void DepthBufferRenderPass::LoadContent(RenderPassBaseInfo* info)
 
 	CD3DX12_ROOT_PARAMETER1 rootParameters[ComputeParams::NumRootParameters];
 	rootParameters[ComputeParams::b0MatCB].InitAsConstantBufferView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_VERTEX);
+	rootParameters[ComputeParams::b1DequantizationCB].InitAsConstantBufferView(1, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_VERTEX);
 
 	CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDescription;
 	rootSignatureDescription.Init_1_1(ComputeParams::NumRootParameters, rootParameters, 0, nullptr, rootSignatureFlags);
@@ -117,13 +120,20 @@ void DepthBufferRenderPass::LoadContent(RenderPassBaseInfo* info)
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineStateStream;
 	ZeroMemory(&pipelineStateStream, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
 	pipelineStateStream.pRootSignature = m_RootSignature.GetRootSignature().Get();
-	pipelineStateStream.InputLayout = { core::PosNormTexExtendedVertex::InputElementsExtended, core::PosNormTexExtendedVertex::InputElementCountExtended };
+	if (depthRPInfo->packedVertices)
+		pipelineStateStream.InputLayout = { core::PackedVertex::InputElementsPackedInstanced, core::PackedVertex::InputElementCountPackedInstanced };
+	else
+		pipelineStateStream.InputLayout = { core::PosNormTexExtendedVertex::InputElementsExtendedInstanced, core::PosNormTexExtendedVertex::InputElementCountExtendedInstanced };
 	pipelineStateStream.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+	// Backface culling of the clockwise front faces, Scene::Render with the camera also culls the backfacing meshlets.
 	pipelineStateStream.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
 	pipelineStateStream.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
 	pipelineStateStream.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
 	pipelineStateStream.SampleMask = UINT_MAX;
-	pipelineStateStream.VS = { g_DepthBuffer_VS, sizeof(g_DepthBuffer_VS) };
+	if (depthRPInfo->packedVertices)
+		pipelineStateStream.VS = { g_DepthBufferPacked_VS, sizeof(g_DepthBufferPacked_VS) };
+	else
+		pipelineStateStream.VS = { g_DepthBuffer_VS, sizeof(g_DepthBuffer_VS) };
 	pipelineStateStream.PS = { g_DepthBuffer_PS, sizeof(g_DepthBuffer_PS) };
 	pipelineStateStream.DSVFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
 	pipelineStateStream.RTVFormats[0] = DXGI_FORMAT_UNKNOWN;
@@ -0,0 +1,520 @@
+#include <EnvironmentBaker.h>
+
+#include <DX12LibPCH.h>
+
+#include <CubemapConverter.h>
+#include <DDSCache.h>
+#include <ThreadPool.h>
+
+using namespace dx12demo::core;
+using namespace DirectX;
+
+namespace
+{
+    // Rows of a face prefiltered per job.
+    const uint32_t BAND_HEIGHT = 16;
+
+    // The SH projection reads the first mip of at most this size, the 9 coefficients don't resolve finer details.
+    const size_t SH_MAX_SIZE = 128;
+
+    // Constants of the real SH basis functions.
+    const float SH_Y00 = 0.282095f;
+    const float SH_Y1 = 0.488603f;
+    const float SH_Y2 = 1.092548f;
+    const float SH_Y20 = 0.315392f;
+    const float SH_Y22 = 0.546274f;
+
+    // The clamped cosine convolution divided by pi of the bands 0, 1 and 2 (pi, 2pi/3 and pi/4).
+    const float SH_BAND_SCALES[9] = { 1.f, 2.f / 3.f, 2.f / 3.f, 2.f / 3.f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+
+    // A GGX sample of the prefiltered mip in tangent space (z along the normal) and the source mip it reads.
+    struct PrefilterSample
+    {
+        XMFLOAT3 Direction;
+        float NdotL;
+        float Lod;
+    };
+
+    void CheckCubemap(const ScratchImage& cubemap)
+    {
+        const TexMetadata& metadata = cubemap.GetMetadata();
+        if (!metadata.IsCubemap() || metadata.arraySize != 6 || metadata.format != DXGI_FORMAT_R32G32B32A32_FLOAT)
+            throw std::exception("The environment must be a R32G32B32A32_FLOAT cubemap.");
+    }
+
+    // Face coordinates in [-1, 1].
+    XMVECTOR GetFaceDirection(uint32_t face, float s, float t)
+    {
+        const float* axes = CubemapConverter::FACE_BASIS[face];
+        return XMVectorSet(axes[0] * s + axes[1] * t + axes[2], axes[3] * s + axes[4] * t + axes[5], axes[6] * s + axes[7] * t + axes[8], 0.f);
+    }
+
+    float RadicalInverse(uint32_t bits)
+    {
+        bits = (bits << 16u) | (bits >> 16u);
+        bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+        bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+        bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+        bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+        return static_cast<float>(bits) * 2.3283064365386963e-10f;
+    }
+
+    // GGX distributed half vector around z of the Hammersley point i of count.
+    XMFLOAT3 ImportanceSampleGGX(uint32_t i, uint32_t count, float alpha)
+    {
+        const float phi = XM_2PI * static_cast<float>(i) / count;
+        const float xi = RadicalInverse(i);
+        const float cosTheta = sqrtf((1.f - xi) / (1.f + (alpha * alpha - 1.f) * xi));
+        const float sinTheta = sqrtf(std::max(0.f, 1.f - cosTheta * cosTheta));
+        return XMFLOAT3(sinTheta * cosf(phi), sinTheta * sinf(phi), cosTheta);
+    }
+
+    // Bilinear filtering clamped to the face, u and v in [0, 1].
+    XMVECTOR SampleFace(const Image& image, float u, float v)
+    {
+        const float x = u * image.width - 0.5f;
+        const float y = v * image.height - 0.5f;
+        const float floorX = floorf(x);
+        const float floorY = floorf(y);
+        const float fractionX = x - floorX;
+        const float fractionY = y - floorY;
+
+        const int64_t lastX = static_cast<int64_t>(image.width) - 1;
+        const int64_t lastY = static_cast<int64_t>(image.height) - 1;
+        const size_t left = static_cast<size_t>(std::clamp<int64_t>(static_cast<int64_t>(floorX), 0, lastX));
+        const size_t right = static_cast<size_t>(std::clamp<int64_t>(static_cast<int64_t>(floorX) + 1, 0, lastX));
+        const auto* top = reinterpret_cast<const XMFLOAT4*>(image.pixels + std::clamp<int64_t>(static_cast<int64_t>(floorY), 0, lastY) * image.rowPitch);
+        const auto* bottom = reinterpret_cast<const XMFLOAT4*>(image.pixels + std::clamp<int64_t>(static_cast<int64_t>(floorY) + 1, 0, lastY) * image.rowPitch);
+
+        XMVECTOR topColor = XMVectorLerp(XMLoadFloat4(top + left), XMLoadFloat4(top + right), fractionX);
+        XMVECTOR bottomColor = XMVectorLerp(XMLoadFloat4(bottom + left), XMLoadFloat4(bottom + right), fractionX);
+        return XMVectorLerp(topColor, bottomColor, fractionY);
+    }
+
+    // Trilinear filtering of the cubemap, without filtering across the faces.
+    XMVECTOR SampleCubemap(const ScratchImage& cubemap, FXMVECTOR direction, float lod)
+    {
+        XMFLOAT3 dir;
+        XMStoreFloat3(&dir, direction);
+        const float absX = fabsf(dir.x);
+        const float absY = fabsf(dir.y);
+        const float absZ = fabsf(dir.z);
+
+        size_t face;
+        float s, t, major;
+        if (absX >= absY && absX >= absZ)
+        {
+            face = dir.x > 0.f ? 0 : 1;
+            major = absX;
+            s = dir.x > 0.f ? -dir.z : dir.z;
+            t = -dir.y;
+        }
+        else if (absY >= absZ)
+        {
+            face = dir.y > 0.f ? 2 : 3;
+            major = absY;
+            s = dir.x;
+            t = dir.y > 0.f ? dir.z : -dir.z;
+        }
+        else
+        {
+            face = dir.z > 0.f ? 4 : 5;
+            major = absZ;
+            s = dir.z > 0.f ? dir.x : -dir.x;
+            t = -dir.y;
+        }
+
+        const float u = (s / major + 1.f) * 0.5f;
+        const float v = (t / major + 1.f) * 0.5f;
+
+        const size_t mipCount = cubemap.GetMetadata().mipLevels;
+        lod = std::clamp(lod, 0.f, static_cast<float>(mipCount - 1));
+        const size_t mip = static_cast<size_t>(lod);
+        const float fraction = lod - mip;
+
+        XMVECTOR color = SampleFace(*cubemap.GetImage(mip, face, 0), u, v);
+        if (fraction > 0.f && mip + 1 < mipCount)
+            color = XMVectorLerp(color, SampleFace(*cubemap.GetImage(mip + 1, face, 0), u, v), fraction);
+
+        return color;
+    }
+
+    // Sums of the texels of a face times the basis functions and the solid angle, per channel and SH coefficient.
+    struct FaceProjection
+    {
+        XMVECTOR Channels[3][9];
+        float Weight = 0.f;
+    };
+
+    void ProjectFace(const Image& image, uint32_t face, FaceProjection& projection)
+    {
+        const float* axes = CubemapConverter::FACE_BASIS[face];
+        const size_t size = image.width;
+        const float invSize = 2.f / size;
+        // The solid angle of a texel is 4 / (size^2 * (s^2 + t^2 + 1)^(3/2)).
+        const float texelArea = invSize * invSize;
+        const XMVECTOR laneOffsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+
+        for (auto& channel : projection.Channels)
+        {
+            for (auto& coefficient : channel)
+                coefficient = XMVectorZero();
+        }
+        XMVECTOR weightSum = XMVectorZero();
+
+        for (size_t y = 0; y < size; ++y)
+        {
+            const XMVECTOR t = XMVectorReplicate((y + 0.5f) * invSize - 1.f);
+            const auto* row = reinterpret_cast<const XMFLOAT4*>(image.pixels + y * image.rowPitch);
+
+            for (size_t x = 0; x < size; x += 4)
+            {
+                const size_t lanes = std::min<size_t>(4, size - x);
+                const XMVECTOR s = XMVectorSubtract(XMVectorMultiply(XMVectorAdd(XMVectorReplicate(static_cast<float>(x)), laneOffsets), XMVectorReplicate(invSize)), g_XMOne);
+
+                // The directions of 4 texels, one component per vector. (s, t, 1) has the length of the direction on every face.
+                const XMVECTOR invLength = XMVectorReciprocalSqrt(XMVectorMultiplyAdd(s, s, XMVectorMultiplyAdd(t, t, g_XMOne)));
+                const XMVECTOR dirX = XMVectorMultiply(XMVectorMultiplyAdd(XMVectorReplicate(axes[0]), s, XMVectorMultiplyAdd(XMVectorReplicate(axes[1]), t, XMVectorReplicate(axes[2]))), invLength);
+                const XMVECTOR dirY = XMVectorMultiply(XMVectorMultiplyAdd(XMVectorReplicate(axes[3]), s, XMVectorMultiplyAdd(XMVectorReplicate(axes[4]), t, XMVectorReplicate(axes[5]))), invLength);
+                const XMVECTOR dirZ = XMVectorMultiply(XMVectorMultiplyAdd(XMVectorReplicate(axes[6]), s, XMVectorMultiplyAdd(XMVectorReplicate(axes[7]), t, XMVectorReplicate(axes[8]))), invLength);
+
+                XMVECTOR weight = XMVectorScale(XMVectorMultiply(invLength, XMVectorMultiply(invLength, invLength)), texelArea);
+
+                // The 4 texels transposed to a vector per channel, the lanes past the row end weigh 0.
+                XMMATRIX colors;
+                for (size_t lane = 0; lane < 4; ++lane)
+                    colors.r[lane] = lane < lanes ? XMLoadFloat4(row + x + lane) : XMVectorZero();
+                if (lanes < 4)
+                    weight = XMVectorSelect(XMVectorZero(), weight, XMVectorLess(laneOffsets, XMVectorReplicate(static_cast<float>(lanes))));
+                colors = XMMatrixTranspose(colors);
+
+                const XMVECTOR basis[9] = {
+                    XMVectorReplicate(SH_Y00),
+                    XMVectorScale(dirY, SH_Y1),
+                    XMVectorScale(dirZ, SH_Y1),
+                    XMVectorScale(dirX, SH_Y1),
+                    XMVectorScale(XMVectorMultiply(dirX, dirY), SH_Y2),
+                    XMVectorScale(XMVectorMultiply(dirY, dirZ), SH_Y2),
+                    XMVectorScale(XMVectorMultiplyAdd(XMVectorMultiply(dirZ, dirZ), XMVectorReplicate(3.f), g_XMNegativeOne), SH_Y20),
+                    XMVectorScale(XMVectorMultiply(dirX, dirZ), SH_Y2),
+                    XMVectorScale(XMVectorSubtract(XMVectorMultiply(dirX, dirX), XMVectorMultiply(dirY, dirY)), SH_Y22),
+                };
+
+                for (size_t channel = 0; channel < 3; ++channel)
+                {
+                    const XMVECTOR weighted = XMVectorMultiply(colors.r[channel], weight);
+                    for (size_t i = 0; i < 9; ++i)
+                        projection.Channels[channel][i] = XMVectorMultiplyAdd(weighted, basis[i], projection.Channels[channel][i]);
+                }
+                weightSum = XMVectorAdd(weightSum, weight);
+            }
+        }
+
+        XMFLOAT4 weights;
+        XMStoreFloat4(&weights, weightSum);
+        projection.Weight = weights.x + weights.y + weights.z + weights.w;
+    }
+
+    float SumLanes(FXMVECTOR vector)
+    {
+        XMFLOAT4 lanes;
+        XMStoreFloat4(&lanes, vector);
+        return lanes.x + lanes.y + lanes.z + lanes.w;
+    }
+}
+
+SHIrradiance EnvironmentBaker::ProjectSH(const DirectX::ScratchImage& cubemap)
+{
+    CheckCubemap(cubemap);
+
+    const TexMetadata& metadata = cubemap.GetMetadata();
+    size_t mip = 0;
+    while (mip + 1 < metadata.mipLevels && cubemap.GetImage(mip, 0, 0)->width > SH_MAX_SIZE)
+        ++mip;
+
+    FaceProjection projections[6];
+    ThreadPool::Get().ParallelFor(6, [&](size_t face)
+    {
+        ProjectFace(*cubemap.GetImage(mip, face, 0), static_cast<uint32_t>(face), projections[face]);
+    });
+
+    // The texel solid angles sum to 4pi, the rest is the error of the formula.
+    float weightSum = 0.f;
+    for (const auto& projection : projections)
+        weightSum += projection.Weight;
+    const float normalization = XM_PI * 4.f / weightSum;
+
+    SHIrradiance irradiance;
+    for (size_t i = 0; i < 9; ++i)
+    {
+        float channels[3];
+        for (size_t channel = 0; channel < 3; ++channel)
+        {
+            XMVECTOR sum = XMVectorZero();
+            for (const auto& projection : projections)
+                sum = XMVectorAdd(sum, projection.Channels[channel][i]);
+            channels[channel] = SumLanes(sum) * normalization * SH_BAND_SCALES[i];
+        }
+        irradiance.Coefficients[i] = XMFLOAT4(channels[0], channels[1], channels[2], 0.f);
+    }
+
+    return irradiance;
+}
+
+DirectX::XMVECTOR EnvironmentBaker::EvaluateSH(const SHIrradiance& irradiance, DirectX::FXMVECTOR normal)
+{
+    XMFLOAT3 n;
+    XMStoreFloat3(&n, normal);
+
+    const float basis[9] = {
+        SH_Y00,
+        SH_Y1 * n.y,
+        SH_Y1 * n.z,
+        SH_Y1 * n.x,
+        SH_Y2 * n.x * n.y,
+        SH_Y2 * n.y * n.z,
+        SH_Y20 * (3.f * n.z * n.z - 1.f),
+        SH_Y2 * n.x * n.z,
+        SH_Y22 * (n.x * n.x - n.y * n.y),
+    };
+
+    XMVECTOR result = XMVectorZero();
+    for (size_t i = 0; i < 9; ++i)
+        result = XMVectorMultiplyAdd(XMLoadFloat4(&irradiance.Coefficients[i]), XMVectorReplicate(basis[i]), result);
+
+    return XMVectorMax(result, XMVectorZero());
+}
+
+float EnvironmentBaker::GetRoughness(uint32_t mip, uint32_t mipLevels)
+{
+    return mipLevels > 1 ? static_cast<float>(mip) / (mipLevels - 1) : 0.f;
+}
+
+void EnvironmentBaker::Prefilter(const DirectX::ScratchImage& cubemap, uint32_t size, uint32_t mipLevels, uint32_t sampleCount, DirectX::ScratchImage& prefiltered)
+{
+    CheckCubemap(cubemap);
+    assert(size > 0 && sampleCount > 0);
+
+    const uint32_t mipCount = CubemapConverter::GetMipCount(size, mipLevels);
+    ThrowIfFailed(prefiltered.InitializeCube(DXGI_FORMAT_R32G32B32A32_FLOAT, size, size, 1, mipCount));
+
+    const float sourceSize = static_cast<float>(cubemap.GetMetadata().width);
+    const float sourceTexelSolidAngle = XM_PI * 4.f / (6.f * sourceSize * sourceSize);
+
+    // The samples are the same for every texel of a mip. Reading the source mip whose texels cover the solid angle
+    // of the sample (pdf) filters the environment between the samples.
+    std::vector<std::vector<PrefilterSample>> mipSamples(mipCount);
+    for (uint32_t mip = 0; mip < mipCount; ++mip)
+    {
+        const float roughness = GetRoughness(mip, mipCount);
+        if (roughness == 0.f)
+            continue;
+
+        const float alpha = roughness * roughness;
+        const float alphaSq = alpha * alpha;
+        for (uint32_t i = 0; i < sampleCount; ++i)
+        {
+            const XMFLOAT3 h = ImportanceSampleGGX(i, sampleCount, alpha);
+
+            // With N = V: L = 2 (N.H) H - N, and the pdf of L is D(N.H) / 4.
+            const XMFLOAT3 l(2.f * h.z * h.x, 2.f * h.z * h.y, 2.f * h.z * h.z - 1.f);
+            if (l.z <= 0.f)
+                continue;
+
+            const float denominator = h.z * h.z * (alphaSq - 1.f) + 1.f;
+            const float pdf = alphaSq / (XM_PI * denominator * denominator) * 0.25f;
+            const float sampleSolidAngle = 1.f / (sampleCount * pdf);
+            const float lod = std::max(0.f, 0.5f * log2f(sampleSolidAngle / sourceTexelSolidAngle) + 1.f);
+
+            mipSamples[mip].push_back({ l, l.z, lod });
+        }
+    }
+
+    const std::vector<CubemapConverter::Band> bands = CubemapConverter::GetBands(size, mipCount, BAND_HEIGHT);
+    ThreadPool::Get().ParallelFor(bands.size(), [&](size_t index)
+    {
+        const CubemapConverter::Band& band = bands[index];
+        const Image& image = *prefiltered.GetImage(band.Mip, band.Face, 0);
+        const auto& samples = mipSamples[band.Mip];
+        const uint32_t mipSize = static_cast<uint32_t>(image.width);
+        // The mirror mip reads the source mip of its size.
+        const float mirrorLod = std::max(0.f, log2f(sourceSize / mipSize));
+
+        const uint32_t endRow = std::min(band.FirstRow + BAND_HEIGHT, mipSize);
+        for (uint32_t y = band.FirstRow; y < endRow; ++y)
+        {
+            auto* row = reinterpret_cast<XMFLOAT4*>(image.pixels + y * image.rowPitch);
+            const float t = (y + 0.5f) * 2.f / mipSize - 1.f;
+
+            for (uint32_t x = 0; x < mipSize; ++x)
+            {
+                const float s = (x + 0.5f) * 2.f / mipSize - 1.f;
+                const XMVECTOR normal = XMVector3Normalize(GetFaceDirection(band.Face, s, t));
+
+                if (samples.empty())
+                {
+                    XMStoreFloat4(row + x, SampleCubemap(cubemap, normal, mirrorLod));
+                    continue;
+                }
+
+                const XMVECTOR up = fabsf(XMVectorGetZ(normal)) < 0.999f ? g_XMIdentityR2 : g_XMIdentityR0;
+                const XMVECTOR tangentX = XMVector3Normalize(XMVector3Cross(up, normal));
+                const XMVECTOR tangentY = XMVector3Cross(normal, tangentX);
+
+                XMVECTOR color = XMVectorZero();
+                float weight = 0.f;
+                for (const auto& sample : samples)
+                {
+                    const XMVECTOR direction = XMVectorMultiplyAdd(tangentX, XMVectorReplicate(sample.Direction.x),
+                        XMVectorMultiplyAdd(tangentY, XMVectorReplicate(sample.Direction.y), XMVectorScale(normal, sample.Direction.z)));
+                    color = XMVectorMultiplyAdd(SampleCubemap(cubemap, direction, sample.Lod), XMVectorReplicate(sample.NdotL), color);
+                    weight += sample.NdotL;
+                }
+
+                XMStoreFloat4(row + x, XMVectorScale(color, 1.f / weight));
+            }
+        }
+    });
+}
+
+void EnvironmentBaker::BakeBRDF(uint32_t size, uint32_t sampleCount, DirectX::ScratchImage& lut)
+{
+    assert(size > 0 && sampleCount > 0);
+
+    ThrowIfFailed(lut.Initialize2D(DXGI_FORMAT_R32G32_FLOAT, size, size, 1, 1));
+    const Image& image = *lut.GetImage(0, 0, 0);
+
+    // 4 samples at a time, the padding samples weigh 0.
+    const size_t groupCount = (sampleCount + 3) / 4;
+
+    ThreadPool::Get().ParallelFor(size, [&](size_t y)
+    {
+        const float roughness = (y + 0.5f) / size;
+        const float alpha = roughness * roughness;
+        // The k of the Schlick-GGX geometry term for the image based lighting.
+        const XMVECTOR k = XMVectorReplicate(alpha * 0.5f);
+        const XMVECTOR oneMinusK = XMVectorReplicate(1.f - alpha * 0.5f);
+
+        // The half vectors of the row, one component per vector.
+        std::vector<XMVECTOR> halfX(groupCount), halfY(groupCount), halfZ(groupCount), valid(groupCount);
+        for (size_t group = 0; group < groupCount; ++group)
+        {
+            XMFLOAT4 hx, hy, hz, v;
+            float* lanes[4] = { &hx.x, &hy.x, &hz.x, &v.x };
+            for (uint32_t lane = 0; lane < 4; ++lane)
+            {
+                const uint32_t i = static_cast<uint32_t>(group * 4 + lane);
+                const XMFLOAT3 h = i < sampleCount ? ImportanceSampleGGX(i, sampleCount, alpha) : XMFLOAT3(0.f, 0.f, 1.f);
+                lanes[0][lane] = h.x;
+                lanes[1][lane] = h.y;
+                lanes[2][lane] = h.z;
+                lanes[3][lane] = i < sampleCount ? 1.f : 0.f;
+            }
+            halfX[group] = XMLoadFloat4(&hx);
+            halfY[group] = XMLoadFloat4(&hy);
+            halfZ[group] = XMLoadFloat4(&hz);
+            valid[group] = XMLoadFloat4(&v);
+        }
+
+        auto* row = reinterpret_cast<XMFLOAT2*>(image.pixels + y * image.rowPitch);
+        for (uint32_t x = 0; x < size; ++x)
+        {
+            const float NdotV = (x + 0.5f) / size;
+            const XMVECTOR viewX = XMVectorReplicate(sqrtf(1.f - NdotV * NdotV));
+            const XMVECTOR viewZ = XMVectorReplicate(NdotV);
+            const XMVECTOR geometryV = XMVectorDivide(viewZ, XMVectorMultiplyAdd(viewZ, oneMinusK, k));
+
+            XMVECTOR scale = XMVectorZero();
+            XMVECTOR bias = XMVectorZero();
+            for (size_t group = 0; group < groupCount; ++group)
+            {
+                // L = 2 (V.H) H - V, V = (sin, 0, cos) around N = z.
+                const XMVECTOR VdotH = XMVectorMultiplyAdd(viewX, halfX[group], XMVectorMultiply(viewZ, halfZ[group]));
+                const XMVECTOR NdotL = XMVectorSubtract(XMVectorMultiply(XMVectorAdd(VdotH, VdotH), halfZ[group]), viewZ);
+                const XMVECTOR NdotH = halfZ[group];
+
+                const XMVECTOR clampedNdotL = XMVectorMax(NdotL, XMVectorZero());
+                const XMVECTOR geometryL = XMVectorDivide(clampedNdotL, XMVectorMultiplyAdd(clampedNdotL, oneMinusK, k));
+                XMVECTOR visibility = XMVectorDivide(XMVectorMultiply(XMVectorMultiply(geometryV, geometryL), VdotH), XMVectorMultiply(NdotH, viewZ));
+                visibility = XMVectorSelect(XMVectorZero(), XMVectorMultiply(visibility, valid[group]), XMVectorGreater(NdotL, XMVectorZero()));
+
+                // Schlick's (1 - V.H)^5.
+                const XMVECTOR oneMinusVdotH = XMVectorMax(XMVectorSubtract(g_XMOne, VdotH), XMVectorZero());
+                const XMVECTOR squared = XMVectorMultiply(oneMinusVdotH, oneMinusVdotH);
+                const XMVECTOR fresnel = XMVectorMultiply(XMVectorMultiply(squared, squared), oneMinusVdotH);
+
+                scale = XMVectorMultiplyAdd(XMVectorSubtract(g_XMOne, fresnel), visibility, scale);
+                bias = XMVectorMultiplyAdd(fresnel, visibility, bias);
+            }
+
+            row[x] = XMFLOAT2(SumLanes(scale) / sampleCount, SumLanes(bias) / sampleCount);
+        }
+    });
+}
+
+void EnvironmentBaker::Load(const std::wstring& panoramaFileName, const DirectX::ScratchImage& cubemap, SHIrradiance& irradiance, DirectX::ScratchImage& prefiltered,
+    uint32_t prefilteredSize/* = DEFAULT_PREFILTERED_SIZE*/, uint32_t prefilteredMips/* = DEFAULT_PREFILTERED_MIPS*/)
+{
+    const uint32_t mipCount = CubemapConverter::GetMipCount(prefilteredSize, prefilteredMips);
+    const std::wstring irradiancePath = panoramaFileName + L".sh9.dds";
+    const std::wstring prefilteredPath = panoramaFileName + L".ggx" + std::to_wstring(prefilteredSize) + L".dds";
+
+    // The coefficients are cached as a 9x1 float texture.
+    ScratchImage irradianceImage;
+    TexMetadata metadata;
+    if (DDSCache::IsValid(panoramaFileName, irradiancePath) && DDSCache::IsValid(panoramaFileName, prefilteredPath) &&
+        SUCCEEDED(LoadFromDDSFile(irradiancePath.c_str(), DDS_FLAGS_NONE, &metadata, irradianceImage)) &&
+        metadata.width == 9 && metadata.height == 1 && metadata.format == DXGI_FORMAT_R32G32B32A32_FLOAT &&
+        SUCCEEDED(LoadFromDDSFile(prefilteredPath.c_str(), DDS_FLAGS_NONE, &metadata, prefiltered)) &&
+        metadata.IsCubemap() && metadata.width == prefilteredSize && metadata.mipLevels == mipCount && metadata.format == DXGI_FORMAT_R32G32B32A32_FLOAT)
+    {
+        memcpy(irradiance.Coefficients, irradianceImage.GetImage(0, 0, 0)->pixels, sizeof(irradiance.Coefficients));
+        return;
+    }
+
+    // The cubemap may be packed to the HDR storage format (HDRDecoder).
+    const ScratchImage* source = &cubemap;
+    ScratchImage unpacked;
+    const TexMetadata& cubemapMetadata = cubemap.GetMetadata();
+    if (cubemapMetadata.format != DXGI_FORMAT_R32G32B32A32_FLOAT)
+    {
+        HRESULT result = IsCompressed(cubemapMetadata.format) ?
+            Decompress(cubemap.GetImages(), cubemap.GetImageCount(), cubemapMetadata, DXGI_FORMAT_R32G32B32A32_FLOAT, unpacked) :
+            Convert(cubemap.GetImages(), cubemap.GetImageCount(), cubemapMetadata, DXGI_FORMAT_R32G32B32A32_FLOAT, TEX_FILTER_DEFAULT, TEX_THRESHOLD_DEFAULT, unpacked);
+        ThrowIfFailed(result);
+        source = &unpacked;
+    }
+
+    irradiance = ProjectSH(*source);
+    Prefilter(*source, prefilteredSize, mipCount, DEFAULT_SAMPLE_COUNT, prefiltered);
+
+    ThrowIfFailed(irradianceImage.Initialize2D(DXGI_FORMAT_R32G32B32A32_FLOAT, 9, 1, 1, 1));
+    memcpy(irradianceImage.GetImage(0, 0, 0)->pixels, irradiance.Coefficients, sizeof(irradiance.Coefficients));
+
+    if (!DDSCache::Write(irradiancePath, irradianceImage) || !DDSCache::Write(prefilteredPath, prefiltered))
+    {
+        std::string path(panoramaFileName.cbegin(), panoramaFileName.cend());
+        char buffer[512];
+        sprintf_s(buffer, "Environment %s: the baked cache can't be written\n", path.c_str());
+        OutputDebugStringA(buffer);
+    }
+}
+
+void EnvironmentBaker::LoadBRDF(const std::wstring& fileName, DirectX::ScratchImage& lut, uint32_t size/* = DEFAULT_BRDF_SIZE*/)
+{
+    TexMetadata metadata;
+    if (SUCCEEDED(LoadFromDDSFile(fileName.c_str(), DDS_FLAGS_NONE, &metadata, lut)) &&
+        metadata.width == size && metadata.height == size && metadata.format == DXGI_FORMAT_R32G32_FLOAT)
+    {
+        return;
+    }
+
+    BakeBRDF(size, DEFAULT_BRDF_SAMPLE_COUNT, lut);
+    if (!DDSCache::Write(fileName, lut))
+    {
+        std::string path(fileName.cbegin(), fileName.cend());
+        char buffer[512];
+        sprintf_s(buffer, "BRDF table %s: the file can't be written\n", path.c_str());
+        OutputDebugStringA(buffer);
+    }
+}
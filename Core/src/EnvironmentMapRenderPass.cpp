@@ -7,9 +7,36 @@
 
 #include <Application.h>
 #include <CommandQueue.h>
+#include <CubemapConverter.h>
+#include <EnvironmentBaker.h>
 
 using namespace dx12demo::core;
 
+namespace
+{
+    // A texture of the image and its mips, every subresource uploaded.
+    void UploadImage(CommandList& commandList, Texture& texture, const DirectX::ScratchImage& scratchImage, const std::wstring& name)
+    {
+        const DirectX::TexMetadata& metadata = scratchImage.GetMetadata();
+        auto textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(metadata.format, metadata.width, static_cast<UINT>(metadata.height),
+            static_cast<UINT16>(metadata.arraySize), static_cast<UINT16>(metadata.mipLevels));
+
+        texture = core::Texture(textureDesc, nullptr, TextureUsage::Albedo, name);
+
+        // Item major like the subresources of the texture array.
+        std::vector<D3D12_SUBRESOURCE_DATA> subresources(scratchImage.GetImageCount());
+        const DirectX::Image* images = scratchImage.GetImages();
+        for (size_t i = 0; i < subresources.size(); ++i)
+        {
+            subresources[i].pData = images[i].pixels;
+            subresources[i].RowPitch = images[i].rowPitch;
+            subresources[i].SlicePitch = images[i].slicePitch;
+        }
+
+        commandList.CopyTextureSubresource(texture, 0, static_cast<uint32_t>(subresources.size()), subresources.data());
+    }
+}
+
 EnvironmentMapRenderPass::EnvironmentMapRenderPass()
 {
 
@@ -28,16 +55,51 @@ void EnvironmentMapRenderPass::LoadContent(RenderPassBaseInfo* info)
 	// Create an inverted (reverse winding order) cube so the insides are not clipped.
 	m_SkyboxMesh = core::Mesh::CreateCube(*envInfo->commandList, 1.0f, true);
 
-	envInfo->commandList->LoadTextureFromFile(m_SrcTexture, envInfo->texturePath);
+    if (envInfo->cpuConversion)
+    {
+        assert(envInfo->cubeMapDepthOrArraySize == 6);
+
+        // The cached cubemap skips the decode of the panorama and the compute pass.
+        DirectX::ScratchImage cubemap;
+        CubemapConverter::Load(envInfo->texturePath, envInfo->cubeMapSize, envInfo->cubeMapMipLevels, cubemap);
+        UploadImage(*envInfo->commandList, m_CubemapTexture, cubemap, envInfo->textureName);
+
+        if (envInfo->bakeLighting)
+        {
+            DirectX::ScratchImage prefiltered;
+            EnvironmentBaker::Load(envInfo->texturePath, cubemap, m_Irradiance, prefiltered);
+            UploadImage(*envInfo->commandList, m_PrefilteredTexture, prefiltered, envInfo->textureName + L" Prefiltered");
+
+            m_PrefilteredSrvDesc = {};
+            m_PrefilteredSrvDesc.Format = m_PrefilteredTexture.GetD3D12ResourceDesc().Format;
+            m_PrefilteredSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            m_PrefilteredSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+            m_PrefilteredSrvDesc.TextureCube.MipLevels = (UINT)-1; // The roughness picks the mip.
+
+            // The table doesn't depend on the environment, one file next to the panoramas.
+            DirectX::ScratchImage brdf;
+            EnvironmentBaker::LoadBRDF(fs::path(envInfo->texturePath).replace_filename(L"brdf_lut.dds").wstring(), brdf);
+            UploadImage(*envInfo->commandList, m_BRDFTexture, brdf, L"BRDF Table");
+        }
+    }
+    else
+    {
+        // The baking reads the cubemap on the CPU.
+        assert(!envInfo->bakeLighting);
 
-    auto cubemapDesc = m_SrcTexture.GetD3D12ResourceDesc();
-    cubemapDesc.Width = cubemapDesc.Height = envInfo->cubeMapSize;
-    cubemapDesc.DepthOrArraySize = envInfo->cubeMapDepthOrArraySize;
-    cubemapDesc.MipLevels = envInfo->cubeMapMipLevels;
+        envInfo->commandList->LoadTextureFromFile(m_SrcTexture, envInfo->texturePath);
 
-    m_CubemapTexture = core::Texture(cubemapDesc, nullptr, TextureUsage::Albedo, envInfo->textureName);
-    // Convert the 2D panorama to a 3D cubemap.
-    envInfo->commandList->PanoToCubemap(m_CubemapTexture, m_SrcTexture);
+        auto cubemapDesc = m_SrcTexture.GetD3D12ResourceDesc();
+        // The compute pass writes a float UAV, whatever the storage format of the panorama (HDRDecoder).
+        cubemapDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+        cubemapDesc.Width = cubemapDesc.Height = envInfo->cubeMapSize;
+        cubemapDesc.DepthOrArraySize = envInfo->cubeMapDepthOrArraySize;
+        cubemapDesc.MipLevels = envInfo->cubeMapMipLevels;
+
+        m_CubemapTexture = core::Texture(cubemapDesc, nullptr, TextureUsage::Albedo, envInfo->textureName);
+        // Convert the 2D panorama to a 3D cubemap.
+        envInfo->commandList->PanoToCubemap(m_CubemapTexture, m_SrcTexture);
+    }
 
     D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
     srvDesc.Format = m_CubemapTexture.GetD3D12ResourceDesc().Format;
@@ -98,6 +160,26 @@ void EnvironmentMapRenderPass::LoadContent(RenderPassBaseInfo* info)
     }
 }
 
+const SHIrradiance& EnvironmentMapRenderPass::GetIrradiance() const
+{
+    return m_Irradiance;
+}
+
+const Texture& EnvironmentMapRenderPass::GetPrefilteredTexture() const
+{
+    return m_PrefilteredTexture;
+}
+
+const D3D12_SHADER_RESOURCE_VIEW_DESC& EnvironmentMapRenderPass::GetPrefilteredSRV() const
+{
+    return m_PrefilteredSrvDesc;
+}
+
+const Texture& EnvironmentMapRenderPass::GetBRDFTexture() const
+{
+    return m_BRDFTexture;
+}
+
 void EnvironmentMapRenderPass::OnUpdate(std::shared_ptr<CommandList>& commandList, UpdateEventArgs& e)
 {
     auto viewMatrix = XMMatrixTranspose(XMMatrixRotationQuaternion(m_Camera->get_Rotation()));
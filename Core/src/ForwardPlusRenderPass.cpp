@@ -1,20 +1,24 @@
 #include <ForwardPlusRenderPass.h>
 
 #include <ForwardPlus_VS.h>
+#include <ForwardPlusPacked_VS.h>
 #include <ForwardPlus_PS.h>
 #include <Mesh.h>
 #include <DX12LibPCH.h>
 #include <Application.h>
+#include <EnvironmentBaker.h>
 #include <Texture.h>
 #include <StructuredBuffer.h>
 
 using namespace dx12demo::core;
+using namespace DirectX;
 
 namespace ComputeParams
 {
     enum
     {
         b0MatCB,
+        b2DequantizationCB, // Scene::DEQUANTIZATION_ROOT_PARAMETER
         t0AmbientTex,
         t1DiffuseTex,
         t2SpecularTex,
@@ -22,10 +26,24 @@ namespace ComputeParams
         t4LightGridTex,
         t5LightsSB,
         t6LightIndexListSB,
+        b1EnvironmentCB,
+        t7PrefilteredTex,
+        t8BRDFTex,
         NumRootParameters
     };
 }
 
+// ConstantBuffer<Environment> EnvironmentCB : register(b1) of ForwardPlus_PS.
+struct alignas(16) EnvironmentCB
+{
+    XMMATRIX InverseViewMatrix;
+    SHIrradiance Irradiance;
+    float PrefilteredMips;
+    float Roughness;
+    float Intensity;
+    float Padding;
+};
+
 ForwardPlusRenderPass::ForwardPlusRenderPass()
 {
 
@@ -42,6 +60,7 @@ void ForwardPlusRenderPass::LoadContent(RenderPassBaseInfo* info)
 
     CD3DX12_ROOT_PARAMETER1 rootParameters[ComputeParams::NumRootParameters];
     rootParameters[ComputeParams::b0MatCB].InitAsConstantBufferView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_VERTEX);
+    rootParameters[ComputeParams::b2DequantizationCB].InitAsConstantBufferView(2, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_VERTEX);
     CD3DX12_DESCRIPTOR_RANGE1 ambientTexDescrRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
     rootParameters[ComputeParams::t0AmbientTex].InitAsDescriptorTable(1, &ambientTexDescrRange, D3D12_SHADER_VISIBILITY_PIXEL);
     CD3DX12_DESCRIPTOR_RANGE1 diffuseTexDescrRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1);
@@ -56,6 +75,11 @@ void ForwardPlusRenderPass::LoadContent(RenderPassBaseInfo* info)
     rootParameters[ComputeParams::t5LightsSB].InitAsDescriptorTable(1, &lightsSBDescrRange, D3D12_SHADER_VISIBILITY_PIXEL);
     CD3DX12_DESCRIPTOR_RANGE1 lightIndexListSBDescrRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 6);
     rootParameters[ComputeParams::t6LightIndexListSB].InitAsDescriptorTable(1, &lightIndexListSBDescrRange, D3D12_SHADER_VISIBILITY_PIXEL);
+    rootParameters[ComputeParams::b1EnvironmentCB].InitAsConstantBufferView(1, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_PIXEL);
+    CD3DX12_DESCRIPTOR_RANGE1 prefilteredTexDescrRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 7);
+    rootParameters[ComputeParams::t7PrefilteredTex].InitAsDescriptorTable(1, &prefilteredTexDescrRange, D3D12_SHADER_VISIBILITY_PIXEL);
+    CD3DX12_DESCRIPTOR_RANGE1 brdfTexDescrRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 8);
+    rootParameters[ComputeParams::t8BRDFTex].InitAsDescriptorTable(1, &brdfTexDescrRange, D3D12_SHADER_VISIBILITY_PIXEL);
 
     // Allow input layout and deny unnecessary access to certain pipeline stages.
     D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags =
@@ -64,10 +88,14 @@ void ForwardPlusRenderPass::LoadContent(RenderPassBaseInfo* info)
         D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
         D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS;
 
-    CD3DX12_STATIC_SAMPLER_DESC linearRepeatSampler(0, D3D12_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR);
+    CD3DX12_STATIC_SAMPLER_DESC staticSamplers[] = {
+        CD3DX12_STATIC_SAMPLER_DESC(0, D3D12_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR),
+        // The BRDF table must not wrap at N.V and roughness 0 and 1.
+        CD3DX12_STATIC_SAMPLER_DESC(1, D3D12_FILTER_MIN_MAG_MIP_LINEAR, D3D12_TEXTURE_ADDRESS_MODE_CLAMP, D3D12_TEXTURE_ADDRESS_MODE_CLAMP, D3D12_TEXTURE_ADDRESS_MODE_CLAMP)
+    };
 
     CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDescription;
-    rootSignatureDescription.Init_1_1(ComputeParams::NumRootParameters, rootParameters, 1, &linearRepeatSampler, rootSignatureFlags);
+    rootSignatureDescription.Init_1_1(ComputeParams::NumRootParameters, rootParameters, _countof(staticSamplers), staticSamplers, rootSignatureFlags);
 
     m_RootSignature.SetRootSignatureDesc(rootSignatureDescription.Desc_1_1, fpInfo->rootSignatureVersion);
 
@@ -76,6 +104,7 @@ void ForwardPlusRenderPass::LoadContent(RenderPassBaseInfo* info)
         CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE pRootSignature;
         CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT InputLayout;
         CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY PrimitiveTopologyType;
+        CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER RasterizerState;
         CD3DX12_PIPELINE_STATE_STREAM_VS VS;
         CD3DX12_PIPELINE_STATE_STREAM_PS PS;
         CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT DSVFormat;
@@ -84,9 +113,17 @@ void ForwardPlusRenderPass::LoadContent(RenderPassBaseInfo* info)
     } pipelineStateStream;
 
     pipelineStateStream.pRootSignature = m_RootSignature.GetRootSignature().Get();
-    pipelineStateStream.InputLayout = { PosNormTexExtendedVertex::InputElementsExtended, PosNormTexExtendedVertex::InputElementCountExtended };
+    if (fpInfo->packedVertices)
+        pipelineStateStream.InputLayout = { PackedVertex::InputElementsPackedInstanced, PackedVertex::InputElementCountPackedInstanced };
+    else
+        pipelineStateStream.InputLayout = { PosNormTexExtendedVertex::InputElementsExtendedInstanced, PosNormTexExtendedVertex::InputElementCountExtendedInstanced };
     pipelineStateStream.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-    pipelineStateStream.VS = {g_ForwardPlus_VS, sizeof(g_ForwardPlus_VS)};
+    // Backface culling of the clockwise front faces, Scene::Render with the camera also culls the backfacing meshlets.
+    pipelineStateStream.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+    if (fpInfo->packedVertices)
+        pipelineStateStream.VS = {g_ForwardPlusPacked_VS, sizeof(g_ForwardPlusPacked_VS)};
+    else
+        pipelineStateStream.VS = {g_ForwardPlus_VS, sizeof(g_ForwardPlus_VS)};
     pipelineStateStream.PS = {g_ForwardPlus_PS, sizeof(g_ForwardPlus_PS)};
     pipelineStateStream.DSVFormat = fpInfo->depthBufferFormat;
     pipelineStateStream.RTVFormats = fpInfo->rtvFormats;
@@ -98,6 +135,9 @@ void ForwardPlusRenderPass::LoadContent(RenderPassBaseInfo* info)
 
     auto& device = GetApp().GetDevice();
     ThrowIfFailed(device->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&m_PipelineState)));
+
+    m_EnvironmentRoughness = fpInfo->environmentRoughness;
+    m_EnvironmentIntensity = fpInfo->environmentIntensity;
 }
 
 void ForwardPlusRenderPass::OnUpdate(std::shared_ptr<CommandList>& commandList, UpdateEventArgs& e)
@@ -149,4 +189,21 @@ void ForwardPlusRenderPass::AttachLightsSB(std::shared_ptr<CommandList>& command
 void ForwardPlusRenderPass::AttachLightIndexListSB(std::shared_ptr<CommandList>& commandList, const StructuredBuffer& sb)
 {
     commandList->SetShaderResourceView(ComputeParams::t6LightIndexListSB, 0, sb, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+}
+
+void ForwardPlusRenderPass::AttachEnvironmentLighting(std::shared_ptr<CommandList>& commandList, const XMMATRIX& inverseViewMatrix, const SHIrradiance& irradiance,
+    const Texture& prefilteredTex, const D3D12_SHADER_RESOURCE_VIEW_DESC* prefilteredSrv, const Texture& brdfTex)
+{
+    EnvironmentCB environment;
+    environment.InverseViewMatrix = inverseViewMatrix;
+    environment.Irradiance = irradiance;
+    environment.PrefilteredMips = static_cast<float>(prefilteredTex.GetD3D12ResourceDesc().MipLevels);
+    environment.Roughness = m_EnvironmentRoughness;
+    environment.Intensity = m_EnvironmentIntensity;
+    environment.Padding = 0.0f;
+
+    commandList->SetGraphicsDynamicConstantBuffer(ComputeParams::b1EnvironmentCB, environment);
+    commandList->SetShaderResourceView(ComputeParams::t7PrefilteredTex, 0, prefilteredTex, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+        0, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, prefilteredSrv);
+    commandList->SetShaderResourceView(ComputeParams::t8BRDFTex, 0, brdfTex, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <Frustum.h>
 
 #include <BoundingVolumesPrimitive.h>
+#include <Helpers.h>
 
 #include <xmmintrin.h>
 #include <mmintrin.h>
@@ -222,4 +223,23 @@ bool Frustum::FrustumInAABB(const BAABB& aabb_data, const std::array<DirectX::XM
 		inside &= d > 0;
 	}
 	return inside;
-}
\ No newline at end of file
+}
+
+bool Frustum::FrustumInOBB(const BOBB& obb_data, const std::array<DirectX::XMFLOAT4, 6>& planes)
+{
+	auto& center = obb_data.center;
+	auto& extents = obb_data.extents;
+	for (int j = 0; j < 6; ++j)
+	{
+		DirectX::XMFLOAT3 normal = { planes[j].x, planes[j].y, planes[j].z };
+
+		// Projection of the box half size on the plane normal.
+		float radius = extents.x * fabsf(Math::float3Dot(normal, obb_data.axes[0]))
+			+ extents.y * fabsf(Math::float3Dot(normal, obb_data.axes[1]))
+			+ extents.z * fabsf(Math::float3Dot(normal, obb_data.axes[2]));
+
+		if (Math::float3Dot(normal, center) + planes[j].w <= -radius)
+			return false;
+	}
+	return true;
+}
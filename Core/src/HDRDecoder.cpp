@@ -0,0 +1,319 @@
+#include <HDRDecoder.h>
+
+#include <DX12LibPCH.h>
+
+#include <MappedFile.h>
+#include <TextureCooker.h>
+#include <ThreadPool.h>
+
+#include <DirectXPackedVector.h>
+
+using namespace dx12demo::core;
+using namespace DirectX;
+
+namespace
+{
+    std::atomic<DXGI_FORMAT> g_StorageFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;
+
+    // Scanlines decoded per job.
+    const size_t BAND_HEIGHT = 32;
+
+    // The new RLE scanlines start with 2, 2 and the width, a width the encoding can't store is written flat.
+    const uint32_t RLE_MIN_WIDTH = 8;
+    const uint32_t RLE_MAX_WIDTH = 0x7fff;
+
+    struct HDRLayout
+    {
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        size_t DataOffset = 0;
+        // Where every scanline starts, empty if the scanlines are flat.
+        std::vector<size_t> Scanlines;
+    };
+
+    // The line at position without the new line, position moved to the next one.
+    bool ReadLine(const uint8_t* data, size_t size, size_t& position, std::string& line)
+    {
+        const uint8_t* end = static_cast<const uint8_t*>(memchr(data + position, '\n', size - position));
+        if (!end)
+            return false;
+
+        line.assign(reinterpret_cast<const char*>(data + position), end - (data + position));
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        position = end - data + 1;
+        return true;
+    }
+
+    // "-Y height +X width", the rows top to bottom and the texels left to right.
+    bool ParseResolution(const std::string& line, uint32_t& width, uint32_t& height)
+    {
+        if (line.compare(0, 3, "-Y ") != 0)
+            return false;
+
+        char* end = nullptr;
+        const unsigned long rows = strtoul(line.c_str() + 3, &end, 10);
+        if (strncmp(end, " +X ", 4) != 0)
+            return false;
+
+        const unsigned long columns = strtoul(end + 4, &end, 10);
+        if (*end != '\0' || rows == 0 || columns == 0 || rows > UINT32_MAX || columns > UINT32_MAX)
+            return false;
+
+        width = static_cast<uint32_t>(columns);
+        height = static_cast<uint32_t>(rows);
+        return true;
+    }
+
+    // The end of the RLE scanline at position, 0 if it isn't a valid one.
+    size_t SkipScanline(const uint8_t* data, size_t size, size_t position, uint32_t width)
+    {
+        if (position + 4 > size || data[position] != 2 || data[position + 1] != 2 || ((data[position + 2] << 8) | data[position + 3]) != width)
+            return 0;
+
+        position += 4;
+        for (uint32_t channel = 0; channel < 4; ++channel)
+        {
+            for (uint32_t x = 0; x < width; )
+            {
+                if (position >= size)
+                    return 0;
+
+                uint32_t count = data[position++];
+                if (count > 128)
+                {
+                    count -= 128;
+                    position += 1;
+                }
+                else
+                {
+                    position += count;
+                }
+
+                x += count;
+                if (count == 0 || x > width)
+                    return 0;
+            }
+        }
+
+        return position <= size ? position : 0;
+    }
+
+    bool ReadLayout(const uint8_t* data, size_t size, HDRLayout& layout)
+    {
+        size_t position = 0;
+        std::string line;
+        if (!ReadLine(data, size, position, line) || (line.compare(0, 10, "#?RADIANCE") != 0 && line.compare(0, 6, "#?RGBE") != 0))
+            return false;
+
+        // The header ends with an empty line, the XYZE files and their color space aren't handled here.
+        while (true)
+        {
+            if (!ReadLine(data, size, position, line))
+                return false;
+            if (line.empty())
+                break;
+            if (line.compare(0, 7, "FORMAT=") == 0 && line != "FORMAT=32-bit_rle_rgbe")
+                return false;
+        }
+
+        if (!ReadLine(data, size, position, line) || !ParseResolution(line, layout.Width, layout.Height))
+            return false;
+
+        layout.DataOffset = position;
+
+        const size_t flatSize = static_cast<size_t>(layout.Width) * layout.Height * 4;
+        const bool rle = layout.Width >= RLE_MIN_WIDTH && layout.Width <= RLE_MAX_WIDTH &&
+            position + 1 < size && data[position] == 2 && data[position + 1] == 2;
+        if (!rle)
+            return size - position == flatSize;
+
+        // The scanlines are of variable size, only their start is needed to decode them in parallel.
+        layout.Scanlines.resize(layout.Height);
+        for (uint32_t y = 0; y < layout.Height; ++y)
+        {
+            layout.Scanlines[y] = position;
+            position = SkipScanline(data, size, position, layout.Width);
+            if (position == 0)
+                return false;
+        }
+
+        return true;
+    }
+
+    // Decode the 4 channel planes of a RLE scanline to RGBE texels, validated by SkipScanline.
+    void DecodeScanline(const uint8_t* scanline, uint32_t width, uint8_t* texels)
+    {
+        scanline += 4;
+        for (uint32_t channel = 0; channel < 4; ++channel)
+        {
+            for (uint32_t x = 0; x < width; )
+            {
+                uint32_t count = *scanline++;
+                if (count > 128)
+                {
+                    count -= 128;
+                    const uint8_t value = *scanline++;
+                    for (uint32_t i = 0; i < count; ++i)
+                        texels[(x + i) * 4 + channel] = value;
+                }
+                else
+                {
+                    for (uint32_t i = 0; i < count; ++i)
+                        texels[(x + i) * 4 + channel] = scanline[i];
+                    scanline += count;
+                }
+                x += count;
+            }
+        }
+    }
+
+    // 2^(e - 136): the mantissas are 8 bits, the exponent is biased by 128. An exponent of 0 is black.
+    const float* GetExponentScales()
+    {
+        static const std::array<float, 256> scales = []()
+        {
+            std::array<float, 256> result;
+            result[0] = 0.f;
+            for (int e = 1; e < 256; ++e)
+                result[e] = ldexpf(1.f, e - 136);
+            return result;
+        }();
+
+        return scales.data();
+    }
+
+    void ConvertScanline(const uint8_t* texels, uint32_t width, XMFLOAT4* row)
+    {
+        const float* scales = GetExponentScales();
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const uint8_t* texel = texels + x * 4;
+            const XMVECTOR color = XMVectorMultiply(PackedVector::XMLoadUByte4(reinterpret_cast<const PackedVector::XMUBYTE4*>(texel)), XMVectorReplicate(scales[texel[3]]));
+            XMStoreFloat4(row + x, XMVectorSelect(g_XMOne, color, g_XMSelect1110));
+        }
+    }
+}
+
+bool HDRDecoder::Decode(const std::wstring& fileName, DirectX::TexMetadata& metadata, DirectX::ScratchImage& scratchImage)
+{
+    MappedFile file;
+    if (!file.Open(fileName) || !file.GetData())
+        return false;
+
+    HDRLayout layout;
+    if (!ReadLayout(file.GetData(), file.GetSize(), layout))
+        return false;
+
+    ThrowIfFailed(scratchImage.Initialize2D(DXGI_FORMAT_R32G32B32A32_FLOAT, layout.Width, layout.Height, 1, 1));
+    const Image& image = *scratchImage.GetImage(0, 0, 0);
+
+    const size_t bandCount = (layout.Height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+    ThreadPool::Get().ParallelFor(bandCount, [&](size_t band)
+    {
+        std::vector<uint8_t> texels(layout.Scanlines.empty() ? 0 : layout.Width * 4);
+
+        const size_t endRow = std::min<size_t>((band + 1) * BAND_HEIGHT, layout.Height);
+        for (size_t y = band * BAND_HEIGHT; y < endRow; ++y)
+        {
+            const uint8_t* scanline = file.GetData() + layout.DataOffset + y * layout.Width * 4;
+            if (!layout.Scanlines.empty())
+            {
+                DecodeScanline(file.GetData() + layout.Scanlines[y], layout.Width, texels.data());
+                scanline = texels.data();
+            }
+
+            ConvertScanline(scanline, layout.Width, reinterpret_cast<XMFLOAT4*>(image.pixels + y * image.rowPitch));
+        }
+    });
+
+    metadata = scratchImage.GetMetadata();
+    return true;
+}
+
+bool HDRDecoder::IsStorageFormat(DXGI_FORMAT format)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+    case DXGI_FORMAT_R11G11B10_FLOAT:
+    case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+    case DXGI_FORMAT_BC6H_UF16:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void HDRDecoder::SetStorageFormat(DXGI_FORMAT format)
+{
+    assert(IsStorageFormat(format));
+    g_StorageFormat = format;
+}
+
+DXGI_FORMAT HDRDecoder::GetStorageFormat()
+{
+    return g_StorageFormat;
+}
+
+void HDRDecoder::Pack(const DirectX::ScratchImage& source, DXGI_FORMAT format, DirectX::ScratchImage& packed)
+{
+    TexMetadata metadata = source.GetMetadata();
+    assert(metadata.format == DXGI_FORMAT_R32G32B32A32_FLOAT);
+    assert(IsStorageFormat(format) && format != DXGI_FORMAT_R32G32B32A32_FLOAT);
+
+    // D3D12 requires the top level of a block compressed texture to be a multiple of the 4x4 block.
+    if (format == DXGI_FORMAT_BC6H_UF16)
+    {
+        if (metadata.width % 4 == 0 && metadata.height % 4 == 0)
+        {
+            TextureCooker::Compress(source, format, packed);
+            return;
+        }
+        format = DXGI_FORMAT_R9G9B9E5_SHAREDEXP;
+    }
+
+    metadata.format = format;
+    ThrowIfFailed(packed.Initialize(metadata));
+
+    struct Band
+    {
+        size_t ImageIndex;
+        size_t FirstRow;
+    };
+
+    std::vector<Band> bands;
+    for (size_t i = 0; i < source.GetImageCount(); ++i)
+    {
+        for (size_t y = 0; y < source.GetImages()[i].height; y += BAND_HEIGHT)
+            bands.push_back({ i, y });
+    }
+
+    ThreadPool::Get().ParallelFor(bands.size(), [&](size_t index)
+    {
+        const Band& band = bands[index];
+        const Image& sourceImage = source.GetImages()[band.ImageIndex];
+        const Image& packedImage = packed.GetImages()[band.ImageIndex];
+
+        const size_t endRow = std::min(band.FirstRow + BAND_HEIGHT, sourceImage.height);
+        for (size_t y = band.FirstRow; y < endRow; ++y)
+        {
+            const auto* sourceRow = reinterpret_cast<const XMFLOAT4*>(sourceImage.pixels + y * sourceImage.rowPitch);
+            uint8_t* packedRow = packedImage.pixels + y * packedImage.rowPitch;
+
+            if (format == DXGI_FORMAT_R11G11B10_FLOAT)
+            {
+                auto* destination = reinterpret_cast<PackedVector::XMFLOAT3PK*>(packedRow);
+                for (size_t x = 0; x < sourceImage.width; ++x)
+                    PackedVector::XMStoreFloat3PK(destination + x, XMLoadFloat4(sourceRow + x));
+            }
+            else
+            {
+                auto* destination = reinterpret_cast<PackedVector::XMFLOAT3SE*>(packedRow);
+                for (size_t x = 0; x < sourceImage.width; ++x)
+                    PackedVector::XMStoreFloat3SE(destination + x, XMLoadFloat4(sourceRow + x));
+            }
+        }
+    });
+}
@@ -0,0 +1,81 @@
+#include <MappedFile.h>
+
+#include <DX12LibPCH.h>
+
+using namespace dx12demo::core;
+
+MappedFile::MappedFile()
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::wstring& fileName)
+{
+    Close();
+
+    m_File = CreateFileW(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_File == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(m_File, &fileSize))
+    {
+        Close();
+        return false;
+    }
+
+    m_Size = static_cast<size_t>(fileSize.QuadPart);
+    if (m_Size == 0)
+        return true;
+
+    m_Mapping = CreateFileMappingW(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_Mapping)
+    {
+        Close();
+        return false;
+    }
+
+    m_Data = static_cast<const uint8_t*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_Data)
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_Data)
+        UnmapViewOfFile(m_Data);
+    if (m_Mapping)
+        CloseHandle(m_Mapping);
+    if (m_File != INVALID_HANDLE_VALUE)
+        CloseHandle(m_File);
+
+    m_File = INVALID_HANDLE_VALUE;
+    m_Mapping = nullptr;
+    m_Data = nullptr;
+    m_Size = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+    return m_File != INVALID_HANDLE_VALUE;
+}
+
+const uint8_t* MappedFile::GetData() const
+{
+    return m_Data;
+}
+
+size_t MappedFile::GetSize() const
+{
+    return m_Size;
+}
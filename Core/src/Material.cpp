@@ -52,4 +52,24 @@ const Texture& Material::GetSpecularTex() const
 const Texture& Material::GetNormalTex() const
 {
 	return m_normal;
+}
+
+void Material::SetDiffuseTex(const Texture& texture)
+{
+	m_diffuse = texture;
+}
+
+void Material::SetAmbientTex(const Texture& texture)
+{
+	m_ambient = texture;
+}
+
+void Material::SetSpecularTex(const Texture& texture)
+{
+	m_specular = texture;
+}
+
+void Material::SetNormalTex(const Texture& texture)
+{
+	m_normal = texture;
 }
\ No newline at end of file
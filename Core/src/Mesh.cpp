@@ -1,6 +1,12 @@
 #include <Mesh.h>
 
 #include <DX12LibPCH.h>
+#include <BoundingVolumeBuilder.h>
+#include <MeshOptimizer.h>
+#include <MeshletBuilder.h>
+#include <TangentGenerator.h>
+#include <VertexPacker.h>
+#include <VertexWelder.h>
 
 using namespace dx12demo::core;
 using namespace DirectX;
@@ -22,6 +28,39 @@ const D3D12_INPUT_ELEMENT_DESC PosNormTexExtendedVertex::InputElementsExtended[]
     { "BITANGENT",  0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
 };
 
+const D3D12_INPUT_ELEMENT_DESC PosNormTexExtendedVertex::InputElementsExtendedInstanced[] =
+{
+    { "POSITION",           0, DXGI_FORMAT_R32G32B32_FLOAT,    0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,   0 },
+    { "NORMAL",             0, DXGI_FORMAT_R32G32B32_FLOAT,    0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,   0 },
+    { "TEXCOORD",           0, DXGI_FORMAT_R32G32_FLOAT,       0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,   0 },
+    { "TANGENT",            0, DXGI_FORMAT_R32G32B32_FLOAT,    0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,   0 },
+    { "BITANGENT",          0, DXGI_FORMAT_R32G32B32_FLOAT,    0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,   0 },
+    { "INSTANCE_TRANSFORM", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+    { "INSTANCE_TRANSFORM", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+    { "INSTANCE_TRANSFORM", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+    { "INSTANCE_TRANSFORM", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+};
+
+const D3D12_INPUT_ELEMENT_DESC PackedVertex::InputElementsPacked[] =
+{
+    { "POSITION",   0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "NORMAL",     0, DXGI_FORMAT_R16G16_SNORM,       0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "TANGENT",    0, DXGI_FORMAT_R16G16_SNORM,       0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "TEXCOORD",   0, DXGI_FORMAT_R16G16_FLOAT,       0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+};
+
+const D3D12_INPUT_ELEMENT_DESC PackedVertex::InputElementsPackedInstanced[] =
+{
+    { "POSITION",           0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,   0 },
+    { "NORMAL",             0, DXGI_FORMAT_R16G16_SNORM,       0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,   0 },
+    { "TANGENT",            0, DXGI_FORMAT_R16G16_SNORM,       0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,   0 },
+    { "TEXCOORD",           0, DXGI_FORMAT_R16G16_FLOAT,       0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,   0 },
+    { "INSTANCE_TRANSFORM", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+    { "INSTANCE_TRANSFORM", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+    { "INSTANCE_TRANSFORM", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+    { "INSTANCE_TRANSFORM", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+};
+
 Mesh::Mesh()
     : m_IndexCount(0)
 {}
@@ -29,31 +68,99 @@ Mesh::Mesh()
 Mesh::~Mesh()
 {
     // Allocated resources will be cleaned automatically when the pointers go out of scope.
+    // The pool ranges may still be used by the frames in flight.
+    if (m_MeshPool)
+        m_MeshPool->Free(m_PoolAllocation);
 }
 
 void Mesh::Render(std::shared_ptr<CommandList>& commandList, uint32_t instanceCount/* = 1*/, uint32_t firstInstance/* = 0*/)
 {
     commandList->SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    commandList->SetVertexBuffer(0, m_VertexBuffer);
+    commandList->SetVertexBuffer(0, GetVertexBuffer());
     if (m_IndexCount > 0)
     {
-        commandList->SetIndexBuffer(m_IndexBuffer);
-        commandList->DrawIndexed(m_IndexCount, instanceCount, 0, 0, firstInstance);
+        commandList->SetIndexBuffer(GetIndexBuffer());
+        commandList->DrawIndexed(m_IndexCount, instanceCount, m_StartIndexLocation, m_BaseVertexLocation, firstInstance);
     }
     else
     {
-        commandList->Draw(m_VertexBuffer.GetNumVertices(), instanceCount, 0, firstInstance);
+        commandList->Draw(m_VertexCount, instanceCount, m_BaseVertexLocation, firstInstance);
     }
 }
 
 void Mesh::RenderSubMesh(std::shared_ptr<CommandList>& commandList, uint16_t indexSubMesh, uint32_t instanceCount/* = 1*/, uint32_t firstInstance/* = 0*/)
 {
     commandList->SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    commandList->SetVertexBuffer(0, m_VertexBuffer);
-    commandList->SetIndexBuffer(m_IndexBuffer);
+    commandList->SetVertexBuffer(0, GetVertexBuffer());
+    commandList->SetIndexBuffer(GetIndexBuffer());
     
     auto& submesh = m_SubMeshes[indexSubMesh];
-    commandList->DrawIndexed(submesh.IndexCount, instanceCount, submesh.StartIndexLocation, submesh.BaseVertexLocation, firstInstance);
+    commandList->DrawIndexed(submesh.IndexCount, instanceCount, m_StartIndexLocation + submesh.StartIndexLocation,
+        m_BaseVertexLocation + submesh.BaseVertexLocation, firstInstance);
+}
+
+uint32_t Mesh::RenderClusters(std::shared_ptr<CommandList>& commandList, const std::array<DirectX::XMFLOAT4, 6>& frustumPlanes, const DirectX::XMFLOAT3* cameraPosition/* = nullptr*/, uint32_t instanceCount/* = 1*/, uint32_t firstInstance/* = 0*/)
+{
+    if (m_Meshlets.empty())
+    {
+        Render(commandList, instanceCount, firstInstance);
+        return m_IndexCount > 0 ? m_IndexCount / 3 : m_VertexCount / 3;
+    }
+
+    MeshletBuilder::Cull(m_Meshlets, frustumPlanes, cameraPosition, m_VisibleMeshletRanges);
+
+    if (m_VisibleMeshletRanges.empty())
+        return 0;
+
+    commandList->SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    commandList->SetVertexBuffer(0, GetVertexBuffer());
+    commandList->SetIndexBuffer(GetIndexBuffer());
+
+    uint32_t triangleCount = 0;
+    for (const auto& range : m_VisibleMeshletRanges)
+    {
+        commandList->DrawIndexed(range.IndexCount, instanceCount, m_StartIndexLocation + range.StartIndexLocation,
+            m_BaseVertexLocation + range.BaseVertexLocation, firstInstance);
+        triangleCount += range.IndexCount / 3;
+    }
+
+    return triangleCount;
+}
+
+void Mesh::RenderLod(std::shared_ptr<CommandList>& commandList, uint32_t lod, uint32_t instanceCount/* = 1*/, uint32_t firstInstance/* = 0*/)
+{
+    if (lod == 0 || lod >= m_Lods.size())
+    {
+        Render(commandList, instanceCount, firstInstance);
+        return;
+    }
+
+    const auto& arguments = GetDrawArguments(lod, instanceCount, firstInstance);
+
+    commandList->SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    commandList->SetVertexBuffer(0, GetVertexBuffer());
+    commandList->SetIndexBuffer(GetIndexBuffer());
+    commandList->DrawIndexed(arguments.IndexCountPerInstance, instanceCount, arguments.StartIndexLocation, arguments.BaseVertexLocation, firstInstance);
+}
+
+uint32_t Mesh::SelectLod(float distance, float projectionScale, float maxPixelError/* = 1.f*/) const
+{
+    uint32_t selected = 0;
+
+    // The camera is inside the mesh bounds.
+    if (distance <= 0.f)
+        return selected;
+
+    for (uint32_t lod = 1; lod < m_Lods.size(); ++lod)
+    {
+        float pixelError = m_Lods[lod].Error * projectionScale / distance;
+        if (pixelError > maxPixelError)
+            break;
+
+        selected = lod;
+    }
+
+    return selected;
 }
 
 void Mesh::PushSubMesh(uint16_t index, SubMesh& submesh)
@@ -83,59 +190,140 @@ const BAABB& Mesh::GetBAABB() const
     return m_baabb;
 }
 
+const BOBB& Mesh::GetBOBB() const
+{
+    return m_bobb;
+}
+
+void Mesh::InitializeBounds(const std::vector<DirectX::XMFLOAT3>& positions)
+{
+    m_baabb = BoundingVolumeBuilder::ComputeAABB(positions);
+    m_bsphere = BoundingVolumeBuilder::ComputeRitterSphere(positions);
+    m_bobb = BoundingVolumeBuilder::ComputeOBB(positions);
+}
+
+const MeshOptimizerReport& Mesh::GetOptimizerReport() const
+{
+    return m_OptimizerReport;
+}
+
+const std::vector<Meshlet>& Mesh::GetMeshlets() const
+{
+    return m_Meshlets;
+}
+
+UINT Mesh::GetIndexCount() const
+{
+    return m_IndexCount;
+}
+
+bool Mesh::IsPacked() const
+{
+    return m_Packed;
+}
+
+const BAABB& Mesh::GetPackedBounds() const
+{
+    return m_PackedBounds;
+}
+
+uint32_t Mesh::GetLodCount() const
+{
+    return static_cast<uint32_t>(m_Lods.size());
+}
+
+const MeshLod& Mesh::GetLod(uint32_t lod) const
+{
+    assert(lod < m_Lods.size());
+
+    return m_Lods[lod];
+}
+
+bool Mesh::IsPooled() const
+{
+    return m_PoolAllocation.IsValid();
+}
+
+const MeshPoolAllocation& Mesh::GetPoolAllocation() const
+{
+    return m_PoolAllocation;
+}
+
+const VertexBuffer& Mesh::GetVertexBuffer() const
+{
+    return m_MeshPool ? m_MeshPool->GetVertexBuffer(m_PoolAllocation.PageIndex) : m_VertexBuffer;
+}
+
+const IndexBuffer& Mesh::GetIndexBuffer() const
+{
+    return m_MeshPool ? m_MeshPool->GetIndexBuffer(m_PoolAllocation.PageIndex) : m_IndexBuffer;
+}
+
+D3D12_DRAW_INDEXED_ARGUMENTS Mesh::GetDrawArguments(uint32_t lod/* = 0*/, uint32_t instanceCount/* = 1*/, uint32_t firstInstance/* = 0*/) const
+{
+    assert(lod < m_Lods.size());
+
+    const auto& range = m_Lods[lod].Range;
+
+    D3D12_DRAW_INDEXED_ARGUMENTS arguments;
+    arguments.IndexCountPerInstance = range.IndexCount;
+    arguments.InstanceCount = instanceCount;
+    arguments.StartIndexLocation = m_StartIndexLocation + range.StartIndexLocation;
+    arguments.BaseVertexLocation = m_BaseVertexLocation + range.BaseVertexLocation;
+    arguments.StartInstanceLocation = firstInstance;
+
+    return arguments;
+}
+
 std::unique_ptr<Mesh> Mesh::CreateCustomMesh(CommandList& commandList, VertexExtendedCollection& vertices, IndexCollection& indices, MeshCreatorInfo& info)
 {
-    auto mesh = Mesh::CreateCustomMesh(commandList, vertices, indices, info.rhcoords);
+    std::unique_ptr<Mesh> mesh(new Mesh());
+    mesh->Initialize(commandList, vertices, indices, info.rhcoords, true, &info.lods, info.packVertices, info.pool, info.weldVertices);
 
-    BSphere bsphere;
-    bsphere.pos = info.bv_pos;
-    bsphere.r = Math::float3Radius(info.bv_max_pos, info.bv_min_pos) * 0.5f;
-    mesh->SetBSphere(bsphere);
-    BAABB bAABB;
-    bAABB.box_max = info.bv_max_pos;
-    bAABB.box_min = info.bv_min_pos;
-    mesh->SetBAABB(bAABB);
+    if (info.exactBoundingSphere)
+    {
+        BSphere bsphere = BoundingVolumeBuilder::ComputeMinimalSphere(BoundingVolumeBuilder::GetPositions(vertices));
+        mesh->SetBSphere(bsphere);
+    }
 
     return mesh;
 }
 
 std::unique_ptr<Mesh> Mesh::CreateCustomMesh(CommandList& commandList, VertexCollection& vertices, IndexCollection& indices, MeshCreatorInfo& info)
 {
-    auto mesh = Mesh::CreateCustomMesh(commandList, vertices, indices, info.rhcoords);
+    std::unique_ptr<Mesh> mesh(new Mesh());
+    mesh->Initialize(commandList, vertices, indices, info.rhcoords, true, &info.lods, info.pool, info.weldVertices);
 
-    BSphere bsphere;
-    bsphere.pos = info.bv_pos;
-    bsphere.r = Math::float3Radius(info.bv_max_pos, info.bv_min_pos) * 0.5f;
-    mesh->SetBSphere(bsphere);
-    BAABB bAABB;
-    bAABB.box_max = info.bv_max_pos;
-    bAABB.box_min = info.bv_min_pos;
-    mesh->SetBAABB(bAABB);
+    if (info.exactBoundingSphere)
+    {
+        BSphere bsphere = BoundingVolumeBuilder::ComputeMinimalSphere(BoundingVolumeBuilder::GetPositions(vertices));
+        mesh->SetBSphere(bsphere);
+    }
 
     return mesh;
 }
 
-std::unique_ptr<Mesh> Mesh::CreateCustomMesh(CommandList& commandList, VertexCollection& vertices, IndexCollection& indices, bool rhcoords/* = false*/)
+std::unique_ptr<Mesh> Mesh::CreateCustomMesh(CommandList& commandList, VertexCollection& vertices, IndexCollection& indices, bool rhcoords/* = false*/, bool optimize/* = true*/)
 {
     // Create the customs object.
     std::unique_ptr<Mesh> mesh(new Mesh());
 
-    mesh->Initialize(commandList, vertices, indices, rhcoords);
+    mesh->Initialize(commandList, vertices, indices, rhcoords, optimize);
 
     return mesh;
 }
 
-std::unique_ptr<Mesh> Mesh::CreateCustomMesh(CommandList& commandList, VertexExtendedCollection& vertices, IndexCollection& indices, bool rhcoords/* = false*/)
+std::unique_ptr<Mesh> Mesh::CreateCustomMesh(CommandList& commandList, VertexExtendedCollection& vertices, IndexCollection& indices, bool rhcoords/* = false*/, bool optimize/* = true*/)
 {
     // Create the customs object.
     std::unique_ptr<Mesh> mesh(new Mesh());
 
-    mesh->Initialize(commandList, vertices, indices, rhcoords);
+    mesh->Initialize(commandList, vertices, indices, rhcoords, optimize);
 
     return mesh;
 }
 
-std::unique_ptr<Mesh> Mesh::CreateSphere(CommandList& commandList, float diameter, size_t tessellation, bool rhcoords)
+std::unique_ptr<Mesh> Mesh::CreateSphere(CommandList& commandList, float diameter, size_t tessellation, bool rhcoords, bool tangents)
 {
     VertexCollection vertices;
     IndexCollection indices;
@@ -200,7 +388,10 @@ std::unique_ptr<Mesh> Mesh::CreateSphere(CommandList& commandList, float diamete
     // Create the primitive object.
     std::unique_ptr<Mesh> mesh(new Mesh());
 
-    mesh->Initialize(commandList, vertices, indices, rhcoords);
+    if (tangents)
+        mesh->InitializeWithTangents(commandList, vertices, indices, rhcoords);
+    else
+        mesh->Initialize(commandList, vertices, indices, rhcoords);
 
     return mesh;
 }
@@ -427,7 +618,7 @@ std::unique_ptr<Mesh> Mesh::CreateCone(CommandList& commandList, float diameter,
     return mesh;
 }
 
-std::unique_ptr<Mesh> Mesh::CreateTorus(CommandList& commandList, float diameter, float thickness, size_t tessellation, bool rhcoords)
+std::unique_ptr<Mesh> Mesh::CreateTorus(CommandList& commandList, float diameter, float thickness, size_t tessellation, bool rhcoords, bool tangents)
 {
     VertexCollection vertices;
     IndexCollection indices;
@@ -485,7 +676,10 @@ std::unique_ptr<Mesh> Mesh::CreateTorus(CommandList& commandList, float diameter
     // Create the primitive object.
     std::unique_ptr<Mesh> mesh(new Mesh());
 
-    mesh->Initialize(commandList, vertices, indices, rhcoords);
+    if (tangents)
+        mesh->InitializeWithTangents(commandList, vertices, indices, rhcoords);
+    else
+        mesh->Initialize(commandList, vertices, indices, rhcoords);
 
     return mesh;
 }
@@ -623,6 +817,16 @@ std::unique_ptr<Mesh> Mesh::CreateSkyPlane(CommandList& commandList, int skyPlan
     return mesh;
 }
 
+// Helper for flipping winding of the index only data, e.g. simplified levels which share the vertices.
+static void ReverseWinding(IndexCollection& indices)
+{
+    assert((indices.size() % 3) == 0);
+    for (auto it = indices.begin(); it != indices.end(); it += 3)
+    {
+        std::swap(*it, *(it + 2));
+    }
+}
+
 // Helper for flipping winding of geometric primitives for LH vs. RH coords
 static void ReverseWinding(IndexCollection& indices, VertexCollection& vertices)
 {
@@ -638,18 +842,40 @@ static void ReverseWinding(IndexCollection& indices, VertexCollection& vertices)
     }
 }
 
-void Mesh::Initialize(CommandList& commandList, VertexCollection& vertices, IndexCollection& indices, bool rhcoords)
+void Mesh::Initialize(CommandList& commandList, VertexCollection& vertices, IndexCollection& indices, bool rhcoords, bool optimize/* = true*/, MeshLodChain* lods/* = nullptr*/,
+    std::shared_ptr<MeshPool> pool/* = nullptr*/, bool weld/* = false*/)
 {
     if (vertices.size() >= USHRT_MAX)
         throw std::exception("Too many vertices for 16-bit index buffer");
 
     if (!rhcoords)
+    {
         ReverseWinding(indices, vertices);
 
-    commandList.CopyVertexBuffer(m_VertexBuffer, vertices);
-    commandList.CopyIndexBuffer(m_IndexBuffer, indices);
+        if (lods)
+        {
+            for (auto& lod : lods->Indices)
+                ReverseWinding(lod);
+        }
+    }
+
+    // The LOD indices would need the remap, so not with them.
+    if (weld && (!lods || lods->Indices.empty()) && !indices.empty())
+        VertexWelder::Weld(vertices, indices);
+
+    // Reorder triangles and vertices for the post-transform cache, overdraw and vertex fetch.
+    if (optimize && !indices.empty())
+        m_OptimizerReport = lods ? MeshOptimizer::Optimize(vertices, indices, lods->Indices) : MeshOptimizer::Optimize(vertices, indices);
+
+    // Meshlets are built on the final index order, so every meshlet is a contiguous index range.
+    MeshletBuilder::Build(vertices, indices, m_Meshlets);
+
+    InitializeBounds(BoundingVolumeBuilder::GetPositions(vertices));
 
     m_IndexCount = static_cast<UINT>(indices.size());
+    InitializeLods(indices, lods);
+
+    UploadGeometry(commandList, vertices.size(), sizeof(PosNormTexVertex), vertices.data(), indices, pool);
 }
 
 // Helper for flipping winding of geometric primitives for LH vs. RH coords
@@ -667,16 +893,108 @@ static void ReverseWinding(IndexCollection& indices, VertexExtendedCollection& v
     }
 }
 
-void Mesh::Initialize(CommandList& commandList, VertexExtendedCollection& vertices, IndexCollection& indices, bool rhcoords)
+void Mesh::Initialize(CommandList& commandList, VertexExtendedCollection& vertices, IndexCollection& indices, bool rhcoords, bool optimize/* = true*/, MeshLodChain* lods/* = nullptr*/,
+    bool packVertices/* = false*/, std::shared_ptr<MeshPool> pool/* = nullptr*/, bool weld/* = false*/)
 {
     if (vertices.size() >= USHRT_MAX)
         throw std::exception("Too many vertices for 16-bit index buffer");
 
     if (!rhcoords)
+    {
         ReverseWinding(indices, vertices);
 
-    commandList.CopyVertexBuffer(m_VertexBuffer, vertices);
-    commandList.CopyIndexBuffer(m_IndexBuffer, indices);
+        if (lods)
+        {
+            for (auto& lod : lods->Indices)
+                ReverseWinding(lod);
+        }
+    }
+
+    // The LOD indices would need the remap, so not with them.
+    if (weld && (!lods || lods->Indices.empty()) && !indices.empty())
+        VertexWelder::Weld(vertices, indices);
+
+    // Reorder triangles and vertices for the post-transform cache, overdraw and vertex fetch.
+    if (optimize && !indices.empty())
+        m_OptimizerReport = lods ? MeshOptimizer::Optimize(vertices, indices, lods->Indices) : MeshOptimizer::Optimize(vertices, indices);
+
+    // Meshlets are built on the final index order, so every meshlet is a contiguous index range.
+    MeshletBuilder::Build(vertices, indices, m_Meshlets);
+
+    InitializeBounds(BoundingVolumeBuilder::GetPositions(vertices));
 
     m_IndexCount = static_cast<UINT>(indices.size());
+    InitializeLods(indices, lods);
+
+    if (packVertices)
+    {
+        PackedVertexCollection packedVertices;
+        m_PackedBounds = VertexPacker::Pack(vertices, packedVertices);
+        m_Packed = true;
+
+        UploadGeometry(commandList, packedVertices.size(), sizeof(PackedVertex), packedVertices.data(), indices, pool);
+    }
+    else
+    {
+        UploadGeometry(commandList, vertices.size(), sizeof(PosNormTexExtendedVertex), vertices.data(), indices, pool);
+    }
+}
+
+void Mesh::InitializeWithTangents(CommandList& commandList, VertexCollection& vertices, IndexCollection& indices, bool rhcoords)
+{
+    if (!rhcoords)
+        ReverseWinding(indices, vertices);
+
+    VertexExtendedCollection extendedVertices;
+    TangentGenerator::Generate(vertices, indices, extendedVertices);
+
+    Initialize(commandList, extendedVertices, indices, true);
+}
+
+void Mesh::UploadGeometry(CommandList& commandList, size_t vertexCount, size_t vertexStride, const void* vertexData,
+    const IndexCollection& indices, std::shared_ptr<MeshPool> pool)
+{
+    m_VertexCount = static_cast<UINT>(vertexCount);
+
+    if (pool && vertexCount > 0)
+    {
+        m_MeshPool = pool;
+        m_PoolAllocation = m_MeshPool->Allocate(commandList, vertexCount, vertexStride, vertexData, indices.size(), indices.data());
+
+        m_StartIndexLocation = m_PoolAllocation.StartIndexLocation;
+        m_BaseVertexLocation = static_cast<INT>(m_PoolAllocation.BaseVertexLocation);
+        return;
+    }
+
+    commandList.CopyVertexBuffer(m_VertexBuffer, vertexCount, vertexStride, vertexData);
+    commandList.CopyIndexBuffer(m_IndexBuffer, indices);
+}
+
+void Mesh::InitializeLods(IndexCollection& indices, MeshLodChain* lods)
+{
+    m_Lods.clear();
+
+    MeshLod fullDetail;
+    fullDetail.Range.IndexCount = m_IndexCount;
+    m_Lods.push_back(fullDetail);
+
+    if (!lods)
+        return;
+
+    assert(lods->Indices.size() == lods->Errors.size());
+
+    for (size_t i = 0; i < lods->Indices.size(); ++i)
+    {
+        const auto& lodIndices = lods->Indices[i];
+        if (lodIndices.empty())
+            continue;
+
+        MeshLod lod;
+        lod.Range.StartIndexLocation = static_cast<UINT>(indices.size());
+        lod.Range.IndexCount = static_cast<UINT>(lodIndices.size());
+        lod.Error = lods->Errors[i];
+        m_Lods.push_back(lod);
+
+        indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+    }
 }
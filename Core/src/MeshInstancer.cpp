@@ -0,0 +1,172 @@
+#include <MeshInstancer.h>
+
+#include <DX12LibPCH.h>
+
+#include <ThreadPool.h>
+
+using namespace dx12demo::core;
+
+namespace
+{
+    const uint64_t FNV_OFFSET = 14695981039346656037ull;
+    const uint64_t FNV_PRIME = 1099511628211ull;
+
+    uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+
+        return hash;
+    }
+
+    // PosNormTexExtendedVertex is padded to its 16 byte alignment, only the attributes are hashed and compared.
+    uint64_t HashVertex(uint64_t hash, const PosNormTexExtendedVertex& vertex)
+    {
+        hash = HashBytes(hash, &vertex.m_position, sizeof(vertex.m_position));
+        hash = HashBytes(hash, &vertex.m_normal, sizeof(vertex.m_normal));
+        hash = HashBytes(hash, &vertex.m_texCoord, sizeof(vertex.m_texCoord));
+        hash = HashBytes(hash, &vertex.m_tangent, sizeof(vertex.m_tangent));
+        return HashBytes(hash, &vertex.m_bitangent, sizeof(vertex.m_bitangent));
+    }
+
+    bool IsSameVertex(const PosNormTexExtendedVertex& a, const PosNormTexExtendedVertex& b)
+    {
+        return memcmp(&a.m_position, &b.m_position, sizeof(a.m_position)) == 0 &&
+            memcmp(&a.m_normal, &b.m_normal, sizeof(a.m_normal)) == 0 &&
+            memcmp(&a.m_texCoord, &b.m_texCoord, sizeof(a.m_texCoord)) == 0 &&
+            memcmp(&a.m_tangent, &b.m_tangent, sizeof(a.m_tangent)) == 0 &&
+            memcmp(&a.m_bitangent, &b.m_bitangent, sizeof(a.m_bitangent)) == 0;
+    }
+
+    bool IsIdentity(const DirectX::XMFLOAT4X4& matrix)
+    {
+        return DirectX::XMMatrixIsIdentity(DirectX::XMLoadFloat4x4(&matrix));
+    }
+}
+
+MeshInstancingReport MeshInstancer::MergeDuplicates(std::vector<SceneMeshData>& meshes)
+{
+    MeshInstancingReport report;
+    report.MeshesBefore = meshes.size();
+
+    std::vector<uint64_t> hashes(meshes.size());
+    ThreadPool::Get().ParallelFor(meshes.size(), [&meshes, &hashes](size_t i)
+    {
+        hashes[i] = HashMesh(meshes[i]);
+    });
+
+    // The first mesh of every content, the duplicates move their occurrences to it. Serial, the result depends only on the mesh order.
+    std::unordered_multimap<uint64_t, size_t> firstByHash;
+    firstByHash.reserve(meshes.size());
+    std::vector<bool> removed(meshes.size(), false);
+
+    auto getOccurrences = [](const SceneMeshData& mesh)
+    {
+        // No instances is a single occurrence with the identity transform.
+        if (mesh.Instances.empty())
+        {
+            DirectX::XMFLOAT4X4 identity;
+            DirectX::XMStoreFloat4x4(&identity, DirectX::XMMatrixIdentity());
+            return std::vector<DirectX::XMFLOAT4X4>(1, identity);
+        }
+
+        return mesh.Instances;
+    };
+
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        report.BytesBefore += GetDataSize(meshes[i]);
+
+        size_t first = i;
+        auto range = firstByHash.equal_range(hashes[i]);
+        for (auto iter = range.first; iter != range.second; ++iter)
+        {
+            if (IsSameContent(meshes[iter->second], meshes[i]))
+            {
+                first = iter->second;
+                break;
+            }
+        }
+
+        if (first == i)
+        {
+            firstByHash.emplace(hashes[i], i);
+            continue;
+        }
+
+        auto instances = getOccurrences(meshes[first]);
+        auto duplicates = getOccurrences(meshes[i]);
+        instances.insert(instances.end(), duplicates.begin(), duplicates.end());
+        meshes[first].Instances.swap(instances);
+
+        removed[i] = true;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        if (removed[i])
+            continue;
+
+        if (count != i)
+            meshes[count] = std::move(meshes[i]);
+
+        auto& mesh = meshes[count++];
+        if (mesh.Instances.size() == 1 && IsIdentity(mesh.Instances[0]))
+            mesh.Instances.clear();
+
+        report.BytesAfter += GetDataSize(mesh);
+        report.InstanceCount += std::max<size_t>(mesh.Instances.size(), 1);
+    }
+    meshes.resize(count);
+
+    report.MeshesAfter = meshes.size();
+
+    return report;
+}
+
+uint64_t MeshInstancer::HashMesh(const SceneMeshData& mesh)
+{
+    uint64_t hash = FNV_OFFSET;
+    for (const auto& vertex : mesh.Vertices)
+        hash = HashVertex(hash, vertex);
+    hash = HashBytes(hash, mesh.Indices.data(), mesh.Indices.size() * sizeof(uint16_t));
+
+    for (const auto& texture : mesh.Textures)
+    {
+        hash = HashBytes(hash, &texture.Type, sizeof(texture.Type));
+        hash = HashBytes(hash, texture.Path.data(), texture.Path.size());
+    }
+
+    return hash;
+}
+
+bool MeshInstancer::IsSameContent(const SceneMeshData& a, const SceneMeshData& b)
+{
+    if (a.Vertices.size() != b.Vertices.size() || a.Indices.size() != b.Indices.size() || a.Textures.size() != b.Textures.size() ||
+        a.GenerateTangents != b.GenerateTangents)
+        return false;
+
+    for (size_t i = 0; i < a.Textures.size(); ++i)
+    {
+        if (a.Textures[i].Type != b.Textures[i].Type || a.Textures[i].Path != b.Textures[i].Path)
+            return false;
+    }
+
+    for (size_t i = 0; i < a.Vertices.size(); ++i)
+    {
+        if (!IsSameVertex(a.Vertices[i], b.Vertices[i]))
+            return false;
+    }
+
+    return memcmp(a.Indices.data(), b.Indices.data(), a.Indices.size() * sizeof(uint16_t)) == 0;
+}
+
+size_t MeshInstancer::GetDataSize(const SceneMeshData& mesh)
+{
+    return mesh.Vertices.size() * sizeof(PosNormTexExtendedVertex) + mesh.Indices.size() * sizeof(uint16_t);
+}
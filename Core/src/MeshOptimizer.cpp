@@ -0,0 +1,337 @@
+#include <MeshOptimizer.h>
+
+#include <DX12LibPCH.h>
+
+using namespace dx12demo::core;
+
+namespace
+{
+    // Forsyth's scoring constants.
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float LAST_TRI_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    float ForsythVertexScore(int cachePosition, uint32_t remainingValence)
+    {
+        // The vertex is not used by any triangle anymore.
+        if (remainingValence == 0)
+            return -1.f;
+
+        float score = 0.f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+            {
+                // The vertex was used in the last triangle, so it has a fixed score,
+                // whichever of the three it's in. Otherwise, you can get very different
+                // answers depending on whether you add the triangle 1,2,3 or 3,1,2.
+                score = LAST_TRI_SCORE;
+            }
+            else
+            {
+                const float scaler = 1.f / (MeshOptimizer::FORSYTH_CACHE_SIZE - 3);
+                score = 1.f - (cachePosition - 3) * scaler;
+                score = powf(score, CACHE_DECAY_POWER);
+            }
+        }
+
+        // Bonus points for having a low number of triangles left to draw, so lone vertices are not left behind.
+        float valenceBoost = powf(static_cast<float>(remainingValence), -VALENCE_BOOST_POWER);
+        score += VALENCE_BOOST_SCALE * valenceBoost;
+
+        return score;
+    }
+}
+
+VertexCacheStatistics MeshOptimizer::AnalyzeVertexCache(const IndexCollection& indices, size_t vertexCount, uint32_t cacheSize/* = ANALYZE_CACHE_SIZE*/)
+{
+    VertexCacheStatistics stats;
+    stats.TriangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+    if (stats.TriangleCount == 0 || vertexCount == 0)
+        return stats;
+
+    // Timestamp based FIFO: a vertex is in the cache while it was inserted less than cacheSize insertions ago.
+    std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    uint32_t timestamp = cacheSize + 1;
+
+    for (size_t i = 0; i < stats.TriangleCount * 3; ++i)
+    {
+        uint32_t index = indices[i];
+        assert(index < vertexCount);
+
+        if (timestamp - cacheTimestamps[index] > cacheSize)
+        {
+            cacheTimestamps[index] = timestamp++;
+            stats.VerticesTransformed++;
+        }
+
+        if (!referenced[index])
+        {
+            referenced[index] = true;
+            stats.VertexCount++;
+        }
+    }
+
+    stats.ACMR = static_cast<float>(stats.VerticesTransformed) / stats.TriangleCount;
+    stats.ATVR = stats.VertexCount > 0 ? static_cast<float>(stats.VerticesTransformed) / stats.VertexCount : 0.f;
+
+    return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(IndexCollection& indices, size_t vertexCount)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+        return;
+
+    // Build vertex -> triangles adjacency.
+    std::vector<uint32_t> valence(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+        valence[indices[i]]++;
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + valence[v];
+
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            for (size_t k = 0; k < 3; ++k)
+                adjacency[fill[indices[triangle * 3 + k]]++] = static_cast<uint32_t>(triangle);
+        }
+    }
+
+    // Triangles which are still to be emitted are kept in the front part of every adjacency list.
+    std::vector<uint32_t> remainingValence(valence);
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        vertexScore[v] = ForsythVertexScore(-1, remainingValence[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        triangleScore[triangle] = vertexScore[indices[triangle * 3 + 0]]
+            + vertexScore[indices[triangle * 3 + 1]]
+            + vertexScore[indices[triangle * 3 + 2]];
+    }
+
+    std::vector<bool> emitted(triangleCount, false);
+
+    // The cache holds FORSYTH_CACHE_SIZE entries plus 3 slots for a newly added triangle.
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    IndexCollection result;
+    result.reserve(triangleCount * 3);
+
+    size_t scanCursor = 0;
+    int64_t bestTriangle = -1;
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+    {
+        if (bestTriangle < 0)
+        {
+            // Nothing adjacent to the cache is left: pick the best remaining triangle from a linear scan.
+            float bestScore = -1.f;
+            for (size_t triangle = scanCursor; triangle < triangleCount; ++triangle)
+            {
+                if (emitted[triangle])
+                    continue;
+
+                if (bestTriangle < 0)
+                    scanCursor = triangle;
+
+                if (triangleScore[triangle] > bestScore)
+                {
+                    bestScore = triangleScore[triangle];
+                    bestTriangle = static_cast<int64_t>(triangle);
+                }
+
+                // Do not scan the whole mesh for every island, the first candidates are good enough.
+                if (triangle - scanCursor > 256)
+                    break;
+            }
+        }
+
+        assert(bestTriangle >= 0);
+        const size_t triangle = static_cast<size_t>(bestTriangle);
+        emitted[triangle] = true;
+
+        const uint32_t triangleVertices[3] = { indices[triangle * 3 + 0], indices[triangle * 3 + 1], indices[triangle * 3 + 2] };
+
+        // Emit the triangle and move its vertices to the front of the LRU cache.
+        newCache.clear();
+        for (uint32_t vertex : triangleVertices)
+        {
+            result.push_back(static_cast<IndexCollection::value_type>(vertex));
+            if (std::find(newCache.begin(), newCache.end(), vertex) == newCache.end())
+                newCache.push_back(vertex);
+
+            // Remove the triangle from the live part of the adjacency list.
+            uint32_t begin = adjacencyOffsets[vertex];
+            uint32_t end = begin + remainingValence[vertex];
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                if (adjacency[i] == triangle)
+                {
+                    std::swap(adjacency[i], adjacency[end - 1]);
+                    break;
+                }
+            }
+            remainingValence[vertex]--;
+        }
+
+        for (uint32_t vertex : cache)
+        {
+            if (vertex != triangleVertices[0] && vertex != triangleVertices[1] && vertex != triangleVertices[2])
+                newCache.push_back(vertex);
+        }
+
+        // Vertices pushed out of the cache lose the cache part of their score.
+        for (size_t i = FORSYTH_CACHE_SIZE; i < newCache.size(); ++i)
+            cachePosition[newCache[i]] = -1;
+
+        if (newCache.size() > FORSYTH_CACHE_SIZE)
+            newCache.resize(FORSYTH_CACHE_SIZE);
+
+        cache.swap(newCache);
+
+        // Update scores of the vertices in the cache and of the triangles using them,
+        // picking the best triangle for the next step along the way.
+        for (size_t i = 0; i < cache.size(); ++i)
+            cachePosition[cache[i]] = static_cast<int>(i);
+
+        bestTriangle = -1;
+        float bestScore = -1.f;
+
+        auto updateVertex = [&](uint32_t vertex)
+        {
+            float newScore = ForsythVertexScore(cachePosition[vertex], remainingValence[vertex]);
+            float delta = newScore - vertexScore[vertex];
+            vertexScore[vertex] = newScore;
+
+            uint32_t begin = adjacencyOffsets[vertex];
+            uint32_t end = begin + remainingValence[vertex];
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                uint32_t adjacentTriangle = adjacency[i];
+                triangleScore[adjacentTriangle] += delta;
+            }
+        };
+
+        for (uint32_t vertex : cache)
+            updateVertex(vertex);
+
+        // Vertices which were evicted also need their triangles rescored.
+        for (uint32_t vertex : newCache)
+        {
+            if (cachePosition[vertex] < 0)
+                updateVertex(vertex);
+        }
+
+        for (uint32_t vertex : cache)
+        {
+            uint32_t begin = adjacencyOffsets[vertex];
+            uint32_t end = begin + remainingValence[vertex];
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                uint32_t adjacentTriangle = adjacency[i];
+                if (triangleScore[adjacentTriangle] > bestScore)
+                {
+                    bestScore = triangleScore[adjacentTriangle];
+                    bestTriangle = adjacentTriangle;
+                }
+            }
+        }
+    }
+
+    indices.swap(result);
+}
+
+void MeshOptimizer::BuildClusters(const IndexCollection& indices, size_t vertexCount, float threshold, std::vector<uint32_t>& clusterStarts)
+{
+    const size_t triangleCount = indices.size() / 3;
+
+    clusterStarts.clear();
+    clusterStarts.push_back(0);
+
+    // Hard boundaries: the places where the simulated cache was completely missed.
+    std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+    uint32_t timestamp = ANALYZE_CACHE_SIZE + 1;
+
+    std::vector<uint32_t> hardBoundaries;
+    uint32_t totalMisses = 0;
+
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        uint32_t misses = 0;
+        for (size_t k = 0; k < 3; ++k)
+        {
+            uint32_t index = indices[triangle * 3 + k];
+            if (timestamp - cacheTimestamps[index] > ANALYZE_CACHE_SIZE)
+            {
+                cacheTimestamps[index] = timestamp++;
+                misses++;
+            }
+        }
+
+        if (misses == 3 && triangle > 0)
+            hardBoundaries.push_back(static_cast<uint32_t>(triangle));
+
+        totalMisses += misses;
+    }
+
+    const float meshACMR = static_cast<float>(totalMisses) / triangleCount;
+    hardBoundaries.push_back(static_cast<uint32_t>(triangleCount));
+
+    // Soft boundaries: split a hard cluster where its ACMR, simulated from a cold cache, is within
+    // the threshold of the mesh ACMR. So reordering the clusters can't make the mesh ACMR much worse.
+    std::fill(cacheTimestamps.begin(), cacheTimestamps.end(), 0);
+    timestamp = ANALYZE_CACHE_SIZE + 1;
+
+    uint32_t clusterStart = 0;
+    for (uint32_t hardEnd : hardBoundaries)
+    {
+        uint32_t misses = 0;
+        for (uint32_t triangle = clusterStart; triangle < hardEnd; ++triangle)
+        {
+            for (size_t k = 0; k < 3; ++k)
+            {
+                uint32_t index = indices[triangle * 3 + k];
+                if (timestamp - cacheTimestamps[index] > ANALYZE_CACHE_SIZE)
+                {
+                    cacheTimestamps[index] = timestamp++;
+                    misses++;
+                }
+            }
+
+            uint32_t clusterTriangles = triangle - clusterStart + 1;
+            float clusterACMR = static_cast<float>(misses) / clusterTriangles;
+
+            if (triangle + 1 < hardEnd && clusterACMR <= meshACMR * threshold)
+            {
+                clusterStarts.push_back(triangle + 1);
+                clusterStart = triangle + 1;
+                misses = 0;
+
+                // Start the next cluster with a cold cache.
+                timestamp += ANALYZE_CACHE_SIZE + 1;
+            }
+        }
+
+        if (hardEnd < triangleCount)
+            clusterStarts.push_back(hardEnd);
+
+        clusterStart = hardEnd;
+        timestamp += ANALYZE_CACHE_SIZE + 1;
+    }
+}
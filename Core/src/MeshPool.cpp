@@ -0,0 +1,137 @@
+#include <MeshPool.h>
+
+#include <DX12LibPCH.h>
+
+#include <Application.h>
+#include <CommandList.h>
+
+using namespace dx12demo::core;
+
+MeshPool::MeshPool(size_t vertexPageSize/* = DEFAULT_VERTEX_PAGE_SIZE*/, size_t indexPageSize/* = DEFAULT_INDEX_PAGE_SIZE*/)
+    : m_VertexPageSize(vertexPageSize)
+    , m_IndexPageSize(indexPageSize)
+{}
+
+MeshPool::~MeshPool()
+{}
+
+uint32_t MeshPool::CreatePage(CommandList& commandList, size_t vertexStride, size_t vertexCount, size_t indexCount)
+{
+    auto page = std::make_unique<Page>();
+    page->VertexStride = vertexStride;
+
+    // Oversized meshes get a page of their own size.
+    size_t pageVertexCount = std::max(m_VertexPageSize / vertexStride, vertexCount);
+    size_t pageIndexCount = std::max(m_IndexPageSize / sizeof(uint16_t), indexCount);
+
+    page->VertexRanges.Reset(pageVertexCount);
+    page->IndexRanges.Reset(pageIndexCount);
+
+    uint32_t pageIndex = static_cast<uint32_t>(m_Pages.size());
+
+    page->Vertices.SetName(L"MeshPool vertices " + std::to_wstring(pageIndex));
+    page->Indices.SetName(L"MeshPool indices " + std::to_wstring(pageIndex));
+
+    // Only the resources are created here, the contents are copied per allocation.
+    commandList.CopyVertexBuffer(page->Vertices, pageVertexCount, vertexStride, nullptr);
+    commandList.CopyIndexBuffer(page->Indices, pageIndexCount, DXGI_FORMAT_R16_UINT, nullptr);
+
+    m_Pages.push_back(std::move(page));
+
+    return pageIndex;
+}
+
+MeshPoolAllocation MeshPool::Allocate(CommandList& commandList, size_t vertexCount, size_t vertexStride, const void* vertexData,
+    size_t indexCount, const uint16_t* indexData)
+{
+    assert(vertexCount > 0 && vertexStride > 0);
+
+    std::lock_guard<std::mutex> lock(m_AllocationMutex);
+
+    MeshPoolAllocation allocation;
+
+    for (uint32_t pageIndex = 0; pageIndex <= m_Pages.size(); ++pageIndex)
+    {
+        if (pageIndex == m_Pages.size())
+            CreatePage(commandList, vertexStride, vertexCount, indexCount);
+
+        auto& page = *m_Pages[pageIndex];
+        if (page.VertexStride != vertexStride)
+            continue;
+
+        if (!page.VertexRanges.HasSpace(vertexCount) || (indexCount > 0 && !page.IndexRanges.HasSpace(indexCount)))
+            continue;
+
+        size_t vertexOffset = page.VertexRanges.Allocate(vertexCount);
+        size_t indexOffset = indexCount > 0 ? page.IndexRanges.Allocate(indexCount) : 0;
+
+        allocation.PageIndex = pageIndex;
+        allocation.BaseVertexLocation = static_cast<UINT>(vertexOffset);
+        allocation.VertexCount = static_cast<UINT>(vertexCount);
+        allocation.StartIndexLocation = static_cast<UINT>(indexOffset);
+        allocation.IndexCount = static_cast<UINT>(indexCount);
+        break;
+    }
+
+    assert(allocation.IsValid());
+
+    auto& page = *m_Pages[allocation.PageIndex];
+
+    if (vertexData)
+        commandList.CopyBufferRegion(page.Vertices, allocation.BaseVertexLocation * vertexStride, vertexCount * vertexStride, vertexData);
+
+    if (indexCount > 0 && indexData)
+        commandList.CopyBufferRegion(page.Indices, allocation.StartIndexLocation * sizeof(uint16_t), indexCount * sizeof(uint16_t), indexData);
+
+    return allocation;
+}
+
+void MeshPool::Free(const MeshPoolAllocation& allocation, uint64_t frameNumber)
+{
+    if (!allocation.IsValid())
+        return;
+
+    std::lock_guard<std::mutex> lock(m_AllocationMutex);
+
+    // Don't add the ranges directly to the free list until the frame has completed.
+    m_StaleAllocations.push({ allocation, frameNumber });
+}
+
+void MeshPool::Free(const MeshPoolAllocation& allocation)
+{
+    Free(allocation, GetApp().GetFrameCount());
+}
+
+void MeshPool::ReleaseStaleAllocations(uint64_t frameNumber)
+{
+    std::lock_guard<std::mutex> lock(m_AllocationMutex);
+
+    while (!m_StaleAllocations.empty() && m_StaleAllocations.front().FrameNumber <= frameNumber)
+    {
+        const auto& allocation = m_StaleAllocations.front().Allocation;
+        auto& page = *m_Pages[allocation.PageIndex];
+
+        page.VertexRanges.Free(allocation.BaseVertexLocation, allocation.VertexCount);
+        page.IndexRanges.Free(allocation.StartIndexLocation, allocation.IndexCount);
+
+        m_StaleAllocations.pop();
+    }
+}
+
+const VertexBuffer& MeshPool::GetVertexBuffer(uint32_t pageIndex) const
+{
+    std::lock_guard<std::mutex> lock(m_AllocationMutex);
+    return m_Pages[pageIndex]->Vertices;
+}
+
+const IndexBuffer& MeshPool::GetIndexBuffer(uint32_t pageIndex) const
+{
+    std::lock_guard<std::mutex> lock(m_AllocationMutex);
+    return m_Pages[pageIndex]->Indices;
+}
+
+uint32_t MeshPool::GetPageCount() const
+{
+    std::lock_guard<std::mutex> lock(m_AllocationMutex);
+    return static_cast<uint32_t>(m_Pages.size());
+}
@@ -0,0 +1,415 @@
+#include <MeshSimplifier.h>
+
+#include <DX12LibPCH.h>
+
+#include <cfloat>
+#include <cstring>
+
+using namespace dx12demo::core;
+
+namespace
+{
+    // Extra weight of the planes which keep the open borders in place.
+    const double BORDER_WEIGHT = 10.0;
+    // Penalty of the collapses which bend the shading normals, only changes the collapse order.
+    const float NORMAL_WEIGHT = 1.0f;
+
+    struct Quadric
+    {
+        double a00 = 0, a11 = 0, a22 = 0;
+        double a01 = 0, a02 = 0, a12 = 0;
+        double b0 = 0, b1 = 0, b2 = 0;
+        double c = 0;
+        double w = 0;
+
+        // Plane n * p + d = 0, n is normalized.
+        void AddPlane(const DirectX::XMFLOAT3& n, float d, double weight)
+        {
+            a00 += weight * n.x * n.x;
+            a11 += weight * n.y * n.y;
+            a22 += weight * n.z * n.z;
+            a01 += weight * n.x * n.y;
+            a02 += weight * n.x * n.z;
+            a12 += weight * n.y * n.z;
+            b0 += weight * n.x * d;
+            b1 += weight * n.y * d;
+            b2 += weight * n.z * d;
+            c += weight * d * d;
+            w += weight;
+        }
+
+        void Add(const Quadric& q)
+        {
+            a00 += q.a00; a11 += q.a11; a22 += q.a22;
+            a01 += q.a01; a02 += q.a02; a12 += q.a12;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2;
+            c += q.c;
+            w += q.w;
+        }
+
+        // Weighted sum of the squared distances from p to the planes.
+        double Evaluate(const DirectX::XMFLOAT3& p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            double result = a00 * x * x + a11 * y * y + a22 * z * z
+                + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                + 2.0 * (b0 * x + b1 * y + b2 * z)
+                + c;
+
+            return result > 0.0 ? result : 0.0;
+        }
+    };
+
+    struct PositionHasher
+    {
+        size_t operator()(const DirectX::XMFLOAT3& p) const
+        {
+            // + 0.f turns -0.f into 0.f, they are equal positions.
+            const float coords[3] = { p.x + 0.f, p.y + 0.f, p.z + 0.f };
+            uint32_t bits[3];
+            memcpy(bits, coords, sizeof(bits));
+            return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+        }
+    };
+
+    struct PositionEqual
+    {
+        bool operator()(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b) const
+        {
+            return a.x == b.x && a.y == b.y && a.z == b.z;
+        }
+    };
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        // Squared geometric error.
+        float error;
+        float cost;
+    };
+
+    uint64_t EdgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+    }
+}
+
+float MeshSimplifier::GetMaxLodError(const std::vector<DirectX::XMFLOAT3>& positions)
+{
+    CollectorBVData collectorBVData;
+    for (const auto& position : positions)
+        collectorBVData.Collect(position);
+
+    return positions.empty() ? 0.f : Math::float3Radius(collectorBVData.GetMax(), collectorBVData.GetMin()) * MAX_LOD_RELATIVE_ERROR;
+}
+
+float MeshSimplifier::Simplify(const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<DirectX::XMFLOAT3>& normals,
+    const IndexCollection& indices, size_t targetIndexCount, float targetError, IndexCollection& result)
+{
+    const size_t vertexCount = positions.size();
+    assert(normals.size() == vertexCount);
+    assert(indices.size() % 3 == 0);
+
+    std::vector<uint32_t> triangles(indices.begin(), indices.end());
+
+    // Seam vertices share the position with the other vertices and can't be removed without cracks.
+    std::vector<bool> locked(vertexCount, false);
+    {
+        std::unordered_map<DirectX::XMFLOAT3, uint32_t, PositionHasher, PositionEqual> firstVertex;
+        firstVertex.reserve(vertexCount);
+
+        std::vector<bool> used(vertexCount, false);
+        for (uint32_t index : triangles)
+            used[index] = true;
+
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            if (!used[v])
+                continue;
+
+            auto inserted = firstVertex.emplace(positions[v], v);
+            if (!inserted.second)
+            {
+                locked[v] = true;
+                locked[inserted.first->second] = true;
+            }
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    std::vector<bool> border(vertexCount);
+
+    std::vector<uint64_t> edges;
+    std::vector<uint64_t> borderEdges;
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+
+    auto triangleNormal = [](const DirectX::XMFLOAT3& p0, const DirectX::XMFLOAT3& p1, const DirectX::XMFLOAT3& p2)
+    {
+        return Math::float3Cross(Math::float3Substruct(p1, p0), Math::float3Substruct(p2, p0));
+    };
+
+    auto isBorderEdge = [&borderEdges](uint32_t a, uint32_t b)
+    {
+        return std::binary_search(borderEdges.begin(), borderEdges.end(), EdgeKey(a, b));
+    };
+
+    // Quadrics are built once from the source triangles and then accumulated by the collapses.
+    for (size_t t = 0; t < triangles.size(); t += 3)
+    {
+        const auto& p0 = positions[triangles[t + 0]];
+        const auto& p1 = positions[triangles[t + 1]];
+        const auto& p2 = positions[triangles[t + 2]];
+
+        DirectX::XMFLOAT3 normal = triangleNormal(p0, p1, p2);
+        float length = Math::float3Len(normal);
+        if (length <= 0.f)
+            continue;
+
+        Math::float3Div(normal, length);
+        float d = -Math::float3Dot(normal, p0);
+        double area = 0.5 * length;
+
+        for (size_t k = 0; k < 3; ++k)
+            quadrics[triangles[t + k]].AddPlane(normal, d, area);
+    }
+
+    float maxError = 0.f;
+    bool borderPlanesAdded = false;
+    const float targetErrorSq = targetError * targetError;
+
+    while (triangles.size() > targetIndexCount)
+    {
+        const size_t triangleCount = triangles.size() / 3;
+
+        // Edges used by one triangle only are the borders.
+        edges.clear();
+        for (size_t t = 0; t < triangles.size(); t += 3)
+        {
+            edges.push_back(EdgeKey(triangles[t + 0], triangles[t + 1]));
+            edges.push_back(EdgeKey(triangles[t + 1], triangles[t + 2]));
+            edges.push_back(EdgeKey(triangles[t + 2], triangles[t + 0]));
+        }
+        std::sort(edges.begin(), edges.end());
+
+        borderEdges.clear();
+        std::fill(border.begin(), border.end(), false);
+        for (size_t i = 0; i < edges.size();)
+        {
+            size_t j = i + 1;
+            while (j < edges.size() && edges[j] == edges[i])
+                ++j;
+
+            if (j - i == 1)
+            {
+                borderEdges.push_back(edges[i]);
+                border[static_cast<uint32_t>(edges[i] >> 32)] = true;
+                border[static_cast<uint32_t>(edges[i])] = true;
+            }
+
+            i = j;
+        }
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        // The border planes are added on the first pass only, the later borders are the same edges after collapses.
+        if (!borderPlanesAdded)
+        {
+            borderPlanesAdded = true;
+
+            for (size_t t = 0; t < triangles.size(); t += 3)
+            {
+                const auto& p0 = positions[triangles[t + 0]];
+                const auto& p1 = positions[triangles[t + 1]];
+                const auto& p2 = positions[triangles[t + 2]];
+
+                DirectX::XMFLOAT3 normal = triangleNormal(p0, p1, p2);
+                if (Math::float3Len(normal) <= 0.f)
+                    continue;
+
+                for (size_t k = 0; k < 3; ++k)
+                {
+                    uint32_t a = triangles[t + k];
+                    uint32_t b = triangles[t + (k + 1) % 3];
+                    if (!isBorderEdge(a, b))
+                        continue;
+
+                    DirectX::XMFLOAT3 edge = Math::float3Substruct(positions[b], positions[a]);
+                    float edgeLength = Math::float3Len(edge);
+                    if (edgeLength <= 0.f)
+                        continue;
+
+                    // The plane through the edge, perpendicular to the triangle.
+                    DirectX::XMFLOAT3 planeNormal = Math::float3Cross(edge, normal);
+                    Math::float3Normalized(planeNormal);
+                    float d = -Math::float3Dot(planeNormal, positions[a]);
+                    double weight = BORDER_WEIGHT * edgeLength * edgeLength;
+
+                    quadrics[a].AddPlane(planeNormal, d, weight);
+                    quadrics[b].AddPlane(planeNormal, d, weight);
+                }
+            }
+        }
+
+        // Vertex -> triangles adjacency of this pass.
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (uint32_t index : triangles)
+            adjacencyOffsets[index + 1]++;
+        for (size_t v = 0; v < vertexCount; ++v)
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+        adjacency.resize(triangles.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < triangles.size(); ++i)
+                adjacency[fill[triangles[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        // The cheapest direction of every edge.
+        collapses.clear();
+        for (uint64_t edge : edges)
+        {
+            uint32_t a = static_cast<uint32_t>(edge >> 32);
+            uint32_t b = static_cast<uint32_t>(edge);
+
+            Collapse best = { 0, 0, FLT_MAX, FLT_MAX };
+            const uint32_t directions[2][2] = { { a, b }, { b, a } };
+            for (const auto& direction : directions)
+            {
+                uint32_t from = direction[0];
+                uint32_t to = direction[1];
+
+                if (locked[from])
+                    continue;
+
+                if (border[from] && !isBorderEdge(from, to))
+                    continue;
+
+                Quadric q = quadrics[from];
+                q.Add(quadrics[to]);
+
+                float error = q.w > 0.0 ? static_cast<float>(q.Evaluate(positions[to]) / q.w) : 0.f;
+
+                float normalDot = Math::float3Dot(normals[from], normals[to]);
+                float edgeLengthSq = Math::float3Radius(positions[from], positions[to]);
+                edgeLengthSq *= edgeLengthSq;
+                float cost = error + NORMAL_WEIGHT * std::max(0.f, 1.f - normalDot) * edgeLengthSq;
+
+                if (cost < best.cost)
+                    best = { from, to, error, cost };
+            }
+
+            if (best.cost < FLT_MAX)
+                collapses.push_back(best);
+        }
+
+        if (collapses.empty())
+            break;
+
+        std::sort(collapses.begin(), collapses.end(),
+            [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        for (uint32_t v = 0; v < vertexCount; ++v)
+            remap[v] = v;
+        std::fill(touched.begin(), touched.end(), false);
+
+        const size_t targetTriangles = targetIndexCount / 3;
+        size_t removedTriangles = 0;
+        size_t appliedCollapses = 0;
+        bool errorLimitReached = false;
+
+        for (const auto& collapse : collapses)
+        {
+            if (triangleCount - removedTriangles <= targetTriangles)
+                break;
+
+            if (collapse.error > targetErrorSq)
+            {
+                errorLimitReached = true;
+                break;
+            }
+
+            // Only one collapse per vertex in a pass, the adjacency must stay valid.
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            // Reject the collapses which flip the neighbour triangles.
+            const auto& target = positions[collapse.to];
+            bool flips = false;
+            size_t degenerate = 0;
+
+            for (uint32_t i = adjacencyOffsets[collapse.from]; i < adjacencyOffsets[collapse.from + 1] && !flips; ++i)
+            {
+                uint32_t t = adjacency[i] * 3;
+                uint32_t v0 = remap[triangles[t + 0]];
+                uint32_t v1 = remap[triangles[t + 1]];
+                uint32_t v2 = remap[triangles[t + 2]];
+
+                if (v0 == v1 || v1 == v2 || v2 == v0)
+                    continue;
+
+                if (v0 == collapse.to || v1 == collapse.to || v2 == collapse.to)
+                {
+                    degenerate++;
+                    continue;
+                }
+
+                DirectX::XMFLOAT3 p0 = positions[v0];
+                DirectX::XMFLOAT3 p1 = positions[v1];
+                DirectX::XMFLOAT3 p2 = positions[v2];
+                DirectX::XMFLOAT3 before = triangleNormal(p0, p1, p2);
+
+                if (v0 == collapse.from) p0 = target;
+                if (v1 == collapse.from) p1 = target;
+                if (v2 == collapse.from) p2 = target;
+                DirectX::XMFLOAT3 after = triangleNormal(p0, p1, p2);
+
+                flips = Math::float3Dot(before, after) <= 0.f;
+            }
+
+            if (flips)
+                continue;
+
+            quadrics[collapse.to].Add(quadrics[collapse.from]);
+            remap[collapse.from] = collapse.to;
+            touched[collapse.from] = true;
+            touched[collapse.to] = true;
+
+            removedTriangles += degenerate;
+            appliedCollapses++;
+            maxError = std::max(maxError, collapse.error);
+        }
+
+        if (appliedCollapses == 0)
+            break;
+
+        // Apply the collapses and drop the degenerate triangles.
+        size_t writeIndex = 0;
+        for (size_t t = 0; t < triangles.size(); t += 3)
+        {
+            uint32_t v0 = remap[triangles[t + 0]];
+            uint32_t v1 = remap[triangles[t + 1]];
+            uint32_t v2 = remap[triangles[t + 2]];
+
+            if (v0 == v1 || v1 == v2 || v2 == v0)
+                continue;
+
+            triangles[writeIndex++] = v0;
+            triangles[writeIndex++] = v1;
+            triangles[writeIndex++] = v2;
+        }
+        triangles.resize(writeIndex);
+
+        if (errorLimitReached)
+            break;
+    }
+
+    result.resize(triangles.size());
+    for (size_t i = 0; i < triangles.size(); ++i)
+        result[i] = static_cast<IndexCollection::value_type>(triangles[i]);
+
+    return sqrtf(maxError);
+}
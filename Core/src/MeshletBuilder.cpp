@@ -0,0 +1,133 @@
+#include <MeshletBuilder.h>
+
+#include <DX12LibPCH.h>
+#include <Frustum.h>
+
+using namespace dx12demo::core;
+
+void MeshletBuilder::ComputeBounds(const std::vector<DirectX::XMFLOAT3>& trianglePositions, Meshlet& meshlet)
+{
+    CollectorBVData collectorBVData;
+    for (const auto& position : trianglePositions)
+        collectorBVData.Collect(position);
+
+    // Bounding sphere around the AABB center.
+    DirectX::XMFLOAT3 center = collectorBVData.GetCenter();
+    float radius = 0.f;
+    for (const auto& position : trianglePositions)
+        radius = std::max(radius, Math::float3Radius(position, center));
+
+    meshlet.bsphere.pos = center;
+    meshlet.bsphere.r = radius;
+
+    // Normal cone axis is the average of the unit triangle normals.
+    const size_t triangleCount = trianglePositions.size() / 3;
+    std::vector<DirectX::XMFLOAT3> normals;
+    normals.reserve(triangleCount);
+
+    DirectX::XMFLOAT3 axis = { 0.f, 0.f, 0.f };
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        const auto& p0 = trianglePositions[triangle * 3 + 0];
+        const auto& p1 = trianglePositions[triangle * 3 + 1];
+        const auto& p2 = trianglePositions[triangle * 3 + 2];
+
+        // Front faces are clockwise (the default D3D12 rasterizer state), so this normal points to the viewer.
+        DirectX::XMFLOAT3 normal = Math::float3Cross(Math::float3Substruct(p1, p0), Math::float3Substruct(p2, p0));
+        float length = Math::float3Len(normal);
+
+        // Degenerate triangles don't affect the cone.
+        if (length <= 0.f)
+        {
+            normals.push_back({ 0.f, 0.f, 0.f });
+            continue;
+        }
+
+        Math::float3Div(normal, length);
+        normals.push_back(normal);
+        Math::float3Add(axis, normal);
+    }
+
+    meshlet.coneCutoff = 1.f;
+
+    float axisLength = Math::float3Len(axis);
+    if (axisLength <= 1e-6f)
+        return;
+
+    Math::float3Div(axis, axisLength);
+
+    float minDot = 1.f;
+    for (const auto& normal : normals)
+    {
+        if (normal.x == 0.f && normal.y == 0.f && normal.z == 0.f)
+            continue;
+
+        minDot = std::min(minDot, Math::float3Dot(axis, normal));
+    }
+
+    // The cone spans 90 degrees or more: backface culling is impossible.
+    if (minDot <= 0.f)
+        return;
+
+    // Move the apex back along the axis, so every triangle plane is in front of it.
+    float maxT = 0.f;
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        const auto& normal = normals[triangle];
+        float dn = Math::float3Dot(axis, normal);
+        if (dn <= 0.f)
+            continue;
+
+        float dc = Math::float3Dot(Math::float3Substruct(center, trianglePositions[triangle * 3]), normal);
+        maxT = std::max(maxT, dc / dn);
+    }
+
+    meshlet.coneAxis = axis;
+    meshlet.coneApex = { center.x - axis.x * maxT, center.y - axis.y * maxT, center.z - axis.z * maxT };
+    // sin of the cone half angle.
+    meshlet.coneCutoff = sqrtf(1.f - minDot * minDot);
+}
+
+bool MeshletBuilder::IsVisible(const Meshlet& meshlet, const std::array<DirectX::XMFLOAT4, 6>& frustumPlanes, const DirectX::XMFLOAT3* cameraPosition/* = nullptr*/)
+{
+    if (!Frustum::FrustumInSphere(meshlet.bsphere, frustumPlanes))
+        return false;
+
+    if (cameraPosition && meshlet.coneCutoff < 1.f)
+    {
+        DirectX::XMFLOAT3 view = Math::float3Substruct(meshlet.coneApex, *cameraPosition);
+        float viewLength = Math::float3Len(view);
+
+        if (viewLength > 0.f && Math::float3Dot(view, meshlet.coneAxis) >= meshlet.coneCutoff * viewLength)
+            return false;
+    }
+
+    return true;
+}
+
+void MeshletBuilder::Cull(const std::vector<Meshlet>& meshlets, const std::array<DirectX::XMFLOAT4, 6>& frustumPlanes, const DirectX::XMFLOAT3* cameraPosition, std::vector<SubMesh>& visibleRanges)
+{
+    visibleRanges.clear();
+
+    for (const auto& meshlet : meshlets)
+    {
+        if (!IsVisible(meshlet, frustumPlanes, cameraPosition))
+            continue;
+
+        if (!visibleRanges.empty())
+        {
+            auto& last = visibleRanges.back();
+            if (last.StartIndexLocation + last.IndexCount == meshlet.StartIndexLocation)
+            {
+                last.IndexCount += meshlet.IndexCount;
+                continue;
+            }
+        }
+
+        SubMesh range;
+        range.StartIndexLocation = meshlet.StartIndexLocation;
+        range.IndexCount = meshlet.IndexCount;
+        range.BaseVertexLocation = 0;
+        visibleRanges.push_back(range);
+    }
+}
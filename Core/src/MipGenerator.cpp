@@ -0,0 +1,390 @@
+#include <MipGenerator.h>
+
+#include <DX12LibPCH.h>
+
+#include <ThreadPool.h>
+
+#include <DirectXPackedVector.h>
+
+#include <array>
+
+using namespace dx12demo::core;
+using namespace DirectX;
+
+namespace
+{
+    // Destination rows per job.
+    const size_t BAND_HEIGHT = 16;
+
+    // Support of the windowed filters each side, in destination texels.
+    const float FILTER_RADIUS = 3.f;
+    const float KAISER_ALPHA = 4.f;
+
+    // Entries of the linear to sRGB table, enough to round every 8 bit value right.
+    const size_t LINEAR_TO_SRGB_SIZE = 16384;
+
+    // Per destination texel, the source texels and their weights: Indices/Weights [Offsets[i], Offsets[i + 1]).
+    struct FilterTaps
+    {
+        std::vector<uint32_t> Offsets;
+        std::vector<uint32_t> Indices;
+        std::vector<float> Weights;
+    };
+
+    float Sinc(float x)
+    {
+        if (fabsf(x) < 1e-5f)
+            return 1.f;
+
+        x *= XM_PI;
+        return sinf(x) / x;
+    }
+
+    // Modified Bessel function of the first kind, order 0.
+    float BesselI0(float x)
+    {
+        float sum = 1.f;
+        float term = 1.f;
+        const float halfX = x * 0.5f;
+        for (int k = 1; k < 32 && term > sum * 1e-8f; ++k)
+        {
+            term *= (halfX / k) * (halfX / k);
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    // x in destination texels from the texel center.
+    float EvaluateFilter(MipFilter filter, float x)
+    {
+        x = fabsf(x);
+        if (x >= FILTER_RADIUS)
+            return 0.f;
+
+        switch (filter)
+        {
+        case MipFilter::Kaiser:
+        {
+            float t = x / FILTER_RADIUS;
+            return Sinc(x) * BesselI0(KAISER_ALPHA * sqrtf(1.f - t * t)) / BesselI0(KAISER_ALPHA);
+        }
+        case MipFilter::Lanczos:
+            return Sinc(x) * Sinc(x / FILTER_RADIUS);
+        default:
+            assert(false);
+            return 0.f;
+        }
+    }
+
+    FilterTaps BuildTaps(size_t sourceSize, size_t destinationSize, MipFilter filter)
+    {
+        FilterTaps taps;
+        taps.Offsets.reserve(destinationSize + 1);
+        taps.Offsets.push_back(0);
+
+        auto addTap = [&taps](int64_t index, size_t size, float weight)
+        {
+            uint32_t clamped = static_cast<uint32_t>(std::clamp<int64_t>(index, 0, static_cast<int64_t>(size) - 1));
+
+            // The taps clamped to the same edge texel are merged.
+            if (taps.Indices.size() > taps.Offsets.back() && taps.Indices.back() == clamped)
+                taps.Weights.back() += weight;
+            else
+            {
+                taps.Indices.push_back(clamped);
+                taps.Weights.push_back(weight);
+            }
+        };
+
+        for (size_t x = 0; x < destinationSize; ++x)
+        {
+            if (filter == MipFilter::Box)
+            {
+                if (sourceSize == 1)
+                {
+                    addTap(0, sourceSize, 1.f);
+                }
+                else if (sourceSize % 2 == 0)
+                {
+                    addTap(2 * x, sourceSize, 0.5f);
+                    addTap(2 * x + 1, sourceSize, 0.5f);
+                }
+                else
+                {
+                    // Source 2n + 1 texels to n, every destination texel covers 2 + 1/n source texels.
+                    const float n = static_cast<float>(destinationSize);
+                    const float scale = 1.f / (2.f * n + 1.f);
+                    addTap(2 * x, sourceSize, (n - x) * scale);
+                    addTap(2 * x + 1, sourceSize, n * scale);
+                    addTap(2 * x + 2, sourceSize, (x + 1.f) * scale);
+                }
+            }
+            else
+            {
+                const float scale = static_cast<float>(sourceSize) / destinationSize;
+                const float center = (x + 0.5f) * scale;
+                const float radius = FILTER_RADIUS * scale;
+
+                const size_t firstTap = taps.Weights.size();
+                float weightSum = 0.f;
+                for (int64_t i = static_cast<int64_t>(floorf(center - radius)); i <= static_cast<int64_t>(ceilf(center + radius)); ++i)
+                {
+                    float weight = EvaluateFilter(filter, (i + 0.5f - center) / scale);
+                    if (weight == 0.f)
+                        continue;
+
+                    addTap(i, sourceSize, weight);
+                    weightSum += weight;
+                }
+
+                for (size_t i = firstTap; i < taps.Weights.size(); ++i)
+                    taps.Weights[i] /= weightSum;
+            }
+
+            taps.Offsets.push_back(static_cast<uint32_t>(taps.Indices.size()));
+        }
+
+        return taps;
+    }
+
+    const float* GetByteToFloatTable(bool isSRGB)
+    {
+        static const auto tables = []()
+        {
+            std::array<std::array<float, 256>, 2> result;
+            for (int i = 0; i < 256; ++i)
+            {
+                float value = i / 255.f;
+                result[0][i] = value;
+                result[1][i] = value < 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+            }
+            return result;
+        }();
+
+        return tables[isSRGB ? 1 : 0].data();
+    }
+
+    const uint8_t* GetLinearToSRGBTable()
+    {
+        static const auto table = []()
+        {
+            std::array<uint8_t, LINEAR_TO_SRGB_SIZE> result;
+            for (size_t i = 0; i < LINEAR_TO_SRGB_SIZE; ++i)
+            {
+                float value = static_cast<float>(i) / (LINEAR_TO_SRGB_SIZE - 1);
+                float srgb = value < 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.f / 2.4f) - 0.055f;
+                result[i] = static_cast<uint8_t>(srgb * 255.f + 0.5f);
+            }
+            return result;
+        }();
+
+        return table.data();
+    }
+
+    // Channel order of the 8 bit formats: the source byte of red, green, blue and alpha (4 = opaque).
+    const uint32_t* GetByteChannels(DXGI_FORMAT format)
+    {
+        static const uint32_t rgba[4] = { 0, 1, 2, 3 };
+        static const uint32_t bgra[4] = { 2, 1, 0, 3 };
+        static const uint32_t bgrx[4] = { 2, 1, 0, 4 };
+
+        switch (format)
+        {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            return rgba;
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            return bgra;
+        case DXGI_FORMAT_B8G8R8X8_UNORM:
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            return bgrx;
+        default:
+            return nullptr;
+        }
+    }
+
+    void LoadRow(const Image& image, size_t y, XMVECTOR* pixels)
+    {
+        const uint8_t* row = image.pixels + y * image.rowPitch;
+
+        if (image.format == DXGI_FORMAT_R32G32B32A32_FLOAT)
+        {
+            const XMFLOAT4* source = reinterpret_cast<const XMFLOAT4*>(row);
+            for (size_t x = 0; x < image.width; ++x)
+                pixels[x] = XMLoadFloat4(&source[x]);
+            return;
+        }
+
+        if (image.format == DXGI_FORMAT_R16G16B16A16_FLOAT)
+        {
+            const PackedVector::XMHALF4* source = reinterpret_cast<const PackedVector::XMHALF4*>(row);
+            for (size_t x = 0; x < image.width; ++x)
+                pixels[x] = PackedVector::XMLoadHalf4(&source[x]);
+            return;
+        }
+
+        const uint32_t* channels = GetByteChannels(image.format);
+        const float* colorTable = GetByteToFloatTable(IsSRGB(image.format));
+        const float* alphaTable = GetByteToFloatTable(false);
+        for (size_t x = 0; x < image.width; ++x)
+        {
+            const uint8_t* texel = row + x * 4;
+            pixels[x] = XMVectorSet(colorTable[texel[channels[0]]], colorTable[texel[channels[1]]], colorTable[texel[channels[2]]],
+                channels[3] < 4 ? alphaTable[texel[channels[3]]] : 1.f);
+        }
+    }
+
+    void StoreRow(const XMVECTOR* pixels, const Image& image, size_t y)
+    {
+        uint8_t* row = image.pixels + y * image.rowPitch;
+
+        if (image.format == DXGI_FORMAT_R32G32B32A32_FLOAT)
+        {
+            XMFLOAT4* destination = reinterpret_cast<XMFLOAT4*>(row);
+            for (size_t x = 0; x < image.width; ++x)
+                XMStoreFloat4(&destination[x], pixels[x]);
+            return;
+        }
+
+        if (image.format == DXGI_FORMAT_R16G16B16A16_FLOAT)
+        {
+            PackedVector::XMHALF4* destination = reinterpret_cast<PackedVector::XMHALF4*>(row);
+            for (size_t x = 0; x < image.width; ++x)
+                PackedVector::XMStoreHalf4(&destination[x], pixels[x]);
+            return;
+        }
+
+        const uint32_t* channels = GetByteChannels(image.format);
+        const bool isSRGB = IsSRGB(image.format);
+        const uint8_t* srgbTable = GetLinearToSRGBTable();
+        const XMVECTOR srgbScale = XMVectorReplicate(static_cast<float>(LINEAR_TO_SRGB_SIZE - 1));
+        const XMVECTOR unormScale = XMVectorReplicate(255.f);
+        const XMVECTOR half = XMVectorReplicate(0.5f);
+
+        for (size_t x = 0; x < image.width; ++x)
+        {
+            XMVECTOR pixel = XMVectorSaturate(pixels[x]);
+            XMFLOAT4 unorm, srgb;
+            XMStoreFloat4(&unorm, XMVectorMultiplyAdd(pixel, unormScale, half));
+            XMStoreFloat4(&srgb, XMVectorMultiplyAdd(pixel, srgbScale, half));
+
+            uint8_t* texel = row + x * 4;
+            if (isSRGB)
+            {
+                texel[channels[0]] = srgbTable[static_cast<size_t>(srgb.x)];
+                texel[channels[1]] = srgbTable[static_cast<size_t>(srgb.y)];
+                texel[channels[2]] = srgbTable[static_cast<size_t>(srgb.z)];
+            }
+            else
+            {
+                texel[channels[0]] = static_cast<uint8_t>(unorm.x);
+                texel[channels[1]] = static_cast<uint8_t>(unorm.y);
+                texel[channels[2]] = static_cast<uint8_t>(unorm.z);
+            }
+            texel[3] = channels[3] < 4 ? static_cast<uint8_t>(unorm.w) : 255;
+        }
+    }
+}
+
+bool MipGenerator::IsSupportedFormat(DXGI_FORMAT format)
+{
+    return GetByteChannels(format) || format == DXGI_FORMAT_R16G16B16A16_FLOAT || format == DXGI_FORMAT_R32G32B32A32_FLOAT;
+}
+
+bool MipGenerator::CanGenerate(const DirectX::TexMetadata& metadata)
+{
+    return metadata.dimension == TEX_DIMENSION_TEXTURE2D && metadata.arraySize == 1 && metadata.depth == 1 &&
+        metadata.mipLevels == 1 && !metadata.IsCubemap() && IsSupportedFormat(metadata.format);
+}
+
+void MipGenerator::Generate(const DirectX::ScratchImage& source, MipFilter filter, DirectX::ScratchImage& mipChain)
+{
+    const TexMetadata& metadata = source.GetMetadata();
+    if (!CanGenerate(metadata))
+    {
+        ThrowIfFailed(GenerateMipMaps(source.GetImages(), source.GetImageCount(), metadata, TEX_FILTER_DEFAULT, 0, mipChain));
+        return;
+    }
+
+    // The full chain, as a texture created with 0 mip levels.
+    size_t levels = 1;
+    for (size_t width = metadata.width, height = metadata.height; width > 1 || height > 1; ++levels)
+    {
+        width = std::max<size_t>(width / 2, 1);
+        height = std::max<size_t>(height / 2, 1);
+    }
+
+    ThrowIfFailed(mipChain.Initialize2D(metadata.format, metadata.width, metadata.height, 1, levels));
+
+    const Image& sourceImage = *source.GetImage(0, 0, 0);
+    const Image& topLevel = *mipChain.GetImage(0, 0, 0);
+    const size_t rowSize = std::min(sourceImage.rowPitch, topLevel.rowPitch);
+    for (size_t y = 0; y < sourceImage.height; ++y)
+        memcpy(topLevel.pixels + y * topLevel.rowPitch, sourceImage.pixels + y * sourceImage.rowPitch, rowSize);
+
+    for (size_t level = 1; level < levels; ++level)
+        Downsample(*mipChain.GetImage(level - 1, 0, 0), *mipChain.GetImage(level, 0, 0), filter);
+}
+
+void MipGenerator::Downsample(const DirectX::Image& source, const DirectX::Image& destination, MipFilter filter)
+{
+    assert(IsSupportedFormat(source.format) && source.format == destination.format);
+    assert(destination.width == std::max<size_t>(source.width / 2, 1) && destination.height == std::max<size_t>(source.height / 2, 1));
+
+    const FilterTaps columnTaps = BuildTaps(source.width, destination.width, filter);
+    const FilterTaps rowTaps = BuildTaps(source.height, destination.height, filter);
+
+    const size_t bandCount = (destination.height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+    ThreadPool::Get().ParallelFor(bandCount, [&](size_t band)
+    {
+        const size_t firstRow = band * BAND_HEIGHT;
+        const size_t endRow = std::min(firstRow + BAND_HEIGHT, destination.height);
+
+        // The source rows the band reads, filtered horizontally once.
+        uint32_t firstSourceRow = UINT32_MAX;
+        uint32_t lastSourceRow = 0;
+        for (size_t y = firstRow; y < endRow; ++y)
+        {
+            for (uint32_t tap = rowTaps.Offsets[y]; tap < rowTaps.Offsets[y + 1]; ++tap)
+            {
+                firstSourceRow = std::min(firstSourceRow, rowTaps.Indices[tap]);
+                lastSourceRow = std::max(lastSourceRow, rowTaps.Indices[tap]);
+            }
+        }
+
+        const size_t width = destination.width;
+        std::vector<XMVECTOR> sourceRow(source.width);
+        std::vector<XMVECTOR> filteredRows((lastSourceRow - firstSourceRow + 1) * width);
+
+        for (uint32_t sourceY = firstSourceRow; sourceY <= lastSourceRow; ++sourceY)
+        {
+            LoadRow(source, sourceY, sourceRow.data());
+
+            XMVECTOR* filtered = &filteredRows[(sourceY - firstSourceRow) * width];
+            for (size_t x = 0; x < width; ++x)
+            {
+                XMVECTOR sum = XMVectorZero();
+                for (uint32_t tap = columnTaps.Offsets[x]; tap < columnTaps.Offsets[x + 1]; ++tap)
+                    sum = XMVectorMultiplyAdd(sourceRow[columnTaps.Indices[tap]], XMVectorReplicate(columnTaps.Weights[tap]), sum);
+                filtered[x] = sum;
+            }
+        }
+
+        std::vector<XMVECTOR> destinationRow(width);
+        for (size_t y = firstRow; y < endRow; ++y)
+        {
+            std::fill(destinationRow.begin(), destinationRow.end(), XMVectorZero());
+            for (uint32_t tap = rowTaps.Offsets[y]; tap < rowTaps.Offsets[y + 1]; ++tap)
+            {
+                const XMVECTOR weight = XMVectorReplicate(rowTaps.Weights[tap]);
+                const XMVECTOR* filtered = &filteredRows[(rowTaps.Indices[tap] - firstSourceRow) * width];
+                for (size_t x = 0; x < width; ++x)
+                    destinationRow[x] = XMVectorMultiplyAdd(filtered[x], weight, destinationRow[x]);
+            }
+
+            StoreRow(destinationRow.data(), destination, y);
+        }
+    });
+}
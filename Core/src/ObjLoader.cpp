@@ -0,0 +1,695 @@
+#include <ObjLoader.h>
+
+#include <DX12LibPCH.h>
+
+#include <MappedFile.h>
+#include <ThreadPool.h>
+
+#include <assimp/material.h>
+
+#include <fstream>
+
+using namespace dx12demo::core;
+
+namespace
+{
+    // The file is split in chunks of about this size, but no more than a few per thread.
+    const size_t MIN_CHUNK_SIZE = 256 * 1024;
+    const size_t CHUNKS_PER_THREAD = 4;
+
+    const int32_t NO_INDEX = INT32_MIN;
+
+    // Position, texture coordinate and normal of a face corner, 0 based.
+    // Negative OBJ indices are relative to the elements read so far, within a chunk they are resolved to the chunk start
+    // and RelativeMask marks them until the element counts of the previous chunks are known.
+    struct ObjCorner
+    {
+        int32_t Index[3] = { NO_INDEX, NO_INDEX, NO_INDEX };
+        uint8_t RelativeMask = 0;
+    };
+
+    struct ObjStatement
+    {
+        enum Type
+        {
+            UseMaterial,
+            Group,
+        };
+
+        Type StatementType;
+        // The statement applies to the faces from this one.
+        uint32_t FaceIndex;
+        std::string Name;
+    };
+
+    struct ObjChunk
+    {
+        std::vector<DirectX::XMFLOAT3> Positions;
+        std::vector<DirectX::XMFLOAT2> TexCoords;
+        std::vector<DirectX::XMFLOAT3> Normals;
+
+        std::vector<ObjCorner> Corners;
+        // Corners of face i are [FaceStarts[i], FaceStarts[i + 1]).
+        std::vector<uint32_t> FaceStarts;
+
+        std::vector<ObjStatement> Statements;
+        std::vector<std::string> MaterialLibraries;
+    };
+
+    struct ObjFaceRef
+    {
+        uint32_t Chunk;
+        uint32_t Face;
+    };
+
+    struct ObjMeshFaces
+    {
+        std::string Group;
+        std::string Material;
+        std::vector<ObjFaceRef> Faces;
+    };
+
+    struct CornerKey
+    {
+        int32_t Position, TexCoord, Normal;
+
+        bool operator==(const CornerKey& other) const
+        {
+            return Position == other.Position && TexCoord == other.TexCoord && Normal == other.Normal;
+        }
+    };
+
+    struct CornerKeyHash
+    {
+        size_t operator()(const CornerKey& key) const
+        {
+            uint64_t hash = static_cast<uint32_t>(key.Position) * 0x9E3779B97F4A7C15ull;
+            hash ^= static_cast<uint32_t>(key.TexCoord) * 0xC2B2AE3D27D4EB4Full + (hash << 6) + (hash >> 2);
+            hash ^= static_cast<uint32_t>(key.Normal) * 0x165667B19E3779F9ull + (hash << 6) + (hash >> 2);
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    using MaterialTextures = std::unordered_map<std::string, std::vector<SceneMeshTexture>>;
+
+    inline bool IsSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    inline bool IsDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    const char* SkipSpaces(const char* p, const char* end)
+    {
+        while (p < end && IsSpace(*p))
+            ++p;
+        return p;
+    }
+
+    const char* SkipLine(const char* p, const char* end)
+    {
+        while (p < end && *p != '\n')
+            ++p;
+        return p < end ? p + 1 : end;
+    }
+
+    double Pow10(int exponent)
+    {
+        static const double table[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+        return exponent <= 22 ? table[exponent] : pow(10.0, exponent);
+    }
+
+    // Decimal float without the locale and the allocations of strtof, exact for the up to 18 significant digits of the exporters.
+    float ParseFloat(const char*& p, const char* end)
+    {
+        p = SkipSpaces(p, end);
+
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+
+        for (; p < end && IsDigit(*p); ++p)
+        {
+            if (digits < 18)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa > 0 ? 1 : 0;
+            }
+            else
+            {
+                ++exponent;
+            }
+        }
+
+        if (p < end && *p == '.')
+        {
+            for (++p; p < end && IsDigit(*p); ++p)
+            {
+                if (digits < 18)
+                {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    digits += mantissa > 0 ? 1 : 0;
+                    --exponent;
+                }
+            }
+        }
+
+        if (p < end && (*p == 'e' || *p == 'E'))
+        {
+            ++p;
+            bool negativeExponent = false;
+            if (p < end && (*p == '-' || *p == '+'))
+                negativeExponent = *p++ == '-';
+
+            int value = 0;
+            for (; p < end && IsDigit(*p); ++p)
+                value = std::min(value * 10 + (*p - '0'), 1000);
+
+            exponent += negativeExponent ? -value : value;
+        }
+
+        double result = static_cast<double>(mantissa);
+        result = exponent < 0 ? result / Pow10(-exponent) : result * Pow10(exponent);
+
+        return static_cast<float>(negative ? -result : result);
+    }
+
+    bool ParseInt(const char*& p, const char* end, int32_t& value)
+    {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+
+        if (p >= end || !IsDigit(*p))
+            return false;
+
+        int64_t result = 0;
+        for (; p < end && IsDigit(*p); ++p)
+            result = std::min<int64_t>(result * 10 + (*p - '0'), INT32_MAX);
+
+        value = static_cast<int32_t>(negative ? -result : result);
+        return true;
+    }
+
+    // The rest of the line without the surrounding spaces.
+    std::string ParseName(const char* p, const char* end)
+    {
+        p = SkipSpaces(p, end);
+        const char* last = p;
+        while (last < end && *last != '\n')
+            ++last;
+        while (last > p && IsSpace(*(last - 1)))
+            --last;
+
+        return std::string(p, last);
+    }
+
+    // OBJ index -> 0 based, a negative one is counted back from elementCount (the elements of this chunk read so far).
+    void ResolveIndex(int32_t value, size_t elementCount, size_t element, ObjCorner& corner)
+    {
+        if (value > 0)
+        {
+            corner.Index[element] = value - 1;
+        }
+        else if (value < 0)
+        {
+            corner.Index[element] = static_cast<int32_t>(elementCount) + value;
+            corner.RelativeMask |= 1 << element;
+        }
+    }
+
+    void ParseFace(const char* p, const char* end, ObjChunk& chunk)
+    {
+        uint32_t firstCorner = static_cast<uint32_t>(chunk.Corners.size());
+
+        for (;;)
+        {
+            p = SkipSpaces(p, end);
+            if (p >= end || *p == '\n' || *p == '#')
+                break;
+
+            ObjCorner corner;
+            int32_t value = 0;
+            if (!ParseInt(p, end, value))
+                break;
+            ResolveIndex(value, chunk.Positions.size(), 0, corner);
+
+            if (p < end && *p == '/')
+            {
+                ++p;
+                if (ParseInt(p, end, value))
+                    ResolveIndex(value, chunk.TexCoords.size(), 1, corner);
+
+                if (p < end && *p == '/')
+                {
+                    ++p;
+                    if (ParseInt(p, end, value))
+                        ResolveIndex(value, chunk.Normals.size(), 2, corner);
+                }
+            }
+
+            chunk.Corners.push_back(corner);
+
+            // Skip anything unexpected up to the next corner.
+            while (p < end && !IsSpace(*p) && *p != '\n')
+                ++p;
+        }
+
+        // Lines and points are not triangles.
+        if (chunk.Corners.size() - firstCorner < 3)
+        {
+            chunk.Corners.resize(firstCorner);
+            return;
+        }
+
+        chunk.FaceStarts.push_back(firstCorner);
+    }
+
+    void ParseChunk(const char* p, const char* end, ObjChunk& chunk)
+    {
+        while (p < end)
+        {
+            p = SkipSpaces(p, end);
+            const char* lineEnd = SkipLine(p, end);
+
+            if (lineEnd - p > 2)
+            {
+                if (p[0] == 'v' && IsSpace(p[1]))
+                {
+                    const char* value = p + 2;
+                    DirectX::XMFLOAT3 position;
+                    position.x = ParseFloat(value, lineEnd);
+                    position.y = ParseFloat(value, lineEnd);
+                    position.z = ParseFloat(value, lineEnd);
+                    chunk.Positions.push_back(position);
+                }
+                else if (p[0] == 'v' && p[1] == 't' && IsSpace(p[2]))
+                {
+                    const char* value = p + 3;
+                    DirectX::XMFLOAT2 texCoord;
+                    texCoord.x = ParseFloat(value, lineEnd);
+                    texCoord.y = ParseFloat(value, lineEnd);
+                    chunk.TexCoords.push_back(texCoord);
+                }
+                else if (p[0] == 'v' && p[1] == 'n' && IsSpace(p[2]))
+                {
+                    const char* value = p + 3;
+                    DirectX::XMFLOAT3 normal;
+                    normal.x = ParseFloat(value, lineEnd);
+                    normal.y = ParseFloat(value, lineEnd);
+                    normal.z = ParseFloat(value, lineEnd);
+                    chunk.Normals.push_back(normal);
+                }
+                else if (p[0] == 'f' && IsSpace(p[1]))
+                {
+                    ParseFace(p + 2, lineEnd, chunk);
+                }
+                else if ((p[0] == 'g' || p[0] == 'o') && IsSpace(p[1]))
+                {
+                    chunk.Statements.push_back({ ObjStatement::Group, static_cast<uint32_t>(chunk.FaceStarts.size()), ParseName(p + 2, lineEnd) });
+                }
+                else if (lineEnd - p > 7 && strncmp(p, "usemtl", 6) == 0 && IsSpace(p[6]))
+                {
+                    chunk.Statements.push_back({ ObjStatement::UseMaterial, static_cast<uint32_t>(chunk.FaceStarts.size()), ParseName(p + 7, lineEnd) });
+                }
+                else if (lineEnd - p > 7 && strncmp(p, "mtllib", 6) == 0 && IsSpace(p[6]))
+                {
+                    chunk.MaterialLibraries.push_back(ParseName(p + 7, lineEnd));
+                }
+            }
+
+            p = lineEnd;
+        }
+
+        chunk.FaceStarts.push_back(static_cast<uint32_t>(chunk.Corners.size()));
+    }
+
+    // Texture paths of every material, prefixed with the library directory relative to the OBJ file.
+    void LoadMaterialLibrary(const fs::path& directory, const std::string& library, MaterialTextures& materials)
+    {
+        std::ifstream stream(directory / library);
+        if (!stream)
+            return;
+
+        std::string libraryDirectory = fs::path(library).parent_path().string();
+        if (!libraryDirectory.empty())
+            libraryDirectory += "/";
+
+        // The order of ProcessMesh, so both importers load the textures alike.
+        const aiTextureType TEXTURE_TYPES[] = { aiTextureType_DIFFUSE, aiTextureType_SPECULAR, aiTextureType_HEIGHT, aiTextureType_NORMALS, aiTextureType_AMBIENT };
+
+        std::string materialName;
+        std::map<aiTextureType, std::string> textures;
+
+        auto flush = [&]()
+        {
+            if (materialName.empty())
+                return;
+
+            auto& list = materials[materialName];
+            list.clear();
+            for (aiTextureType type : TEXTURE_TYPES)
+            {
+                auto texture = textures.find(type);
+                if (texture != textures.end())
+                    list.push_back({ static_cast<uint32_t>(type), libraryDirectory + texture->second });
+            }
+        };
+
+        std::string line;
+        while (std::getline(stream, line))
+        {
+            const char* p = SkipSpaces(line.data(), line.data() + line.size());
+            const char* end = line.data() + line.size();
+
+            const char* keywordEnd = p;
+            while (keywordEnd < end && !IsSpace(*keywordEnd))
+                ++keywordEnd;
+            std::string keyword(p, keywordEnd);
+
+            if (keyword == "newmtl")
+            {
+                flush();
+                materialName = ParseName(keywordEnd, end);
+                textures.clear();
+                continue;
+            }
+
+            aiTextureType type = aiTextureType_NONE;
+            if (keyword == "map_Kd")
+                type = aiTextureType_DIFFUSE;
+            else if (keyword == "map_Ks")
+                type = aiTextureType_SPECULAR;
+            else if (keyword == "map_Ka")
+                type = aiTextureType_AMBIENT;
+            else if (keyword == "map_bump" || keyword == "map_Bump" || keyword == "bump")
+                type = aiTextureType_HEIGHT;
+            else if (keyword == "map_Kn" || keyword == "norm")
+                type = aiTextureType_NORMALS;
+
+            if (type == aiTextureType_NONE)
+                continue;
+
+            // The file name is the last token, the texture options (-bm 1.0 etc.) go before it.
+            std::string arguments = ParseName(keywordEnd, end);
+            size_t nameStart = arguments.find_last_of(" \t");
+            textures[type] = nameStart == std::string::npos ? arguments : arguments.substr(nameStart + 1);
+        }
+
+        flush();
+    }
+
+    void BuildMeshes(const ObjMeshFaces& meshFaces, const std::vector<ObjChunk>& chunks,
+        const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<DirectX::XMFLOAT2>& texCoords, const std::vector<DirectX::XMFLOAT3>& normals,
+        const std::vector<SceneMeshTexture>& textures, std::vector<SceneMeshData>& meshes)
+    {
+        const int32_t positionCount = static_cast<int32_t>(positions.size());
+
+        // Area weighted face normals (Newell) for the corners without a normal.
+        std::unordered_map<int32_t, DirectX::XMFLOAT3> smoothNormals;
+        for (const auto& face : meshFaces.Faces)
+        {
+            const auto& chunk = chunks[face.Chunk];
+            uint32_t begin = chunk.FaceStarts[face.Face], end = chunk.FaceStarts[face.Face + 1];
+
+            bool needsNormal = false;
+            for (uint32_t c = begin; c < end; ++c)
+                needsNormal |= chunk.Corners[c].Index[2] == NO_INDEX;
+            if (!needsNormal)
+                continue;
+
+            DirectX::XMFLOAT3 faceNormal = { 0.f, 0.f, 0.f };
+            for (uint32_t c = begin; c < end; ++c)
+            {
+                int32_t i0 = chunk.Corners[c].Index[0];
+                int32_t i1 = chunk.Corners[c + 1 < end ? c + 1 : begin].Index[0];
+                if (i0 == NO_INDEX || i1 == NO_INDEX)
+                    continue;
+
+                const auto& a = positions[i0];
+                const auto& b = positions[i1];
+                faceNormal.x += (a.y - b.y) * (a.z + b.z);
+                faceNormal.y += (a.z - b.z) * (a.x + b.x);
+                faceNormal.z += (a.x - b.x) * (a.y + b.y);
+            }
+
+            for (uint32_t c = begin; c < end; ++c)
+            {
+                const auto& corner = chunk.Corners[c];
+                if (corner.Index[2] == NO_INDEX && corner.Index[0] != NO_INDEX)
+                {
+                    auto normal = smoothNormals.try_emplace(corner.Index[0], DirectX::XMFLOAT3(0.f, 0.f, 0.f)).first;
+                    Math::float3Add(normal->second, faceNormal);
+                }
+            }
+        }
+
+        for (auto& normal : smoothNormals)
+        {
+            if (Math::float3Len(normal.second) > 0.f)
+                Math::float3Normalized(normal.second);
+        }
+
+        std::unordered_map<CornerKey, uint16_t, CornerKeyHash> cornerVertices;
+
+        auto beginMesh = [&]()
+        {
+            // The previous part is kept only if it has triangles.
+            if (meshes.empty() || !meshes.back().Indices.empty())
+                meshes.emplace_back();
+
+            auto& mesh = meshes.back();
+            mesh.Name = meshes.size() > 1 ? meshFaces.Group + "_" + std::to_string(meshes.size() - 1) : meshFaces.Group;
+            mesh.Vertices.clear();
+            mesh.Textures = textures;
+            mesh.GenerateTangents = true;
+
+            cornerVertices.clear();
+        };
+
+        beginMesh();
+
+        for (const auto& face : meshFaces.Faces)
+        {
+            const auto& chunk = chunks[face.Chunk];
+            uint32_t begin = chunk.FaceStarts[face.Face], end = chunk.FaceStarts[face.Face + 1];
+
+            bool valid = true;
+            for (uint32_t c = begin; c < end; ++c)
+                valid &= chunk.Corners[c].Index[0] >= 0 && chunk.Corners[c].Index[0] < positionCount;
+            if (!valid)
+                continue;
+
+            // Mesh::Initialize takes less than USHRT_MAX vertices.
+            if (meshes.back().Vertices.size() + (end - begin) >= USHRT_MAX)
+                beginMesh();
+
+            auto& mesh = meshes.back();
+
+            uint16_t faceVertices[3];
+            for (uint32_t c = begin; c < end; ++c)
+            {
+                const auto& corner = chunk.Corners[c];
+                CornerKey key = { corner.Index[0], corner.Index[1], corner.Index[2] };
+
+                auto vertex = cornerVertices.find(key);
+                uint16_t index;
+                if (vertex != cornerVertices.end())
+                {
+                    index = vertex->second;
+                }
+                else
+                {
+                    const auto& position = positions[key.Position];
+
+                    DirectX::XMFLOAT3 normal = { 0.f, 0.f, 0.f };
+                    if (key.Normal >= 0 && key.Normal < static_cast<int32_t>(normals.size()))
+                        normal = normals[key.Normal];
+                    else if (key.Normal == NO_INDEX)
+                        normal = smoothNormals[key.Position];
+
+                    // aiProcess_FlipUVs.
+                    DirectX::XMFLOAT2 texCoord = { 0.f, 0.f };
+                    if (key.TexCoord >= 0 && key.TexCoord < static_cast<int32_t>(texCoords.size()))
+                        texCoord = { texCoords[key.TexCoord].x, 1.f - texCoords[key.TexCoord].y };
+
+                    index = static_cast<uint16_t>(mesh.Vertices.size());
+                    mesh.Vertices.emplace_back(PosNormTexExtendedVertex(position, normal, texCoord));
+                    cornerVertices.emplace(key, index);
+                }
+
+                // Fan triangulation: (0, 1, 2), (0, 2, 3), ...
+                uint32_t faceCorner = c - begin;
+                if (faceCorner < 2)
+                {
+                    faceVertices[faceCorner] = index;
+                    continue;
+                }
+
+                faceVertices[2] = index;
+                mesh.Indices.push_back(faceVertices[0]);
+                mesh.Indices.push_back(faceVertices[1]);
+                mesh.Indices.push_back(faceVertices[2]);
+                faceVertices[1] = index;
+            }
+        }
+
+        if (!meshes.empty() && meshes.back().Indices.empty())
+            meshes.pop_back();
+    }
+}
+
+bool ObjLoader::Load(const std::wstring& fileName, std::vector<SceneMeshData>& meshes)
+{
+    meshes.clear();
+
+    MappedFile file;
+    if (!file.Open(fileName))
+        return false;
+
+    const char* data = reinterpret_cast<const char*>(file.GetData());
+    const size_t size = file.GetSize();
+
+    // Chunk boundaries are moved to the line starts.
+    const size_t maxChunks = (ThreadPool::Get().GetThreadCount() + 1) * CHUNKS_PER_THREAD;
+    const size_t chunkCount = std::clamp<size_t>(size / MIN_CHUNK_SIZE, 1, maxChunks);
+
+    std::vector<size_t> chunkStarts(chunkCount + 1, size);
+    chunkStarts[0] = 0;
+    for (size_t i = 1; i < chunkCount; ++i)
+    {
+        size_t start = std::max(size * i / chunkCount, chunkStarts[i - 1]);
+        chunkStarts[i] = static_cast<size_t>(SkipLine(data + start, data + size) - data);
+    }
+
+    std::vector<ObjChunk> chunks(chunkCount);
+    ThreadPool::Get().ParallelFor(chunkCount, [&](size_t i)
+    {
+        ParseChunk(data + chunkStarts[i], data + chunkStarts[i + 1], chunks[i]);
+    });
+
+    // Element counts of the previous chunks resolve the relative indices, and place the chunk elements in the file arrays.
+    std::vector<size_t> positionBase(chunkCount + 1, 0), texCoordBase(chunkCount + 1, 0), normalBase(chunkCount + 1, 0);
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        positionBase[i + 1] = positionBase[i] + chunks[i].Positions.size();
+        texCoordBase[i + 1] = texCoordBase[i] + chunks[i].TexCoords.size();
+        normalBase[i + 1] = normalBase[i] + chunks[i].Normals.size();
+    }
+
+    std::vector<DirectX::XMFLOAT3> positions(positionBase[chunkCount]);
+    std::vector<DirectX::XMFLOAT2> texCoords(texCoordBase[chunkCount]);
+    std::vector<DirectX::XMFLOAT3> normals(normalBase[chunkCount]);
+
+    ThreadPool::Get().ParallelFor(chunkCount, [&](size_t i)
+    {
+        auto& chunk = chunks[i];
+        std::copy(chunk.Positions.begin(), chunk.Positions.end(), positions.begin() + positionBase[i]);
+        std::copy(chunk.TexCoords.begin(), chunk.TexCoords.end(), texCoords.begin() + texCoordBase[i]);
+        std::copy(chunk.Normals.begin(), chunk.Normals.end(), normals.begin() + normalBase[i]);
+
+        const size_t bases[3] = { positionBase[i], texCoordBase[i], normalBase[i] };
+        for (auto& corner : chunk.Corners)
+        {
+            for (size_t element = 0; element < 3; ++element)
+            {
+                if (corner.RelativeMask & (1 << element))
+                    corner.Index[element] += static_cast<int32_t>(bases[element]);
+            }
+        }
+    });
+
+    MaterialTextures materials;
+    const fs::path directory = fs::path(fileName).parent_path();
+    for (const auto& chunk : chunks)
+    {
+        for (const auto& library : chunk.MaterialLibraries)
+            LoadMaterialLibrary(directory, library, materials);
+    }
+
+    // Faces are grouped by the group and the material, the statements of a chunk are in its face order.
+    std::vector<ObjMeshFaces> meshFaces;
+    std::unordered_map<std::string, size_t> meshIndices;
+    std::string group = "default";
+    std::string material;
+    size_t currentMesh = SIZE_MAX;
+
+    for (uint32_t c = 0; c < chunkCount; ++c)
+    {
+        const auto& chunk = chunks[c];
+        const uint32_t faceCount = static_cast<uint32_t>(chunk.FaceStarts.size() - 1);
+
+        size_t statement = 0;
+        for (uint32_t f = 0; f <= faceCount; ++f)
+        {
+            for (; statement < chunk.Statements.size() && chunk.Statements[statement].FaceIndex == f; ++statement)
+            {
+                const auto& next = chunk.Statements[statement];
+                (next.StatementType == ObjStatement::Group ? group : material) = next.Name;
+                currentMesh = SIZE_MAX;
+            }
+
+            if (f == faceCount)
+                break;
+
+            if (currentMesh == SIZE_MAX)
+            {
+                auto inserted = meshIndices.try_emplace(group + '\n' + material, meshFaces.size());
+                if (inserted.second)
+                    meshFaces.push_back({ group, material, {} });
+                currentMesh = inserted.first->second;
+            }
+
+            meshFaces[currentMesh].Faces.push_back({ c, f });
+        }
+    }
+
+    std::vector<std::vector<SceneMeshData>> meshParts(meshFaces.size());
+    const std::vector<SceneMeshTexture> noTextures;
+    ThreadPool::Get().ParallelFor(meshFaces.size(), [&](size_t i)
+    {
+        auto textures = materials.find(meshFaces[i].Material);
+        BuildMeshes(meshFaces[i], chunks, positions, texCoords, normals,
+            textures != materials.end() ? textures->second : noTextures, meshParts[i]);
+    });
+
+    for (auto& parts : meshParts)
+    {
+        for (auto& part : parts)
+            meshes.push_back(std::move(part));
+    }
+
+    return true;
+}
+
+std::vector<std::string> ObjLoader::GetMaterialLibraries(const std::wstring& fileName)
+{
+    std::vector<std::string> libraries;
+
+    MappedFile file;
+    if (!file.Open(fileName))
+        return libraries;
+
+    const char* p = reinterpret_cast<const char*>(file.GetData());
+    const char* end = p + file.GetSize();
+    while (p < end)
+    {
+        p = SkipSpaces(p, end);
+        if (end - p > 7 && strncmp(p, "mtllib", 6) == 0 && IsSpace(p[6]))
+            libraries.push_back(ParseName(p + 7, end));
+
+        p = SkipLine(p, end);
+    }
+
+    return libraries;
+}
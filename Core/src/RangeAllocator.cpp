@@ -0,0 +1,113 @@
+#include <RangeAllocator.h>
+
+#include <DX12LibPCH.h>
+
+using namespace dx12demo::core;
+
+RangeAllocator::RangeAllocator(size_t size/* = 0*/)
+{
+    Reset(size);
+}
+
+void RangeAllocator::Reset(size_t size)
+{
+    m_FreeListByOffset.clear();
+    m_FreeListBySize.clear();
+
+    m_Size = size;
+    m_FreeSize = size;
+
+    if (size > 0)
+        AddNewBlock(0, size);
+}
+
+void RangeAllocator::AddNewBlock(size_t offset, size_t size)
+{
+    auto offsetIt = m_FreeListByOffset.emplace(offset, size);
+    auto sizeIt = m_FreeListBySize.emplace(size, offsetIt.first);
+    offsetIt.first->second.FreeListBySizeIt = sizeIt;
+}
+
+size_t RangeAllocator::Allocate(size_t size)
+{
+    if (size == 0 || size > m_FreeSize)
+        return INVALID_OFFSET;
+
+    // Get the first block that is large enough to satisfy the request.
+    auto smallestBlockIt = m_FreeListBySize.lower_bound(size);
+    if (smallestBlockIt == m_FreeListBySize.end())
+        return INVALID_OFFSET;
+
+    size_t blockSize = smallestBlockIt->first;
+    auto offsetIt = smallestBlockIt->second;
+    size_t offset = offsetIt->first;
+
+    m_FreeListBySize.erase(smallestBlockIt);
+    m_FreeListByOffset.erase(offsetIt);
+
+    // Return the left-over to the free list.
+    if (blockSize > size)
+        AddNewBlock(offset + size, blockSize - size);
+
+    m_FreeSize -= size;
+
+    return offset;
+}
+
+void RangeAllocator::Free(size_t offset, size_t size)
+{
+    assert(offset + size <= m_Size);
+
+    if (size == 0)
+        return;
+
+    // The block that should appear after the block that is being freed.
+    auto nextBlockIt = m_FreeListByOffset.upper_bound(offset);
+
+    // The block that appears before the block being freed.
+    auto prevBlockIt = nextBlockIt;
+    if (prevBlockIt != m_FreeListByOffset.begin())
+        --prevBlockIt;
+    else
+        prevBlockIt = m_FreeListByOffset.end();
+
+    m_FreeSize += size;
+
+    if (prevBlockIt != m_FreeListByOffset.end() &&
+        offset == prevBlockIt->first + prevBlockIt->second.Size)
+    {
+        // The previous block is exactly behind the block that is to be freed.
+        offset = prevBlockIt->first;
+        size += prevBlockIt->second.Size;
+
+        m_FreeListBySize.erase(prevBlockIt->second.FreeListBySizeIt);
+        m_FreeListByOffset.erase(prevBlockIt);
+    }
+
+    if (nextBlockIt != m_FreeListByOffset.end() &&
+        offset + size == nextBlockIt->first)
+    {
+        // The next block is exactly in front of the block that is to be freed.
+        size += nextBlockIt->second.Size;
+
+        m_FreeListBySize.erase(nextBlockIt->second.FreeListBySizeIt);
+        m_FreeListByOffset.erase(nextBlockIt);
+    }
+
+    AddNewBlock(offset, size);
+}
+
+bool RangeAllocator::HasSpace(size_t size) const
+{
+    return m_FreeListBySize.lower_bound(size) != m_FreeListBySize.end();
+}
+
+size_t RangeAllocator::GetSize() const
+{
+    return m_Size;
+}
+
+size_t RangeAllocator::GetFreeSize() const
+{
+    return m_FreeSize;
+}
@@ -2,21 +2,188 @@
 
 #include <DX12LibPCH.h>
 
+#include <Application.h>
 #include <CommandList.h>
 #include <Material.h>
 #include <Mesh.h>
 #include <BoundingVolumesPrimitive.h>
+#include <BoundingVolumeBuilder.h>
 #include <Frustum.h>
+#include <MeshInstancer.h>
+#include <MeshPool.h>
+#include <MeshSimplifier.h>
+#include <ObjLoader.h>
+#include <SceneCache.h>
+#include <TangentGenerator.h>
+#include <Texture.h>
+#include <TextureCache.h>
+#include <TextureCooker.h>
+#include <TextureDecoder.h>
+#include <ThreadPool.h>
+#include <ThreadSafeQueue.h>
+#include <VertexPacker.h>
 
 #include <DirectXMath.h>
 
 #include <iostream>
+#include <limits>
+#include <thread>
+#include <unordered_set>
 
 using namespace dx12demo::core;
 
 using VertexCollection = std::vector<PosNormTexVertex>;
 using IndexCollection = std::vector<uint16_t>;
 
+namespace
+{
+    // Material texture slots, the placeholders are per slot.
+    enum class MaterialSlot
+    {
+        Diffuse,
+        Specular,
+        Normal,
+        Ambient,
+        Count,
+        None = Count
+    };
+
+    MaterialSlot GetMaterialSlot(aiTextureType type)
+    {
+        switch (type)
+        {
+        case aiTextureType_DIFFUSE:
+            return MaterialSlot::Diffuse;
+        case aiTextureType_SPECULAR:
+            return MaterialSlot::Specular;
+        case aiTextureType_HEIGHT:
+        case aiTextureType_NORMALS:
+            return MaterialSlot::Normal;
+        case aiTextureType_AMBIENT:
+            return MaterialSlot::Ambient;
+        default:
+            return MaterialSlot::None;
+        }
+    }
+
+    TextureUsage GetTextureUsage(MaterialSlot slot)
+    {
+        switch (slot)
+        {
+        case MaterialSlot::Diffuse:
+            return TextureUsage::Diffuse;
+        case MaterialSlot::Specular:
+            return TextureUsage::Specular;
+        case MaterialSlot::Normal:
+            return TextureUsage::Normalmap;
+        default:
+            return TextureUsage::Ambient;
+        }
+    }
+
+    void SetMaterialTexture(Material& material, MaterialSlot slot, const Texture& texture)
+    {
+        switch (slot)
+        {
+        case MaterialSlot::Diffuse:
+            material.SetDiffuseTex(texture);
+            break;
+        case MaterialSlot::Specular:
+            material.SetSpecularTex(texture);
+            break;
+        case MaterialSlot::Normal:
+            material.SetNormalTex(texture);
+            break;
+        case MaterialSlot::Ambient:
+            material.SetAmbientTex(texture);
+            break;
+        default:
+            break;
+        }
+    }
+
+    size_t GetUploadSize(const SceneMeshData& data)
+    {
+        size_t size = data.Vertices.size() * sizeof(PosNormTexExtendedVertex) + data.Indices.size() * sizeof(uint16_t);
+        for (const auto& lod : data.Lods.Indices)
+            size += lod.size() * sizeof(uint16_t);
+        return size;
+    }
+
+    // The largest axis scale bounds the radius of the transformed sphere.
+    BSphere TransformSphere(const BSphere& sphere, const DirectX::XMFLOAT4X4& instance)
+    {
+        DirectX::XMMATRIX transform = DirectX::XMLoadFloat4x4(&instance);
+        float scale = std::max({ DirectX::XMVectorGetX(DirectX::XMVector3Length(transform.r[0])),
+            DirectX::XMVectorGetX(DirectX::XMVector3Length(transform.r[1])),
+            DirectX::XMVectorGetX(DirectX::XMVector3Length(transform.r[2])) });
+
+        BSphere transformed;
+        DirectX::XMStoreFloat3(&transformed.pos, DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&sphere.pos), transform));
+        transformed.r = sphere.r * scale;
+        return transformed;
+    }
+
+    // Distance from the camera to the surface of the instance sphere, in the units of the mesh for Mesh::SelectLod.
+    float GetLodDistance(const BSphere& meshSphere, const BSphere& sphere, DirectX::FXMVECTOR cameraPosition)
+    {
+        float distance = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&sphere.pos), cameraPosition))) - sphere.r;
+        return sphere.r > 0.0f ? distance * meshSphere.r / sphere.r : distance;
+    }
+
+    // Projected diameter in pixels, the whole viewport from inside the sphere.
+    float GetScreenSize(const BSphere& sphere, DirectX::FXMVECTOR cameraPosition, float projectionScale)
+    {
+        float distance = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&sphere.pos), cameraPosition)));
+        return 2.0f * sphere.r * projectionScale / std::max(distance, sphere.r);
+    }
+
+    double GetMilliseconds(std::chrono::high_resolution_clock::time_point startTime)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    }
+}
+
+struct Scene::StreamingState
+{
+    struct DecodedTexture
+    {
+        std::wstring Path;
+        TextureUsage Usage;
+        DirectX::ScratchImage Image;
+        // The DDS file for the TextureStreamer instead of the Image.
+        std::wstring StreamPath;
+    };
+
+    std::thread LoadThread;
+    std::atomic_bool Cancel = false;
+
+    // Set by the load thread after the last push to the queue, also when the load fails.
+    std::atomic_bool MeshesQueued = false;
+    std::atomic_bool TexturesQueued = false;
+
+    ThreadSafeQueue<std::shared_ptr<SceneMeshData>> Meshes;
+    ThreadSafeQueue<std::shared_ptr<DecodedTexture>> Textures;
+
+    // The rest is used only by the thread calling UpdateStreaming.
+    bool Active = false;
+
+    // Material slots waiting for a texture, by TextureDecoder::GetCacheKey of the path and the slot usage.
+    std::unordered_map<std::wstring, std::vector<std::pair<std::shared_ptr<Material>, MaterialSlot>>> TextureSlots;
+
+    // Kept after the load, the materials whose texture failed to decode still use them.
+    std::array<Texture, static_cast<size_t>(MaterialSlot::Count)> Placeholders;
+    bool PlaceholdersCreated = false;
+
+    std::string Path;
+    std::chrono::high_resolution_clock::time_point StartTime;
+    double FirstMeshTime = 0.0;
+    size_t MeshCount = 0;
+    size_t VertexCount = 0;
+    size_t TextureCount = 0;
+    size_t UploadedBytes = 0;
+};
+
 Scene::Scene()
 {
 
@@ -24,20 +191,570 @@ Scene::Scene()
 
 Scene::~Scene()
 {
+    if (m_Streaming && m_Streaming->LoadThread.joinable())
+    {
+        m_Streaming->Cancel = true;
+        m_Streaming->LoadThread.join();
+    }
 
+    for (auto id : m_StreamedTextures)
+        m_TextureStreamer->Remove(id);
 }
 
-bool Scene::LoadFromFile(std::shared_ptr<CommandList>& commandList, const std::wstring& fileName, bool rhcoords/* = false*/, float scale/* = 1*/)
+bool Scene::LoadFromFile(std::shared_ptr<CommandList>& commandList, const std::wstring& fileName, bool rhcoords/* = false*/, float scale/* = 1*/, bool packVertices/* = false*/)
 {
+    assert(!IsLoading());
+
     fs::path filePath(fileName);
     if (!fs::exists(filePath))
     {
         return false;
     }
 
+    auto loadStartTime = std::chrono::high_resolution_clock::now();
+
+    std::string path(fileName.cbegin(), fileName.cend());
+
+    std::vector<SceneMeshData> meshes;
+    bool fromCache = false;
+    if (!ReadMeshes(fileName, meshes, fromCache))
+        return false;
+
+    auto cpuTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - loadStartTime);
+
+    m_lastDirectory = path.substr(0, path.find_last_of('/'));
+    m_last_rhcoords = rhcoords;
+    m_last_scale = scale;
+    m_last_packVertices = packVertices;
+
+    // All the decodes start on the workers here, the loads of CreateMesh then only wait for them.
+    // The requests are kept until the meshes are created, a finished decode is freed with its last request.
+    std::vector<std::shared_ptr<TextureDecodeRequest>> textureRequests;
+    {
+        std::unordered_set<std::wstring> uniqueKeys;
+        for (const auto& data : meshes)
+        {
+            for (const auto& texture : data.Textures)
+            {
+                std::wstring texturePath = GetTexturePath(texture);
+                MaterialSlot slot = GetMaterialSlot(static_cast<aiTextureType>(texture.Type));
+                if (slot == MaterialSlot::None || !uniqueKeys.insert(TextureDecoder::GetCacheKey(texturePath, GetTextureUsage(slot))).second ||
+                    !fs::exists(fs::path(texturePath)))
+                    continue;
+
+                auto request = CommandList::RequestTexture(texturePath, GetTextureUsage(slot));
+                if (request)
+                    textureRequests.push_back(request);
+            }
+        }
+    }
+
+    size_t vertexCount = 0;
+    for (auto& data : meshes)
+    {
+        vertexCount += data.Vertices.size();
+        CreateMesh(commandList, data);
+    }
+
+    {
+        auto loadTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - loadStartTime);
+        char buffer[512];
+        sprintf_s(buffer, "Scene %s: %s load in %.2f ms, %.2f ms of it %s\n", path.c_str(),
+            fromCache ? "warm (scene cache)" : "cold (assimp)", loadTime.count(), cpuTime.count(),
+            fromCache ? "reading the cache" : "importing");
+        OutputDebugStringA(buffer);
+    }
+
+    LogSceneStatistics(path, vertexCount);
+
+    return true;
+}
+
+bool Scene::LoadFromFileAsync(const std::wstring& fileName, bool rhcoords/* = false*/, float scale/* = 1*/, bool packVertices/* = false*/)
+{
+    if (IsLoading() || !fs::exists(fs::path(fileName)))
+        return false;
+
+    // The previous load thread has finished, IsLoading is false only after the join.
+    if (!m_Streaming)
+        m_Streaming = std::make_unique<StreamingState>();
+
+    auto& streaming = *m_Streaming;
+    streaming.Cancel = false;
+    streaming.MeshesQueued = false;
+    streaming.TexturesQueued = false;
+    streaming.Active = true;
+    streaming.TextureSlots.clear();
+    streaming.Path = std::string(fileName.cbegin(), fileName.cend());
+    streaming.StartTime = std::chrono::high_resolution_clock::now();
+    streaming.FirstMeshTime = 0.0;
+    streaming.MeshCount = 0;
+    streaming.VertexCount = 0;
+    streaming.TextureCount = 0;
+    streaming.UploadedBytes = 0;
+
+    // Read by CreateMesh and by the load thread, set before it starts.
+    m_lastDirectory = streaming.Path.substr(0, streaming.Path.find_last_of('/'));
+    m_last_rhcoords = rhcoords;
+    m_last_scale = scale;
+    m_last_packVertices = packVertices;
+
+    streaming.LoadThread = std::thread(&Scene::StreamFile, this, fileName);
+
+    return true;
+}
+
+void Scene::StreamFile(const std::wstring& fileName)
+{
+    auto& streaming = *m_Streaming;
+
+    std::vector<std::pair<std::wstring, TextureUsage>> texturePaths;
+    try
+    {
+        std::vector<SceneMeshData> meshes;
+        bool fromCache = false;
+        if (ReadMeshes(fileName, meshes, fromCache))
+        {
+            if (m_LogStatistics)
+            {
+                char buffer[512];
+                sprintf_s(buffer, "Scene %s: %s in %.2f ms on the load thread\n", streaming.Path.c_str(),
+                    fromCache ? "scene cache read" : "import", GetMilliseconds(streaming.StartTime));
+                OutputDebugStringA(buffer);
+            }
+
+            // Every texture is decoded once per cooked usage, in the order of the first use.
+            std::unordered_set<std::wstring> uniqueKeys;
+            for (const auto& data : meshes)
+            {
+                for (const auto& texture : data.Textures)
+                {
+                    MaterialSlot slot = GetMaterialSlot(static_cast<aiTextureType>(texture.Type));
+                    if (slot == MaterialSlot::None)
+                        continue;
+
+                    std::wstring path = GetTexturePath(texture);
+                    if (uniqueKeys.insert(TextureDecoder::GetCacheKey(path, GetTextureUsage(slot))).second)
+                        texturePaths.emplace_back(path, GetTextureUsage(slot));
+                }
+            }
+
+            for (auto& data : meshes)
+                streaming.Meshes.Push(std::make_shared<SceneMeshData>(std::move(data)));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        char buffer[512];
+        sprintf_s(buffer, "Scene %s: the load failed, %s\n", streaming.Path.c_str(), e.what());
+        OutputDebugStringA(buffer);
+        texturePaths.clear();
+    }
+
+    streaming.MeshesQueued = true;
+
+    // The decode jobs push the images as they finish, a failed texture keeps its placeholder.
+    const bool streamTextures = m_TextureStreamer != nullptr;
+    ThreadPool::Get().ParallelFor(texturePaths.size(), [&streaming, &texturePaths, streamTextures](size_t i)
+    {
+        if (streaming.Cancel)
+            return;
+
+        auto decoded = std::make_shared<StreamingState::DecodedTexture>();
+        decoded->Path = texturePaths[i].first;
+        decoded->Usage = texturePaths[i].second;
+        try
+        {
+            // Cooked first if the cache is stale, then only the DDS header is read here, the streamer maps the mips it uploads.
+            if (streamTextures)
+            {
+                std::wstring streamPath = TextureCooker::IsCooked(decoded->Path, decoded->Usage) ?
+                    TextureCooker::Cook(decoded->Path, decoded->Usage) : decoded->Path;
+                if (!streamPath.empty() && TextureStreamer::IsStreamable(streamPath))
+                {
+                    decoded->StreamPath = streamPath;
+                    streaming.Textures.Push(decoded);
+                    return;
+                }
+            }
+
+            DirectX::TexMetadata metadata;
+            TextureDecoder::LoadFile(decoded->Path, decoded->Usage, metadata, decoded->Image);
+        }
+        catch (const std::exception&)
+        {
+            std::string path(decoded->Path.cbegin(), decoded->Path.cend());
+            char buffer[512];
+            sprintf_s(buffer, "Scene: texture %s can't be decoded\n", path.c_str());
+            OutputDebugStringA(buffer);
+            return;
+        }
+
+        streaming.Textures.Push(decoded);
+    });
+
+    streaming.TexturesQueued = true;
+}
+
+void Scene::UpdateStreaming(std::shared_ptr<CommandList>& commandList, size_t byteBudget)
+{
+    if (!IsLoading())
+        return;
+
+    assert(commandList->GetCommandListType() == D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+    auto& streaming = *m_Streaming;
+    if (!streaming.PlaceholdersCreated)
+        CreatePlaceholderTextures(commandList);
+
+    size_t recordedBytes = 0;
+
+    std::shared_ptr<SceneMeshData> data;
+    while (recordedBytes < byteBudget && streaming.Meshes.TryPop(data))
+    {
+        if (streaming.FirstMeshTime == 0.0)
+            streaming.FirstMeshTime = GetMilliseconds(streaming.StartTime);
+
+        recordedBytes += GetUploadSize(*data);
+        streaming.MeshCount++;
+        streaming.VertexCount += data->Vertices.size();
+        CreateMesh(commandList, *data);
+    }
+
+    // Textures go after the geometry: all the meshes are queued before the first decode starts,
+    // so once they are created every decoded texture finds all its material slots.
+    if (!streaming.MeshesQueued || !streaming.Meshes.Empty())
+    {
+        streaming.UploadedBytes += recordedBytes;
+        return;
+    }
+
+    std::shared_ptr<StreamingState::DecodedTexture> decoded;
+    while (recordedBytes < byteBudget && streaming.Textures.TryPop(decoded))
+    {
+        recordedBytes += decoded->Image.GetPixelsSize();
+        streaming.TextureCount++;
+
+        auto slots = streaming.TextureSlots.find(TextureDecoder::GetCacheKey(decoded->Path, decoded->Usage));
+        if (slots == streaming.TextureSlots.end())
+            continue;
+
+        if (!decoded->StreamPath.empty())
+        {
+            // The materials hold their textures by value, every residency change is set again.
+            auto materialSlots = slots->second;
+            std::vector<std::shared_ptr<Material>> materials;
+            for (auto& [material, slot] : materialSlots)
+                materials.push_back(material);
+
+            recordedBytes += AddStreamedTexture(commandList, decoded->StreamPath, GetTextureUsage(materialSlots.front().second), materials,
+                [materialSlots](const Texture& texture)
+            {
+                for (auto& [material, slot] : materialSlots)
+                    SetMaterialTexture(*material, slot, texture);
+            });
+            streaming.TextureSlots.erase(slots);
+            continue;
+        }
+
+        for (auto& [material, slot] : slots->second)
+        {
+            Texture texture;
+            commandList->LoadTextureFromImage(texture, decoded->Path, decoded->Image, GetTextureUsage(slot));
+            SetMaterialTexture(*material, slot, texture);
+        }
+        streaming.TextureSlots.erase(slots);
+    }
+
+    streaming.UploadedBytes += recordedBytes;
+
+    if (!streaming.TexturesQueued || !streaming.Textures.Empty())
+        return;
+
+    streaming.LoadThread.join();
+    streaming.Active = false;
+    streaming.TextureSlots.clear();
+
+    {
+        char buffer[512];
+        sprintf_s(buffer, "Scene %s: streamed %zu meshes and %zu textures (%.2f MB) in %.2f ms, the first mesh after %.2f ms\n",
+            streaming.Path.c_str(), streaming.MeshCount, streaming.TextureCount, streaming.UploadedBytes / (1024.0 * 1024.0),
+            GetMilliseconds(streaming.StartTime), streaming.FirstMeshTime);
+        OutputDebugStringA(buffer);
+    }
+
+    LogSceneStatistics(streaming.Path, streaming.VertexCount);
+}
+
+bool Scene::IsLoading() const
+{
+    return m_Streaming && m_Streaming->Active;
+}
+
+void Scene::SetTextureStreamer(TextureStreamer* streamer)
+{
+    assert(!IsLoading() && m_StreamedTextures.empty());
+    m_TextureStreamer = streamer;
+}
+
+void Scene::UpdateTextureStreaming(std::shared_ptr<CommandList>& commandList, const DirectX::XMFLOAT3& cameraPosition, float projectionScale, size_t uploadBudget)
+{
+    if (!m_TextureStreamer)
+        return;
+
+    DirectX::XMVECTOR eye = DirectX::XMLoadFloat3(&cameraPosition);
+    for (size_t i = 0; i < m_MeshStreamedTextures.size(); ++i)
+    {
+        if (m_MeshStreamedTextures[i].empty())
+            continue;
+
+        const BSphere& sphere = m_Data[i].first->GetBSphere();
+        float screenSize = 0.0f;
+        if (m_MeshInstances[i].empty())
+        {
+            screenSize = GetScreenSize(sphere, eye, projectionScale);
+        }
+        else
+        {
+            for (const auto& instance : m_MeshInstances[i])
+                screenSize = std::max(screenSize, GetScreenSize(TransformSphere(sphere, instance), eye, projectionScale));
+        }
+
+        for (auto id : m_MeshStreamedTextures[i])
+            m_TextureStreamer->RequestScreenSize(id, screenSize);
+    }
+
+    m_TextureStreamer->Update(*commandList, uploadBudget);
+}
+
+size_t Scene::AddStreamedTexture(std::shared_ptr<CommandList>& commandList, const std::wstring& fileName, TextureUsage textureUsage,
+    const std::vector<std::shared_ptr<Material>>& materials, TextureStreamer::ResidencyCallback callback)
+{
+    const size_t residentBytes = m_TextureStreamer->GetStatistics().ResidentBytes;
+    auto id = m_TextureStreamer->Add(*commandList, fileName, textureUsage, std::move(callback));
+
+    if (id == TextureStreamer::INVALID_TEXTURE)
+    {
+        std::string path(fileName.cbegin(), fileName.cend());
+        char buffer[512];
+        sprintf_s(buffer, "Scene: texture %s can't be streamed\n", path.c_str());
+        OutputDebugStringA(buffer);
+        return 0;
+    }
+
+    m_StreamedTextures.push_back(id);
+    m_MeshStreamedTextures.resize(m_Data.size());
+    for (size_t i = 0; i < m_Data.size(); ++i)
+    {
+        if (std::find(materials.begin(), materials.end(), m_Data[i].second) != materials.end())
+            m_MeshStreamedTextures[i].push_back(id);
+    }
+
+    return m_TextureStreamer->GetStatistics().ResidentBytes - residentBytes;
+}
+
+void Scene::CreatePlaceholderTextures(std::shared_ptr<CommandList>& commandList)
+{
+    auto& streaming = *m_Streaming;
+
+    // 1x1 textures: gray diffuse and ambient, no specular, flat normal.
+    const std::array<uint32_t, static_cast<size_t>(MaterialSlot::Count)> colors = { 0xff808080, 0xff000000, 0xffff8080, 0xff808080 };
+    for (size_t slot = 0; slot < colors.size(); ++slot)
+    {
+        DirectX::ScratchImage image;
+        ThrowIfFailed(image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, 1, 1, 1, 1));
+        memcpy(image.GetPixels(), &colors[slot], sizeof(uint32_t));
+
+        std::wstring name = L"Scene Placeholder Texture " + std::to_wstring(slot);
+        commandList->LoadTextureFromImage(streaming.Placeholders[slot], name, image, GetTextureUsage(static_cast<MaterialSlot>(slot)));
+    }
+
+    streaming.PlaceholdersCreated = true;
+}
+
+bool Scene::ReadMeshes(const std::wstring& fileName, std::vector<SceneMeshData>& meshes, bool& fromCache)
+{
+    std::string path(fileName.cbegin(), fileName.cend());
+
+    SceneImportSettings settings;
+    settings.WeldOptions = m_WeldOptions;
+    settings.Importer = m_Importer;
+
+    fromCache = m_UseSceneCache && SceneCache::Read(fileName, settings, meshes);
+    if (fromCache)
+        return true;
+
+    if (!ImportFile(fileName, meshes))
+        return false;
+
+    if (m_UseSceneCache && !SceneCache::Write(fileName, settings, meshes))
+    {
+        char buffer[512];
+        sprintf_s(buffer, "Scene %s: the scene cache can't be written\n", path.c_str());
+        OutputDebugStringA(buffer);
+    }
+
+    return true;
+}
+
+void Scene::LogSceneStatistics(const std::string& path, size_t vertexCount)
+{
+    if (!m_LogStatistics)
+        return;
+
+    {
+        size_t vertexSize = m_last_packVertices ? sizeof(PackedVertex) : sizeof(PosNormTexExtendedVertex);
+        char buffer[512];
+        sprintf_s(buffer, "Scene %s: %zu vertices, %zu bytes per vertex, vertex data %.2f MB (%.2f MB unpacked)\n",
+            path.c_str(), vertexCount, vertexSize,
+            vertexCount * vertexSize / (1024.0 * 1024.0),
+            vertexCount * sizeof(PosNormTexExtendedVertex) / (1024.0 * 1024.0));
+        OutputDebugStringA(buffer);
+
+        sprintf_s(buffer, "Scene %s: geometry in %u mesh pool pages\n", path.c_str(), GetApp().GetMeshPool()->GetPageCount());
+        OutputDebugStringA(buffer);
+
+        size_t occurrenceCount = 0, instancedMeshCount = 0;
+        for (const auto& instances : m_MeshInstances)
+        {
+            occurrenceCount += std::max<size_t>(instances.size(), 1);
+            instancedMeshCount += instances.size() > 1 ? 1 : 0;
+        }
+
+        sprintf_s(buffer, "Scene %s: %zu mesh occurrences in %zu draws, %zu meshes drawn instanced\n",
+            path.c_str(), occurrenceCount, m_Data.size(), instancedMeshCount);
+        OutputDebugStringA(buffer);
+    }
+
+    // Bounding volume fit for the whole scene, the culling difference is in GetCullingStatistics.
+    {
+        double aabbSphereRadius = 0.0, sphereRadius = 0.0, aabbVolume = 0.0, obbVolume = 0.0;
+        for (auto& nextMesh : m_Data)
+        {
+            const auto& mesh = nextMesh.first;
+            const auto& aabb = mesh->GetBAABB();
+            aabbSphereRadius += Math::float3Radius(aabb.box_max, aabb.box_min) * 0.5f;
+            sphereRadius += mesh->GetBSphere().r;
+            aabbVolume += BoundingVolumeBuilder::GetVolume(BoundingVolumeBuilder::ToOBB(aabb));
+            obbVolume += BoundingVolumeBuilder::GetVolume(mesh->GetBOBB());
+        }
+
+        if (aabbSphereRadius > 0.0 && aabbVolume > 0.0)
+        {
+            char buffer[512];
+            sprintf_s(buffer, "Scene %s: bounding sphere radius %.1f%% of the AABB sphere, OBB volume %.1f%% of the AABB\n",
+                path.c_str(), sphereRadius / aabbSphereRadius * 100.0, obbVolume / aabbVolume * 100.0);
+            OutputDebugStringA(buffer);
+        }
+    }
+
+    {
+        auto textureStatistics = CommandList::GetTextureCache().GetStatistics();
+        char buffer[512];
+        sprintf_s(buffer, "Scene %s: texture cache %zu textures, %.2f MB of %.2f MB, %llu hits, %llu misses, %llu evictions\n",
+            path.c_str(), textureStatistics.EntryCount, textureStatistics.ResidentBytes / (1024.0 * 1024.0),
+            textureStatistics.Budget / (1024.0 * 1024.0), textureStatistics.Hits, textureStatistics.Misses, textureStatistics.Evictions);
+        OutputDebugStringA(buffer);
+    }
+
+    // Vertex cache report for the whole scene.
+    VertexCacheStatistics before, after;
+    for (auto& nextMesh : m_Data)
+    {
+        const auto& report = nextMesh.first->GetOptimizerReport();
+        before.TriangleCount += report.Before.TriangleCount;
+        before.VertexCount += report.Before.VertexCount;
+        before.VerticesTransformed += report.Before.VerticesTransformed;
+        after.TriangleCount += report.After.TriangleCount;
+        after.VertexCount += report.After.VertexCount;
+        after.VerticesTransformed += report.After.VerticesTransformed;
+    }
+
+    if (before.TriangleCount > 0 && before.VertexCount > 0)
+    {
+        char buffer[512];
+        sprintf_s(buffer, "Scene %s: %zu meshes, vertices transformed %u -> %u, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+            path.c_str(), m_Data.size(), before.VerticesTransformed, after.VerticesTransformed,
+            static_cast<float>(before.VerticesTransformed) / before.TriangleCount,
+            static_cast<float>(after.VerticesTransformed) / after.TriangleCount,
+            static_cast<float>(before.VerticesTransformed) / before.VertexCount,
+            static_cast<float>(after.VerticesTransformed) / after.VertexCount);
+        OutputDebugStringA(buffer);
+    }
+}
+
+bool Scene::ImportFile(const std::wstring& fileName, std::vector<SceneMeshData>& meshes)
+{
     std::string path(fileName.cbegin(), fileName.cend());
+
+    std::wstring extension = fs::path(fileName).extension().wstring();
+    std::transform(extension.begin(), extension.end(), extension.begin(), towlower);
+    const bool useObjLoader = m_Importer == SceneImporter::Obj || (m_Importer == SceneImporter::Auto && extension == L".obj");
+
+    // Both importers read the file and convert the meshes to SceneMeshData on all cores.
+    auto readStartTime = std::chrono::high_resolution_clock::now();
+
+    if (useObjLoader ? !ObjLoader::Load(fileName, meshes) : !ImportAssimp(path, meshes))
+        return false;
+
+    auto readTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - readStartTime);
+
+    // Before the processing, the duplicates aren't processed at all.
+    MeshInstancingReport instancing = MeshInstancer::MergeDuplicates(meshes);
+    if (m_LogStatistics)
+    {
+        char buffer[512];
+        sprintf_s(buffer, "Scene %s: instancing %zu -> %zu meshes for %zu occurrences, geometry %.2f MB -> %.2f MB\n",
+            path.c_str(), instancing.MeshesBefore, instancing.MeshesAfter, instancing.InstanceCount,
+            instancing.BytesBefore / (1024.0 * 1024.0), instancing.BytesAfter / (1024.0 * 1024.0));
+        OutputDebugStringA(buffer);
+    }
+
+    // Tangents go after the welding and before the LODs, the generator can split vertices and the LOD indices must reference the final ones.
+    auto processStartTime = std::chrono::high_resolution_clock::now();
+
+    std::vector<VertexWeldReport> weldReports(meshes.size());
+    ThreadPool::Get().ParallelFor(meshes.size(), [this, &meshes, &weldReports](size_t i)
+    {
+        auto& data = meshes[i];
+        weldReports[i] = VertexWelder::Weld(data.Vertices, data.Indices, m_WeldOptions);
+
+        if (data.GenerateTangents)
+            TangentGenerator::Generate(data.Vertices, data.Indices);
+
+        MeshSimplifier::BuildLodChain(data.Vertices, data.Indices, data.Lods);
+    });
+
+    auto processTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - processStartTime);
+    if (m_LogStatistics)
+    {
+        char buffer[512];
+        sprintf_s(buffer, "Scene %s: %s read %zu meshes in %.2f ms, welding, tangent frames and LOD chains in %.2f ms on %u threads\n",
+            path.c_str(), useObjLoader ? "OBJ loader" : "assimp", meshes.size(), readTime.count(), processTime.count(), ThreadPool::Get().GetThreadCount() + 1);
+        OutputDebugStringA(buffer);
+
+        VertexWeldReport weldTotal;
+        for (const auto& report : weldReports)
+        {
+            weldTotal.VerticesBefore += report.VerticesBefore;
+            weldTotal.VerticesAfter += report.VerticesAfter;
+            weldTotal.RemovedTriangles += report.RemovedTriangles;
+        }
+
+        sprintf_s(buffer, "Scene %s: welding %zu -> %zu vertices (%.1f%% less), %zu collapsed triangles removed\n",
+            path.c_str(), weldTotal.VerticesBefore, weldTotal.VerticesAfter,
+            weldTotal.VerticesBefore ? 100.0 * (weldTotal.VerticesBefore - weldTotal.VerticesAfter) / weldTotal.VerticesBefore : 0.0,
+            weldTotal.RemovedTriangles);
+        OutputDebugStringA(buffer);
+    }
+
+    return true;
+}
+
+bool Scene::ImportAssimp(const std::string& path, std::vector<SceneMeshData>& meshes)
+{
     Assimp::Importer import;
-    const aiScene* scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+    const aiScene* scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals);
 
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
     {
@@ -45,37 +762,66 @@ bool Scene::LoadFromFile(std::shared_ptr<CommandList>& commandList, const std::w
         return false;
     }
 
-    m_lastDirectory = path.substr(0, path.find_last_of('/'));
-    m_last_rhcoords = rhcoords;
-    m_last_scale = scale;
+    // Two phases: the node walk only collects the meshes, then every mesh is converted on its own worker.
+    // Each mesh writes only its SceneMeshData, the aiScene is read-only, nothing is shared between the jobs.
+    // The GPU uploads are recorded later by LoadFromFile on the calling thread.
+    // A mesh referenced by several nodes is converted once, the node transforms become its instances.
+    std::vector<std::vector<aiMatrix4x4>> meshTransforms(scene->mNumMeshes);
+    std::vector<unsigned int> sourceMeshes;
+    ProcessNode(scene->mRootNode, scene, aiMatrix4x4(), meshTransforms, sourceMeshes);
+
+    meshes.resize(sourceMeshes.size());
+    ThreadPool::Get().ParallelFor(meshes.size(), [this, scene, &sourceMeshes, &meshTransforms, &meshes](size_t i)
+    {
+        ProcessMesh(scene->mMeshes[sourceMeshes[i]], scene, meshes[i]);
+
+        const auto& transforms = meshTransforms[sourceMeshes[i]];
+        if (transforms.size() == 1 && transforms[0].IsIdentity())
+            return;
+
+        // assimp transforms column vectors, DirectXMath and the shaders use row vectors.
+        for (const auto& transform : transforms)
+        {
+            aiMatrix4x4 transposed = transform;
+            transposed.Transpose();
+
+            DirectX::XMFLOAT4X4 instance;
+            memcpy(&instance, &transposed, sizeof(instance));
+            meshes[i].Instances.push_back(instance);
+        }
+    });
 
-    ProcessNode(commandList, scene->mRootNode, scene);
     return true;
 }
 
-void Scene::ProcessNode(std::shared_ptr<CommandList>& commandList, aiNode* node, const aiScene* scene)
+void Scene::ProcessNode(aiNode* node, const aiScene* scene, const aiMatrix4x4& parentTransform,
+    std::vector<std::vector<aiMatrix4x4>>& meshTransforms, std::vector<unsigned int>& meshes)
 {
+    aiMatrix4x4 transform = parentTransform * node->mTransformation;
+
     for (unsigned int i = 0; i < node->mNumMeshes; i++)
     {
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        ProcessMesh(commandList, mesh, scene);
+        unsigned int meshIndex = node->mMeshes[i];
+        if (meshTransforms[meshIndex].empty())
+            meshes.push_back(meshIndex);
+
+        meshTransforms[meshIndex].push_back(transform);
     }
 
     for (unsigned int i = 0; i < node->mNumChildren; i++)
     {
-        ProcessNode(commandList, node->mChildren[i], scene);
+        ProcessNode(node->mChildren[i], scene, transform, meshTransforms, meshes);
     }
 }
 
-void Scene::ProcessMesh(std::shared_ptr<CommandList>& commandList, aiMesh* mesh, const aiScene* scene)
+void Scene::ProcessMesh(aiMesh* mesh, const aiScene* scene, SceneMeshData& importData)
 {
-    static VertexExtendedCollection vertices;
-    static IndexCollection indices;
-
-    vertices.clear();
-    indices.clear();
+    importData.Name = mesh->mName.C_Str();
 
-    CollectorBVData collectorBVData;
+    auto& vertices = importData.Vertices;
+    auto& indices = importData.Indices;
+    vertices.reserve(mesh->mNumVertices);
+    indices.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
 
     for (unsigned int i = 0; i < mesh->mNumVertices; i++)
     {
@@ -83,22 +829,28 @@ void Scene::ProcessMesh(std::shared_ptr<CommandList>& commandList, aiMesh* mesh,
         position.x = mesh->mVertices[i].x;
         position.y = mesh->mVertices[i].y;
         position.z = mesh->mVertices[i].z;
-        collectorBVData.Collect(position);
 
-        DirectX::XMFLOAT3 normal;
-        normal.x = mesh->mNormals[i].x;
-        normal.y = mesh->mNormals[i].y;
-        normal.z = mesh->mNormals[i].z;
+        // aiProcess_GenSmoothNormals fills the missing normals, except for the point and line meshes.
+        DirectX::XMFLOAT3 normal = { 0.f, 0.f, 0.f };
+        if (mesh->HasNormals())
+        {
+            normal.x = mesh->mNormals[i].x;
+            normal.y = mesh->mNormals[i].y;
+            normal.z = mesh->mNormals[i].z;
+        }
 
-        DirectX::XMFLOAT3 tangent;
-        tangent.x = mesh->mTangents[i].x;
-        tangent.y = mesh->mTangents[i].y;
-        tangent.z = mesh->mTangents[i].z;
+        DirectX::XMFLOAT3 tangent = { 0.f, 0.f, 0.f };
+        DirectX::XMFLOAT3 bitangent = { 0.f, 0.f, 0.f };
+        if (mesh->HasTangentsAndBitangents())
+        {
+            tangent.x = mesh->mTangents[i].x;
+            tangent.y = mesh->mTangents[i].y;
+            tangent.z = mesh->mTangents[i].z;
 
-        DirectX::XMFLOAT3 bitangent;
-        bitangent.x = mesh->mBitangents[i].x;
-        bitangent.y = mesh->mBitangents[i].y;
-        bitangent.z = mesh->mBitangents[i].z;
+            bitangent.x = mesh->mBitangents[i].x;
+            bitangent.y = mesh->mBitangents[i].y;
+            bitangent.z = mesh->mBitangents[i].z;
+        }
 
         DirectX::XMFLOAT2 textureCoordinate;
         if (mesh->mTextureCoords[0])
@@ -122,88 +874,325 @@ void Scene::ProcessMesh(std::shared_ptr<CommandList>& commandList, aiMesh* mesh,
     }
 
 
+    importData.GenerateTangents = !mesh->HasTangentsAndBitangents();
+
+    // Only the texture paths are kept, the textures are loaded by CreateMesh on the thread recording the command list.
+    if (mesh->mMaterialIndex < scene->mNumMaterials)
+    {
+        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+        for (aiTextureType type : { aiTextureType_DIFFUSE, aiTextureType_SPECULAR, aiTextureType_HEIGHT, aiTextureType_NORMALS, aiTextureType_AMBIENT })
+        {
+            for (unsigned int i = 0; i < material->GetTextureCount(type); i++)
+            {
+                aiString str;
+                material->GetTexture(type, i, &str);
+
+                SceneMeshTexture texture;
+                texture.Type = static_cast<uint32_t>(type);
+                texture.Path = str.C_Str();
+                importData.Textures.push_back(texture);
+            }
+        }
+    }
+}
+
+void Scene::CreateMesh(std::shared_ptr<CommandList>& commandList, SceneMeshData& importData)
+{
     MeshCreatorInfo info;
-    info.bv_min_pos = collectorBVData.GetMin();
-    info.bv_max_pos = collectorBVData.GetMax();
-    info.bv_pos = collectorBVData.GetCenter();
     info.rhcoords = m_last_rhcoords;
     info.scale = m_last_scale;
+    info.packVertices = m_last_packVertices;
+    info.exactBoundingSphere = true;
+    info.lods = std::move(importData.Lods);
+
+    // All scene meshes share the pool buffers, the renderer binds them once per page.
+    info.pool = GetApp().GetMeshPool();
 
-    std::shared_ptr<Mesh> storedMesh = Mesh::CreateCustomMesh(*commandList, vertices, indices, info);
+    std::shared_ptr<Mesh> storedMesh = Mesh::CreateCustomMesh(*commandList, importData.Vertices, importData.Indices, info);
 
     std::shared_ptr<Material> meshMaterial(new Material);
-    if (mesh->mMaterialIndex >= 0)
+    if (IsLoading())
     {
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-        ProcessMeshLoadMaterialTextures(commandList, meshMaterial, material,
-            aiTextureType_DIFFUSE);
-        ProcessMeshLoadMaterialTextures(commandList, meshMaterial, material,
-            aiTextureType_SPECULAR);
-        ProcessMeshLoadMaterialTextures(commandList, meshMaterial, material,
-            aiTextureType_HEIGHT);
-        ProcessMeshLoadMaterialTextures(commandList, meshMaterial, material,
-            aiTextureType_NORMALS);
-        ProcessMeshLoadMaterialTextures(commandList, meshMaterial, material,
-            aiTextureType_AMBIENT);
+        // Streamed: the placeholders until UpdateStreaming uploads the decoded texture.
+        for (const auto& texture : importData.Textures)
+        {
+            MaterialSlot slot = GetMaterialSlot(static_cast<aiTextureType>(texture.Type));
+            if (slot == MaterialSlot::None)
+                continue;
+
+            SetMaterialTexture(*meshMaterial, slot, m_Streaming->Placeholders[static_cast<size_t>(slot)]);
+            m_Streaming->TextureSlots[TextureDecoder::GetCacheKey(GetTexturePath(texture), GetTextureUsage(slot))].emplace_back(meshMaterial, slot);
+        }
+    }
+    else
+    {
+        for (const auto& texture : importData.Textures)
+            ProcessMeshLoadMaterialTextures(commandList, meshMaterial, texture);
     }
 
     m_Data.emplace_back(std::make_pair(storedMesh, meshMaterial));
+    m_MeshInstances.push_back(std::move(importData.Instances));
 }
 
-void Scene::ProcessMeshLoadMaterialTextures(std::shared_ptr<CommandList>& commandList, std::shared_ptr<Material>& inStoreMat, aiMaterial* mat, aiTextureType type)
+void Scene::ProcessMeshLoadMaterialTextures(std::shared_ptr<CommandList>& commandList, std::shared_ptr<Material>& inStoreMat, const SceneMeshTexture& texture)
 {
-    for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
-    {
-        aiString str;
-        mat->GetTexture(type, i, &str);
-        std::string texPath = m_lastDirectory + "/" + std::string(str.C_Str());
-        std::wstring path(texPath.cbegin(), texPath.cend());
+    std::wstring path = GetTexturePath(texture);
 
-        switch (type)
-        {
-        case aiTextureType_DIFFUSE:
-            inStoreMat->LoadDiffuseTex(commandList, path);
-            break;
-        case aiTextureType_SPECULAR:
-            inStoreMat->LoadSpecularTex(commandList, path);
-            break;
-        case aiTextureType_HEIGHT:
-        case aiTextureType_NORMALS:
-            inStoreMat->LoadNormalTex(commandList, path);
-            break;
-        case aiTextureType_AMBIENT:
-            inStoreMat->LoadAmbientTex(commandList, path);
-            break;
-        default:
-            continue;
-        }
+    switch (static_cast<aiTextureType>(texture.Type))
+    {
+    case aiTextureType_DIFFUSE:
+        inStoreMat->LoadDiffuseTex(commandList, path);
+        break;
+    case aiTextureType_SPECULAR:
+        inStoreMat->LoadSpecularTex(commandList, path);
+        break;
+    case aiTextureType_HEIGHT:
+    case aiTextureType_NORMALS:
+        inStoreMat->LoadNormalTex(commandList, path);
+        break;
+    case aiTextureType_AMBIENT:
+        inStoreMat->LoadAmbientTex(commandList, path);
+        break;
+    default:
+        break;
     }
 }
 
+std::wstring Scene::GetTexturePath(const SceneMeshTexture& texture) const
+{
+    std::string texPath = m_lastDirectory + "/" + texture.Path;
+    return std::wstring(texPath.cbegin(), texPath.cend());
+}
+
 void Scene::Render(std::shared_ptr<CommandList>& commandList, std::function<void(std::shared_ptr<CommandList>&, std::shared_ptr<Material>&)>& drawMatFun)
 {
-    for (auto& nextMesh : m_Data)
+    m_SubmittedTriangleCount = 0;
+    m_CullingStatistics = CullingStatistics();
+
+    bool identityBound = false;
+    for (size_t i = 0; i < m_Data.size(); ++i)
     {
-        auto& mesh = nextMesh.first;
-        auto& mat = nextMesh.second;
+        auto& mesh = m_Data[i].first;
+        auto& mat = m_Data[i].second;
+
+        uint32_t instanceCount = BindInstances(commandList, i, nullptr, identityBound);
+        if (instanceCount == 0)
+            continue;
 
+        BindDequantization(commandList, *mesh);
         drawMatFun(commandList, mat);
-        mesh->Render(commandList);
+        mesh->Render(commandList, instanceCount);
+        m_SubmittedTriangleCount += mesh->GetIndexCount() / 3 * instanceCount;
     }
 }
 
 void Scene::Render(std::shared_ptr<CommandList>& commandList, Frustum& frustum, std::function<void(std::shared_ptr<CommandList>&, std::shared_ptr<Material>&)>& drawMatFun)
 {
-    for (auto& nextMesh : m_Data)
+    m_SubmittedTriangleCount = 0;
+    m_CullingStatistics = CullingStatistics();
+
+    const auto& frustumPlanes = frustum.GetFrustumPlanesF4();
+    bool identityBound = false;
+    for (size_t i = 0; i < m_Data.size(); ++i)
     {
-        auto& mesh = nextMesh.first;
-        auto& mat = nextMesh.second;
+        auto& mesh = m_Data[i].first;
+        auto& mat = m_Data[i].second;
+
+        // The instanced meshes are culled per instance and drawn whole, the clusters are culled in the mesh space.
+        if (!m_MeshInstances[i].empty())
+        {
+            uint32_t instanceCount = BindInstances(commandList, i, &frustumPlanes, identityBound);
+            if (instanceCount == 0)
+                continue;
 
-        if (!Frustum::FrustumInSphere(mesh->GetBSphere(), frustum.GetFrustumPlanesF4()))
+            BindDequantization(commandList, *mesh);
+            drawMatFun(commandList, mat);
+            mesh->Render(commandList, instanceCount);
+            m_SubmittedTriangleCount += mesh->GetIndexCount() / 3 * instanceCount;
+            continue;
+        }
+
+        if (!IsMeshVisible(*mesh, frustumPlanes))
             continue;
 
+        BindInstances(commandList, i, nullptr, identityBound);
+        BindDequantization(commandList, *mesh);
         drawMatFun(commandList, mat);
-        mesh->Render(commandList);
+        m_SubmittedTriangleCount += mesh->RenderClusters(commandList, frustumPlanes);
     }
 }
 
+void Scene::Render(std::shared_ptr<CommandList>& commandList, Frustum& frustum, const DirectX::XMFLOAT3& cameraPosition, float projectionScale,
+    std::function<void(std::shared_ptr<CommandList>&, std::shared_ptr<Material>&)>& drawMatFun)
+{
+    m_SubmittedTriangleCount = 0;
+    m_CullingStatistics = CullingStatistics();
+
+    const auto& frustumPlanes = frustum.GetFrustumPlanesF4();
+    DirectX::XMVECTOR eye = DirectX::XMLoadFloat3(&cameraPosition);
+    bool identityBound = false;
+    for (size_t i = 0; i < m_Data.size(); ++i)
+    {
+        auto& mesh = m_Data[i].first;
+        auto& mat = m_Data[i].second;
+        const BSphere& sphere = mesh->GetBSphere();
+
+        if (!m_MeshInstances[i].empty())
+        {
+            uint32_t instanceCount = BindInstances(commandList, i, &frustumPlanes, identityBound);
+            if (instanceCount == 0)
+                continue;
+
+            // All the instances share one draw, the nearest one picks the level.
+            float distance = std::numeric_limits<float>::max();
+            for (const auto& instance : m_VisibleInstances)
+                distance = std::min(distance, GetLodDistance(sphere, TransformSphere(sphere, instance), eye));
+
+            uint32_t lod = mesh->SelectLod(distance, projectionScale);
+            BindDequantization(commandList, *mesh);
+            drawMatFun(commandList, mat);
+            mesh->RenderLod(commandList, lod, instanceCount);
+            m_SubmittedTriangleCount += mesh->GetLod(lod).Range.IndexCount / 3 * instanceCount;
+            continue;
+        }
+
+        if (!IsMeshVisible(*mesh, frustumPlanes))
+            continue;
+
+        BindInstances(commandList, i, nullptr, identityBound);
+        BindDequantization(commandList, *mesh);
+        drawMatFun(commandList, mat);
+
+        uint32_t lod = mesh->SelectLod(GetLodDistance(sphere, sphere, eye), projectionScale);
+        if (lod > 0)
+        {
+            mesh->RenderLod(commandList, lod);
+            m_SubmittedTriangleCount += mesh->GetLod(lod).Range.IndexCount / 3;
+        }
+        else
+        {
+            m_SubmittedTriangleCount += mesh->RenderClusters(commandList, frustumPlanes, &cameraPosition);
+        }
+    }
+}
+
+uint32_t Scene::BindInstances(std::shared_ptr<CommandList>& commandList, size_t meshIndex, const std::array<DirectX::XMFLOAT4, 6>* frustumPlanes, bool& identityBound)
+{
+    const auto& instances = m_MeshInstances[meshIndex];
+    if (instances.empty())
+    {
+        if (!identityBound)
+        {
+            DirectX::XMFLOAT4X4 identity;
+            DirectX::XMStoreFloat4x4(&identity, DirectX::XMMatrixIdentity());
+            commandList->SetDynamicVertexBuffer(INSTANCE_SLOT, 1, sizeof(DirectX::XMFLOAT4X4), &identity);
+            identityBound = true;
+        }
+        return 1;
+    }
+
+    m_VisibleInstances.clear();
+    if (frustumPlanes)
+    {
+        const auto& sphere = m_Data[meshIndex].first->GetBSphere();
+        for (const auto& instance : instances)
+        {
+            BSphere instanceSphere = TransformSphere(sphere, instance);
+
+            m_CullingStatistics.InstanceCount++;
+            if (!Frustum::FrustumInSphere(instanceSphere, *frustumPlanes))
+            {
+                m_CullingStatistics.CulledInstances++;
+                continue;
+            }
+
+            m_VisibleInstances.push_back(instance);
+        }
+    }
+    else
+    {
+        m_VisibleInstances.assign(instances.begin(), instances.end());
+    }
+
+    identityBound = false;
+    if (m_VisibleInstances.empty())
+        return 0;
+
+    commandList->SetDynamicVertexBuffer(INSTANCE_SLOT, m_VisibleInstances);
+    return static_cast<uint32_t>(m_VisibleInstances.size());
+}
+
+void Scene::BindDequantization(std::shared_ptr<CommandList>& commandList, const Mesh& mesh)
+{
+    if (!mesh.IsPacked())
+        return;
+
+    // PackedVertexDequantization of PackedVertexInclude.hlsl.
+    struct alignas(16) Dequantization
+    {
+        DirectX::XMFLOAT3 PositionScale;
+        float Padding0;
+        DirectX::XMFLOAT3 PositionBias;
+        float Padding1;
+    } dequantization = {};
+    VertexPacker::GetDequantization(mesh.GetPackedBounds(), dequantization.PositionScale, dequantization.PositionBias);
+
+    commandList->SetGraphicsDynamicConstantBuffer(DEQUANTIZATION_ROOT_PARAMETER, dequantization);
+}
+
+uint32_t Scene::GetSubmittedTriangleCount() const
+{
+    return m_SubmittedTriangleCount;
+}
+
+const Scene::CullingStatistics& Scene::GetCullingStatistics() const
+{
+    return m_CullingStatistics;
+}
+
+void Scene::SetVertexWeldOptions(const VertexWeldOptions& options)
+{
+    m_WeldOptions = options;
+}
+
+void Scene::SetSceneCacheEnabled(bool enabled)
+{
+    m_UseSceneCache = enabled;
+}
+
+void Scene::SetImporter(SceneImporter importer)
+{
+    m_Importer = importer;
+}
+
+void Scene::SetStatisticsLogEnabled(bool enabled)
+{
+    m_LogStatistics = enabled;
+}
+
+bool Scene::IsMeshVisible(const Mesh& mesh, const std::array<DirectX::XMFLOAT4, 6>& frustumPlanes)
+{
+    m_CullingStatistics.MeshCount++;
+
+    const auto& aabb = mesh.GetBAABB();
+    BSphere aabbSphere;
+    aabbSphere.pos = BoundingVolumeBuilder::ToOBB(aabb).center;
+    aabbSphere.r = Math::float3Radius(aabb.box_max, aabb.box_min) * 0.5f;
+    if (!Frustum::FrustumInSphere(aabbSphere, frustumPlanes))
+        m_CullingStatistics.CulledByAABBSphere++;
+
+    if (!Frustum::FrustumInSphere(mesh.GetBSphere(), frustumPlanes))
+    {
+        m_CullingStatistics.CulledBySphere++;
+        return false;
+    }
+
+    if (!Frustum::FrustumInOBB(mesh.GetBOBB(), frustumPlanes))
+    {
+        m_CullingStatistics.CulledByOBB++;
+        return false;
+    }
+
+    return true;
+}
+
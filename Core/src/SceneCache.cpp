@@ -0,0 +1,452 @@
+#include <SceneCache.h>
+
+#include <DX12LibPCH.h>
+
+#include <MappedFile.h>
+#include <ObjLoader.h>
+
+#include <fstream>
+
+using namespace dx12demo::core;
+
+namespace
+{
+    // "DXSC"
+    const uint32_t CACHE_MAGIC = 0x43535844;
+
+    struct FileHeader
+    {
+        uint32_t Magic = CACHE_MAGIC;
+        uint32_t Version = SceneCache::VERSION;
+        uint32_t VertexSize = sizeof(PosNormTexExtendedVertex);
+        uint32_t MeshCount = 0;
+
+        uint64_t SourceSize = 0;
+        int64_t SourceTime = 0;
+        uint64_t SourceHash = 0;
+
+        VertexWeldOptions WeldOptions;
+        SceneImporter Importer = SceneImporter::Auto;
+
+        // DependencyHeader and its path each, before the meshes.
+        uint32_t DependencyCount = 0;
+    };
+
+    // Size of a dependency missing when the cache was written.
+    const uint64_t MISSING_FILE_SIZE = UINT64_MAX;
+
+    // A file the source references, the path is relative to the source file directory.
+    struct DependencyHeader
+    {
+        uint32_t PathLength = 0;
+        uint64_t Size = MISSING_FILE_SIZE;
+        int64_t Time = 0;
+        uint64_t Hash = 0;
+    };
+
+    struct MeshHeader
+    {
+        uint32_t NameLength = 0;
+        uint32_t VertexCount = 0;
+        uint32_t IndexCount = 0;
+        uint32_t LodCount = 0;
+        uint32_t TextureCount = 0;
+        uint32_t InstanceCount = 0;
+    };
+
+    struct LodHeader
+    {
+        uint32_t IndexCount = 0;
+        float Error = 0.f;
+    };
+
+    struct TextureHeader
+    {
+        uint32_t Type = 0;
+        uint32_t PathLength = 0;
+    };
+
+    // Vertex data starts at this alignment in the file, so the mapped vertices are aligned as in memory.
+    const size_t VERTEX_ALIGNMENT = 16;
+
+    class BlobWriter
+    {
+    public:
+        void Write(const void* data, size_t size)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            m_Data.insert(m_Data.end(), bytes, bytes + size);
+        }
+
+        template<typename T>
+        void Write(const T& value)
+        {
+            Write(&value, sizeof(T));
+        }
+
+        // Attribute by attribute, the padding of the vertices is written as zeros instead of whatever the memory held.
+        void Write(const std::vector<PosNormTexExtendedVertex>& vertices)
+        {
+            const size_t offset = m_Data.size();
+            m_Data.resize(offset + vertices.size() * sizeof(PosNormTexExtendedVertex), 0);
+
+            uint8_t* destination = m_Data.data() + offset;
+            for (const auto& vertex : vertices)
+            {
+                memcpy(destination + offsetof(PosNormTexExtendedVertex, m_position), &vertex.m_position, sizeof(vertex.m_position));
+                memcpy(destination + offsetof(PosNormTexExtendedVertex, m_normal), &vertex.m_normal, sizeof(vertex.m_normal));
+                memcpy(destination + offsetof(PosNormTexExtendedVertex, m_texCoord), &vertex.m_texCoord, sizeof(vertex.m_texCoord));
+                memcpy(destination + offsetof(PosNormTexExtendedVertex, m_tangent), &vertex.m_tangent, sizeof(vertex.m_tangent));
+                memcpy(destination + offsetof(PosNormTexExtendedVertex, m_bitangent), &vertex.m_bitangent, sizeof(vertex.m_bitangent));
+                destination += sizeof(PosNormTexExtendedVertex);
+            }
+        }
+
+        void Align(size_t alignment)
+        {
+            m_Data.resize((m_Data.size() + alignment - 1) / alignment * alignment, 0);
+        }
+
+        const std::vector<uint8_t>& GetData() const
+        {
+            return m_Data;
+        }
+
+    private:
+        std::vector<uint8_t> m_Data;
+    };
+
+    // Bounds checked reads from the mapped file, a truncated or corrupted cache fails instead of crashing.
+    class BlobReader
+    {
+    public:
+        BlobReader(const uint8_t* data, size_t size)
+            : m_Data(data)
+            , m_Size(size)
+        {
+        }
+
+        const uint8_t* Read(size_t size)
+        {
+            if (size > m_Size - m_Offset)
+                return nullptr;
+
+            const uint8_t* data = m_Data + m_Offset;
+            m_Offset += size;
+            return data;
+        }
+
+        template<typename T>
+        bool Read(T& value)
+        {
+            const uint8_t* data = Read(sizeof(T));
+            if (!data)
+                return false;
+
+            memcpy(&value, data, sizeof(T));
+            return true;
+        }
+
+        template<typename T>
+        bool Read(std::vector<T>& values, size_t count)
+        {
+            if (count > (m_Size - m_Offset) / sizeof(T))
+                return false;
+
+            values.resize(count);
+            if (count > 0)
+                memcpy(values.data(), Read(count * sizeof(T)), count * sizeof(T));
+            return true;
+        }
+
+        bool Read(std::string& value, size_t length)
+        {
+            const uint8_t* data = Read(length);
+            if (!data)
+                return false;
+
+            value.assign(reinterpret_cast<const char*>(data), length);
+            return true;
+        }
+
+        bool Align(size_t alignment)
+        {
+            size_t aligned = (m_Offset + alignment - 1) / alignment * alignment;
+            if (aligned > m_Size)
+                return false;
+
+            m_Offset = aligned;
+            return true;
+        }
+
+    private:
+        const uint8_t* m_Data;
+        size_t m_Size;
+        size_t m_Offset = 0;
+    };
+
+    bool GetSourceStamp(const std::wstring& fileName, uint64_t& size, int64_t& time)
+    {
+        std::error_code error;
+        size = fs::file_size(fileName, error);
+        if (error)
+            return false;
+
+        auto writeTime = fs::last_write_time(fileName, error);
+        if (error)
+            return false;
+
+        time = static_cast<int64_t>(writeTime.time_since_epoch().count());
+        return true;
+    }
+
+    // The material libraries, the textures of the meshes come from them.
+    std::vector<std::string> GetDependencies(const std::wstring& sourceFileName, const SceneImportSettings& settings)
+    {
+        std::wstring extension = fs::path(sourceFileName).extension().wstring();
+        std::transform(extension.begin(), extension.end(), extension.begin(), towlower);
+        if (settings.Importer == SceneImporter::Obj || extension == L".obj")
+            return ObjLoader::GetMaterialLibraries(sourceFileName);
+
+        return {};
+    }
+
+    bool IsSameSettings(const FileHeader& header, const SceneImportSettings& settings)
+    {
+        const auto& a = header.WeldOptions;
+        const auto& b = settings.WeldOptions;
+        return a.PositionEpsilon == b.PositionEpsilon && a.NormalEpsilon == b.NormalEpsilon && a.TexCoordEpsilon == b.TexCoordEpsilon &&
+            header.Importer == settings.Importer;
+    }
+}
+
+std::wstring SceneCache::GetCachePath(const std::wstring& sourceFileName)
+{
+    return sourceFileName + L".dxsc";
+}
+
+bool SceneCache::Read(const std::wstring& sourceFileName, const SceneImportSettings& settings, std::vector<SceneMeshData>& meshes)
+{
+    meshes.clear();
+
+    MappedFile file;
+    if (!file.Open(GetCachePath(sourceFileName)) || !file.GetData())
+        return false;
+
+    BlobReader reader(file.GetData(), file.GetSize());
+
+    FileHeader header;
+    if (!reader.Read(header) || header.Magic != CACHE_MAGIC || header.Version != VERSION ||
+        header.VertexSize != sizeof(PosNormTexExtendedVertex) || !IsSameSettings(header, settings))
+        return false;
+
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    if (!GetSourceStamp(sourceFileName, sourceSize, sourceTime) || sourceSize != header.SourceSize)
+        return false;
+
+    // A touched but unchanged file (e.g. a fresh checkout) keeps the cache.
+    if (sourceTime != header.SourceTime && HashFile(sourceFileName) != header.SourceHash)
+        return false;
+
+    // The source didn't change, so neither did its dependency list, only the dependencies themselves are checked.
+    const fs::path directory = fs::path(sourceFileName).parent_path();
+    for (uint32_t i = 0; i < header.DependencyCount; ++i)
+    {
+        DependencyHeader dependency;
+        std::string path;
+        if (!reader.Read(dependency) || !reader.Read(path, dependency.PathLength) || !reader.Align(4))
+            return false;
+
+        const std::wstring dependencyFileName = (directory / path).wstring();
+        uint64_t dependencySize = 0;
+        int64_t dependencyTime = 0;
+        if (!GetSourceStamp(dependencyFileName, dependencySize, dependencyTime))
+        {
+            if (dependency.Size != MISSING_FILE_SIZE)
+                return false;
+            continue;
+        }
+
+        if (dependencySize != dependency.Size)
+            return false;
+
+        if (dependencyTime != dependency.Time && HashFile(dependencyFileName) != dependency.Hash)
+            return false;
+    }
+
+    auto readMesh = [&reader](SceneMeshData& mesh)
+    {
+        MeshHeader meshHeader;
+        if (!reader.Read(meshHeader) || !reader.Read(mesh.Name, meshHeader.NameLength) || !reader.Align(VERTEX_ALIGNMENT))
+            return false;
+
+        if (!reader.Read(mesh.Vertices, meshHeader.VertexCount) || !reader.Read(mesh.Indices, meshHeader.IndexCount) || !reader.Align(4))
+            return false;
+
+        mesh.Lods.Indices.resize(meshHeader.LodCount);
+        mesh.Lods.Errors.resize(meshHeader.LodCount);
+        for (uint32_t lod = 0; lod < meshHeader.LodCount; ++lod)
+        {
+            LodHeader lodHeader;
+            if (!reader.Read(lodHeader) || !reader.Read(mesh.Lods.Indices[lod], lodHeader.IndexCount) || !reader.Align(4))
+                return false;
+
+            mesh.Lods.Errors[lod] = lodHeader.Error;
+        }
+
+        mesh.Textures.resize(meshHeader.TextureCount);
+        for (auto& texture : mesh.Textures)
+        {
+            TextureHeader textureHeader;
+            if (!reader.Read(textureHeader) || !reader.Read(texture.Path, textureHeader.PathLength) || !reader.Align(4))
+                return false;
+
+            texture.Type = textureHeader.Type;
+        }
+
+        if (!reader.Read(mesh.Instances, meshHeader.InstanceCount))
+            return false;
+
+        // Any index out of the vertex range means a corrupted file.
+        for (auto index : mesh.Indices)
+        {
+            if (index >= mesh.Vertices.size())
+                return false;
+        }
+
+        return true;
+    };
+
+    if (header.MeshCount > file.GetSize() / sizeof(MeshHeader))
+        return false;
+
+    meshes.resize(header.MeshCount);
+    for (auto& mesh : meshes)
+    {
+        if (!readMesh(mesh))
+        {
+            meshes.clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool SceneCache::Write(const std::wstring& sourceFileName, const SceneImportSettings& settings, const std::vector<SceneMeshData>& meshes)
+{
+    FileHeader header;
+    if (!GetSourceStamp(sourceFileName, header.SourceSize, header.SourceTime))
+        return false;
+
+    header.SourceHash = HashFile(sourceFileName);
+    header.WeldOptions = settings.WeldOptions;
+    header.Importer = settings.Importer;
+    header.MeshCount = static_cast<uint32_t>(meshes.size());
+
+    const std::vector<std::string> dependencies = GetDependencies(sourceFileName, settings);
+    header.DependencyCount = static_cast<uint32_t>(dependencies.size());
+
+    BlobWriter writer;
+    writer.Write(header);
+
+    const fs::path directory = fs::path(sourceFileName).parent_path();
+    for (const auto& path : dependencies)
+    {
+        const std::wstring dependencyFileName = (directory / path).wstring();
+
+        DependencyHeader dependency;
+        dependency.PathLength = static_cast<uint32_t>(path.size());
+        if (GetSourceStamp(dependencyFileName, dependency.Size, dependency.Time))
+            dependency.Hash = HashFile(dependencyFileName);
+        else
+            dependency.Size = MISSING_FILE_SIZE;
+
+        writer.Write(dependency);
+        writer.Write(path.data(), path.size());
+        writer.Align(4);
+    }
+
+    for (const auto& mesh : meshes)
+    {
+        MeshHeader meshHeader;
+        meshHeader.NameLength = static_cast<uint32_t>(mesh.Name.size());
+        meshHeader.VertexCount = static_cast<uint32_t>(mesh.Vertices.size());
+        meshHeader.IndexCount = static_cast<uint32_t>(mesh.Indices.size());
+        meshHeader.LodCount = static_cast<uint32_t>(mesh.Lods.Indices.size());
+        meshHeader.TextureCount = static_cast<uint32_t>(mesh.Textures.size());
+        meshHeader.InstanceCount = static_cast<uint32_t>(mesh.Instances.size());
+
+        writer.Write(meshHeader);
+        writer.Write(mesh.Name.data(), mesh.Name.size());
+        writer.Align(VERTEX_ALIGNMENT);
+        writer.Write(mesh.Vertices);
+        writer.Write(mesh.Indices.data(), mesh.Indices.size() * sizeof(uint16_t));
+        writer.Align(4);
+
+        for (size_t lod = 0; lod < mesh.Lods.Indices.size(); ++lod)
+        {
+            LodHeader lodHeader;
+            lodHeader.IndexCount = static_cast<uint32_t>(mesh.Lods.Indices[lod].size());
+            lodHeader.Error = lod < mesh.Lods.Errors.size() ? mesh.Lods.Errors[lod] : 0.f;
+
+            writer.Write(lodHeader);
+            writer.Write(mesh.Lods.Indices[lod].data(), mesh.Lods.Indices[lod].size() * sizeof(uint16_t));
+            writer.Align(4);
+        }
+
+        for (const auto& texture : mesh.Textures)
+        {
+            TextureHeader textureHeader;
+            textureHeader.Type = texture.Type;
+            textureHeader.PathLength = static_cast<uint32_t>(texture.Path.size());
+
+            writer.Write(textureHeader);
+            writer.Write(texture.Path.data(), texture.Path.size());
+            writer.Align(4);
+        }
+
+        writer.Write(mesh.Instances.data(), mesh.Instances.size() * sizeof(DirectX::XMFLOAT4X4));
+    }
+
+    const std::wstring cachePath = GetCachePath(sourceFileName);
+    const std::wstring tempPath = cachePath + L".tmp";
+    {
+        std::ofstream stream(fs::path(tempPath), std::ios::binary | std::ios::trunc);
+        if (!stream)
+            return false;
+
+        const auto& data = writer.GetData();
+        stream.write(reinterpret_cast<const char*>(data.data()), data.size());
+        if (!stream)
+            return false;
+    }
+
+    std::error_code error;
+    fs::rename(tempPath, cachePath, error);
+    if (error)
+    {
+        fs::remove(tempPath, error);
+        return false;
+    }
+
+    return true;
+}
+
+uint64_t SceneCache::HashFile(const std::wstring& fileName)
+{
+    MappedFile file;
+    if (!file.Open(fileName))
+        return 0;
+
+    uint64_t hash = 14695981039346656037ull;
+    const uint8_t* data = file.GetData();
+    for (size_t i = 0; i < file.GetSize(); ++i)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
@@ -0,0 +1,234 @@
+#include <TangentGenerator.h>
+
+#include <DX12LibPCH.h>
+
+#include <ThreadPool.h>
+
+using namespace dx12demo::core;
+
+namespace
+{
+    // Triangles and vertices are processed in chunks of this size on the workers.
+    const size_t CHUNK_SIZE = 4096;
+
+    struct TriangleFrame
+    {
+        // Unit derivative of the position along u.
+        DirectX::XMFLOAT3 tangent;
+        // Positive UV orientation, the mirrored mapping has it false.
+        bool orientation = true;
+        // Zero UV area or zero position area, the triangle doesn't contribute.
+        bool degenerate = true;
+    };
+
+    struct VertexFrame
+    {
+        DirectX::XMFLOAT3 tangent[2] = {};
+        uint32_t count[2] = {};
+    };
+
+    DirectX::XMFLOAT3 ProjectOnPlane(const DirectX::XMFLOAT3& v, const DirectX::XMFLOAT3& normal)
+    {
+        DirectX::XMFLOAT3 n = normal;
+        Math::float3Mult(n, Math::float3Dot(normal, v));
+        return Math::float3Substruct(v, n);
+    }
+
+    bool NormalizeSafe(DirectX::XMFLOAT3& v)
+    {
+        float length = Math::float3Len(v);
+        if (length <= 1e-20f)
+            return false;
+
+        Math::float3Div(v, length);
+        return true;
+    }
+
+    template<typename Func>
+    void ParallelForChunks(size_t count, Func&& func)
+    {
+        size_t chunkCount = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        ThreadPool::Get().ParallelFor(chunkCount, [count, &func](size_t chunk)
+        {
+            size_t end = std::min(count, (chunk + 1) * CHUNK_SIZE);
+            for (size_t i = chunk * CHUNK_SIZE; i < end; ++i)
+                func(i);
+        });
+    }
+}
+
+void TangentGenerator::Generate(VertexExtendedCollection& vertices, IndexCollection& indices)
+{
+    const size_t vertexCount = vertices.size();
+    const size_t triangleCount = indices.size() / 3;
+
+    std::vector<DirectX::XMFLOAT3> normals(vertexCount);
+    ParallelForChunks(vertexCount, [&](size_t i)
+    {
+        normals[i] = vertices[i].m_normal;
+        NormalizeSafe(normals[i]);
+    });
+
+    // Triangle tangents, the sign keeps them pointing along +u for both orientations.
+    std::vector<TriangleFrame> triangles(triangleCount);
+    ParallelForChunks(triangleCount, [&](size_t t)
+    {
+        const auto& v0 = vertices[indices[t * 3 + 0]];
+        const auto& v1 = vertices[indices[t * 3 + 1]];
+        const auto& v2 = vertices[indices[t * 3 + 2]];
+
+        DirectX::XMFLOAT3 dP1 = Math::float3Substruct(v1.m_position, v0.m_position);
+        DirectX::XMFLOAT3 dP2 = Math::float3Substruct(v2.m_position, v0.m_position);
+        float dU1 = v1.m_texCoord.x - v0.m_texCoord.x, dV1 = v1.m_texCoord.y - v0.m_texCoord.y;
+        float dU2 = v2.m_texCoord.x - v0.m_texCoord.x, dV2 = v2.m_texCoord.y - v0.m_texCoord.y;
+
+        auto& frame = triangles[t];
+        float signedArea = dU1 * dV2 - dV1 * dU2;
+        if (fabsf(signedArea) <= 1e-20f || Math::float3Len(Math::float3Cross(dP1, dP2)) <= 1e-20f)
+            return;
+
+        DirectX::XMFLOAT3 a = dP1, b = dP2;
+        Math::float3Mult(a, dV2);
+        Math::float3Mult(b, dV1);
+        frame.tangent = Math::float3Substruct(a, b);
+        if (!NormalizeSafe(frame.tangent))
+            return;
+
+        frame.orientation = signedArea > 0.f;
+        if (!frame.orientation)
+            Math::float3Mult(frame.tangent, -1.f);
+        frame.degenerate = false;
+    });
+
+    // Vertex -> corners adjacency, the counting sort keeps the corners of every vertex in the index order.
+    std::vector<uint32_t> cornerOffsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+        cornerOffsets[indices[i] + 1]++;
+    for (size_t v = 0; v < vertexCount; ++v)
+        cornerOffsets[v + 1] += cornerOffsets[v];
+
+    std::vector<uint32_t> corners(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(cornerOffsets.begin(), cornerOffsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; ++i)
+            corners[fill[indices[i]]++] = static_cast<uint32_t>(i);
+    }
+
+    // Angle weighted sum per vertex and UV orientation.
+    std::vector<VertexFrame> frames(vertexCount);
+    ParallelForChunks(vertexCount, [&](size_t v)
+    {
+        const auto& normal = normals[v];
+        auto& frame = frames[v];
+
+        for (uint32_t c = cornerOffsets[v]; c < cornerOffsets[v + 1]; ++c)
+        {
+            uint32_t corner = corners[c];
+            const auto& triangle = triangles[corner / 3];
+            if (triangle.degenerate)
+                continue;
+
+            uint32_t base = corner - corner % 3;
+            const auto& p = vertices[v].m_position;
+            const auto& pNext = vertices[indices[base + (corner + 1) % 3]].m_position;
+            const auto& pPrev = vertices[indices[base + (corner + 2) % 3]].m_position;
+
+            DirectX::XMFLOAT3 edge0 = ProjectOnPlane(Math::float3Substruct(pNext, p), normal);
+            DirectX::XMFLOAT3 edge1 = ProjectOnPlane(Math::float3Substruct(pPrev, p), normal);
+            DirectX::XMFLOAT3 tangent = ProjectOnPlane(triangle.tangent, normal);
+            if (!NormalizeSafe(edge0) || !NormalizeSafe(edge1) || !NormalizeSafe(tangent))
+                continue;
+
+            float angle = acosf(std::clamp(Math::float3Dot(edge0, edge1), -1.f, 1.f));
+            Math::float3Mult(tangent, angle);
+
+            size_t group = triangle.orientation ? 1 : 0;
+            Math::float3Add(frame.tangent[group], tangent);
+            frame.count[group]++;
+        }
+    });
+
+    // The mirrored corners of the vertices used by both orientations move to a copy of the vertex.
+    // Serial and in the vertex order, the copies get the same indices on every run.
+    std::vector<uint32_t> splitVertex(vertexCount, UINT32_MAX);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        if (frames[v].count[0] == 0 || frames[v].count[1] == 0)
+            continue;
+
+        // 16 bit indices (Mesh takes less than USHRT_MAX vertices), the vertex keeps the larger group when there is no room for the copy.
+        if (vertices.size() + 1 >= USHRT_MAX)
+        {
+            size_t minor = frames[v].count[0] < frames[v].count[1] ? 0 : 1;
+            frames[v].count[minor] = 0;
+            continue;
+        }
+
+        splitVertex[v] = static_cast<uint32_t>(vertices.size());
+        vertices.push_back(vertices[v]);
+    }
+
+    auto resolve = [](const DirectX::XMFLOAT3& sum, const DirectX::XMFLOAT3& normal, float sign, PosNormTexExtendedVertex& vertex)
+    {
+        DirectX::XMFLOAT3 tangent = ProjectOnPlane(sum, normal);
+        if (!NormalizeSafe(tangent))
+            tangent = GetOrthogonal(normal);
+
+        DirectX::XMFLOAT3 bitangent = Math::float3Cross(normal, tangent);
+        Math::float3Mult(bitangent, sign);
+
+        vertex.m_tangent = tangent;
+        vertex.m_bitangent = bitangent;
+    };
+
+    ParallelForChunks(vertexCount, [&](size_t v)
+    {
+        const auto& frame = frames[v];
+        const auto& normal = normals[v];
+
+        if (splitVertex[v] != UINT32_MAX)
+        {
+            resolve(frame.tangent[1], normal, 1.f, vertices[v]);
+            resolve(frame.tangent[0], normal, -1.f, vertices[splitVertex[v]]);
+            return;
+        }
+
+        size_t group = frame.count[1] > 0 || frame.count[0] == 0 ? 1 : 0;
+        resolve(frame.tangent[group], normal, group == 1 ? 1.f : -1.f, vertices[v]);
+    });
+
+    ParallelForChunks(triangleCount, [&](size_t t)
+    {
+        if (triangles[t].degenerate || triangles[t].orientation)
+            return;
+
+        for (size_t i = t * 3; i < t * 3 + 3; ++i)
+        {
+            uint32_t split = splitVertex[indices[i]];
+            if (split != UINT32_MAX)
+                indices[i] = static_cast<uint16_t>(split);
+        }
+    });
+}
+
+void TangentGenerator::Generate(const VertexCollection& vertices, IndexCollection& indices, VertexExtendedCollection& result)
+{
+    result.clear();
+    result.reserve(vertices.size());
+    for (const auto& vertex : vertices)
+        result.emplace_back(PosNormTexExtendedVertex(vertex.m_position, vertex.m_normal, vertex.m_texCoord));
+
+    Generate(result, indices);
+}
+
+DirectX::XMFLOAT3 TangentGenerator::GetOrthogonal(const DirectX::XMFLOAT3& normal)
+{
+    // The axis least aligned with the normal gives a stable cross product.
+    DirectX::XMFLOAT3 axis = fabsf(normal.x) < 0.9f ? DirectX::XMFLOAT3(1.f, 0.f, 0.f) : DirectX::XMFLOAT3(0.f, 1.f, 0.f);
+
+    DirectX::XMFLOAT3 tangent = Math::float3Cross(axis, normal);
+    if (!NormalizeSafe(tangent))
+        return { 1.f, 0.f, 0.f };
+
+    return tangent;
+}
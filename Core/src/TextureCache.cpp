@@ -0,0 +1,161 @@
+#include <TextureCache.h>
+
+#include <DX12LibPCH.h>
+
+#include <Application.h>
+#include <ResourceStateTracker.h>
+
+using namespace dx12demo::core;
+
+TextureCache::TextureCache(size_t budget/* = DEFAULT_BUDGET*/)
+    : m_Budget(budget)
+{
+}
+
+TextureCache::~TextureCache()
+{
+}
+
+Microsoft::WRL::ComPtr<ID3D12Resource> TextureCache::Find(const std::wstring& key)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto iter = m_Entries.find(key);
+    if (iter == m_Entries.end())
+    {
+        ++m_Misses;
+        return nullptr;
+    }
+
+    ++m_Hits;
+    m_LruOrder.splice(m_LruOrder.begin(), m_LruOrder, iter->second.LruPosition);
+    return iter->second.Resource;
+}
+
+bool TextureCache::Contains(const std::wstring& key) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Entries.find(key) != m_Entries.end();
+}
+
+Microsoft::WRL::ComPtr<ID3D12Resource> TextureCache::Add(const std::wstring& key, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource)
+{
+    assert(resource);
+
+    // Outside the lock, the device call is the slow part.
+    size_t size = GetResourceSize(resource.Get());
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto iter = m_Entries.find(key);
+    if (iter != m_Entries.end())
+        return iter->second.Resource;
+
+    m_LruOrder.push_front(key);
+
+    Entry& entry = m_Entries[key];
+    entry.Resource = resource;
+    entry.Size = size;
+    entry.LruPosition = m_LruOrder.begin();
+    m_ResidentBytes += size;
+
+    if (m_ResidentBytes > m_Budget)
+        EvictTo(m_Budget);
+
+    return resource;
+}
+
+void TextureCache::SetBudget(size_t budget)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Budget = budget;
+    EvictTo(m_Budget);
+}
+
+size_t TextureCache::GetBudget() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Budget;
+}
+
+size_t TextureCache::Trim()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return EvictTo(m_Budget);
+}
+
+size_t TextureCache::EvictUnreferenced()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return EvictTo(0);
+}
+
+TextureCacheStatistics TextureCache::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    TextureCacheStatistics statistics;
+    statistics.Hits = m_Hits;
+    statistics.Misses = m_Misses;
+    statistics.Evictions = m_Evictions;
+    statistics.EvictedBytes = m_EvictedBytes;
+    statistics.EntryCount = m_Entries.size();
+    statistics.ResidentBytes = m_ResidentBytes;
+    statistics.Budget = m_Budget;
+
+    for (const auto& iter : m_Entries)
+    {
+        if (IsReferenced(iter.second))
+            ++statistics.ReferencedCount;
+    }
+
+    return statistics;
+}
+
+size_t TextureCache::EvictTo(size_t targetBytes)
+{
+    size_t evictedBytes = 0;
+
+    // From the least recently used end, skipping the entries still in use.
+    auto lruIter = m_LruOrder.end();
+    while (m_ResidentBytes > targetBytes && lruIter != m_LruOrder.begin())
+    {
+        --lruIter;
+
+        auto iter = m_Entries.find(*lruIter);
+        assert(iter != m_Entries.end());
+
+        Entry& entry = iter->second;
+        if (IsReferenced(entry))
+            continue;
+
+        // The cache holds the last reference, the resource is released with the entry.
+        ResourceStateTracker::RemoveGlobalResourceState(entry.Resource.Get());
+
+        m_ResidentBytes -= entry.Size;
+        evictedBytes += entry.Size;
+        ++m_Evictions;
+
+        lruIter = m_LruOrder.erase(lruIter);
+        m_Entries.erase(iter);
+    }
+
+    m_EvictedBytes += evictedBytes;
+
+    return evictedBytes;
+}
+
+bool TextureCache::IsReferenced(const Entry& entry) const
+{
+    // Release returns the remaining count, 1 is the cache's own reference.
+    entry.Resource->AddRef();
+    return entry.Resource->Release() > 1;
+}
+
+size_t TextureCache::GetResourceSize(ID3D12Resource* resource)
+{
+    auto& device = GetApp().GetDevice();
+    D3D12_RESOURCE_DESC desc = resource->GetDesc();
+    D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = device->GetResourceAllocationInfo(0, 1, &desc);
+    return static_cast<size_t>(allocationInfo.SizeInBytes);
+}
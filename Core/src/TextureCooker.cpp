@@ -0,0 +1,208 @@
+#include <TextureCooker.h>
+
+#include <DX12LibPCH.h>
+
+#include <DDSCache.h>
+#include <MipGenerator.h>
+#include <TextureDecoder.h>
+#include <ThreadPool.h>
+
+using namespace dx12demo::core;
+using namespace DirectX;
+
+namespace
+{
+    std::atomic_bool g_CookerEnabled = true;
+
+    // Pixel rows compressed per job, a multiple of the 4 rows of a block.
+    const size_t STRIP_HEIGHT = 64;
+
+    const wchar_t* GetUsageName(TextureUsage textureUsage)
+    {
+        switch (textureUsage)
+        {
+        case TextureUsage::Albedo:
+            return L"albedo";
+        case TextureUsage::Ambient:
+            return L"ambient";
+        case TextureUsage::Specular:
+            return L"specular";
+        case TextureUsage::Normalmap:
+            return L"normal";
+        default:
+            return nullptr;
+        }
+    }
+
+    // Decode, mip and compress the source and write the cache. Returns false with the decoded source if it can't be compressed.
+    bool CookFile(const std::wstring& sourceFileName, TextureUsage textureUsage, const std::wstring& cachePath, ScratchImage& scratchImage, bool& written)
+    {
+        TexMetadata sourceMetadata;
+        ScratchImage source;
+        TextureDecoder::DecodeFile(sourceFileName, sourceMetadata, source);
+
+        DXGI_FORMAT format = TextureCooker::GetCompressedFormat(textureUsage, source);
+        if (format == DXGI_FORMAT_UNKNOWN)
+        {
+            scratchImage = std::move(source);
+            written = false;
+            return false;
+        }
+
+        ScratchImage mipChain;
+        MipGenerator::Generate(source, MipFilter::Kaiser, mipChain);
+        source.Release();
+
+        TextureCooker::Compress(mipChain, format, scratchImage);
+
+        written = DDSCache::Write(cachePath, scratchImage);
+        if (!written)
+        {
+            std::string path(sourceFileName.cbegin(), sourceFileName.cend());
+            char buffer[512];
+            sprintf_s(buffer, "Texture %s: the cooked cache can't be written\n", path.c_str());
+            OutputDebugStringA(buffer);
+        }
+
+        return true;
+    }
+}
+
+void TextureCooker::SetEnabled(bool enabled)
+{
+    g_CookerEnabled = enabled;
+}
+
+bool TextureCooker::IsEnabled()
+{
+    return g_CookerEnabled;
+}
+
+bool TextureCooker::IsCooked(const std::wstring& sourceFileName, TextureUsage textureUsage)
+{
+    if (!IsEnabled() || !GetUsageName(textureUsage))
+        return false;
+
+    // DDS files are already in their GPU format, HDR files need a float format.
+    fs::path extension = fs::path(sourceFileName).extension();
+    return extension != ".dds" && extension != ".hdr";
+}
+
+std::wstring TextureCooker::GetCachePath(const std::wstring& sourceFileName, TextureUsage textureUsage)
+{
+    assert(GetUsageName(textureUsage));
+    return sourceFileName + L"." + GetUsageName(textureUsage) + L".dds";
+}
+
+bool TextureCooker::Load(const std::wstring& sourceFileName, TextureUsage textureUsage, DirectX::TexMetadata& metadata, DirectX::ScratchImage& scratchImage)
+{
+    if (!IsCooked(sourceFileName, textureUsage))
+        return false;
+
+    const std::wstring cachePath = GetCachePath(sourceFileName, textureUsage);
+    if (DDSCache::IsValid(sourceFileName, cachePath) &&
+        SUCCEEDED(LoadFromDDSFile(cachePath.c_str(), DDS_FLAGS_NONE, &metadata, scratchImage)))
+    {
+        return true;
+    }
+
+    bool written = false;
+    CookFile(sourceFileName, textureUsage, cachePath, scratchImage, written);
+    metadata = scratchImage.GetMetadata();
+    return true;
+}
+
+std::wstring TextureCooker::Cook(const std::wstring& sourceFileName, TextureUsage textureUsage)
+{
+    if (!IsCooked(sourceFileName, textureUsage))
+        return std::wstring();
+
+    const std::wstring cachePath = GetCachePath(sourceFileName, textureUsage);
+    if (DDSCache::IsValid(sourceFileName, cachePath))
+        return cachePath;
+
+    ScratchImage scratchImage;
+    bool written = false;
+    if (!CookFile(sourceFileName, textureUsage, cachePath, scratchImage, written) || !written)
+        return std::wstring();
+
+    return cachePath;
+}
+
+DXGI_FORMAT TextureCooker::GetCompressedFormat(TextureUsage textureUsage, const DirectX::ScratchImage& scratchImage)
+{
+    const TexMetadata& metadata = scratchImage.GetMetadata();
+
+    // D3D12 requires the top level of a block compressed texture to be a multiple of the 4x4 block.
+    if (metadata.dimension != TEX_DIMENSION_TEXTURE2D || metadata.arraySize != 1 || metadata.IsCubemap() ||
+        IsCompressed(metadata.format) || metadata.width % 4 != 0 || metadata.height % 4 != 0)
+    {
+        return DXGI_FORMAT_UNKNOWN;
+    }
+
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    switch (textureUsage)
+    {
+    case TextureUsage::Albedo:
+        format = scratchImage.IsAlphaAllOpaque() ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC7_UNORM;
+        break;
+    case TextureUsage::Ambient:
+    case TextureUsage::Specular:
+        format = scratchImage.IsAlphaAllOpaque() ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC3_UNORM;
+        break;
+    case TextureUsage::Normalmap:
+        return DXGI_FORMAT_BC5_UNORM;
+    default:
+        return DXGI_FORMAT_UNKNOWN;
+    }
+
+    // Keep the color space the source was loaded in.
+    return IsSRGB(metadata.format) ? MakeSRGB(format) : format;
+}
+
+void TextureCooker::Compress(const DirectX::ScratchImage& source, DXGI_FORMAT format, DirectX::ScratchImage& compressed)
+{
+    TexMetadata metadata = source.GetMetadata();
+    metadata.format = format;
+    ThrowIfFailed(compressed.Initialize(metadata));
+    assert(compressed.GetImageCount() == source.GetImageCount());
+
+    // The blocks are independent: every strip of block rows is compressed on its own and copied in place.
+    struct Strip
+    {
+        size_t ImageIndex;
+        size_t Y;
+        size_t Height;
+    };
+
+    std::vector<Strip> strips;
+    for (size_t i = 0; i < source.GetImageCount(); ++i)
+    {
+        const Image& image = source.GetImages()[i];
+        for (size_t y = 0; y < image.height; y += STRIP_HEIGHT)
+            strips.push_back({ i, y, std::min(STRIP_HEIGHT, image.height - y) });
+    }
+
+    TEX_COMPRESS_FLAGS flags = TEX_COMPRESS_DEFAULT;
+    if (format == DXGI_FORMAT_BC7_UNORM || format == DXGI_FORMAT_BC7_UNORM_SRGB)
+        flags = TEX_COMPRESS_BC7_QUICK;
+
+    ThreadPool::Get().ParallelFor(strips.size(), [&](size_t s)
+    {
+        const Strip& strip = strips[s];
+        const Image& sourceImage = source.GetImages()[strip.ImageIndex];
+
+        Image stripImage = sourceImage;
+        stripImage.height = strip.Height;
+        stripImage.slicePitch = sourceImage.rowPitch * strip.Height;
+        stripImage.pixels = sourceImage.pixels + strip.Y * sourceImage.rowPitch;
+
+        ScratchImage compressedStrip;
+        ThrowIfFailed(DirectX::Compress(stripImage, format, flags, TEX_THRESHOLD_DEFAULT, compressedStrip));
+
+        const Image& destination = compressed.GetImages()[strip.ImageIndex];
+        const Image* compressedImage = compressedStrip.GetImage(0, 0, 0);
+        assert(compressedImage->rowPitch == destination.rowPitch);
+        memcpy(destination.pixels + strip.Y / 4 * destination.rowPitch, compressedImage->pixels, compressedImage->slicePitch);
+    });
+}
@@ -0,0 +1,233 @@
+#include <TextureDecoder.h>
+
+#include <DX12LibPCH.h>
+
+#include <HDRDecoder.h>
+#include <MipGenerator.h>
+#include <TextureCooker.h>
+#include <ThreadPool.h>
+
+using namespace dx12demo::core;
+using namespace DirectX;
+
+namespace
+{
+    // COM is initialized once per decoding thread instead of around every WIC load.
+    class ComScope
+    {
+    public:
+        ComScope()
+            : m_Result(CoInitializeEx(nullptr, COINIT_MULTITHREADED))
+        {
+        }
+
+        ~ComScope()
+        {
+            if (SUCCEEDED(m_Result))
+                CoUninitialize();
+        }
+
+        // A thread already in a single threaded apartment can use WIC as well.
+        bool IsInitialized() const
+        {
+            return SUCCEEDED(m_Result) || m_Result == RPC_E_CHANGED_MODE;
+        }
+
+    private:
+        HRESULT m_Result;
+    };
+
+    void EnsureComInitialized()
+    {
+        thread_local ComScope comScope;
+        if (!comScope.IsInitialized())
+            throw std::exception("COM initialization failed.");
+    }
+}
+
+TextureDecodeRequest::TextureDecodeRequest(const std::wstring& fileName, TextureUsage textureUsage)
+    : m_FileName(fileName)
+    , m_TextureUsage(textureUsage)
+{
+}
+
+const std::wstring& TextureDecodeRequest::GetFileName() const
+{
+    return m_FileName;
+}
+
+TextureUsage TextureDecodeRequest::GetTextureUsage() const
+{
+    return m_TextureUsage;
+}
+
+bool TextureDecodeRequest::IsReady() const
+{
+    return m_Ready;
+}
+
+void TextureDecodeRequest::Wait()
+{
+    if (m_Ready)
+        return;
+
+    // Rather than blocking on a job still queued behind others.
+    if (Run())
+        return;
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_ReadyCondition.wait(lock, [this]() { return m_Ready.load(); });
+}
+
+const DirectX::ScratchImage& TextureDecodeRequest::GetImage() const
+{
+    assert(m_Ready);
+    if (!m_Error.empty())
+        throw std::exception(m_Error.c_str());
+
+    return m_Image;
+}
+
+bool TextureDecodeRequest::Run()
+{
+    if (m_Started.exchange(true))
+        return false;
+
+    try
+    {
+        TexMetadata metadata;
+        TextureDecoder::LoadFile(m_FileName, m_TextureUsage, metadata, m_Image);
+    }
+    catch (const std::exception& e)
+    {
+        m_Image.Release();
+        m_Error = e.what();
+        if (m_Error.empty())
+            m_Error = "Texture decode failed.";
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Ready = true;
+    }
+    m_ReadyCondition.notify_all();
+
+    TextureDecoder::Get().OnDecoded(*this);
+    return true;
+}
+
+TextureDecoder& TextureDecoder::Get()
+{
+    static TextureDecoder decoder;
+    return decoder;
+}
+
+std::shared_ptr<TextureDecodeRequest> TextureDecoder::Request(const std::wstring& fileName, TextureUsage textureUsage/* = TextureUsage::None*/)
+{
+    const std::wstring key = GetCacheKey(fileName, textureUsage);
+
+    std::shared_ptr<TextureDecodeRequest> request;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto iter = m_PendingRequests.find(key);
+        if (iter != m_PendingRequests.end())
+            return iter->second;
+
+        request = std::make_shared<TextureDecodeRequest>(fileName, textureUsage);
+        request->m_Key = key;
+        m_PendingRequests.emplace(key, request);
+    }
+
+    ThreadPool::Get().Submit([request]()
+    {
+        request->Run();
+    });
+
+    return request;
+}
+
+size_t TextureDecoder::GetPendingCount()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_PendingRequests.size();
+}
+
+std::wstring TextureDecoder::GetCacheKey(const std::wstring& fileName, TextureUsage textureUsage)
+{
+    return TextureCooker::IsCooked(fileName, textureUsage) ? TextureCooker::GetCachePath(fileName, textureUsage) : fileName;
+}
+
+void TextureDecoder::OnDecoded(const TextureDecodeRequest& request)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto iter = m_PendingRequests.find(request.m_Key);
+    if (iter != m_PendingRequests.end() && iter->second.get() == &request)
+        m_PendingRequests.erase(iter);
+}
+
+void TextureDecoder::DecodeFile(const std::wstring& fileName, DirectX::TexMetadata& metadata, DirectX::ScratchImage& scratchImage)
+{
+    fs::path filePath(fileName);
+    if (filePath.extension() == ".dds")
+    {
+        ThrowIfFailed(LoadFromDDSFile(
+            fileName.c_str(),
+            DDS_FLAGS_FORCE_RGB,
+            &metadata,
+            scratchImage));
+    }
+    else if (filePath.extension() == ".hdr")
+    {
+        // DirectXTex reads the layouts the parallel decoder doesn't handle.
+        if (!HDRDecoder::Decode(fileName, metadata, scratchImage))
+        {
+            ThrowIfFailed(LoadFromHDRFile(
+                fileName.c_str(),
+                &metadata,
+                scratchImage));
+        }
+    }
+    else if (filePath.extension() == ".tga")
+    {
+        ThrowIfFailed(LoadFromTGAFile(
+            fileName.c_str(),
+            &metadata,
+            scratchImage));
+    }
+    else
+    {
+        EnsureComInitialized();
+        ThrowIfFailed(LoadFromWICFile(
+            fileName.c_str(),
+            WIC_FLAGS_FORCE_RGB,
+            &metadata,
+            scratchImage));
+    }
+}
+
+void TextureDecoder::LoadFile(const std::wstring& fileName, TextureUsage textureUsage, DirectX::TexMetadata& metadata, DirectX::ScratchImage& scratchImage)
+{
+    if (TextureCooker::Load(fileName, textureUsage, metadata, scratchImage))
+        return;
+
+    DecodeFile(fileName, metadata, scratchImage);
+
+    // The mips are generated here on the worker, the texture is uploaded complete without a compute queue pass.
+    if (MipGenerator::CanGenerate(metadata))
+    {
+        ScratchImage mipChain;
+        MipGenerator::Generate(scratchImage, MipFilter::Box, mipChain);
+        scratchImage = std::move(mipChain);
+        metadata = scratchImage.GetMetadata();
+    }
+
+    // The HDR images are packed once their mips are filtered in float.
+    const DXGI_FORMAT storageFormat = HDRDecoder::GetStorageFormat();
+    if (fs::path(fileName).extension() == ".hdr" && metadata.format == DXGI_FORMAT_R32G32B32A32_FLOAT && storageFormat != DXGI_FORMAT_R32G32B32A32_FLOAT)
+    {
+        ScratchImage packed;
+        HDRDecoder::Pack(scratchImage, storageFormat, packed);
+        scratchImage = std::move(packed);
+        metadata = scratchImage.GetMetadata();
+    }
+}
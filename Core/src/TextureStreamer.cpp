@@ -0,0 +1,367 @@
+#include <TextureStreamer.h>
+
+#include <DX12LibPCH.h>
+
+#include <Application.h>
+#include <CommandList.h>
+#include <ResourceStateTracker.h>
+
+#include <queue>
+
+using namespace dx12demo::core;
+using namespace DirectX;
+
+namespace
+{
+    // The magic number and the DDS_HEADER, the DDS_HEADER_DXT10 follows if the pixel format has the 'DX10' fourCC.
+    const size_t DDS_HEADER_SIZE = sizeof(uint32_t) + 124;
+    const size_t DDS_HEADER_DXT10_SIZE = 20;
+    const size_t DDS_PIXEL_FORMAT_FLAGS_OFFSET = sizeof(uint32_t) + 76;
+    const size_t DDS_FOURCC_OFFSET = sizeof(uint32_t) + 80;
+    const uint32_t DDS_PIXEL_FORMAT_FOURCC = 0x4;
+
+    // Candidates of Update, the highest priority on top.
+    struct StreamingCandidate
+    {
+        float Priority;
+        TextureStreamer::TextureId Id;
+
+        bool operator<(const StreamingCandidate& other) const
+        {
+            return Priority < other.Priority;
+        }
+    };
+}
+
+TextureStreamer::TextureStreamer(size_t budget/* = DEFAULT_BUDGET*/)
+    : m_Budget(budget)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+}
+
+bool TextureStreamer::IsStreamable(const std::wstring& fileName)
+{
+    if (fs::path(fileName).extension() != ".dds")
+        return false;
+
+    MappedFile file;
+    FileLayout layout;
+    return file.Open(fileName) && ReadLayout(file, layout);
+}
+
+TextureStreamer::TextureId TextureStreamer::Add(CommandList& commandList, const std::wstring& fileName, TextureUsage textureUsage, ResidencyCallback callback)
+{
+    auto texture = std::make_unique<StreamedTexture>();
+    if (fs::path(fileName).extension() != ".dds" || !texture->File.Open(fileName) || !ReadLayout(texture->File, texture->Layout))
+        return INVALID_TEXTURE;
+
+    texture->FileName = fileName;
+    texture->Usage = textureUsage;
+    texture->Callback = std::move(callback);
+
+    // The first level within MIP_TAIL_SIZE, or the closest level above it a block compressed resource can start with.
+    const TexMetadata& metadata = texture->Layout.Metadata;
+    for (uint32_t mip = 0; mip < metadata.mipLevels; ++mip)
+    {
+        if (IsValidTopMip(metadata, mip))
+            texture->TailMip = mip;
+
+        if (std::max(metadata.width >> mip, metadata.height >> mip) <= MIP_TAIL_SIZE)
+            break;
+    }
+
+    // Nothing is resident yet.
+    texture->ResidentMip = static_cast<uint32_t>(metadata.mipLevels);
+    texture->DesiredMip = texture->TailMip;
+
+    TextureId id;
+    if (m_FreeIds.empty())
+    {
+        id = static_cast<TextureId>(m_Textures.size());
+        m_Textures.push_back(std::move(texture));
+    }
+    else
+    {
+        id = m_FreeIds.back();
+        m_FreeIds.pop_back();
+        m_Textures[id] = std::move(texture);
+    }
+
+    SetResidentMip(commandList, *m_Textures[id], m_Textures[id]->TailMip);
+    return id;
+}
+
+void TextureStreamer::Remove(TextureId id)
+{
+    assert(id < m_Textures.size() && m_Textures[id]);
+
+    m_ResidentBytes -= GetSize(*m_Textures[id], m_Textures[id]->ResidentMip);
+    m_Textures[id].reset();
+    m_FreeIds.push_back(id);
+}
+
+void TextureStreamer::RequestScreenSize(TextureId id, float screenPixels)
+{
+    assert(id < m_Textures.size() && m_Textures[id]);
+
+    auto& texture = *m_Textures[id];
+    texture.ScreenPixels = std::max(texture.ScreenPixels, screenPixels);
+}
+
+size_t TextureStreamer::Update(CommandList& commandList, size_t uploadBudget)
+{
+    // Loads: the largest screen sizes missing the most levels first. Evictions: the smallest screen sizes first.
+    std::priority_queue<StreamingCandidate> loads;
+    std::priority_queue<StreamingCandidate> evictions;
+
+    for (TextureId id = 0; id < m_Textures.size(); ++id)
+    {
+        if (!m_Textures[id])
+            continue;
+
+        auto& texture = *m_Textures[id];
+        const TexMetadata& metadata = texture.Layout.Metadata;
+
+        texture.DesiredMip = texture.TailMip;
+        if (texture.ScreenPixels > 0.0f)
+        {
+            uint32_t mip = EstimateDesiredMip(static_cast<uint32_t>(metadata.width), static_cast<uint32_t>(metadata.height), texture.ScreenPixels);
+            mip = std::min(mip, texture.TailMip);
+            // Mip 0 is always valid, rounds to the finer level.
+            while (!IsValidTopMip(metadata, mip))
+                --mip;
+            texture.DesiredMip = mip;
+        }
+
+        if (texture.ResidentMip > texture.DesiredMip)
+            loads.push({ texture.ScreenPixels * (texture.ResidentMip - texture.DesiredMip), id });
+        else if (texture.ResidentMip < texture.DesiredMip)
+            // Negated, the smallest screen size is on top.
+            evictions.push({ -texture.ScreenPixels, id });
+
+        texture.ScreenPixels = 0.0f;
+    }
+
+    size_t recordedBytes = 0;
+
+    auto evictNext = [&]()
+    {
+        if (evictions.empty())
+            return false;
+
+        auto& texture = *m_Textures[evictions.top().Id];
+        evictions.pop();
+        recordedBytes += SetResidentMip(commandList, texture, texture.DesiredMip);
+        return true;
+    };
+
+    // The budget may have been lowered.
+    while (m_ResidentBytes > m_Budget && recordedBytes < uploadBudget && evictNext())
+    {
+    }
+
+    while (!loads.empty() && recordedBytes < uploadBudget)
+    {
+        auto& texture = *m_Textures[loads.top().Id];
+        loads.pop();
+
+        const size_t residentSize = GetSize(texture, texture.ResidentMip);
+        auto fits = [&](uint32_t mip)
+        {
+            return m_ResidentBytes - residentSize + GetSize(texture, mip) <= m_Budget;
+        };
+
+        while (!fits(texture.DesiredMip) && evictNext())
+        {
+        }
+
+        // Without enough memory to evict, the finest level that fits.
+        for (uint32_t mip = texture.DesiredMip; mip < texture.ResidentMip; ++mip)
+        {
+            if (IsValidTopMip(texture.Layout.Metadata, mip) && fits(mip))
+            {
+                recordedBytes += SetResidentMip(commandList, texture, mip);
+                break;
+            }
+        }
+    }
+
+    return recordedBytes;
+}
+
+uint32_t TextureStreamer::EstimateDesiredMip(uint32_t width, uint32_t height, float screenPixels)
+{
+    float ratio = std::max(width, height) / screenPixels;
+    if (!(ratio > 1.0f))
+        return 0;
+
+    // The coarsest level still at least as large as the screen.
+    return static_cast<uint32_t>(std::floor(std::log2(ratio)));
+}
+
+void TextureStreamer::SetBudget(size_t budget)
+{
+    m_Budget = budget;
+}
+
+size_t TextureStreamer::GetBudget() const
+{
+    return m_Budget;
+}
+
+const Texture& TextureStreamer::GetTexture(TextureId id) const
+{
+    assert(id < m_Textures.size() && m_Textures[id]);
+    return m_Textures[id]->Resident;
+}
+
+uint32_t TextureStreamer::GetResidentMip(TextureId id) const
+{
+    assert(id < m_Textures.size() && m_Textures[id]);
+    return m_Textures[id]->ResidentMip;
+}
+
+TextureStreamerStatistics TextureStreamer::GetStatistics() const
+{
+    TextureStreamerStatistics statistics;
+    for (const auto& texture : m_Textures)
+    {
+        if (!texture)
+            continue;
+
+        statistics.TextureCount++;
+        if (texture->ResidentMip > texture->DesiredMip)
+            statistics.PendingCount++;
+    }
+
+    statistics.ResidentBytes = m_ResidentBytes;
+    statistics.Budget = m_Budget;
+    statistics.LoadedMips = m_LoadedMips;
+    statistics.EvictedMips = m_EvictedMips;
+    return statistics;
+}
+
+bool TextureStreamer::ReadLayout(const MappedFile& file, FileLayout& layout)
+{
+    const uint8_t* data = file.GetData();
+    const size_t size = file.GetSize();
+    if (!data || size < DDS_HEADER_SIZE)
+        return false;
+
+    TexMetadata& metadata = layout.Metadata;
+    if (FAILED(GetMetadataFromDDSMemory(data, size, DDS_FLAGS_NONE, metadata)))
+        return false;
+
+    if (metadata.dimension != TEX_DIMENSION_TEXTURE2D || metadata.arraySize != 1 || metadata.IsCubemap() ||
+        metadata.mipLevels < 2 || !IsValidTopMip(metadata, 0))
+    {
+        return false;
+    }
+
+    uint32_t pixelFormatFlags = 0;
+    uint32_t fourCC = 0;
+    memcpy(&pixelFormatFlags, data + DDS_PIXEL_FORMAT_FLAGS_OFFSET, sizeof(uint32_t));
+    memcpy(&fourCC, data + DDS_FOURCC_OFFSET, sizeof(uint32_t));
+    bool hasDXT10Header = (pixelFormatFlags & DDS_PIXEL_FORMAT_FOURCC) && fourCC == MAKEFOURCC('D', 'X', '1', '0');
+
+    // An uncompressed format in a legacy header may need a conversion (e.g. 24 bit RGB), the mips can't be used as stored.
+    if (!hasDXT10Header && !IsCompressed(metadata.format))
+        return false;
+
+    size_t offset = DDS_HEADER_SIZE + (hasDXT10Header ? DDS_HEADER_DXT10_SIZE : 0);
+    layout.Offsets.resize(metadata.mipLevels);
+    layout.RowPitches.resize(metadata.mipLevels);
+    layout.SlicePitches.resize(metadata.mipLevels);
+    for (size_t mip = 0; mip < metadata.mipLevels; ++mip)
+    {
+        size_t rowPitch = 0;
+        size_t slicePitch = 0;
+        if (FAILED(ComputePitch(metadata.format, std::max<size_t>(1, metadata.width >> mip), std::max<size_t>(1, metadata.height >> mip), rowPitch, slicePitch)))
+            return false;
+
+        layout.Offsets[mip] = offset;
+        layout.RowPitches[mip] = rowPitch;
+        layout.SlicePitches[mip] = slicePitch;
+        offset += slicePitch;
+    }
+
+    // The mips are read in place, a file with anything else than the one image is loaded whole.
+    return offset == size;
+}
+
+bool TextureStreamer::IsValidTopMip(const DirectX::TexMetadata& metadata, uint32_t mip)
+{
+    if (!IsCompressed(metadata.format))
+        return true;
+
+    const size_t width = metadata.width >> mip;
+    const size_t height = metadata.height >> mip;
+    return width > 0 && height > 0 && width % 4 == 0 && height % 4 == 0;
+}
+
+size_t TextureStreamer::GetSize(const StreamedTexture& texture, uint32_t topMip)
+{
+    size_t size = 0;
+    for (size_t mip = topMip; mip < texture.Layout.SlicePitches.size(); ++mip)
+        size += texture.Layout.SlicePitches[mip];
+    return size;
+}
+
+size_t TextureStreamer::SetResidentMip(CommandList& commandList, StreamedTexture& texture, uint32_t mip)
+{
+    const TexMetadata& metadata = texture.Layout.Metadata;
+    const uint32_t mipCount = static_cast<uint32_t>(metadata.mipLevels) - mip;
+
+    auto textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(
+        metadata.format,
+        static_cast<UINT64>(std::max<size_t>(1, metadata.width >> mip)),
+        static_cast<UINT>(std::max<size_t>(1, metadata.height >> mip)),
+        1,
+        static_cast<UINT16>(mipCount));
+
+    auto device = GetApp().GetDevice();
+    Microsoft::WRL::ComPtr<ID3D12Resource> textureResource;
+    auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+
+    ThrowIfFailed(device->CreateCommittedResource(
+        &heapProp,
+        D3D12_HEAP_FLAG_NONE,
+        &textureDesc,
+        D3D12_RESOURCE_STATE_COMMON,
+        nullptr,
+        IID_PPV_ARGS(&textureResource)));
+
+    ResourceStateTracker::AddGlobalResourceState(textureResource.Get(), D3D12_RESOURCE_STATE_COMMON);
+
+    Texture resident(textureResource, texture.Usage, texture.FileName);
+
+    // The upload copies the levels out of the mapped file while recording, the pages are read from the disk here.
+    std::vector<D3D12_SUBRESOURCE_DATA> subresources(mipCount);
+    for (uint32_t i = 0; i < mipCount; ++i)
+    {
+        auto& subresource = subresources[i];
+        subresource.pData = texture.File.GetData() + texture.Layout.Offsets[mip + i];
+        subresource.RowPitch = texture.Layout.RowPitches[mip + i];
+        subresource.SlicePitch = texture.Layout.SlicePitches[mip + i];
+    }
+
+    commandList.CopyTextureSubresource(resident, 0, mipCount, subresources.data());
+
+    if (mip < texture.ResidentMip)
+        m_LoadedMips += texture.ResidentMip - mip;
+    else
+        m_EvictedMips += mip - texture.ResidentMip;
+
+    const size_t size = GetSize(texture, mip);
+    m_ResidentBytes = m_ResidentBytes - GetSize(texture, texture.ResidentMip) + size;
+    texture.ResidentMip = mip;
+    texture.Resident = resident;
+
+    if (texture.Callback)
+        texture.Callback(texture.Resident);
+
+    return size;
+}
@@ -0,0 +1,75 @@
+#include <ThreadPool.h>
+
+#include <DX12LibPCH.h>
+
+using namespace dx12demo::core;
+
+ThreadPool::ThreadPool(uint32_t threadCount/* = 0*/)
+{
+    if (threadCount == 0)
+    {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    m_Threads.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+        m_Threads.emplace_back(&ThreadPool::WorkerThread, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    for (size_t i = 0; i < m_Threads.size(); ++i)
+        m_Tasks.Push(Task());
+
+    for (auto& thread : m_Threads)
+        thread.join();
+}
+
+ThreadPool& ThreadPool::Get()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::Submit(Task task)
+{
+    assert(task);
+    m_Tasks.Push(std::move(task));
+}
+
+uint32_t ThreadPool::GetThreadCount() const
+{
+    return static_cast<uint32_t>(m_Threads.size());
+}
+
+void ThreadPool::WorkerThread()
+{
+    while (true)
+    {
+        Task task;
+        m_Tasks.WaitAndPop(task);
+
+        if (!task)
+            break;
+
+        task();
+    }
+}
+
+bool ThreadPool::RunPendingTask()
+{
+    Task task;
+    if (!m_Tasks.TryPop(task))
+        return false;
+
+    // A stop request is not ours to consume, give it back to the workers.
+    if (!task)
+    {
+        m_Tasks.Push(Task());
+        return false;
+    }
+
+    task();
+    return true;
+}
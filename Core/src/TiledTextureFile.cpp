@@ -0,0 +1,250 @@
+#include <TiledTextureFile.h>
+
+#include <DX12LibPCH.h>
+
+#include <MipGenerator.h>
+#include <ThreadPool.h>
+
+#include <fstream>
+
+using namespace dx12demo::core;
+using namespace DirectX;
+
+namespace
+{
+    // One row of a tile from the source row, the texels left and right of the image repeat its edge.
+    void CopyTileRow(const uint8_t* sourceRow, size_t sourceWidth, int64_t firstX, size_t tileSize, size_t bytesPerTexel, uint8_t* tileRow)
+    {
+        const int64_t lastX = static_cast<int64_t>(sourceWidth) - 1;
+        const int64_t insideBegin = std::clamp<int64_t>(-firstX, 0, static_cast<int64_t>(tileSize));
+        const int64_t insideEnd = std::clamp<int64_t>(lastX + 1 - firstX, insideBegin, static_cast<int64_t>(tileSize));
+
+        for (int64_t x = 0; x < insideBegin; ++x)
+            memcpy(tileRow + x * bytesPerTexel, sourceRow, bytesPerTexel);
+
+        memcpy(tileRow + insideBegin * bytesPerTexel, sourceRow + (firstX + insideBegin) * bytesPerTexel, (insideEnd - insideBegin) * bytesPerTexel);
+
+        for (int64_t x = insideEnd; x < static_cast<int64_t>(tileSize); ++x)
+            memcpy(tileRow + x * bytesPerTexel, sourceRow + lastX * bytesPerTexel, bytesPerTexel);
+    }
+}
+
+TiledTextureFile::TiledTextureFile()
+{
+}
+
+TiledTextureFile::~TiledTextureFile()
+{
+}
+
+bool TiledTextureFile::Write(const std::wstring& fileName, const DirectX::ScratchImage& source, uint32_t pageSize/* = DEFAULT_PAGE_SIZE*/, uint32_t border/* = DEFAULT_BORDER*/)
+{
+    const TexMetadata& metadata = source.GetMetadata();
+    if (metadata.dimension != TEX_DIMENSION_TEXTURE2D || metadata.arraySize != 1 || metadata.IsCubemap() ||
+        IsCompressed(metadata.format) || IsPlanar(metadata.format) || IsPalettized(metadata.format) || BitsPerPixel(metadata.format) % 8 != 0)
+    {
+        return false;
+    }
+
+    if (pageSize == 0 || border > pageSize || metadata.width != metadata.height || metadata.width % pageSize != 0)
+        return false;
+
+    const uint32_t pages = static_cast<uint32_t>(metadata.width / pageSize);
+    if ((pages & (pages - 1)) != 0 || pages > VirtualPageId::MAX_PAGES)
+        return false;
+
+    uint32_t mipCount = 1;
+    while ((pages >> (mipCount - 1)) > 1)
+        ++mipCount;
+
+    const ScratchImage* mipChain = &source;
+    ScratchImage generated;
+    if (metadata.mipLevels < mipCount)
+    {
+        if (MipGenerator::CanGenerate(metadata))
+            MipGenerator::Generate(source, MipFilter::Box, generated);
+        else if (FAILED(GenerateMipMaps(*source.GetImage(0, 0, 0), TEX_FILTER_DEFAULT, 0, generated)))
+            return false;
+
+        mipChain = &generated;
+    }
+
+    Header header;
+    header.Magic = MAGIC;
+    header.Version = VERSION;
+    header.Format = static_cast<uint32_t>(metadata.format);
+    header.PageSize = pageSize;
+    header.Border = border;
+    header.PagesX = pages;
+    header.PagesY = pages;
+    header.MipCount = mipCount;
+
+    const size_t bytesPerTexel = BitsPerPixel(metadata.format) / 8;
+    const size_t tileSize = pageSize + 2 * border;
+    const size_t tileRowPitch = tileSize * bytesPerTexel;
+    header.TileBytes = tileRowPitch * tileSize;
+
+    const std::wstring tempPath = fileName + L".tmp";
+    {
+        std::ofstream stream(fs::path(tempPath), std::ios::binary | std::ios::trunc);
+        if (!stream)
+            return false;
+
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        // A row of pages at a time, its tiles are filled in parallel.
+        std::vector<uint8_t> tileRow;
+        for (uint32_t mip = 0; mip < mipCount && stream; ++mip)
+        {
+            const Image& image = *mipChain->GetImage(mip, 0, 0);
+            const uint32_t mipPages = pages >> mip;
+            tileRow.resize(mipPages * header.TileBytes);
+
+            for (uint32_t pageY = 0; pageY < mipPages && stream; ++pageY)
+            {
+                ThreadPool::Get().ParallelFor(mipPages, [&](size_t pageX)
+                {
+                    uint8_t* tile = tileRow.data() + pageX * header.TileBytes;
+                    const int64_t firstX = static_cast<int64_t>(pageX) * pageSize - border;
+                    const int64_t firstY = static_cast<int64_t>(pageY) * pageSize - border;
+
+                    for (size_t y = 0; y < tileSize; ++y)
+                    {
+                        const int64_t sourceY = std::clamp<int64_t>(firstY + static_cast<int64_t>(y), 0, static_cast<int64_t>(image.height) - 1);
+                        CopyTileRow(image.pixels + sourceY * image.rowPitch, image.width, firstX, tileSize, bytesPerTexel, tile + y * tileRowPitch);
+                    }
+                });
+
+                stream.write(reinterpret_cast<const char*>(tileRow.data()), tileRow.size());
+            }
+        }
+
+        if (!stream)
+            return false;
+    }
+
+    std::error_code error;
+    fs::rename(tempPath, fileName, error);
+    if (error)
+    {
+        fs::remove(tempPath, error);
+        return false;
+    }
+
+    return true;
+}
+
+bool TiledTextureFile::Open(const std::wstring& fileName)
+{
+    Close();
+
+    if (!m_File.Open(fileName) || m_File.GetSize() < sizeof(Header))
+    {
+        Close();
+        return false;
+    }
+
+    Header header;
+    memcpy(&header, m_File.GetData(), sizeof(Header));
+
+    const DXGI_FORMAT format = static_cast<DXGI_FORMAT>(header.Format);
+    // Square and a power of two pages, as Write makes it: the mips halve the page grid exactly down to one page.
+    const bool validHeader = header.Magic == MAGIC && header.Version == VERSION && header.PageSize > 0 &&
+        header.PagesX == header.PagesY && header.PagesX <= VirtualPageId::MAX_PAGES &&
+        header.MipCount > 0 && header.MipCount <= VirtualPageId::MAX_MIPS && (1u << (header.MipCount - 1)) == header.PagesX &&
+        !IsCompressed(format) && BitsPerPixel(format) % 8 == 0 &&
+        header.TileBytes == static_cast<uint64_t>(header.PageSize + 2 * header.Border) * (header.PageSize + 2 * header.Border) * (BitsPerPixel(format) / 8);
+    if (!validHeader)
+    {
+        Close();
+        return false;
+    }
+
+    m_Header = header;
+    m_MipTiles.resize(header.MipCount);
+    size_t tileCount = 0;
+    for (uint32_t mip = 0; mip < header.MipCount; ++mip)
+    {
+        m_MipTiles[mip] = tileCount;
+        tileCount += static_cast<size_t>(header.PagesX >> mip) * (header.PagesY >> mip);
+    }
+
+    if (m_File.GetSize() != sizeof(Header) + tileCount * header.TileBytes)
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void TiledTextureFile::Close()
+{
+    m_File.Close();
+    m_Header = Header();
+    m_MipTiles.clear();
+}
+
+bool TiledTextureFile::IsOpen() const
+{
+    return m_File.IsOpen();
+}
+
+DXGI_FORMAT TiledTextureFile::GetFormat() const
+{
+    return static_cast<DXGI_FORMAT>(m_Header.Format);
+}
+
+uint32_t TiledTextureFile::GetPageSize() const
+{
+    return m_Header.PageSize;
+}
+
+uint32_t TiledTextureFile::GetBorder() const
+{
+    return m_Header.Border;
+}
+
+uint32_t TiledTextureFile::GetTileSize() const
+{
+    return m_Header.PageSize + 2 * m_Header.Border;
+}
+
+size_t TiledTextureFile::GetTileRowPitch() const
+{
+    return GetTileSize() * (BitsPerPixel(GetFormat()) / 8);
+}
+
+size_t TiledTextureFile::GetTileBytes() const
+{
+    return static_cast<size_t>(m_Header.TileBytes);
+}
+
+uint32_t TiledTextureFile::GetPagesX() const
+{
+    return m_Header.PagesX;
+}
+
+uint32_t TiledTextureFile::GetPagesY() const
+{
+    return m_Header.PagesY;
+}
+
+uint32_t TiledTextureFile::GetMipCount() const
+{
+    return m_Header.MipCount;
+}
+
+const uint8_t* TiledTextureFile::GetTile(const VirtualPageId& page) const
+{
+    if (!IsOpen() || page.Mip >= m_Header.MipCount)
+        return nullptr;
+
+    const uint32_t pagesX = m_Header.PagesX >> page.Mip;
+    const uint32_t pagesY = m_Header.PagesY >> page.Mip;
+    if (page.X >= pagesX || page.Y >= pagesY)
+        return nullptr;
+
+    const size_t tile = m_MipTiles[page.Mip] + static_cast<size_t>(page.Y) * pagesX + page.X;
+    return m_File.GetData() + sizeof(Header) + tile * m_Header.TileBytes;
+}
@@ -0,0 +1,320 @@
+#include <TransformHierarchy.h>
+
+#include <DX12LibPCH.h>
+
+#include <ThreadPool.h>
+
+using namespace dx12demo::core;
+
+namespace
+{
+    // Smaller hierarchies are updated on the calling thread, a job costs more than this many matrix products.
+    const uint32_t MIN_JOB_SIZE = 2048;
+}
+
+TransformHierarchy::TransformHierarchy()
+{
+
+}
+
+TransformHierarchy::~TransformHierarchy()
+{
+
+}
+
+void TransformHierarchy::Reserve(size_t nodeCount)
+{
+    m_Local.reserve(nodeCount);
+    m_World.reserve(nodeCount);
+    m_ParentSlot.reserve(nodeCount);
+    m_LocalDirty.reserve(nodeCount);
+    m_WorldChanged.reserve(nodeCount);
+    m_SubtreeEnd.reserve(nodeCount);
+    m_NodeOfSlot.reserve(nodeCount);
+
+    m_SlotOfNode.reserve(nodeCount);
+    m_Parent.reserve(nodeCount);
+    m_FirstChild.reserve(nodeCount);
+    m_LastChild.reserve(nodeCount);
+    m_NextSibling.reserve(nodeCount);
+    m_Names.reserve(nodeCount);
+}
+
+TransformHierarchy::NodeId TransformHierarchy::AddNode(NodeId parent, const DirectX::XMMATRIX& localTransform/* = DirectX::XMMatrixIdentity()*/, const std::string& name/* = ""*/)
+{
+    assert(parent == INVALID_NODE || parent < m_Parent.size());
+
+    NodeId node = static_cast<NodeId>(m_Parent.size());
+
+    m_Parent.push_back(parent);
+    m_FirstChild.push_back(INVALID_NODE);
+    m_LastChild.push_back(INVALID_NODE);
+    m_NextSibling.push_back(INVALID_NODE);
+    m_Names.push_back(name);
+
+    if (parent != INVALID_NODE)
+    {
+        if (m_LastChild[parent] == INVALID_NODE)
+            m_FirstChild[parent] = node;
+        else
+            m_NextSibling[m_LastChild[parent]] = node;
+        m_LastChild[parent] = node;
+    }
+
+    if (!name.empty())
+        m_NodesByName.try_emplace(name, node);
+
+    // Appended for now, RebuildOrder moves it after its parent.
+    uint32_t slot = static_cast<uint32_t>(m_Local.size());
+    m_SlotOfNode.push_back(slot);
+    m_NodeOfSlot.push_back(node);
+    m_ParentSlot.push_back(INVALID_SLOT);
+    m_SubtreeEnd.push_back(slot + 1);
+
+    DirectX::XMFLOAT4X4 local;
+    DirectX::XMStoreFloat4x4(&local, localTransform);
+    m_Local.push_back(local);
+    m_World.push_back(local);
+    m_LocalDirty.push_back(1);
+    m_WorldChanged.push_back(0);
+
+    m_OrderValid = false;
+    m_AnyDirty = true;
+
+    return node;
+}
+
+void TransformHierarchy::SetParent(NodeId node, NodeId parent)
+{
+    assert(node < m_Parent.size());
+    assert(parent == INVALID_NODE || parent < m_Parent.size());
+
+    if (m_Parent[node] == parent)
+        return;
+
+#if defined(_DEBUG)
+    for (NodeId ancestor = parent; ancestor != INVALID_NODE; ancestor = m_Parent[ancestor])
+        assert(ancestor != node && "The new parent is in the subtree of the node.");
+#endif
+
+    NodeId oldParent = m_Parent[node];
+    if (oldParent != INVALID_NODE)
+    {
+        NodeId previous = INVALID_NODE;
+        for (NodeId child = m_FirstChild[oldParent]; child != node; child = m_NextSibling[child])
+            previous = child;
+
+        if (previous == INVALID_NODE)
+            m_FirstChild[oldParent] = m_NextSibling[node];
+        else
+            m_NextSibling[previous] = m_NextSibling[node];
+
+        if (m_LastChild[oldParent] == node)
+            m_LastChild[oldParent] = previous;
+    }
+
+    m_Parent[node] = parent;
+    m_NextSibling[node] = INVALID_NODE;
+    if (parent != INVALID_NODE)
+    {
+        if (m_LastChild[parent] == INVALID_NODE)
+            m_FirstChild[parent] = node;
+        else
+            m_NextSibling[m_LastChild[parent]] = node;
+        m_LastChild[parent] = node;
+    }
+
+    // The world transform of the whole subtree changes.
+    m_LocalDirty[m_SlotOfNode[node]] = 1;
+    m_OrderValid = false;
+    m_AnyDirty = true;
+}
+
+TransformHierarchy::NodeId TransformHierarchy::GetParent(NodeId node) const
+{
+    return m_Parent[node];
+}
+
+void TransformHierarchy::SetLocalTransform(NodeId node, const DirectX::XMMATRIX& localTransform)
+{
+    uint32_t slot = m_SlotOfNode[node];
+    DirectX::XMStoreFloat4x4(&m_Local[slot], localTransform);
+    m_LocalDirty[slot] = 1;
+    m_AnyDirty = true;
+}
+
+DirectX::XMMATRIX TransformHierarchy::GetLocalTransform(NodeId node) const
+{
+    return DirectX::XMLoadFloat4x4(&m_Local[m_SlotOfNode[node]]);
+}
+
+DirectX::XMMATRIX TransformHierarchy::GetWorldTransform(NodeId node) const
+{
+    return DirectX::XMLoadFloat4x4(&m_World[m_SlotOfNode[node]]);
+}
+
+TransformHierarchy::NodeId TransformHierarchy::FindNode(const std::string& name) const
+{
+    auto iter = m_NodesByName.find(name);
+    return iter != m_NodesByName.end() ? iter->second : INVALID_NODE;
+}
+
+const std::string& TransformHierarchy::GetName(NodeId node) const
+{
+    return m_Names[node];
+}
+
+size_t TransformHierarchy::GetNodeCount() const
+{
+    return m_Parent.size();
+}
+
+size_t TransformHierarchy::GetUpdatedNodeCount() const
+{
+    return m_UpdatedNodeCount;
+}
+
+void TransformHierarchy::Update()
+{
+    m_UpdatedNodeCount = 0;
+    if (!m_AnyDirty)
+        return;
+
+    if (!m_OrderValid)
+        RebuildOrder();
+
+    m_UpdateIndex++;
+    // 0 marks the nodes never changed, skip it on the wrap around.
+    if (m_UpdateIndex == 0)
+    {
+        std::fill(m_WorldChanged.begin(), m_WorldChanged.end(), 0);
+        m_UpdateIndex = 1;
+    }
+
+    size_t updated = 0;
+    for (uint32_t slot : m_SerialSlots)
+        updated += UpdateRange(slot, slot + 1);
+
+    std::atomic<size_t> jobsUpdated = 0;
+    ThreadPool::Get().ParallelFor(m_JobRanges.size(), [this, &jobsUpdated](size_t i)
+    {
+        jobsUpdated += UpdateRange(m_JobRanges[i].first, m_JobRanges[i].second);
+    });
+
+    m_UpdatedNodeCount = updated + jobsUpdated;
+    m_AnyDirty = false;
+}
+
+size_t TransformHierarchy::UpdateRange(uint32_t begin, uint32_t end)
+{
+    size_t updated = 0;
+    for (uint32_t slot = begin; slot < end; ++slot)
+    {
+        uint32_t parent = m_ParentSlot[slot];
+        bool parentChanged = parent != INVALID_SLOT && m_WorldChanged[parent] == m_UpdateIndex;
+        if (!m_LocalDirty[slot] && !parentChanged)
+            continue;
+
+        DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&m_Local[slot]);
+        if (parent != INVALID_SLOT)
+            world = DirectX::XMMatrixMultiply(world, DirectX::XMLoadFloat4x4(&m_World[parent]));
+
+        DirectX::XMStoreFloat4x4(&m_World[slot], world);
+        m_LocalDirty[slot] = 0;
+        m_WorldChanged[slot] = m_UpdateIndex;
+        updated++;
+    }
+
+    return updated;
+}
+
+void TransformHierarchy::RebuildOrder()
+{
+    const uint32_t count = static_cast<uint32_t>(m_Parent.size());
+
+    // Preorder walk, the children in the order they were added.
+    std::vector<NodeId> order;
+    order.reserve(count);
+    std::vector<NodeId> stack;
+    for (NodeId root = 0; root < count; ++root)
+    {
+        if (m_Parent[root] != INVALID_NODE)
+            continue;
+
+        stack.push_back(root);
+        while (!stack.empty())
+        {
+            NodeId node = stack.back();
+            stack.pop_back();
+            order.push_back(node);
+
+            // Pushed in reverse, the first child is visited first.
+            size_t firstPushed = stack.size();
+            for (NodeId child = m_FirstChild[node]; child != INVALID_NODE; child = m_NextSibling[child])
+                stack.push_back(child);
+            std::reverse(stack.begin() + firstPushed, stack.end());
+        }
+    }
+    assert(order.size() == count);
+
+    std::vector<DirectX::XMFLOAT4X4> local(count), world(count);
+    std::vector<uint8_t> localDirty(count);
+    std::vector<uint32_t> worldChanged(count);
+    for (uint32_t slot = 0; slot < count; ++slot)
+    {
+        uint32_t oldSlot = m_SlotOfNode[order[slot]];
+        local[slot] = m_Local[oldSlot];
+        world[slot] = m_World[oldSlot];
+        localDirty[slot] = m_LocalDirty[oldSlot];
+        worldChanged[slot] = m_WorldChanged[oldSlot];
+    }
+
+    m_Local.swap(local);
+    m_World.swap(world);
+    m_LocalDirty.swap(localDirty);
+    m_WorldChanged.swap(worldChanged);
+    m_NodeOfSlot.swap(order);
+
+    for (uint32_t slot = 0; slot < count; ++slot)
+        m_SlotOfNode[m_NodeOfSlot[slot]] = slot;
+
+    for (uint32_t slot = 0; slot < count; ++slot)
+    {
+        NodeId parent = m_Parent[m_NodeOfSlot[slot]];
+        m_ParentSlot[slot] = parent != INVALID_NODE ? m_SlotOfNode[parent] : INVALID_SLOT;
+        m_SubtreeEnd[slot] = slot + 1;
+    }
+
+    // Children follow their parent, the reverse walk extends every parent range by the ranges of its children.
+    for (uint32_t slot = count; slot-- > 0;)
+    {
+        uint32_t parent = m_ParentSlot[slot];
+        if (parent != INVALID_SLOT)
+            m_SubtreeEnd[parent] = std::max(m_SubtreeEnd[parent], m_SubtreeEnd[slot]);
+    }
+
+    // The subtrees small enough for a job are updated in parallel, the nodes above them (a few) first on the calling thread.
+    // Adjacent small subtrees (siblings, or roots) share a job.
+    m_SerialSlots.clear();
+    m_JobRanges.clear();
+    const uint32_t jobSize = std::max(MIN_JOB_SIZE, count / ((ThreadPool::Get().GetThreadCount() + 1) * 4));
+    for (uint32_t slot = 0; slot < count;)
+    {
+        if (m_SubtreeEnd[slot] - slot <= jobSize)
+        {
+            if (!m_JobRanges.empty() && m_JobRanges.back().second == slot && m_SubtreeEnd[slot] - m_JobRanges.back().first <= jobSize)
+                m_JobRanges.back().second = m_SubtreeEnd[slot];
+            else
+                m_JobRanges.emplace_back(slot, m_SubtreeEnd[slot]);
+
+            slot = m_SubtreeEnd[slot];
+        }
+        else
+        {
+            m_SerialSlots.push_back(slot);
+            slot++;
+        }
+    }
+
+    m_OrderValid = true;
+}
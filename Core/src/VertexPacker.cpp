@@ -0,0 +1,153 @@
+#include <VertexPacker.h>
+
+#include <DX12LibPCH.h>
+
+#include <DirectXPackedVector.h>
+
+using namespace dx12demo::core;
+
+namespace
+{
+    int16_t PackSnorm16(float value)
+    {
+        value = std::clamp(value, -1.f, 1.f);
+        return static_cast<int16_t>(roundf(value * 32767.f));
+    }
+
+    float UnpackSnorm16(int16_t value)
+    {
+        return std::max(static_cast<float>(value) / 32767.f, -1.f);
+    }
+
+    uint16_t PackUnorm16(float value)
+    {
+        value = std::clamp(value, 0.f, 1.f);
+        return static_cast<uint16_t>(roundf(value * 65535.f));
+    }
+
+    float UnpackUnorm16(uint16_t value)
+    {
+        return static_cast<float>(value) / 65535.f;
+    }
+
+    float SignNotZero(float value)
+    {
+        return value >= 0.f ? 1.f : -1.f;
+    }
+}
+
+DirectX::XMFLOAT2 VertexPacker::OctahedralEncode(const DirectX::XMFLOAT3& n)
+{
+    float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+    if (l1 <= 0.f)
+        return { 0.f, 0.f };
+
+    DirectX::XMFLOAT2 e = { n.x / l1, n.y / l1 };
+
+    // Fold the lower hemisphere over the diagonals.
+    if (n.z < 0.f)
+    {
+        float x = (1.f - fabsf(e.y)) * SignNotZero(e.x);
+        float y = (1.f - fabsf(e.x)) * SignNotZero(e.y);
+        e = { x, y };
+    }
+
+    return e;
+}
+
+DirectX::XMFLOAT3 VertexPacker::OctahedralDecode(const DirectX::XMFLOAT2& e)
+{
+    DirectX::XMFLOAT3 n = { e.x, e.y, 1.f - fabsf(e.x) - fabsf(e.y) };
+
+    if (n.z < 0.f)
+    {
+        float x = (1.f - fabsf(n.y)) * SignNotZero(n.x);
+        float y = (1.f - fabsf(n.x)) * SignNotZero(n.y);
+        n.x = x;
+        n.y = y;
+    }
+
+    Math::float3Normalized(n);
+
+    return n;
+}
+
+PackedVertex VertexPacker::Pack(const PosNormTexExtendedVertex& vertex, const BAABB& bounds)
+{
+    PackedVertex packed;
+
+    const float* position = &vertex.m_position.x;
+    const float* boxMin = &bounds.box_min.x;
+    const float* boxMax = &bounds.box_max.x;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        float extent = boxMax[i] - boxMin[i];
+        float t = extent > 0.f ? (position[i] - boxMin[i]) / extent : 0.f;
+        packed.m_position[i] = PackUnorm16(t);
+    }
+
+    // Handedness of the tangent frame, the bitangent is restored as cross(normal, tangent) * sign.
+    DirectX::XMFLOAT3 bitangent = Math::float3Cross(vertex.m_normal, vertex.m_tangent);
+    float sign = Math::float3Dot(bitangent, vertex.m_bitangent) < 0.f ? -1.f : 1.f;
+    packed.m_position[3] = sign > 0.f ? 65535 : 0;
+
+    DirectX::XMFLOAT2 normal = OctahedralEncode(vertex.m_normal);
+    packed.m_normal[0] = PackSnorm16(normal.x);
+    packed.m_normal[1] = PackSnorm16(normal.y);
+
+    DirectX::XMFLOAT2 tangent = OctahedralEncode(vertex.m_tangent);
+    packed.m_tangent[0] = PackSnorm16(tangent.x);
+    packed.m_tangent[1] = PackSnorm16(tangent.y);
+
+    packed.m_texCoord[0] = DirectX::PackedVector::XMConvertFloatToHalf(vertex.m_texCoord.x);
+    packed.m_texCoord[1] = DirectX::PackedVector::XMConvertFloatToHalf(vertex.m_texCoord.y);
+
+    return packed;
+}
+
+PosNormTexExtendedVertex VertexPacker::Unpack(const PackedVertex& vertex, const BAABB& bounds)
+{
+    DirectX::XMFLOAT3 scale, bias;
+    GetDequantization(bounds, scale, bias);
+
+    DirectX::XMFLOAT3 position = {
+        UnpackUnorm16(vertex.m_position[0]) * scale.x + bias.x,
+        UnpackUnorm16(vertex.m_position[1]) * scale.y + bias.y,
+        UnpackUnorm16(vertex.m_position[2]) * scale.z + bias.z };
+
+    DirectX::XMFLOAT3 normal = OctahedralDecode({ UnpackSnorm16(vertex.m_normal[0]), UnpackSnorm16(vertex.m_normal[1]) });
+    DirectX::XMFLOAT3 tangent = OctahedralDecode({ UnpackSnorm16(vertex.m_tangent[0]), UnpackSnorm16(vertex.m_tangent[1]) });
+
+    DirectX::XMFLOAT3 bitangent = Math::float3Cross(normal, tangent);
+    if (vertex.m_position[3] < 32768)
+        Math::float3Mult(bitangent, -1.f);
+
+    DirectX::XMFLOAT2 texCoord = {
+        DirectX::PackedVector::XMConvertHalfToFloat(vertex.m_texCoord[0]),
+        DirectX::PackedVector::XMConvertHalfToFloat(vertex.m_texCoord[1]) };
+
+    return PosNormTexExtendedVertex(position, normal, texCoord, tangent, bitangent);
+}
+
+BAABB VertexPacker::Pack(const VertexExtendedCollection& vertices, PackedVertexCollection& packedVertices)
+{
+    CollectorBVData collectorBVData;
+    for (const auto& vertex : vertices)
+        collectorBVData.Collect(vertex.m_position);
+
+    BAABB bounds;
+    bounds.box_min = collectorBVData.GetMin();
+    bounds.box_max = collectorBVData.GetMax();
+
+    packedVertices.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+        packedVertices[i] = Pack(vertices[i], bounds);
+
+    return bounds;
+}
+
+void VertexPacker::GetDequantization(const BAABB& bounds, DirectX::XMFLOAT3& scale, DirectX::XMFLOAT3& bias)
+{
+    scale = Math::float3Substruct(bounds.box_max, bounds.box_min);
+    bias = bounds.box_min;
+}
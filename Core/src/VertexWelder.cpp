@@ -0,0 +1,44 @@
+#include <VertexWelder.h>
+
+#include <DX12LibPCH.h>
+
+using namespace dx12demo::core;
+
+bool VertexWelder::IsEqual(const PosNormTexVertex& a, const PosNormTexVertex& b, const VertexWeldOptions& options)
+{
+    return IsEqual(a.m_position, b.m_position, options.PositionEpsilon) &&
+        IsEqual(a.m_normal, b.m_normal, options.NormalEpsilon) &&
+        IsEqual(a.m_texCoord, b.m_texCoord, options.TexCoordEpsilon);
+}
+
+bool VertexWelder::IsEqual(const PosNormTexExtendedVertex& a, const PosNormTexExtendedVertex& b, const VertexWeldOptions& options)
+{
+    return IsEqual(a.m_position, b.m_position, options.PositionEpsilon) &&
+        IsEqual(a.m_normal, b.m_normal, options.NormalEpsilon) &&
+        IsEqual(a.m_texCoord, b.m_texCoord, options.TexCoordEpsilon) &&
+        IsEqual(a.m_tangent, b.m_tangent, options.NormalEpsilon) &&
+        IsEqual(a.m_bitangent, b.m_bitangent, options.NormalEpsilon);
+}
+
+bool VertexWelder::IsEqual(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b, float epsilon)
+{
+    return fabsf(a.x - b.x) <= epsilon && fabsf(a.y - b.y) <= epsilon && fabsf(a.z - b.z) <= epsilon;
+}
+
+bool VertexWelder::IsEqual(const DirectX::XMFLOAT2& a, const DirectX::XMFLOAT2& b, float epsilon)
+{
+    return fabsf(a.x - b.x) <= epsilon && fabsf(a.y - b.y) <= epsilon;
+}
+
+void VertexWelder::GetCell(const DirectX::XMFLOAT3& position, float cellSize, int64_t cell[3])
+{
+    cell[0] = static_cast<int64_t>(floor(static_cast<double>(position.x) / cellSize));
+    cell[1] = static_cast<int64_t>(floor(static_cast<double>(position.y) / cellSize));
+    cell[2] = static_cast<int64_t>(floor(static_cast<double>(position.z) / cellSize));
+}
+
+uint64_t VertexWelder::HashCell(int64_t x, int64_t y, int64_t z)
+{
+    // Teschner et al., "Optimized Spatial Hashing for Collision Detection of Deformable Objects".
+    return static_cast<uint64_t>(x) * 73856093ull ^ static_cast<uint64_t>(y) * 19349663ull ^ static_cast<uint64_t>(z) * 83492791ull;
+}
@@ -0,0 +1,70 @@
+#include <VirtualTextureFeedback.h>
+
+#include <DX12LibPCH.h>
+
+#include <ThreadPool.h>
+
+using namespace dx12demo::core;
+
+namespace
+{
+    // Feedback texels counted per job.
+    const size_t CHUNK_SIZE = 16 * 1024;
+
+    // Bits of VirtualPageId::Pack(), the shader may use the others.
+    const uint32_t PAGE_BITS = 0x0fffffff;
+}
+
+std::vector<VirtualPageRequest> VirtualTextureFeedback::Analyze(const uint32_t* feedback, size_t count, const VirtualTexturePageTable& pageTable)
+{
+    const size_t chunkCount = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::vector<std::unordered_map<uint32_t, uint32_t>> chunkCounts(chunkCount);
+
+    ThreadPool::Get().ParallelFor(chunkCount, [&](size_t chunk)
+    {
+        auto& counts = chunkCounts[chunk];
+        const uint32_t* data = feedback + chunk * CHUNK_SIZE;
+        const uint32_t* end = feedback + std::min(count, (chunk + 1) * CHUNK_SIZE);
+
+        while (data < end)
+        {
+            const uint32_t packed = *data;
+            const uint32_t* runEnd = data + 1;
+            while (runEnd < end && *runEnd == packed)
+                ++runEnd;
+
+            if (packed != VirtualPageId::INVALID)
+                counts[packed & PAGE_BITS] += static_cast<uint32_t>(runEnd - data);
+
+            data = runEnd;
+        }
+    });
+
+    std::unordered_map<uint32_t, uint32_t> totals;
+    for (const auto& counts : chunkCounts)
+    {
+        for (const auto& [packed, pageCount] : counts)
+            totals[packed] += pageCount;
+    }
+
+    std::vector<VirtualPageRequest> requests;
+    requests.reserve(totals.size());
+    for (const auto& [packed, pageCount] : totals)
+    {
+        VirtualPageId page = VirtualPageId::Unpack(packed);
+        if (pageTable.IsValid(page))
+            requests.push_back({ page, pageCount });
+    }
+
+    std::sort(requests.begin(), requests.end(), [](const VirtualPageRequest& a, const VirtualPageRequest& b)
+    {
+        if (a.Page.Mip != b.Page.Mip)
+            return a.Page.Mip > b.Page.Mip;
+        if (a.Count != b.Count)
+            return a.Count > b.Count;
+        // Deterministic order of the equal priorities.
+        return a.Page.Pack() < b.Page.Pack();
+    });
+
+    return requests;
+}
@@ -0,0 +1,159 @@
+#include <VirtualTextureLoader.h>
+
+#include <DX12LibPCH.h>
+
+#include <ThreadPool.h>
+
+using namespace dx12demo::core;
+
+VirtualTextureLoader::VirtualTextureLoader(uint32_t physicalPagesX, uint32_t physicalPagesY)
+    : m_PhysicalPagesX(physicalPagesX)
+    , m_PhysicalPagesY(physicalPagesY)
+{
+}
+
+VirtualTextureLoader::~VirtualTextureLoader()
+{
+    // The jobs read the mapped file and push to the queue.
+    WaitForLoads();
+}
+
+bool VirtualTextureLoader::Open(const std::wstring& fileName, UploadCallback upload)
+{
+    WaitForLoads();
+
+    std::shared_ptr<LoadedPage> loaded;
+    while (m_LoadedPages.TryPop(loaded))
+    {
+    }
+    m_PendingPages.clear();
+    m_PageTable.reset();
+
+    if (!m_File.Open(fileName))
+        return false;
+
+    m_Upload = std::move(upload);
+    m_PageTable = std::make_unique<VirtualTexturePageTable>(m_File.GetPagesX(), m_File.GetPagesY(), m_PhysicalPagesX, m_PhysicalPagesY);
+    assert(m_PageTable->GetMipCount() == m_File.GetMipCount());
+
+    // The fallback of every page, never evicted.
+    VirtualPageId lastPage = { 0, 0, m_PageTable->GetMipCount() - 1 };
+    uint32_t slot = m_PageTable->MapPage(lastPage, true);
+    if (m_Upload)
+        m_Upload(slot, lastPage, m_File.GetTile(lastPage));
+    m_LoadedCount++;
+
+    return true;
+}
+
+void VirtualTextureLoader::Update(const uint32_t* feedback, size_t count, size_t maxNewLoads/* = DEFAULT_MAX_LOADS*/)
+{
+    assert(m_PageTable);
+
+    m_PageTable->BeginFrame();
+
+    auto requests = VirtualTextureFeedback::Analyze(feedback, count, *m_PageTable);
+    m_RequestedPages = requests.size();
+
+    // Before the new pages take slots, the ones this frame samples are marked as used.
+    for (const auto& request : requests)
+        m_PageTable->Touch(request.Page);
+
+    MapLoadedPages();
+
+    // A load without a slot to map it to would be dropped, and requested again.
+    const size_t availableSlots = m_PageTable->GetAvailableCount();
+    maxNewLoads = std::min(maxNewLoads, availableSlots > m_PendingPages.size() ? availableSlots - m_PendingPages.size() : 0);
+
+    size_t newLoads = 0;
+    for (const auto& request : requests)
+    {
+        if (newLoads == maxNewLoads)
+            break;
+
+        if (m_PageTable->IsResident(request.Page) || m_PendingPages.count(request.Page.Pack()))
+            continue;
+
+        StartLoad(request.Page);
+        newLoads++;
+    }
+}
+
+void VirtualTextureLoader::Flush()
+{
+    WaitForLoads();
+    MapLoadedPages();
+}
+
+VirtualTexturePageTable& VirtualTextureLoader::GetPageTable()
+{
+    assert(m_PageTable);
+    return *m_PageTable;
+}
+
+const TiledTextureFile& VirtualTextureLoader::GetFile() const
+{
+    return m_File;
+}
+
+VirtualTextureStatistics VirtualTextureLoader::GetStatistics() const
+{
+    VirtualTextureStatistics statistics;
+    statistics.RequestedPages = m_RequestedPages;
+    statistics.ResidentPages = m_PageTable ? m_PageTable->GetMappedCount() : 0;
+    statistics.PendingLoads = m_PendingPages.size();
+    statistics.LoadedPages = m_LoadedCount;
+    statistics.EvictedPages = m_EvictedCount;
+    statistics.DroppedPages = m_DroppedCount;
+    return statistics;
+}
+
+void VirtualTextureLoader::StartLoad(const VirtualPageId& page)
+{
+    m_PendingPages.insert(page.Pack());
+    m_LoadsInFlight++;
+
+    // The copy takes the page faults of the mapped file off the thread calling Update.
+    ThreadPool::Get().Submit([this, page]()
+    {
+        auto loaded = std::make_shared<LoadedPage>();
+        loaded->Page = page;
+
+        const uint8_t* tile = m_File.GetTile(page);
+        loaded->Tile.assign(tile, tile + m_File.GetTileBytes());
+
+        m_LoadedPages.Push(loaded);
+        m_LoadsInFlight--;
+    });
+}
+
+void VirtualTextureLoader::MapLoadedPages()
+{
+    std::shared_ptr<LoadedPage> loaded;
+    while (m_LoadedPages.TryPop(loaded))
+    {
+        m_PendingPages.erase(loaded->Page.Pack());
+
+        VirtualPageId evicted;
+        evicted.Mip = VirtualPageId::MAX_MIPS;
+        uint32_t slot = m_PageTable->MapPage(loaded->Page, false, &evicted);
+        if (slot == VirtualTexturePageTable::INVALID_SLOT)
+        {
+            m_DroppedCount++;
+            continue;
+        }
+
+        if (evicted.Mip != VirtualPageId::MAX_MIPS)
+            m_EvictedCount++;
+
+        if (m_Upload)
+            m_Upload(slot, loaded->Page, loaded->Tile.data());
+        m_LoadedCount++;
+    }
+}
+
+void VirtualTextureLoader::WaitForLoads()
+{
+    while (m_LoadsInFlight > 0)
+        std::this_thread::yield();
+}
@@ -0,0 +1,227 @@
+#include <VirtualTexturePageTable.h>
+
+#include <DX12LibPCH.h>
+
+using namespace dx12demo::core;
+
+VirtualTexturePageTable::VirtualTexturePageTable(uint32_t virtualPagesX, uint32_t virtualPagesY, uint32_t physicalPagesX, uint32_t physicalPagesY)
+    : m_PhysicalPagesX(physicalPagesX)
+{
+    assert(virtualPagesX > 0 && virtualPagesY > 0 && virtualPagesX <= VirtualPageId::MAX_PAGES && virtualPagesY <= VirtualPageId::MAX_PAGES);
+    assert(physicalPagesX > 0 && physicalPagesY > 0 && physicalPagesX <= 256 && physicalPagesY <= 256);
+
+    size_t offset = 0;
+    uint32_t pagesX = virtualPagesX;
+    uint32_t pagesY = virtualPagesY;
+    while (true)
+    {
+        m_PagesX.push_back(pagesX);
+        m_PagesY.push_back(pagesY);
+        m_MipOffsets.push_back(offset);
+        offset += static_cast<size_t>(pagesX) * pagesY;
+
+        if (pagesX == 1 && pagesY == 1)
+            break;
+
+        pagesX = (pagesX + 1) / 2;
+        pagesY = (pagesY + 1) / 2;
+    }
+    assert(m_PagesX.size() <= VirtualPageId::MAX_MIPS);
+
+    m_PageSlots.assign(offset, INVALID_SLOT);
+    m_Indirection.resize(m_PagesX.size());
+
+    m_Slots.resize(static_cast<size_t>(physicalPagesX) * physicalPagesY);
+    // Handed out from the back, slot 0 first.
+    for (uint32_t slot = static_cast<uint32_t>(m_Slots.size()); slot > 0; --slot)
+        m_FreeSlots.push_back(slot - 1);
+}
+
+VirtualTexturePageTable::~VirtualTexturePageTable()
+{
+}
+
+uint32_t VirtualTexturePageTable::GetMipCount() const
+{
+    return static_cast<uint32_t>(m_PagesX.size());
+}
+
+uint32_t VirtualTexturePageTable::GetPagesX(uint32_t mip) const
+{
+    return m_PagesX[mip];
+}
+
+uint32_t VirtualTexturePageTable::GetPagesY(uint32_t mip) const
+{
+    return m_PagesY[mip];
+}
+
+bool VirtualTexturePageTable::IsValid(const VirtualPageId& page) const
+{
+    return page.Mip < m_PagesX.size() && page.X < m_PagesX[page.Mip] && page.Y < m_PagesY[page.Mip];
+}
+
+uint32_t VirtualTexturePageTable::GetSlotCount() const
+{
+    return static_cast<uint32_t>(m_Slots.size());
+}
+
+uint32_t VirtualTexturePageTable::GetMappedCount() const
+{
+    return static_cast<uint32_t>(m_Slots.size() - m_FreeSlots.size());
+}
+
+uint32_t VirtualTexturePageTable::GetAvailableCount() const
+{
+    // The pages used by the frame are at the front of the LRU order.
+    uint32_t count = static_cast<uint32_t>(m_FreeSlots.size());
+    for (auto slot = m_LruOrder.rbegin(); slot != m_LruOrder.rend() && m_Slots[*slot].LastUsedFrame != m_Frame; ++slot)
+        count++;
+    return count;
+}
+
+void VirtualTexturePageTable::BeginFrame()
+{
+    m_Frame++;
+}
+
+bool VirtualTexturePageTable::IsResident(const VirtualPageId& page) const
+{
+    return GetSlot(page) != INVALID_SLOT;
+}
+
+uint32_t VirtualTexturePageTable::GetSlot(const VirtualPageId& page) const
+{
+    if (!IsValid(page))
+        return INVALID_SLOT;
+
+    return m_PageSlots[GetEntryIndex(page)];
+}
+
+void VirtualTexturePageTable::Touch(const VirtualPageId& page)
+{
+    uint32_t slotIndex = GetSlot(page);
+    if (slotIndex == INVALID_SLOT)
+        return;
+
+    Slot& slot = m_Slots[slotIndex];
+    slot.LastUsedFrame = m_Frame;
+    if (!slot.Pinned)
+        m_LruOrder.splice(m_LruOrder.begin(), m_LruOrder, slot.LruPosition);
+}
+
+uint32_t VirtualTexturePageTable::MapPage(const VirtualPageId& page, bool pinned/* = false*/, VirtualPageId* evicted/* = nullptr*/)
+{
+    assert(IsValid(page));
+
+    uint32_t slotIndex = GetSlot(page);
+    if (slotIndex != INVALID_SLOT)
+    {
+        Touch(page);
+        return slotIndex;
+    }
+
+    if (!m_FreeSlots.empty())
+    {
+        slotIndex = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+    }
+    else
+    {
+        // The least recently used page, if even it is used by this frame the cache is too small for the frame.
+        if (m_LruOrder.empty() || m_Slots[m_LruOrder.back()].LastUsedFrame == m_Frame)
+            return INVALID_SLOT;
+
+        slotIndex = m_LruOrder.back();
+        m_LruOrder.pop_back();
+
+        Slot& slot = m_Slots[slotIndex];
+        m_PageSlots[GetEntryIndex(slot.Page)] = INVALID_SLOT;
+        if (evicted)
+            *evicted = slot.Page;
+    }
+
+    Slot& slot = m_Slots[slotIndex];
+    slot.Page = page;
+    slot.Pinned = pinned;
+    slot.LastUsedFrame = m_Frame;
+    if (!pinned)
+    {
+        m_LruOrder.push_front(slotIndex);
+        slot.LruPosition = m_LruOrder.begin();
+    }
+
+    m_PageSlots[GetEntryIndex(page)] = slotIndex;
+    m_IndirectionDirty = true;
+    return slotIndex;
+}
+
+void VirtualTexturePageTable::UnmapPage(const VirtualPageId& page)
+{
+    uint32_t slotIndex = GetSlot(page);
+    if (slotIndex == INVALID_SLOT)
+        return;
+
+    Slot& slot = m_Slots[slotIndex];
+    if (!slot.Pinned)
+        m_LruOrder.erase(slot.LruPosition);
+
+    slot = Slot();
+    m_FreeSlots.push_back(slotIndex);
+    m_PageSlots[GetEntryIndex(page)] = INVALID_SLOT;
+    m_IndirectionDirty = true;
+}
+
+void VirtualTexturePageTable::GetSlotPosition(uint32_t slot, uint32_t& x, uint32_t& y) const
+{
+    x = slot % m_PhysicalPagesX;
+    y = slot / m_PhysicalPagesX;
+}
+
+const std::vector<uint32_t>& VirtualTexturePageTable::GetIndirection(uint32_t mip)
+{
+    if (m_IndirectionDirty)
+        RebuildIndirection();
+
+    return m_Indirection[mip];
+}
+
+size_t VirtualTexturePageTable::GetEntryIndex(const VirtualPageId& page) const
+{
+    return m_MipOffsets[page.Mip] + static_cast<size_t>(page.Y) * m_PagesX[page.Mip] + page.X;
+}
+
+void VirtualTexturePageTable::RebuildIndirection()
+{
+    // From the last mip down, a page without a slot of its own inherits the entry of its parent.
+    for (uint32_t mip = GetMipCount(); mip-- > 0;)
+    {
+        auto& entries = m_Indirection[mip];
+        entries.resize(static_cast<size_t>(m_PagesX[mip]) * m_PagesY[mip]);
+
+        for (uint32_t y = 0; y < m_PagesY[mip]; ++y)
+        {
+            for (uint32_t x = 0; x < m_PagesX[mip]; ++x)
+            {
+                VirtualPageId page = { x, y, mip };
+                uint32_t slot = m_PageSlots[GetEntryIndex(page)];
+
+                uint32_t entry = UINT32_MAX;
+                if (slot != INVALID_SLOT)
+                {
+                    uint32_t physicalX, physicalY;
+                    GetSlotPosition(slot, physicalX, physicalY);
+                    entry = physicalX | (physicalY << 8) | (mip << 16);
+                }
+                else if (mip + 1 < GetMipCount())
+                {
+                    entry = m_Indirection[mip + 1][static_cast<size_t>(y / 2) * m_PagesX[mip + 1] + x / 2];
+                }
+
+                entries[static_cast<size_t>(y) * m_PagesX[mip] + x] = entry;
+            }
+        }
+    }
+
+    m_IndirectionDirty = false;
+}
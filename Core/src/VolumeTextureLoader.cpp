@@ -0,0 +1,79 @@
+#include <VolumeTextureLoader.h>
+
+#include <DX12LibPCH.h>
+
+#include <DDSCache.h>
+#include <ThreadPool.h>
+
+#include <stb_image/stb_image.h>
+
+using namespace dx12demo::core;
+using namespace DirectX;
+
+void VolumeTextureLoader::LoadSlices(const std::vector<std::string>& slicePaths, uint32_t width, uint32_t height, DXGI_FORMAT format, DirectX::ScratchImage& volume)
+{
+    assert(!slicePaths.empty() && width > 0 && height > 0);
+    assert(BitsPerPixel(format) == 32 && !IsCompressed(format));
+
+    ThrowIfFailed(volume.Initialize3D(format, width, height, slicePaths.size(), 1));
+    const Image& image = *volume.GetImage(0, 0, 0);
+
+    // stbi_load is reentrant, only its failure reason is global, so the errors are collected per slice.
+    std::vector<uint8_t> failed(slicePaths.size(), 0);
+    ThreadPool::Get().ParallelFor(slicePaths.size(), [&](size_t z)
+    {
+        int sliceWidth, sliceHeight, sliceChannels;
+        stbi_uc* pixels = stbi_load(slicePaths[z].c_str(), &sliceWidth, &sliceHeight, &sliceChannels, STBI_rgb_alpha);
+        if (!pixels || sliceWidth != static_cast<int>(width) || sliceHeight != static_cast<int>(height))
+        {
+            failed[z] = 1;
+        }
+        else
+        {
+            const size_t sourceRowPitch = static_cast<size_t>(width) * 4;
+            uint8_t* slice = image.pixels + z * image.slicePitch;
+            for (uint32_t y = 0; y < height; ++y)
+                memcpy(slice + y * image.rowPitch, pixels + y * sourceRowPitch, sourceRowPitch);
+        }
+
+        stbi_image_free(pixels);
+    });
+
+    for (size_t z = 0; z < slicePaths.size(); ++z)
+    {
+        if (failed[z])
+            throw std::exception(("Failed to load the volume slice " + slicePaths[z]).c_str());
+    }
+}
+
+void VolumeTextureLoader::GenerateMips(const DirectX::ScratchImage& volume, DirectX::ScratchImage& mipChain)
+{
+    const TexMetadata& metadata = volume.GetMetadata();
+    assert(metadata.dimension == TEX_DIMENSION_TEXTURE3D && metadata.mipLevels == 1);
+
+    ThrowIfFailed(GenerateMipMaps3D(volume.GetImages(), metadata.depth, TEX_FILTER_DEFAULT, 0, mipChain));
+}
+
+void VolumeTextureLoader::Load(const std::vector<std::string>& slicePaths, const std::wstring& cachePath, uint32_t width, uint32_t height, DXGI_FORMAT format, DirectX::ScratchImage& volume)
+{
+    TexMetadata metadata;
+    if (DDSCache::IsValid(slicePaths, cachePath) &&
+        SUCCEEDED(LoadFromDDSFile(cachePath.c_str(), DDS_FLAGS_NONE, &metadata, volume)) &&
+        metadata.dimension == TEX_DIMENSION_TEXTURE3D && metadata.width == width && metadata.height == height &&
+        metadata.depth == slicePaths.size() && metadata.mipLevels > 1 && metadata.format == format)
+    {
+        return;
+    }
+
+    ScratchImage slices;
+    LoadSlices(slicePaths, width, height, format, slices);
+    GenerateMips(slices, volume);
+
+    if (!DDSCache::Write(cachePath, volume))
+    {
+        std::string path(cachePath.cbegin(), cachePath.cend());
+        char buffer[512];
+        sprintf_s(buffer, "Volume %s: the cache can't be written\n", path.c_str());
+        OutputDebugStringA(buffer);
+    }
+}
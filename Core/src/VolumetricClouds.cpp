@@ -1,6 +1,7 @@
 #include <VolumetricClouds.h>
 
 #include <Application.h>
+#include <CloudNoiseGenerator.h>
 #include <CommandQueue.h>
 #include <CommandList.h>
 #include <DX12LibPCH.h>
@@ -49,27 +50,40 @@ void VolumetricClouds::LoadContent(RenderPassBaseInfo* info)
 
 	commandList->LoadTextureFromFile(m_WeatherMapTex, sdInfo->weathermap_path);
 
-	CommandList::Create3DTextureBuildData lowFreqBuildData;
-	lowFreqBuildData.folderPath = "Assets/Textures/bitmap_clouds/LowFrequency/";
-	lowFreqBuildData.textureBaseName = "LowFrequency";
-	lowFreqBuildData.fileExtensionBaseName = ".tga";
-	lowFreqBuildData.width = lowFreqBuildData.height = lowFreqBuildData.depth = 128;
-	lowFreqBuildData.format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	lowFreqBuildData.num2DImages = 128;
-	lowFreqBuildData.numChannels = 4;
-
-	commandList->Create3DTextureFromMany2DTextures(m_LowFrequency3DTex, lowFreqBuildData);
-
-	CommandList::Create3DTextureBuildData highFreqBuildData;
-	highFreqBuildData.folderPath = "Assets/Textures/bitmap_clouds/HighFrequency/";
-	highFreqBuildData.textureBaseName = "HighFrequency";
-	highFreqBuildData.fileExtensionBaseName = ".tga";
-	highFreqBuildData.width = highFreqBuildData.height = highFreqBuildData.depth = 32;
-	highFreqBuildData.format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	highFreqBuildData.num2DImages = 32;
-	highFreqBuildData.numChannels = 4;
-
-	commandList->Create3DTextureFromMany2DTextures(m_HighFrequency3DTex, highFreqBuildData);
+	if (sdInfo->proceduralNoise)
+	{
+		DirectX::ScratchImage lowFrequencyVolume;
+		CloudNoiseGenerator::GenerateLowFrequency(CloudNoiseGenerator::DEFAULT_LOW_FREQUENCY_SIZE, lowFrequencyVolume);
+		commandList->LoadTextureFromImage(m_LowFrequency3DTex, L"CloudNoiseGenerator/LowFrequency", lowFrequencyVolume);
+
+		DirectX::ScratchImage highFrequencyVolume;
+		CloudNoiseGenerator::GenerateHighFrequency(CloudNoiseGenerator::DEFAULT_HIGH_FREQUENCY_SIZE, highFrequencyVolume);
+		commandList->LoadTextureFromImage(m_HighFrequency3DTex, L"CloudNoiseGenerator/HighFrequency", highFrequencyVolume);
+	}
+	else
+	{
+		CommandList::Create3DTextureBuildData lowFreqBuildData;
+		lowFreqBuildData.folderPath = "Assets/Textures/bitmap_clouds/LowFrequency/";
+		lowFreqBuildData.textureBaseName = "LowFrequency";
+		lowFreqBuildData.fileExtensionBaseName = ".tga";
+		lowFreqBuildData.width = lowFreqBuildData.height = lowFreqBuildData.depth = 128;
+		lowFreqBuildData.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		lowFreqBuildData.num2DImages = 128;
+		lowFreqBuildData.numChannels = 4;
+
+		commandList->Create3DTextureFromMany2DTextures(m_LowFrequency3DTex, lowFreqBuildData);
+
+		CommandList::Create3DTextureBuildData highFreqBuildData;
+		highFreqBuildData.folderPath = "Assets/Textures/bitmap_clouds/HighFrequency/";
+		highFreqBuildData.textureBaseName = "HighFrequency";
+		highFreqBuildData.fileExtensionBaseName = ".tga";
+		highFreqBuildData.width = highFreqBuildData.height = highFreqBuildData.depth = 32;
+		highFreqBuildData.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		highFreqBuildData.num2DImages = 32;
+		highFreqBuildData.numChannels = 4;
+
+		commandList->Create3DTextureFromMany2DTextures(m_HighFrequency3DTex, highFreqBuildData);
+	}
 
 	commandList->CopyStructuredBuffer(m_SkyBuffer, m_SkyBufferStruct);
 
@@ -127,7 +127,7 @@ void VoxelGrid::Init()
         D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineStateStream;
         ZeroMemory(&pipelineStateStream, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
         pipelineStateStream.pRootSignature = m_RootSignature.GetRootSignature().Get();
-        pipelineStateStream.InputLayout = { core::PosNormTexExtendedVertex::InputElementsExtended, core::PosNormTexExtendedVertex::InputElementCountExtended };
+        pipelineStateStream.InputLayout = { core::PosNormTexExtendedVertex::InputElementsExtendedInstanced, core::PosNormTexExtendedVertex::InputElementCountExtendedInstanced };
         pipelineStateStream.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
         pipelineStateStream.DepthStencilState = depthDesc;
         pipelineStateStream.SampleMask = UINT_MAX;
@@ -5,6 +5,7 @@
 #include <Window.h>
 #include <Mesh.h>
 #include <Texture.h>
+#include <TextureStreamer.h>
 #include <RenderTarget.h>
 #include <RootSignature.h>
 #include <Scene.h>
@@ -104,6 +105,8 @@ namespace dx12demo
 
         D3D12_RECT m_ScissorRect;
 
+        // Declared before the scene, which removes its textures from it.
+        core::TextureStreamer m_TextureStreamer;
         core::Scene m_Sponza;
         // HDR Render target
         core::RenderTarget m_RenderTarget;
@@ -145,6 +148,9 @@ namespace dx12demo
         CameraData* m_pAlignedCameraData;
 
         core::Frustum m_Frustum;
+        // The camera in the mesh space of m_Sponza and the pixels per unit at the distance 1, for its LODs.
+        DirectX::XMFLOAT3 m_SceneCameraPosition;
+        float m_ProjectionScale;
 
         // Camera controller
         float m_Forward;
@@ -164,6 +170,11 @@ namespace dx12demo
 
         const float m_CameraStep = 5.f;
 
+        // Bytes of scene data uploaded per frame while the scene streams in.
+        const size_t SCENE_STREAMING_BUDGET = 16 * 1024 * 1024;
+        // Bytes of texture mips uploaded per frame, the streamed texture memory is TextureStreamer::DEFAULT_BUDGET.
+        const size_t TEXTURE_STREAMING_BUDGET = 8 * 1024 * 1024;
+
         double m_FPS = 0.;
 
         bool m_ContentLoaded;
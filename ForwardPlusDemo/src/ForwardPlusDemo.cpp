@@ -14,6 +14,10 @@ using namespace DirectX;
 
 const float SCREEN_DEPTH = 1000.0f;
 const float SCREEN_NEAR = 0.1f;
+// Sponza is modelled in centimeters.
+const float SCENE_SCALE = 9.999999776e-003f;
+// Sponza is uploaded as PackedVertex, 20 bytes a vertex instead of 56, the depth and forward passes decode it.
+const bool PACK_SCENE_VERTICES = true;
 
 enum class SceneRootParameters
 {
@@ -70,6 +74,8 @@ ForwardPlusDemo::ForwardPlusDemo(const std::wstring& name, int width, int height
     , m_Width(width)
     , m_Height(height)
     , m_RenderScale(1.0f)
+    , m_SceneCameraPosition(0.0f, 0.0f, 0.0f)
+    , m_ProjectionScale(1.0f)
 {
     
     m_Config = std::make_unique<core::Config>(ConfigPathStr);
@@ -103,8 +109,10 @@ bool ForwardPlusDemo::LoadContent()
     auto commandQueue = app.GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY);
     auto commandList = commandQueue->GetCommandList();
 
+    // The scene streams in from OnUpdate, the first frames render what is already uploaded.
     auto scenePath = m_Config->GetRoot().GetPath(SceneFileNameStr).GetValueText<std::wstring>();
-    m_Sponza.LoadFromFile(commandList, scenePath, true);
+    m_Sponza.SetTextureStreamer(&m_TextureStreamer);
+    m_Sponza.LoadFromFileAsync(scenePath, true, 1, PACK_SCENE_VERTICES);
 
     // Create an HDR intermediate render target.
     DXGI_FORMAT HDRFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -234,6 +242,8 @@ bool ForwardPlusDemo::LoadContent()
         envInfo.cubeMapDepthOrArraySize = 6;
         envInfo.texturePath = L"Assets/Textures/grace-new.hdr";
         envInfo.textureName = L"Grace Cathedral Cubemap";
+        // The forward pass lights the scene with the baked SH irradiance and prefiltered cubemap.
+        envInfo.bakeLighting = true;
         envInfo.rootSignatureVersion = featureData.HighestVersion;
         envInfo.rtvFormats = m_RenderTarget.GetRenderTargetFormats();
         m_envRenderPass.LoadContent(&envInfo);
@@ -244,6 +254,7 @@ bool ForwardPlusDemo::LoadContent()
         info.bufferW = swidth;
         info.bufferH = sheight;
         info.rootSignatureVersion = featureData.HighestVersion;
+        info.packedVertices = PACK_SCENE_VERTICES;
         m_DepthBufferRenderPass.LoadContent(&info);
     }
 
@@ -260,6 +271,7 @@ bool ForwardPlusDemo::LoadContent()
         info.rootSignatureVersion = featureData.HighestVersion;
         info.rtvFormats = m_RenderTarget.GetRenderTargetFormats();
         info.depthBufferFormat = m_RenderTarget.GetDepthStencilFormat();
+        info.packedVertices = PACK_SCENE_VERTICES;
         m_ForwardPlusRenderPass.LoadContent(&info);
     }
 
@@ -388,6 +400,38 @@ void ForwardPlusDemo::OnUpdate(core::UpdateEventArgs& e)
         m_envRenderPass.OnUpdate(commandList, e);
     }
 
+    {
+        // The scene culls and selects its LODs in its mesh space, the camera is brought to it.
+        XMMATRIX sceneModel = XMMatrixScaling(SCENE_SCALE, SCENE_SCALE, SCENE_SCALE);
+        XMStoreFloat3(&m_SceneCameraPosition, XMVector3TransformCoord(m_Camera.get_Translation(), XMMatrixInverse(nullptr, sceneModel)));
+        // Sized for the render target the scene is drawn to.
+        m_ProjectionScale = m_Height * m_RenderScale / (2.0f * std::tan(XMConvertToRadians(m_Camera.get_FoV()) * 0.5f));
+    }
+
+    {
+        auto& app = GetApp();
+        auto directQueue = app.GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+        // The streamed meshes go into the mesh pool pages the frames draw from, so they are copied on the direct queue.
+        if (m_Sponza.IsLoading())
+        {
+            auto streamingCommandList = directQueue->GetCommandList();
+            m_Sponza.UpdateStreaming(streamingCommandList, SCENE_STREAMING_BUDGET);
+            directQueue->ExecuteCommandList(streamingCommandList);
+        }
+
+        auto copyQueue = app.GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY);
+        auto commandList = copyQueue->GetCommandList();
+
+        // The texture mips follow the camera, in the mesh space of the scene as its bounds.
+        m_Sponza.UpdateTextureStreaming(commandList, m_SceneCameraPosition, m_ProjectionScale, TEXTURE_STREAMING_BUDGET);
+        copyQueue->ExecuteCommandList(commandList);
+
+        // The frame waits on the GPU for the uploads and for the mips generated on the compute queue, the CPU doesn't block.
+        directQueue->Wait(*copyQueue);
+        directQueue->Wait(*app.GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COMPUTE));
+    }
+
     {
         // Update the model matrix.
         float angle = static_cast<float>(e.TotalTime * 90.0);
@@ -401,7 +445,9 @@ void ForwardPlusDemo::OnUpdate(core::UpdateEventArgs& e)
     }
 
     {
-        m_Frustum.ConstructFrustum(SCREEN_DEPTH, m_Camera.get_ViewMatrix(), m_Camera.get_ProjectionMatrix());
+        // In the mesh space of the scene, as the camera position it is rendered with.
+        XMMATRIX sceneModel = XMMatrixScaling(SCENE_SCALE, SCENE_SCALE, SCENE_SCALE);
+        m_Frustum.ConstructFrustum(SCREEN_DEPTH, sceneModel * m_Camera.get_ViewMatrix(), m_Camera.get_ProjectionMatrix());
     }
 }
 
@@ -432,14 +478,14 @@ void ForwardPlusDemo::OnRender(core::RenderEventArgs& e)
     }
 
     Mat matrices;
-    auto model = XMMatrixScaling(9.999999776e-003, 9.999999776e-003, 9.999999776e-003);
+    auto model = XMMatrixScaling(SCENE_SCALE, SCENE_SCALE, SCENE_SCALE);
     //auto model = XMMatrixScaling(0.1, 0.1, 0.1);
     ComputeMatrices(model, m_ViewMatrix, m_ProjectionMatrix, matrices);
 
     {
         m_DepthBufferRenderPass.OnRender(commandList, e);
         commandList->SetGraphicsDynamicConstantBuffer(static_cast<int>(SceneRootParameters::MatricesCB), matrices);     
-        m_Sponza.Render(commandList, m_Frustum, m_DepthBufferDrawFun);
+        m_Sponza.Render(commandList, m_Frustum, m_SceneCameraPosition, m_ProjectionScale, m_DepthBufferDrawFun);
     }
 
     m_ComputePerformanceTest.StartCompute(commandList);
@@ -484,7 +530,9 @@ void ForwardPlusDemo::OnRender(core::RenderEventArgs& e)
         m_ForwardPlusRenderPass.AttachLightGridTex(commandList, m_ComputeLightCulling.GetOpaqueLightGrid());
         m_ForwardPlusRenderPass.AttachLightsSB(commandList, m_ComputeLightsToView.GetLightsBuffer());
         m_ForwardPlusRenderPass.AttachLightIndexListSB(commandList, m_ComputeLightCulling.GetOpaqueLightIndexList());
-        m_Sponza.Render(commandList, m_Frustum, m_ForwardPlusDrawFun);
+        m_ForwardPlusRenderPass.AttachEnvironmentLighting(commandList, m_Camera.get_InverseViewMatrix(), m_envRenderPass.GetIrradiance(),
+            m_envRenderPass.GetPrefilteredTexture(), &m_envRenderPass.GetPrefilteredSRV(), m_envRenderPass.GetBRDFTexture());
+        m_Sponza.Render(commandList, m_Frustum, m_SceneCameraPosition, m_ProjectionScale, m_ForwardPlusDrawFun);
     }
 
     commandList->SetRenderTarget(m_pWindow->GetRenderTarget());
@@ -136,9 +136,11 @@ float4 DoNormalMapping(in float3x3 TBN, in Texture2D tex, in sampler s, in float
     return normalize(float4(normal, 0));
 }
 
+// The normal maps may have only x and y (BC5), z is rebuilt from them.
 float3 ExpandNormal(in float3 n)
 {
-    return n * 2.0f - 1.0f;
+    float2 xy = n.xy * 2.0f - 1.0f;
+    return float3(xy, sqrt(saturate(1.0f - dot(xy, xy))));
 }
 
 float DoAttenuation(float attenuation, float distance)
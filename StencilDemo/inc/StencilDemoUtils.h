@@ -174,7 +174,8 @@ namespace dx12demo::stdu
             16, 18, 19
         };
 
-        auto mesh = core::Mesh::CreateCustomMesh(commandList, vertices, indices, true);
+        // Submesh ranges below refer to this triangle order, so it must not be optimized.
+        auto mesh = core::Mesh::CreateCustomMesh(commandList, vertices, indices, true, false);
 
         core::SubMesh floorSubmesh;
         floorSubmesh.IndexCount = 6;